@@ -66,6 +66,7 @@ char *path = 0;
 char *suffix = 0;
 int external;			/* emit blocks as root graphs */
 int doTree;			/* emit block-cutpoint tree */
+int pipeline;			/* read graphs ahead on another thread */
 
 DEFINE_LIST(edge_stack, Agedge_t *)
 
@@ -259,8 +260,9 @@ static int process(Agraph_t * g, int gcnt)
 }
 
 static char *useString =
-    "Usage: bcomps [-stvx?] [-o<out template>] <files>\n\
+    "Usage: bcomps [-Pstvx?] [-o<out template>] <files>\n\
   -o - output file template\n\
+  -P - read graphs ahead of processing them, on another thread\n\
   -s - don't print components\n\
   -t - emit block-cutpoint tree\n\
   -v - verbose\n\
@@ -293,7 +295,7 @@ static void init(int argc, char *argv[])
     int c;
 
     opterr = 0;
-    while ((c = getopt(argc, argv, ":o:xstv?")) != -1) {
+    while ((c = getopt(argc, argv, ":o:xPstv?")) != -1) {
 	switch (c) {
 	case 'o':
 	    outfile = optarg;
@@ -312,6 +314,9 @@ static void init(int argc, char *argv[])
 	case 'x':
 	    external = 1;
 	    break;
+	case 'P':
+	    pipeline = 1;
+	    break;
 	case ':':
 	    fprintf(stderr, "bcomps: option -%c missing argument - ignored\n", optopt);
 	    break;
@@ -344,6 +349,8 @@ int main(int argc, char *argv[])
 
     init(argc, argv);
     newIngraph(&ig, Files);
+    if (pipeline)
+	prefetchIngraph(&ig, INGRAPH_PREFETCH_DEPTH);
 
     while ((g = nextGraph(&ig)) != 0) {
 	r |= process(g, gcnt);
@@ -86,9 +86,10 @@ static int x_index = -1;
 static int x_final = -1; // require 0 <= x_index <= x_final or x_final= -1
 static int x_mode;
 static char *x_node;
+static int pipeline; // read graphs ahead on another thread
 
 static char *useString =
-    "Usage: ccomps [-svenCx?] [-X[#%]s[-f]] [-o<out template>] <files>\n\
+    "Usage: ccomps [-svenCPx?] [-X[#%]s[-f]] [-o<out template>] <files>\n\
   -s - silent\n\
   -x - external\n\
   -X - extract component\n\
@@ -98,6 +99,7 @@ static char *useString =
   -v - verbose\n\
   -o - output file template\n\
   -z - sort by size, largest first\n\
+  -P - read graphs ahead of processing them, on another thread\n\
   -? - print usage\n\
 If no files are specified, stdin is used\n";
 
@@ -127,7 +129,7 @@ static void init(int argc, char *argv[])
 
     Cmd = argv[0];
     opterr = 0;
-    while ((c = getopt(argc, argv, ":zo:xCX:nesv?")) != -1) {
+    while ((c = getopt(argc, argv, ":zo:xCPX:nesv?")) != -1) {
 	switch (c) {
 	case 'o':
 	    outfile = optarg;
@@ -191,6 +193,9 @@ static void init(int argc, char *argv[])
 	case 'z':
 	    sorted = 1;
 	    break;
+	case 'P':
+	    pipeline = 1;
+	    break;
 	case ':':
 	    fprintf(stderr,
 		"ccomps: option -%c missing argument - ignored\n", optopt);
@@ -813,6 +818,8 @@ int main(int argc, char *argv[])
     int r = 0;
     init(argc, argv);
     newIngraph(&ig, Inputs);
+    if (pipeline)
+	prefetchIngraph(&ig, INGRAPH_PREFETCH_DEPTH);
 
     while ((g = nextGraph(&ig)) != 0) {
 	r += process(g, chkGraphName(g));
@@ -21,6 +21,7 @@
 #include "config.h"
 
 #include <getopt.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -36,6 +37,7 @@ static FILE *outFile;
 static char *CmdName;
 static char **Files;
 static mode act = Unset;
+static bool Pipeline; ///< read graphs ahead on another thread?
 
 #ifdef HAVE_EXPAT
 static FILE *getFile(void)
@@ -63,10 +65,12 @@ static FILE *getFile(void)
 }
 #endif
 
-static const char *use = "Usage: %s [-gd?] [-o<file>] [<graphs>]\n\
+static const char *use = "Usage: %s [-gdP?] [-o<file>] [<graphs>]\n\
  -g        : convert to GXL\n\
  -d        : convert to GV\n\
  -o<file>  : output to <file> (stdout)\n\
+ -P        : read graphs ahead of converting them, on another thread\n\
+             (conversion to GXL only)\n\
  -?        : usage\n";
 
 static void usage(int v)
@@ -133,7 +137,7 @@ static void initargs(int argc, char **argv)
 
     CmdName = cmdName(argv[0]);
     opterr = 0;
-    while ((c = getopt(argc, argv, ":gdo:")) != -1) {
+    while ((c = getopt(argc, argv, ":gdo:P")) != -1) {
 	switch (c) {
 	case 'd':
 	    act = ToGV;
@@ -146,6 +150,9 @@ static void initargs(int argc, char **argv)
 		fclose(outFile);
 	    outFile = openFile(CmdName, optarg, "w");
 	    break;
+	case 'P':
+	    Pipeline = true;
+	    break;
 	case ':':
 	    fprintf(stderr, "%s: option -%c missing argument\n", CmdName, optopt);
 	    break;
@@ -184,6 +191,8 @@ int main(int argc, char **argv)
     if (act == ToGXL) {
 	ingraph_state ig;
 	newIngraph(&ig, Files);
+	if (Pipeline)
+	    prefetchIngraph(&ig, INGRAPH_PREFETCH_DEPTH);
 
 	while ((G = nextGraph(&ig))) {
 	    if (prev)
@@ -34,6 +34,7 @@ static bool setall;		/* if false, don't set dist attribute for
 				 */
 static bool doPath;		/* if true, record shortest paths */
 static bool doDirected;	/* if true, use directed paths */
+static bool pipeline;	/* if true, read graphs ahead on another thread */
 static Agsym_t *len_sym;
 
 typedef struct {
@@ -212,10 +213,11 @@ static void dijkstra(Dict_t * Q, Agraph_t * G, Agnode_t * n)
 }
 
 static char *useString =
-    "Usage: dijkstra [-ap?] <node> [<file> <node> <file>]\n\
+    "Usage: dijkstra [-adpP?] <node> [<file> <node> <file>]\n\
   -a - for nodes in a different component, set dist very large\n\
   -d - use forward directed edges\n\
   -p - attach shortest path info\n\
+  -P - read graphs ahead of processing them, on another thread\n\
   -? - print usage\n\
 If no files are specified, stdin is used\n";
 
@@ -231,7 +233,7 @@ static void init(int argc, char *argv[])
 
     CmdName = argv[0];
     opterr = 0;
-    while ((c = getopt(argc, argv, "adp?")) != -1) {
+    while ((c = getopt(argc, argv, "adpP?")) != -1) {
 	switch (c) {
 	case 'a':
 	    setall = true;
@@ -242,6 +244,9 @@ static void init(int argc, char *argv[])
 	case 'p':
 	    doPath = true;
 	    break;
+	case 'P':
+	    pipeline = true;
+	    break;
 	case '?':
 	    if (optopt == '\0' || optopt == '?')
 		usage(0);
@@ -283,6 +288,8 @@ int main(int argc, char **argv)
 
     init(argc, argv);
     newIngraph(&ig, Files);
+    if (pipeline)
+	prefetchIngraph(&ig, INGRAPH_PREFETCH_DEPTH);
 
     Q = dtopen(&MyDisc, Dtoset);
     while ((g = nextGraph(&ig)) != 0) {
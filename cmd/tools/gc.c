@@ -57,13 +57,14 @@ static int n_indent;
 static int recurse;
 static int silent;
 static int verbose;
+static int pipeline;
 static int gtype;
 static int flags;
 static char *fname;
 static char **Inputs;
 static FILE *outfile;
 
-static char *useString = "Usage: gc [-necCaDUrsv?] <files>\n\
+static char *useString = "Usage: gc [-necCaDPUrsv?] <files>\n\
   -n - print number of nodes\n\
   -e - print number of edges\n\
   -c - print number of connected components\n\
@@ -71,6 +72,7 @@ static char *useString = "Usage: gc [-necCaDUrsv?] <files>\n\
   -a - print all counts\n\
   -D - only directed graphs\n\
   -U - only undirected graphs\n\
+  -P - read graphs ahead of analyzing them, on another thread\n\
   -r - recursively analyze subgraphs\n\
   -s - silent\n\
   -v - verbose\n\
@@ -89,7 +91,7 @@ static void init(int argc, char *argv[])
     int c;
 
     opterr = 0;
-    while ((c = getopt(argc, argv, "necCaDUrsv?")) != -1) {
+    while ((c = getopt(argc, argv, "necCaDPUrsv?")) != -1) {
 	switch (c) {
 	case 'e':
 	    flags |= EDGES;
@@ -122,6 +124,9 @@ static void init(int argc, char *argv[])
 	case 'U':
 	    gtype = UNDIRECTED;
 	    break;
+	case 'P':
+	    pipeline = 1;
+	    break;
 	case '?':
 	    if (optopt == '\0' || optopt == '?')
 		usage(0);
@@ -302,6 +307,8 @@ int main(int argc, char *argv[])
 
     init(argc, argv);
     newIngraph(&ig, Inputs);
+    if (pipeline)
+	prefetchIngraph(&ig, INGRAPH_PREFETCH_DEPTH);
 
     while ((g = nextGraph(&ig)) != 0) {
 	if (prev)
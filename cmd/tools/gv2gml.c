@@ -41,6 +41,7 @@ static char *CmdName;
 static char **Files;
 static uint64_t id;
 static bool yworks; ///< use yWorks.com variant of GML?
+static bool pipeline; ///< read graphs ahead on another thread?
 
 #define POS_SET (1<<0)
 #define W_SET   (1<<1)
@@ -635,9 +636,10 @@ static void gv_to_gml(Agraph_t *G) {
     fprintf (outFile, "]\n");
 }
 
-static char *useString = "Usage: %s [-y] [-?] <files>\n\
+static char *useString = "Usage: %s [-y] [-P] [-?] <files>\n\
   -o<file>  : output to <file> (stdout)\n\
   -y        : output yWorks.com GML variant\n\
+  -P        : read graphs ahead of converting them, on another thread\n\
   -? - print usage\n\
 If no files are specified, stdin is used\n";
 
@@ -665,7 +667,7 @@ static void initargs(int argc, char **argv)
 
     CmdName = cmdName(argv[0]);
     opterr = 0;
-    while ((c = getopt(argc, argv, ":o:y")) != -1) {
+    while ((c = getopt(argc, argv, ":o:yP")) != -1) {
 	switch (c) {
 	case 'o':
 	    if (outFile != NULL)
@@ -675,6 +677,9 @@ static void initargs(int argc, char **argv)
 	case 'y':
 	    yworks = true;
 	    break;
+	case 'P':
+	    pipeline = true;
+	    break;
 	case ':':
 	    fprintf(stderr, "%s: option -%c missing parameter\n", CmdName, optopt);
 	    usage(1);
@@ -712,6 +717,8 @@ int main(int argc, char **argv)
     rv = 0;
     initargs(argc, argv);
     newIngraph(&ig, Files);
+    if (pipeline)
+	prefetchIngraph(&ig, INGRAPH_PREFETCH_DEPTH);
 
     while ((G = nextGraph(&ig))) {
 	if (prev) {
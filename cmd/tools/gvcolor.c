@@ -87,8 +87,10 @@ static void setcolor(char *p, double *v)
 }
 
 static char **Files;
+static bool Pipeline;
 
-static char *useString = "Usage: gvcolor [-?] <files>\n\
+static char *useString = "Usage: gvcolor [-P?] <files>\n\
+  -P - read graphs ahead of coloring them, on another thread\n\
   -? - print usage\n\
 If no files are specified, stdin is used\n";
 
@@ -103,8 +105,11 @@ static void init(int argc, char *argv[])
     int c;
 
     opterr = 0;
-    while ((c = getopt(argc, argv, ":?")) != -1) {
+    while ((c = getopt(argc, argv, ":P?")) != -1) {
 	switch (c) {
+	case 'P':
+	    Pipeline = true;
+	    break;
 	case '?':
 	    if (optopt == '\0' || optopt == '?')
 		usage(0);
@@ -255,6 +260,8 @@ int main(int argc, char **argv)
 
     init(argc, argv);
     newIngraph(&ig, Files);
+    if (Pipeline)
+	prefetchIngraph(&ig, INGRAPH_PREFETCH_DEPTH);
 
     while ((g = nextGraph(&ig)) != 0) {
 	color(g);
@@ -24,9 +24,11 @@
 
 static char **Files;
 static bool chkOnly;
+static bool pipeline;
 
-static const char useString[] = "Usage: nop [-p?] <files>\n\
+static const char useString[] = "Usage: nop [-pP?] <files>\n\
   -p - check for valid DOT\n\
+  -P - read graphs ahead of writing them, on another thread\n\
   -? - print usage\n\
 If no files are specified, stdin is used\n";
 
@@ -41,11 +43,14 @@ static void init(int argc, char *argv[])
     int c;
 
     opterr = 0;
-    while ((c = getopt(argc, argv, "p?")) != -1) {
+    while ((c = getopt(argc, argv, "pP?")) != -1) {
 	switch (c) {
 	case 'p':
 	    chkOnly = true;
 	    break;
+	case 'P':
+	    pipeline = true;
+	    break;
 	case '?':
 	    if (optopt == '\0' || optopt == '?')
 		usage(EXIT_SUCCESS);
@@ -74,6 +79,8 @@ int main(int argc, char **argv)
 
     init(argc, argv);
     newIngraph(&ig, Files);
+    if (pipeline)
+	prefetchIngraph(&ig, INGRAPH_PREFETCH_DEPTH);
 
     while ((g = nextGraph(&ig)) != 0) {
 	if (!chkOnly) agwrite(g, stdout);
@@ -83,6 +83,7 @@ typedef struct {
 static int wantDegenerateComp;
 static int Silent;
 static int StatsOnly;
+static int Pipeline;
 static int Verbose;
 static char *CmdName;
 static char **Files;
@@ -251,11 +252,12 @@ static void process(Agraph_t * G)
 
 }
 
-static char *useString = "Usage: %s [-sdv?] <files>\n\
+static char *useString = "Usage: %s [-sdPv?] <files>\n\
   -s           - only produce statistics\n\
   -S           - silent\n\
   -d           - allow degenerate components\n\
   -o<outfile>  - write to <outfile> (stdout)\n\
+  -P           - read graphs ahead of processing them, on another thread\n\
   -v           - verbose\n\
   -?           - print usage\n\
 If no files are specified, stdin is used\n";
@@ -272,7 +274,7 @@ static void scanArgs(int argc, char **argv)
 
     CmdName = argv[0];
     opterr = 0;
-    while ((c = getopt(argc, argv, ":o:sdvS?")) != EOF) {
+    while ((c = getopt(argc, argv, ":o:sdPvS?")) != EOF) {
 	switch (c) {
 	case 's':
 	    StatsOnly = 1;
@@ -280,6 +282,9 @@ static void scanArgs(int argc, char **argv)
 	case 'd':
 	    wantDegenerateComp = 1;
 	    break;
+	case 'P':
+	    Pipeline = 1;
+	    break;
 	case 'o':
 	    if (outfp != NULL)
 		fclose(outfp);
@@ -325,6 +330,8 @@ int main(int argc, char **argv)
 
     scanArgs(argc, argv);
     newIngraph(&ig, Files);
+    if (Pipeline)
+	prefetchIngraph(&ig, INGRAPH_PREFETCH_DEPTH);
 
     while ((g = nextGraph(&ig)) != 0) {
 	if (agisdirected(g))
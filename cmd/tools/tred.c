@@ -35,13 +35,15 @@
 
 static char **Files;
 static char *CmdName;
+static bool Pipeline;
 
 typedef graphviz_tred_options_t opts_t;
 
-static char *useString = "Usage: %s [-vr?] <files>\n\
+static char *useString = "Usage: %s [-vrP?] <files>\n\
   -o FILE - redirect output (default to stdout)\n\
   -v - verbose (to stderr)\n\
   -r - print removed edges to stderr\n\
+  -P - read graphs ahead of reducing them, on another thread\n\
   -? - print usage\n\
 If no files are specified, stdin is used\n";
 
@@ -56,7 +58,7 @@ static void init(opts_t *opts, int argc, char *argv[]) {
 
     CmdName = argv[0];
     opterr = 0;
-    while ((c = getopt(argc, argv, "o:vr?")) != -1) {
+    while ((c = getopt(argc, argv, "o:vrP?")) != -1) {
 	switch (c) {
 	case 'o':
 	    (void)fclose(opts->out);
@@ -73,6 +75,9 @@ static void init(opts_t *opts, int argc, char *argv[]) {
 	case 'r':
         opts->PrintRemovedEdges = true;
         break;
+	case 'P':
+	    Pipeline = true;
+	    break;
 	case '?':
 	    if (optopt == '\0' || optopt == '?')
 		usage(0);
@@ -101,6 +106,8 @@ int main(int argc, char **argv)
 
     init(&opts, argc, argv);
     newIngraph(&ig, Files);
+    if (Pipeline)
+	prefetchIngraph(&ig, INGRAPH_PREFETCH_DEPTH);
 
     while ((g = nextGraph(&ig)) != 0) {
 	if (agisdirected(g))
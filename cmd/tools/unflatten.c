@@ -34,13 +34,15 @@ typedef graphviz_unflatten_options_t opts_t;
 
 static FILE *outFile;
 static char *cmd;
+static bool pipeline;
 
 static char *useString =
-    "Usage: %s [-f?] [-l <M>] [-c <N>] [-o <outfile>] <files>\n\
+    "Usage: %s [-fP?] [-l <M>] [-c <N>] [-o <outfile>] <files>\n\
   -o <outfile> - put output in <outfile>\n\
   -f           - adjust immediate fanout chains\n\
   -l <M>       - stagger length of leaf edges between [1,<M>]\n\
   -c <N>       - put disconnected nodes in chains of length <N>\n\
+  -P           - read graphs ahead of processing them, on another thread\n\
   -?           - print usage\n";
 
 static void usage(int v)
@@ -54,7 +56,7 @@ static char **scanargs(opts_t *opts, int argc, char **argv) {
 
     cmd = argv[0];
     opterr = 0;
-    while ((c = getopt(argc, argv, ":fl:c:o:")) != -1) {
+    while ((c = getopt(argc, argv, ":fl:c:o:P")) != -1) {
 	switch (c) {
 	case 'f':
 	    opts->Do_fans = true;
@@ -74,6 +76,9 @@ static char **scanargs(opts_t *opts, int argc, char **argv) {
 		fclose(outFile);
 	    outFile = openFile(cmd, optarg, "w");
 	    break;
+	case 'P':
+	    pipeline = true;
+	    break;
 	case '?':
 	    if (optopt == '?')
 		usage(0);
@@ -114,6 +119,8 @@ int main(int argc, char **argv)
 
     files = scanargs(&opts, argc, argv);
     newIngraph(&ig, files);
+    if (pipeline)
+	prefetchIngraph(&ig, INGRAPH_PREFETCH_DEPTH);
     while ((g = nextGraph(&ig))) {
 	graphviz_unflatten(g, &opts);
 	agwrite(g, outFile);
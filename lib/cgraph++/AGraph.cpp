@@ -1,5 +1,8 @@
+#include <cstddef>
 #include <stdexcept>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "AGraph.h"
 
@@ -13,6 +16,58 @@ AGraph::AGraph(const std::string &dot) {
   m_g = g;
 }
 
+AGraph::AGraph(const std::string &name, Agdesc_t desc) {
+  const auto g = agopen(const_cast<char *>(name.c_str()), desc, nullptr);
+  if (!g) {
+    throw std::runtime_error("Could not create graph");
+  }
+  m_g = g;
+}
+
+void AGraph::build(
+    const std::vector<std::string> &nodes,
+    const std::vector<std::pair<std::size_t, std::size_t>> &edges,
+    const std::vector<Column> &columns) {
+  std::vector<const char *> names;
+  names.reserve(nodes.size());
+  for (const auto &node : nodes) {
+    names.push_back(node.c_str());
+  }
+
+  std::vector<std::size_t> ends;
+  ends.reserve(2 * edges.size());
+  for (const auto &[tail, head] : edges) {
+    if (tail >= nodes.size() || head >= nodes.size()) {
+      throw std::invalid_argument("Edge refers to a node that does not exist");
+    }
+    ends.push_back(tail);
+    ends.push_back(head);
+  }
+
+  std::vector<std::vector<const char *>> values;
+  std::vector<Agcolumn_t> cols;
+  values.reserve(columns.size());
+  cols.reserve(columns.size());
+  for (const auto &column : columns) {
+    const auto size = column.kind == AGNODE ? nodes.size() : edges.size();
+    if ((column.kind != AGNODE && column.kind != AGEDGE) ||
+        column.values.size() != size) {
+      throw std::invalid_argument("Invalid attribute column " + column.name);
+    }
+    auto &vs = values.emplace_back();
+    vs.reserve(size);
+    for (const auto &value : column.values) {
+      vs.push_back(value.c_str());
+    }
+    cols.push_back(Agcolumn_t{column.kind, column.name.c_str(), vs.data()});
+  }
+
+  if (agbuild(m_g, names.size(), names.data(), edges.size(), ends.data(),
+              cols.size(), cols.data(), nullptr, nullptr) != 0) {
+    throw std::runtime_error("Could not build graph");
+  }
+}
+
 AGraph::~AGraph() {
   if (m_g) {
     agclose(m_g);
@@ -1,7 +1,9 @@
 #pragma once
 
+#include <cstddef>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "cgraph.h"
 
@@ -26,6 +28,8 @@ namespace CGraph {
 class AGRAPH_API AGraph {
 public:
   explicit AGraph(const std::string &dot);
+  // make an empty graph of the given kind, e.g. `Agdirected`
+  AGraph(const std::string &name, Agdesc_t desc);
   ~AGraph();
 
   // delete copy since we manage a C struct using a raw pointer and the struct
@@ -44,6 +48,22 @@ public:
   // get a non-owning pointer to the underlying C data structure
   Agraph_t *c_struct() const { return m_g; }
 
+  /// values of an attribute, one per node or edge, as for `agbuild`
+  struct Column {
+    int kind; ///< `AGNODE` or `AGEDGE`
+    std::string name;
+    std::vector<std::string> values;
+  };
+
+  /// add nodes, edges between them by index and their attributes in bulk
+  ///
+  /// See `agbuild`. Throws `std::invalid_argument` if an edge refers to a node
+  /// not in `nodes` or a column is the wrong length, in which case nothing is
+  /// added, and `std::runtime_error` if the nodes or edges cannot be made.
+  void build(const std::vector<std::string> &nodes,
+             const std::vector<std::pair<std::size_t, std::size_t>> &edges,
+             const std::vector<Column> &columns = {});
+
 private:
   // the underlying C data structure
   Agraph_t *m_g = nullptr;
@@ -21,6 +21,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <util/streq.h>
+#include <util/thread.h>
 
 static agerrlevel_t agerrno;             /* Last error level */
 static agerrlevel_t agerrlevel = AGWARN; /* Report errors >= agerrlevel */
@@ -29,6 +30,13 @@ static int agmaxerr;
 static agxbuf last;         ///< last message
 static agusererrf usererrf; /* User-set error function */
 
+/// protects the above, for messages from a thread reading graphs ahead of the
+/// one working on them
+///
+/// This is deliberately not `gv_global_lock`, which is held across calls that
+/// may report errors.
+static gv_mutex_t lock = GV_MUTEX_INIT;
+
 agusererrf agseterrf(agusererrf newf) {
   agusererrf oldf = usererrf;
   usererrf = newf;
@@ -42,6 +50,8 @@ agerrlevel_t agseterr(agerrlevel_t lvl) {
 }
 
 char *aglasterr(void) {
+  gv_mutex_lock(&lock);
+
   // Extract a heap-allocated copy of the last message. Note that this resets
   // `last` to an empty buffer ready to be written to again.
   char *buf = agxbdisown(&last);
@@ -50,6 +60,8 @@ char *aglasterr(void) {
   // without losing the last error
   agxbput(&last, buf);
 
+  gv_mutex_unlock(&lock);
+
   // was there no last message?
   if (streq(buf, "")) {
     free(buf);
@@ -128,6 +140,8 @@ static void out(agerrlevel_t level, const char *fmt, va_list args) {
 static int agerr_va(agerrlevel_t level, const char *fmt, va_list args) {
   agerrlevel_t lvl;
 
+  gv_mutex_lock(&lock);
+
   /* Use previous error level if continuation message;
    * Convert AGMAX to AGERROR;
    * else use input level
@@ -143,12 +157,13 @@ static int agerr_va(agerrlevel_t level, const char *fmt, va_list args) {
    */
   if (lvl >= agerrlevel) {
     out(level, fmt, args);
-    return 0;
+  } else {
+    if (level != AGPREV)
+      agxbclear(&last);
+    vagxbprint(&last, fmt, args);
   }
 
-  if (level != AGPREV)
-    agxbclear(&last);
-  vagxbprint(&last, fmt, args);
+  gv_mutex_unlock(&lock);
   return 0;
 }
 
@@ -178,10 +193,17 @@ void agwarningf(const char *fmt, ...) {
   va_end(args);
 }
 
-int agerrors(void) { return agmaxerr; }
+int agerrors(void) {
+  gv_mutex_lock(&lock);
+  const int rc = agmaxerr;
+  gv_mutex_unlock(&lock);
+  return rc;
+}
 
 int agreseterrors(void) {
+  gv_mutex_lock(&lock);
   int rc = agmaxerr;
   agmaxerr = 0;
+  gv_mutex_unlock(&lock);
   return rc;
 }
@@ -15,9 +15,12 @@
  *************************************************************************/
 
 #include	<cgraph/cghdr.h>
+#include	<limits.h>
 #include	<stddef.h>
 #include	<stdbool.h>
+#include	<stdlib.h>
 #include	<util/streq.h>
+#include	<util/thread.h>
 #include	<util/unreachable.h>
 
 /*
@@ -44,6 +47,9 @@ static void init_all_attrs(Agraph_t * g);
 static Agdesc_t ProtoDesc = {.directed = true, .no_loop = true,
                              .no_write = true};
 static Agraph_t *ProtoGraph;
+/// protects `ProtoGraph`, which every new root graph copies, from graphs being
+/// opened on one thread while another declares or looks up default attributes
+static gv_mutex_t ProtoGraph_lock = GV_MUTEX_INIT;
 
 Agdatadict_t *agdatadict(Agraph_t *g, bool cflag) {
     Agdatadict_t *rv = (Agdatadict_t *) aggetrec(g, DataDictName, 0);
@@ -121,6 +127,7 @@ static Agdatadict_t *agmakedatadict(Agraph_t * g)
 	dtview(dd->dict.e, parent_dd->dict.e);
 	dtview(dd->dict.g, parent_dd->dict.g);
     } else {
+	gv_mutex_lock(&ProtoGraph_lock);
 	if (ProtoGraph && g != ProtoGraph) {
 	    /* it's not ok to dtview here for several reasons. the proto
 	       graph could change, and the sym indices don't match */
@@ -129,6 +136,7 @@ static Agdatadict_t *agmakedatadict(Agraph_t * g)
 	    agcopydict(parent_dd->dict.e, dd->dict.e, g, AGEDGE);
 	    agcopydict(parent_dd->dict.g, dd->dict.g, g, AGRAPH);
 	}
+	gv_mutex_unlock(&ProtoGraph_lock);
     }
     return dd;
 }
@@ -198,13 +206,31 @@ static Agrec_t *agmakeattrs(Agraph_t * context, void *obj)
 	rec->str = agalloc(agraphof(obj), (size_t) sz * sizeof(char *));
 	/* doesn't call agxset() so no obj-modified callbacks occur */
 	for (sym = dtfirst(datadict); sym; sym = dtnext(datadict, sym))
-	    rec->str[sym->id] = agstrdup(agraphof(obj), sym->defval);
+	    rec->str[sym->id] = agstrref(agraphof(obj), sym->defval);
     } else {
 	assert(rec->dict == datadict);
     }
     return (Agrec_t *) rec;
 }
 
+/* numbers parsed from attribute values:
+ * An object's Agattr_t.num parallels its Agattr_t.str, and is allocated the
+ * first time one of its values is read as a number. Each entry remembers
+ * the string it was parsed from, and is parsed again once the value is a
+ * different string. agxset clears the entry of the value it replaces, as
+ * the new string could be allocated where the old one was.
+ */
+
+enum { NUM_DOUBLE = 1, NUM_INT = 2 };
+
+struct Agattrnum_s {
+    const char *str;		/* the value these were parsed from */
+    double d;
+    int i;
+    unsigned char parsed;	/* which of NUM_DOUBLE, NUM_INT were tried */
+    unsigned char ok;		/* and which of those succeeded */
+};
+
 static void freeattr(Agobj_t * obj, Agattr_t * attr)
 {
     int i, sz;
@@ -215,6 +241,7 @@ static void freeattr(Agobj_t * obj, Agattr_t * attr)
     for (i = 0; i < sz; i++)
 	agstrfree(g, attr->str[i]);
     agfree(g, attr->str);
+    agfree(g, attr->num);
 }
 
 static void freesym(void *obj) {
@@ -242,7 +269,11 @@ static void addattr(Agraph_t * g, Agobj_t * obj, Agsym_t * sym)
 						     sizeof(char *),
 						     ((size_t) sym->id +
 						      1) * sizeof(char *));
-    attr->str[sym->id] = agstrdup(g, sym->defval);
+    attr->str[sym->id] = agstrref(g, sym->defval);
+    if (attr->num && sym->id >= MINATTR)
+	attr->num = agrealloc(g, attr->num,
+			      (size_t) sym->id * sizeof(Agattrnum_t),
+			      ((size_t) sym->id + 1) * sizeof(Agattrnum_t));
 }
 
 static Agsym_t *getattr(Agraph_t *g, int kind, char *name) {
@@ -340,16 +371,28 @@ static Agsym_t *setattr(Agraph_t * g, int kind, char *name, const char *value) {
  */
 Agsym_t *agattr(Agraph_t * g, int kind, char *name, const char *value) {
     Agsym_t *rv;
-
-    if (g == 0) {
-	if (ProtoGraph == 0)
-	    ProtoGraph = agopen(0, ProtoDesc, 0);
+    const bool proto = g == NULL;
+
+    if (proto) {
+	gv_mutex_lock(&ProtoGraph_lock);
+	if (ProtoGraph == 0) {
+	    gv_mutex_unlock(&ProtoGraph_lock);
+	    // opening a root graph takes the lock, to copy ProtoGraph
+	    Agraph_t *pg = agopen(0, ProtoDesc, 0);
+	    gv_mutex_lock(&ProtoGraph_lock);
+	    if (ProtoGraph == 0)
+		ProtoGraph = pg;
+	    else
+		agclose(pg);
+	}
 	g = ProtoGraph;
     }
     if (value)
 	rv = setattr(g, kind, name, value);
     else
 	rv = getattr(g, kind, name);
+    if (proto)
+	gv_mutex_unlock(&ProtoGraph_lock);
     return rv;
 }
 
@@ -466,6 +509,70 @@ char *agxget(void *obj, Agsym_t * sym)
     return rv;
 }
 
+static Agattrnum_t *attrnum(void *obj, Agsym_t * sym)
+{
+    Agattr_t *data;
+    Agattrnum_t *num;
+    int sz;
+
+    data = agattrrec(obj);
+    assert(sym->id >= 0 && sym->id < topdictsize(obj));
+    if (data->num == NULL) {
+	/* as many entries as data->str has */
+	sz = topdictsize(obj);
+	if (sz < MINATTR)
+	    sz = MINATTR;
+	data->num = agalloc(agraphof(obj), (size_t) sz * sizeof(Agattrnum_t));
+    }
+    num = &data->num[sym->id];
+    if (num->str != data->str[sym->id])
+	*num = (Agattrnum_t){.str = data->str[sym->id]};
+    return num;
+}
+
+bool agxget_double(void *obj, Agsym_t * sym, double *value)
+{
+    Agattrnum_t *num;
+    char *endp;
+
+    num = attrnum(obj, sym);
+    if (!(num->parsed & NUM_DOUBLE)) {
+	num->parsed |= NUM_DOUBLE;
+	if (num->str && num->str[0] != '\0') {
+	    num->d = strtod(num->str, &endp);
+	    if (endp != num->str)
+		num->ok |= NUM_DOUBLE;
+	}
+    }
+    if (!(num->ok & NUM_DOUBLE))
+	return false;
+    *value = num->d;
+    return true;
+}
+
+bool agxget_int(void *obj, Agsym_t * sym, int *value)
+{
+    Agattrnum_t *num;
+    char *endp;
+    long l;
+
+    num = attrnum(obj, sym);
+    if (!(num->parsed & NUM_INT)) {
+	num->parsed |= NUM_INT;
+	if (num->str && num->str[0] != '\0') {
+	    l = strtol(num->str, &endp, 10);
+	    if (endp != num->str && l >= INT_MIN && l <= INT_MAX) {
+		num->i = (int) l;
+		num->ok |= NUM_INT;
+	    }
+	}
+    }
+    if (!(num->ok & NUM_INT))
+	return false;
+    *value = num->i;
+    return true;
+}
+
 int agset(void *obj, char *name, const char *value) {
     Agsym_t *sym;
     int rv;
@@ -478,7 +585,8 @@ int agset(void *obj, char *name, const char *value) {
     return rv;
 }
 
-int agxset(void *obj, Agsym_t * sym, const char *value)
+/// set an attribute's value to `value`, on which a reference is already held
+static int agxset_ref(void *obj, Agsym_t * sym, char *value)
 {
     Agraph_t *g;
     Agobj_t *hdr;
@@ -490,14 +598,16 @@ int agxset(void *obj, Agsym_t * sym, const char *value)
     data = agattrrec(hdr);
     assert(sym->id >= 0 && sym->id < topdictsize(obj));
     agstrfree(g, data->str[sym->id]);
-    data->str[sym->id] = agstrdup(g, value);
+    data->str[sym->id] = value;
+    if (data->num)
+	data->num[sym->id] = (Agattrnum_t){0};
     if (hdr->tag.objtype == AGRAPH) {
 	/* also update dict default */
 	Dict_t *dict;
 	dict = agdatadict(g, false)->dict.g;
 	if ((lsym = aglocaldictsym(dict, sym->name))) {
 	    agstrfree(g, lsym->defval);
-	    lsym->defval = agstrdup(g, value);
+	    lsym->defval = agstrref(g, value);
 	} else {
 	    lsym = agnewsym(g, sym->name, value, sym->id, AGTYPE(hdr));
 	    dtinsert(dict, lsym);
@@ -507,6 +617,16 @@ int agxset(void *obj, Agsym_t * sym, const char *value)
     return SUCCESS;
 }
 
+int agxset(void *obj, Agsym_t * sym, const char *value)
+{
+    return agxset_ref(obj, sym, agstrdup(agraphof(obj), value));
+}
+
+int agxset_interned(void *obj, Agsym_t * sym, const char *value)
+{
+    return agxset_ref(obj, sym, agstrref(agraphof(obj), value));
+}
+
 int agsafeset(void *obj, char *name, const char *value, const char *def) {
     Agsym_t *a;
 
@@ -0,0 +1,98 @@
+/**
+ * @file
+ * @brief adding nodes and edges to graphs in bulk, API: cgraph.h
+ * @ingroup cgraph_core
+ */
+/*************************************************************************
+ * Copyright (c) 2011 AT&T Intellectual Property
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * https://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors: Details at https://graphviz.org
+ *************************************************************************/
+
+#include <cgraph/cghdr.h>
+#include <cgraph/node_set.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <util/alloc.h>
+
+int agbuild(Agraph_t *g, size_t nnodes, const char *const *names,
+            size_t nedges, const size_t *ends, size_t ncolumns,
+            const Agcolumn_t *columns, Agnode_t **nodes, Agedge_t **edges) {
+  Agraph_t *root = agroot(g);
+
+  // check everything before changing anything
+  for (size_t i = 0; i < 2 * nedges; ++i) {
+    if (ends[i] >= nnodes) {
+      agerrorf("agbuild: edge %zu has end %zu, but there are %zu nodes\n",
+               i / 2, ends[i], nnodes);
+      return -1;
+    }
+  }
+  for (size_t i = 0; i < ncolumns; ++i) {
+    if ((columns[i].kind != AGNODE && columns[i].kind != AGEDGE) ||
+        columns[i].name == NULL || columns[i].values == NULL) {
+      agerrorf("agbuild: invalid attribute column %zu\n", i);
+      return -1;
+    }
+  }
+
+  // declare attributes first, so records are made the right size
+  Agsym_t **syms = gv_calloc(ncolumns, sizeof(syms[0]));
+  for (size_t i = 0; i < ncolumns; ++i) {
+    char *name = (char *)columns[i].name;
+    syms[i] = agattr(root, columns[i].kind, name, NULL);
+    if (syms[i] == NULL) {
+      syms[i] = agattr(root, columns[i].kind, name, "");
+    }
+  }
+
+  Agnode_t **n = nodes ? nodes : gv_calloc(nnodes, sizeof(n[0]));
+  Agedge_t **e = edges ? edges : gv_calloc(nedges, sizeof(e[0]));
+
+  for (Agraph_t *sg = g; sg != NULL; sg = agparent(sg)) {
+    node_set_reserve(sg->n_id, node_set_size(sg->n_id) + nnodes);
+  }
+  int rc = 0;
+  for (size_t i = 0; i < nnodes; ++i) {
+    n[i] = agnode(g, (char *)names[i], 1);
+    if (n[i] == NULL) {
+      rc = -1;
+    }
+  }
+
+  if (rc == 0) {
+    Agnode_t **tails = gv_calloc(nedges, sizeof(tails[0]));
+    Agnode_t **heads = gv_calloc(nedges, sizeof(heads[0]));
+    for (size_t i = 0; i < nedges; ++i) {
+      tails[i] = n[ends[2 * i]];
+      heads[i] = n[ends[2 * i + 1]];
+    }
+    agbuildedges(g, nedges, tails, heads, e);
+    free(heads);
+    free(tails);
+
+    for (size_t i = 0; i < ncolumns; ++i) {
+      const bool node = columns[i].kind == AGNODE;
+      for (size_t j = 0; j < (node ? nnodes : nedges); ++j) {
+        void *obj = node ? (void *)n[j] : (void *)e[j];
+        if (obj != NULL && columns[i].values[j] != NULL) {
+          agxset(obj, syms[i], columns[i].values[j]);
+        }
+      }
+    }
+  }
+
+  if (e != edges) {
+    free(e);
+  }
+  if (n != nodes) {
+    free(n);
+  }
+  free(syms);
+  return rc;
+}
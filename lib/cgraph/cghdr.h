@@ -39,6 +39,7 @@
 #include		<string.h>
 #include <assert.h>
 #include <stdint.h>
+#include <util/tls.h>
 
 #define	SUCCESS				0
 #define FAILURE				-1
@@ -54,7 +55,9 @@ CGHDR_API int agapply(Agraph_t * g, Agobj_t * obj, agobjfn_t fn, void *arg,
 	    int preorder);
 
 	/* global variables */
-extern Agraph_t *Ag_G_global;
+/// graph being read or freed; per thread, so one thread can read graphs while
+/// another works on those it has already read
+extern TLS Agraph_t *Ag_G_global;
 extern char *AgDataRecName;
 
 	/* set ordering disciplines */
@@ -72,6 +75,15 @@ int agstrclose(Agraph_t * g);
 
 	/* ref string management */
 void agmarkhtmlstr(char *s);
+/// copy `len` bytes of `s` without entering them in a string dictionary
+///
+/// The copy can be passed where a string from @ref agstrdup is expected. It
+/// is entered in the dictionary by whatever keeps it.
+char *agstrdup_unbound(const char *s, size_t len);
+/// release a string from @ref agstrdup_unbound or from @ref agstrdup
+int agstrfree_unbound(Agraph_t *g, char *s);
+/// release every string from @ref agstrdup_unbound not yet released
+void agstrclose_unbound(void);
 
 /// Mask of `Agtag_s.seq` width
 enum { SEQ_MASK = (1 << (sizeof(unsigned) * 8 - 4)) - 1 };
@@ -125,6 +137,15 @@ void agregister(Agraph_t * g, int objtype, void *obj);
 
 	/* internal set operations */
 void agedgesetop(Agraph_t * g, Agedge_t * e, int insertion);
+/// make anonymous edges in bulk, for @ref agbuild
+///
+/// The result is as if `agedge(g, tails[i], heads[i], NULL, 1)` were called
+/// for each edge in turn, except that init callbacks are only called once all
+/// of the edges exist.
+///
+/// @param edges [out] - the edge made or found for each pair of nodes
+void agbuildedges(Agraph_t *g, size_t n, Agnode_t **tails, Agnode_t **heads,
+                  Agedge_t **edges);
 void agdelnodeimage(Agraph_t * g, Agnode_t * node, void *ignored);
 void agdeledgeimage(Agraph_t * g, Agedge_t * edge, void *ignored);
 CGHDR_API int agrename(Agobj_t * obj, char *newname);
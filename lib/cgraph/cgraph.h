@@ -95,6 +95,7 @@ typedef struct Agedgepair_s Agedgepair_t; ///< the edge object
 /// @{
 typedef struct Agiddisc_s Agiddisc_t; ///< object ID allocator
 typedef struct Agiodisc_s Agiodisc_t; ///< IO services
+typedef struct Agmemdisc_s Agmemdisc_t; ///< memory allocator
 typedef struct Agdisc_s Agdisc_t;     ///< union of client discipline methods
 /// @}
 /// @addtogroup cgraph_callback
@@ -164,6 +165,7 @@ typedef struct Agcbstack_s Agcbstack_t; ///< enclosing state for @ref Agcbdisc_t
 
 typedef struct Agsym_s Agsym_t;           ///< string attribute descriptors
 typedef struct Agattr_s Agattr_t;         ///< string attribute container
+typedef struct Agattrnum_s Agattrnum_t;   ///< numbers parsed from attributes
 typedef struct Agdatadict_s Agdatadict_t; ///< set of dictionaries per graph
 typedef struct Agrec_s Agrec_t;
 ///< generic header of @ref Agattr_s, @ref Agdatadict_s and user records
@@ -251,6 +253,8 @@ struct Agsubnode_s { /* the node-per-graph-or-subgraph record */
   Agnode_t *node;             /* the object */
   Dtlink_t *in_id, *out_id;   /* by node/ID for random access */
   Dtlink_t *in_seq, *out_seq; /* by node/sequence for serial access */
+  struct Agedgeseq_s *in_array, *out_array; /* in_seq and out_seq copied
+                                               into arrays for iteration */
 };
 
 struct Agnode_s {
@@ -328,18 +332,48 @@ struct Agiodisc_s {
                             /* error messages? */
 };
 
+/**
+ * @brief memory allocator discipline
+ *
+ * Every object of a graph and its subgraphs, the graph's strings and its
+ * attribute tables are allocated from the state `open` returns for the
+ * root graph. `alloc` returns zeroed memory, and `resize` zeroes any memory
+ * it adds. A NULL `free` means memory is only given back all at once by
+ * `close`, in which case @ref agclose releases a root graph without deleting
+ * its objects one by one, unless callbacks have been pushed with
+ * @ref agpushdisc. The ID discipline's `free` is then not called for each
+ * object either, only its `close`.
+ */
+struct Agmemdisc_s {
+  void *(*open)(Agdisc_t *); /* independent of other resources */
+  void *(*alloc)(void *state, size_t req);
+  void *(*resize)(void *state, void *ptr, size_t old, size_t req);
+  void (*free)(void *state, void *ptr);
+  void (*close)(void *state);
+};
+
 /// @brief user's discipline
 ///
 /// A default discipline is supplied when NULL is given for any of these fields.
 struct Agdisc_s {
   Agiddisc_t *id;
   Agiodisc_t *io;
+  Agmemdisc_t *mem;
 };
 
 /* default resource disciplines */
 
 CGRAPH_API extern Agiddisc_t AgIdDisc;
 CGRAPH_API extern Agiodisc_t AgIoDisc;
+CGRAPH_API extern Agmemdisc_t AgMemDisc;
+
+/// @brief allocates from large chunks, all released when the graph is closed
+///
+/// Memory given back by deleting an object is not reused, so this suits
+/// graphs that are built, used and closed, such as those read from a file,
+/// rather than graphs that are edited at length. It saves a system allocation
+/// per object, and closing such a graph does not delete objects one by one.
+CGRAPH_API extern Agmemdisc_t AgArenaMemDisc;
 
 CGRAPH_API extern Agdisc_t AgDefaultDisc;
 /// @}
@@ -358,6 +392,7 @@ CGRAPH_API extern Agdisc_t AgDefaultDisc;
 
 /// client state (closures)
 struct Agdstate_s {
+  void *mem;
   void *id;
   /* IO must be initialized and finalized outside Cgraph,
    * and channels (FILES) are passed as void* arguments. */
@@ -404,11 +439,14 @@ CGRAPH_API int agpopdisc(Agraph_t *g, Agcbdisc_t *disc);
 
 /// @}
 
+/// opaque type; the definition of this is internal to Graphviz
+struct graphviz_strdict;
+
 /// shared resources for Agraph_s
 struct Agclos_s {
   Agdisc_t disc;    /* resource discipline functions */
   Agdstate_t state; /* resource closures */
-  Dict_t *strdict;  /* shared string dict */
+  struct graphviz_strdict *strdict; /* shared string dict */
   uint64_t seq[3];  /* local object sequence number counter */
   Agcbstack_t *cb;  /* user and system callback function stacks */
   Dict_t *lookup_by_name[3];
@@ -470,6 +508,36 @@ CGRAPH_API Agraph_t *agconcat(Agraph_t *g, void *chan, Agdisc_t *disc);
  * the behavior is undefined.
  */
 
+/// a file mapped into memory, to read graphs from with @ref agmmapread
+typedef struct Agmmap_s Agmmap_t;
+
+CGRAPH_API Agmmap_t *agmmapopen(FILE *f);
+/**< @brief maps a file into memory for reading graphs from it
+ *
+ * Graphs read from a mapped file are scanned in place, rather than copied
+ * through an @ref Agiodisc_t channel, and names and values are only entered
+ * in the string dictionary once the graph keeps them. This makes reading
+ * large files faster than with @ref agread.
+ *
+ * @param f - a regular file opened for reading, which is read from its start
+ *   and can be closed once the file is mapped
+ * @return a mapped file, or NULL, with `errno` set, if `f` cannot be mapped
+ */
+
+CGRAPH_API Agraph_t *agmmapread(Agmmap_t *m, Agdisc_t *disc);
+/**< @brief reads the next graph in a mapped file
+ *
+ * This is as @ref agread, except that the `io` member of `disc` is not used.
+ * After a syntax error, no more graphs are read from the file. A graph in the
+ * gvb format is read as by @ref agmemreadgvb.
+ */
+
+CGRAPH_API Agraph_t *agmmapconcat(Agraph_t *g, Agmmap_t *m, Agdisc_t *disc);
+///< merges the next graph in a mapped file with a pre-existing graph
+
+CGRAPH_API void agmmapclose(Agmmap_t *m);
+///< unmaps a file mapped by @ref agmmapopen
+
 CGRAPH_API int agwrite(Agraph_t *g, void *chan);
 CGRAPH_API int agisdirected(Agraph_t *g);
 CGRAPH_API int agisundirected(Agraph_t *g);
@@ -594,6 +662,22 @@ CGRAPH_API char *agstrbind(Agraph_t *g, const char *);
 ///< returns a pointer to a reference-counted string if it exists, or NULL if
 ///< not
 
+CGRAPH_API char *agstrref(Agraph_t *g, const char *s);
+/**< @brief takes another reference to a string from @ref agstrdup
+ *
+ * This is @ref agstrdup for a string already interned for `g`, which is found
+ * from the hash stored with it rather than by hashing and comparing its text
+ * again. A string interned for another graph is copied as by @ref agstrdup.
+ * The result must be released with @ref agstrfree.
+ *
+ * For strings of no graph, `g` is NULL, and taking a reference does not lock
+ * the dictionary these share between threads. `s` must then be a string
+ * interned for no graph, on which the caller holds a reference.
+ *
+ * @param s - a string returned by @ref agstrdup, @ref agstrdup_html or
+ *   @ref agstrref
+ */
+
 CGRAPH_API int agstrfree(Agraph_t *, const char *);
 CGRAPH_API char *agcanon(char *str, int html);
 CGRAPH_API char *agstrcanon(char *, char *);
@@ -629,6 +713,7 @@ struct Agattr_s { /* dynamic string attributes */
   Agrec_t h;      /* common data header */
   Dict_t *dict;   ///< shared dict of Agsym_s to interpret Agattr_s.str
   char **str;     ///< the attribute string values indexed by Agsym_s.id
+  Agattrnum_t *num; ///< numbers parsed from Agattr_s.str, made on demand
 };
 
 /// @brief string attribute descriptor
@@ -712,8 +797,52 @@ CGRAPH_API void agclean(Agraph_t *g, int kind, char *rec_name);
 
 CGRAPH_API char *agget(void *obj, char *name);
 CGRAPH_API char *agxget(void *obj, Agsym_t *sym);
+
+CGRAPH_API bool agxget_double(void *obj, Agsym_t *sym, double *value);
+/**< @brief gets an attribute's value as a floating point number
+ *
+ * The value is parsed as by `strtod`. The result is kept with the object, so
+ * later calls do not parse it again until @ref agxset changes it.
+ *
+ * @param value [out] - the number, left unchanged if there is none
+ * @return false if the value is empty or does not start with a number
+ */
+
+CGRAPH_API bool agxget_int(void *obj, Agsym_t *sym, int *value);
+/**< @brief gets an attribute's value as an integer
+ *
+ * The value is parsed as by `strtol` in base 10, and is kept as by
+ * @ref agxget_double.
+ *
+ * @param value [out] - the number, left unchanged if there is none
+ * @return false if the value is empty, does not start with an integer or
+ *   is out of range of `int`
+ */
+
+CGRAPH_API size_t agxget_coords(void *obj, Agsym_t *sym, const double **coords);
+/**< @brief gets the numbers kept with a node's `pos` or a graph's `bb`
+ *
+ * A graph read by @ref agreadgvb keeps these as numbers, so that a layout
+ * reading them back need not parse them again. A node `pos` is kept as two
+ * numbers if it is of the form "x,y" or "x,y!", and a graph `bb` as four.
+ *
+ * @param coords [out] - the numbers, until the value is changed
+ * @return how many numbers are kept, or 0 if the value has none kept
+ */
+
 CGRAPH_API int agset(void *obj, char *name, const char *value);
 CGRAPH_API int agxset(void *obj, Agsym_t *sym, const char *value);
+
+CGRAPH_API int agxset_interned(void *obj, Agsym_t *sym, const char *value);
+/**< @brief sets an attribute's value to an interned string
+ *
+ * This is @ref agxset for a `value` returned by @ref agstrdup,
+ * @ref agstrdup_html or @ref agstrref for the graph of `obj`, which takes
+ * another reference to it with @ref agstrref rather than looking it up by its
+ * text. Setting many objects from a few interned strings avoids hashing the
+ * same text each time.
+ */
+
 CGRAPH_API int agsafeset(void *obj, char *name, const char *value,
                          const char *def);
 ///< @brief ensures the given attribute is declared
@@ -758,6 +887,162 @@ CGRAPH_API Agraph_t *agparent(Agraph_t *g);
 CGRAPH_API int agdelsubg(Agraph_t *g, Agraph_t *sub); /* could be agclose */
 /// @}
 
+/** @defgroup cgraph_build bulk construction
+ *  @brief adding many nodes and edges at once
+ *  @ingroup cgraph_graph
+ *
+ * @ref agbuild adds nodes, anonymous edges between them and their attribute
+ * values to a graph in one call, from arrays, for programs that make large
+ * graphs themselves rather than reading them. The graph is as if @ref agnode,
+ * @ref agedge and @ref agxset had been called for each node, edge and value
+ * in turn, but it is made faster: node tables are sized once, and the edge
+ * sets of nodes without edges are made whole rather than grown an edge at a
+ * time.
+ *
+ * @{
+ */
+
+/// values of one attribute, for the nodes or edges given to @ref agbuild
+typedef struct {
+  int kind;                  ///< @ref AGNODE or @ref AGEDGE
+  const char *name;          ///< attribute, declared if it is not already
+  const char *const *values; ///< a value for each node or edge, where a NULL
+                             ///< value leaves the default
+} Agcolumn_t;
+
+CGRAPH_API int agbuild(Agraph_t *g, size_t nnodes, const char *const *names,
+                       size_t nedges, const size_t *ends, size_t ncolumns,
+                       const Agcolumn_t *columns, Agnode_t **nodes,
+                       Agedge_t **edges);
+/**< @brief adds nodes and edges to a graph in bulk
+ *
+ * An attribute not yet declared is declared in the root graph, with an
+ * empty default value. A name of a node already in the graph gives that
+ * node. In a strict graph, an edge between nodes already joined gives the
+ * edge already joining them, and a loop in a graph without loops gives
+ * NULL, as for @ref agedge.
+ *
+ * @param g - graph or subgraph to add to
+ * @param names - name of each node
+ * @param ends - tail and head of each edge, as indices into `names`, so
+ *   `ends[2 * i]` and `ends[2 * i + 1]` for edge `i`
+ * @param columns - attribute values
+ * @param nodes [out] - the node of each name, or NULL if not wanted
+ * @param edges [out] - the edge made or found for each pair of ends, or
+ *   NULL if not wanted
+ * @return 0 on success, or -1 if an argument is invalid, in which case
+ *   nothing is added, or if a node cannot be made, in which case no edges
+ *   are added
+ */
+/// @}
+
+/** @defgroup cgraph_csr adjacency snapshots
+ *  @brief read-only compressed sparse row views of a graph
+ *  @ingroup cgraph_graph
+ *
+ * @ref agcsr copies the adjacency of a graph or subgraph into contiguous
+ * arrays, so that code making many passes over the edges can index them
+ * instead of stepping through @ref agfstout and @ref agnxtout each time.
+ *
+ * Nodes are numbered from 0 in the order @ref agfstnode visits them. The
+ * out-edges of each node are in the order @ref agfstout visits them, and its
+ * in-edges are ordered by the number of their tail. A loop is both an out-edge
+ * and an in-edge of its node. In an undirected graph, out-edges and in-edges
+ * are as the edges were created, as for @ref agfstout and @ref agfstin.
+ *
+ * A snapshot does not follow later changes to the graph. It must be freed
+ * with @ref agcsrfree before any node or edge it refers to is deleted, and
+ * may be read by several threads at once.
+ *
+ * @{
+ */
+
+/// a read-only snapshot of the adjacency of a graph
+typedef struct {
+  size_t nnodes;    ///< number of nodes
+  size_t nedges;    ///< number of edges
+  Agnode_t **node;  ///< the node of each number
+  IDTYPE *seq;      ///< the @ref AGSEQ of each node, in increasing order
+  size_t *out;      ///< out-edges of node `i` are `out[i]` to `out[i + 1] - 1`
+  size_t *head;     ///< number of the head of each out-edge
+  Agedge_t **edge;  ///< each out-edge
+  double *weight;   ///< weight of each out-edge, or NULL if not requested
+  size_t *in;       ///< in-edges of node `i` are `in[i]` to `in[i + 1] - 1`
+  size_t *tail;     ///< number of the tail of each in-edge
+  size_t *in_edge;  ///< index of each in-edge in the out-edge arrays
+} Agcsr_t;
+
+CGRAPH_API Agcsr_t *agcsr(Agraph_t *g, Agsym_t *weight, double dflt);
+/**< @brief takes a snapshot of the adjacency of a graph or subgraph
+ *
+ * @param g - graph or subgraph whose nodes and edges to take
+ * @param weight - edge attribute to read weights from, parsed as by
+ *   @ref agxget_double, or NULL for no weights
+ * @param dflt - weight of an edge whose attribute is not a number
+ * @return the snapshot, to be freed with @ref agcsrfree
+ */
+
+CGRAPH_API bool agcsrindex(const Agcsr_t *csr, Agnode_t *n, size_t *index);
+/**< @brief finds the number of a node in a snapshot
+ *
+ * @param index [out] - the number, left unchanged if there is none
+ * @return false if the node is not in the snapshot
+ */
+
+CGRAPH_API void agcsrfree(Agcsr_t *csr);
+///< frees a snapshot taken by @ref agcsr
+/// @}
+
+/** @defgroup cgraph_gvb binary graphs
+ *  @brief reading and writing graphs in the gvb format
+ *  @ingroup cgraph_graph
+ *
+ * gvb is a binary form of a graph, for graphs that are written once and read
+ * many times, such as laid out graphs kept to be rendered later. Rather than
+ * text to be scanned, it holds a table of the graph's strings, the nodes,
+ * edges and subgraphs as numbers, a column of values for each attribute, and
+ * the numbers of node `pos` and graph `bb` values, so reading a graph is
+ * mostly a matter of checking indices. The graph read is as @ref agwrite and
+ * @ref agread would give, with the same nodes, edges, subgraphs and values in
+ * the same order.
+ *
+ * Numbers are written in the byte order of the machine writing them, and a
+ * machine of another byte order cannot read them.
+ *
+ * @{
+ */
+
+CGRAPH_API int agwritegvb(Agraph_t *g, void *chan,
+                          size_t (*write)(void *chan, const void *data,
+                                          size_t size));
+/**< @brief writes a graph in the gvb format
+ *
+ * @param write - function to write `size` bytes to `chan`, returning how
+ *   many were written, or NULL if `chan` is a stdio `FILE` pointer
+ * @return 0 on success, or EOF if writing fails
+ */
+
+CGRAPH_API Agraph_t *agreadgvb(FILE *f, Agdisc_t *disc);
+/**< @brief reads the next graph in the gvb format from a file
+ *
+ * @return the graph, or NULL at the end of the file or if the graph is not
+ *   valid, which is reported with @ref agerr
+ */
+
+CGRAPH_API Agraph_t *agmemreadgvb(const void *data, size_t size, size_t *used,
+                                  Agdisc_t *disc);
+/**< @brief reads a graph in the gvb format from memory
+ *
+ * Names and values are copied from `data` as the graph needs them, so `data`
+ * can be freed once the graph is read.
+ *
+ * @param used [out] - how many bytes of `data` the graph took, if not NULL
+ */
+
+CGRAPH_API bool agisgvb(const void *data, size_t size);
+///< tells whether data starts with a graph in the gvb format
+/// @}
+
 /** @defgroup cgraph_misc miscellaneous
  *  @ingroup cgraph_api
  *  @{
@@ -0,0 +1,167 @@
+/**
+ * @file
+ * @brief read-only compressed sparse row snapshots of graphs, API: cgraph.h
+ * @ingroup cgraph_core
+ */
+/*************************************************************************
+ * Copyright (c) 2011 AT&T Intellectual Property
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * https://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors: Details at https://graphviz.org
+ *************************************************************************/
+
+#include <assert.h>
+#include <cgraph/cghdr.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <util/alloc.h>
+
+/// find the number of the node with the given sequence number
+static bool seqindex(const Agcsr_t *csr, IDTYPE seq, size_t *index) {
+  size_t lo = 0;
+  size_t hi = csr->nnodes;
+  while (lo < hi) {
+    const size_t mid = lo + (hi - lo) / 2;
+    if (csr->seq[mid] < seq) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  if (lo == csr->nnodes || csr->seq[lo] != seq) {
+    return false;
+  }
+  *index = lo;
+  return true;
+}
+
+/// read an edge's weight, with the rules of agxget_double
+///
+/// This parses the value rather than calling agxget_double, so as not to give
+/// every edge a cache of numbers for one read.
+static double edgeweight(Agedge_t *e, Agsym_t *weight, double dflt) {
+  const char *s = agxget(e, weight);
+  if (s == NULL || *s == '\0') {
+    return dflt;
+  }
+  char *endp;
+  const double w = strtod(s, &endp);
+  return endp == s ? dflt : w;
+}
+
+Agcsr_t *agcsr(Agraph_t *g, Agsym_t *weight, double dflt) {
+  Agcsr_t *csr = gv_alloc(sizeof(Agcsr_t));
+  const size_t nnodes = csr->nnodes = (size_t)agnnodes(g);
+  const size_t nedges = csr->nedges = (size_t)agnedges(g);
+
+  // nodes come in sequence order, so numbering them sorts their sequence
+  // numbers
+  csr->node = gv_calloc(nnodes, sizeof(csr->node[0]));
+  csr->seq = gv_calloc(nnodes, sizeof(csr->seq[0]));
+  size_t i = 0;
+  for (Agnode_t *n = agfstnode(g); n != NULL; n = agnxtnode(g, n), ++i) {
+    csr->node[i] = n;
+    csr->seq[i] = AGSEQ(n);
+  }
+  assert(i == nnodes);
+
+  // Where few nodes have been deleted, or the subgraph holds most of the
+  // root's nodes, look heads up in a table rather than by binary search.
+  size_t *dense = NULL;
+  IDTYPE base = 0;
+  if (nnodes > 0) {
+    base = csr->seq[0];
+    const IDTYPE range = csr->seq[nnodes - 1] - base + 1;
+    if (range <= 2 * (IDTYPE)nnodes) {
+      dense = gv_calloc((size_t)range, sizeof(dense[0]));
+      for (i = 0; i < nnodes; ++i) {
+        dense[csr->seq[i] - base] = i;
+      }
+    }
+  }
+
+  csr->out = gv_calloc(nnodes + 1, sizeof(csr->out[0]));
+  csr->head = gv_calloc(nedges, sizeof(csr->head[0]));
+  csr->edge = gv_calloc(nedges, sizeof(csr->edge[0]));
+  if (weight != NULL) {
+    csr->weight = gv_calloc(nedges, sizeof(csr->weight[0]));
+  }
+  csr->in = gv_calloc(nnodes + 1, sizeof(csr->in[0]));
+  size_t k = 0;
+  for (i = 0; i < nnodes; ++i) {
+    csr->out[i] = k;
+    for (Agedge_t *e = agfstout(g, csr->node[i]); e != NULL;
+         e = agnxtout(g, e), ++k) {
+      assert(k < nedges);
+      const IDTYPE seq = AGSEQ(aghead(e));
+      size_t h;
+      if (dense != NULL) {
+        h = dense[seq - base];
+      } else {
+        const bool found = seqindex(csr, seq, &h);
+        assert(found && "edge whose head is not in the graph");
+        (void)found;
+      }
+      csr->head[k] = h;
+      csr->edge[k] = e;
+      if (weight != NULL) {
+        csr->weight[k] = edgeweight(e, weight, dflt);
+      }
+      ++csr->in[h + 1];
+    }
+  }
+  csr->out[nnodes] = k;
+  assert(k == nedges);
+  free(dense);
+
+  // in-edges, by counting sort of the out-edges on their heads
+  for (i = 0; i < nnodes; ++i) {
+    csr->in[i + 1] += csr->in[i];
+  }
+  csr->tail = gv_calloc(nedges, sizeof(csr->tail[0]));
+  csr->in_edge = gv_calloc(nedges, sizeof(csr->in_edge[0]));
+  size_t *next = gv_calloc(nnodes, sizeof(next[0]));
+  for (i = 0; i < nnodes; ++i) {
+    next[i] = csr->in[i];
+  }
+  for (i = 0; i < nnodes; ++i) {
+    for (k = csr->out[i]; k < csr->out[i + 1]; ++k) {
+      const size_t j = next[csr->head[k]]++;
+      csr->tail[j] = i;
+      csr->in_edge[j] = k;
+    }
+  }
+  free(next);
+
+  return csr;
+}
+
+bool agcsrindex(const Agcsr_t *csr, Agnode_t *n, size_t *index) {
+  size_t i;
+  // the sequence number of a node from another root graph can match
+  if (!seqindex(csr, AGSEQ(n), &i) || csr->node[i] != n) {
+    return false;
+  }
+  *index = i;
+  return true;
+}
+
+void agcsrfree(Agcsr_t *csr) {
+  if (csr == NULL) {
+    return;
+  }
+  free(csr->node);
+  free(csr->seq);
+  free(csr->out);
+  free(csr->head);
+  free(csr->edge);
+  free(csr->weight);
+  free(csr->in);
+  free(csr->tail);
+  free(csr->in_edge);
+  free(csr);
+}
@@ -18,6 +18,95 @@
 #include <cgraph/node_set.h>
 #include <stddef.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <util/alloc.h>
+
+/* iteration:
+ * The first time a node's out- or in-edges in a graph are visited, they are
+ * copied in sequence into an array kept with the node's Agsubnode_t, and later
+ * visits walk the array rather than the set's tree. The array remembers the
+ * edge it last returned, so agnxtout and agnxtin need not search for it. Any
+ * change to the set discards the array. A caller that changes the set while
+ * visiting it, or visits it twice at once, goes on in the tree. Arrays are
+ * only made when the graph's memory discipline can free them.
+ */
+struct Agedgeseq_s {
+    size_t size;	/* number of edges */
+    size_t at;		/* index of the edge last returned */
+    Agedge_t *edge[];	/* the edges, in sequence */
+};
+
+/* copy an edge set into an array, in sequence */
+static struct Agedgeseq_s *seqarray(Agraph_t * g, Dtlink_t ** set)
+{
+    struct Agedgeseq_s *array;
+    Dtlink_t **stack, *l;
+    size_t size, depth = 0, i = 0;
+
+    dtrestore(g->e_seq, *set);
+    size = (size_t) dtsize(g->e_seq);
+    *set = dtextract(g->e_seq);
+
+    array = agalloc(g, sizeof(struct Agedgeseq_s) + size * sizeof(Agedge_t *));
+    array->size = size;
+    /* walk the tree in order, without changing its shape */
+    stack = gv_calloc(size, sizeof(Dtlink_t *));
+    for (l = *set; l || depth > 0; l = l->right) {
+	for (; l; l = l->hl._left)
+	    stack[depth++] = l;
+	l = stack[--depth];
+	array->edge[i++] = dtobj(g->e_seq, l);
+    }
+    assert(i == size);
+    free(stack);
+    return array;
+}
+
+/* discard the array of a set that is about to change */
+static void dropseq(Agraph_t * g, struct Agedgeseq_s **array)
+{
+    if (*array) {
+	agfree(g, *array);
+	*array = NULL;
+    }
+}
+
+static Agedge_t *fstseq(Agraph_t * g, Dtlink_t ** set,
+			struct Agedgeseq_s **array)
+{
+    Agedge_t *e;
+
+    if (*set == NULL)
+	return NULL;
+    if (*array == NULL && AGDISC(g, mem)->free)
+	*array = seqarray(g, set);
+    if (*array) {
+	(*array)->at = 0;
+	return (*array)->edge[0];
+    }
+    dtrestore(g->e_seq, *set);
+    e = dtfirst(g->e_seq);
+    *set = dtextract(g->e_seq);
+    return e;
+}
+
+static Agedge_t *nxtseq(Agraph_t * g, Dtlink_t ** set,
+			struct Agedgeseq_s *array, Agedge_t * e)
+{
+    Agedge_t *f;
+
+    if (array && array->at < array->size && array->edge[array->at] == e) {
+	if (++array->at < array->size)
+	    return array->edge[array->at];
+	return NULL;
+    }
+    dtrestore(g->e_seq, *set);
+    f = dtnext(g->e_seq, e);
+    *set = dtextract(g->e_seq);
+    return f;
+}
 
 /* return first outedge of <n> */
 Agedge_t *agfstout(Agraph_t * g, Agnode_t * n)
@@ -26,11 +115,8 @@ Agedge_t *agfstout(Agraph_t * g, Agnode_t * n)
     Agedge_t *e = NULL;
 
     sn = agsubrep(g, n);
-    if (sn) {
-		dtrestore(g->e_seq, sn->out_seq);
-		e = dtfirst(g->e_seq);
-		sn->out_seq = dtextract(g->e_seq);
-	}
+    if (sn)
+	e = fstseq(g, &sn->out_seq, &sn->out_array);
     return e;
 }
 
@@ -43,11 +129,8 @@ Agedge_t *agnxtout(Agraph_t * g, Agedge_t * e)
 
     n = AGTAIL(e);
     sn = agsubrep(g, n);
-    if (sn) {
-		dtrestore(g->e_seq, sn->out_seq);
-		f = dtnext(g->e_seq, e);
-		sn->out_seq = dtextract(g->e_seq);
-	}
+    if (sn)
+	f = nxtseq(g, &sn->out_seq, sn->out_array, e);
     return f;
 }
 
@@ -57,11 +140,8 @@ Agedge_t *agfstin(Agraph_t * g, Agnode_t * n)
     Agedge_t *e = NULL;
 
     sn = agsubrep(g, n);
-	if (sn) {
-		dtrestore(g->e_seq, sn->in_seq);
-		e = dtfirst(g->e_seq);
-		sn->in_seq = dtextract(g->e_seq);
-	}
+    if (sn)
+	e = fstseq(g, &sn->in_seq, &sn->in_array);
     return e;
 }
 
@@ -73,12 +153,9 @@ Agedge_t *agnxtin(Agraph_t * g, Agedge_t * e)
 
     n = AGHEAD(e);
     sn = agsubrep(g, n);
-	if (sn) {
-		dtrestore(g->e_seq, sn->in_seq);
-		f = dtnext(g->e_seq, e);
-		sn->in_seq = dtextract(g->e_seq);
-	}
-	return f;
+    if (sn)
+	f = nxtseq(g, &sn->in_seq, sn->in_array, e);
+    return f;
 }
 
 Agedge_t *agfstedge(Agraph_t * g, Agnode_t * n)
@@ -176,9 +253,11 @@ static void installedge(Agraph_t * g, Agedge_t * e)
     while (g) {
 	if (agfindedge_by_key(g, t, h, AGTAG(e))) break;
 	sn = agsubrep(g, t);
+	dropseq(g, &sn->out_array);
 	ins(g->e_seq, &sn->out_seq, out);
 	ins(g->e_id, &sn->out_id, out);
 	sn = agsubrep(g, h);
+	dropseq(g, &sn->in_array);
 	ins(g->e_seq, &sn->in_seq, in);
 	ins(g->e_id, &sn->in_id, in);
 	g = agparent(g);
@@ -191,14 +270,13 @@ static void subedge(Agraph_t * g, Agedge_t * e)
     /* might an init method call be needed here? */
 }
 
-static Agedge_t *newedge(Agraph_t * g, Agnode_t * t, Agnode_t * h,
+/* allocate an edge, without installing it in any graph */
+static Agedge_t *allocedge(Agraph_t * g, Agnode_t * t, Agnode_t * h,
              IDTYPE id)
 {
     Agedgepair_t *e2;
     Agedge_t *in, *out;
 
-    (void)agsubnode(g, t, 1);
-    (void)agsubnode(g, h, 1);
     e2 = agalloc(g, sizeof(Agedgepair_t));
     in = &(e2->in);
     out = &(e2->out);
@@ -210,6 +288,17 @@ static Agedge_t *newedge(Agraph_t * g, Agnode_t * t, Agnode_t * h,
     AGSEQ(in) = AGSEQ(out) = seq & SEQ_MASK;
     in->node = t;
     out->node = h;
+    return out;
+}
+
+static Agedge_t *newedge(Agraph_t * g, Agnode_t * t, Agnode_t * h,
+             IDTYPE id)
+{
+    Agedge_t *out;
+
+    (void)agsubnode(g, t, 1);
+    (void)agsubnode(g, h, 1);
+    out = allocedge(g, t, h, id);
 
     installedge(g, out);
     if (g->desc.has_attrs) {
@@ -301,6 +390,248 @@ Agedge_t *agedge(Agraph_t * g, Agnode_t * t, Agnode_t * h, char *name,
     return e;
 }
 
+/* bulk edge creation:
+ * agbuildedges makes many anonymous edges at once. Where a node had no edges
+ * on one side before, the root graph's sets for that side are not grown one
+ * insertion at a time. They are made at the end, from the new edges sorted
+ * into the sets' orders and linked into a chain down the right. A chain is a
+ * valid, if unbalanced, tree for cdt, and the first searches splay it into
+ * shape. The sets of other sides get their edges by insertion, as usual.
+ */
+
+/* an edge half, with its key in one of its node's sets */
+typedef struct {
+    Agedge_t *e;
+    IDTYPE other;	/* AGSEQ or AGID of the node at the other end */
+    IDTYPE self;	/* AGSEQ or AGID of the edge */
+} edgekey_t;
+
+static int edgekeycmpf(const void *x, const void *y)
+{
+    const edgekey_t *a = x;
+    const edgekey_t *b = y;
+
+    if (a->other != b->other) return a->other < b->other ? -1 : 1;
+    if (a->self != b->self) return a->self < b->self ? -1 : 1;
+    return 0;
+}
+
+/* sort the keys of one node's set, and link them into a chain */
+static void linkset(edgekey_t * keys, size_t n, size_t link, Dtlink_t ** set)
+{
+    edgekey_t key;
+    Dtlink_t *l, *prev = NULL;
+    size_t i, j;
+
+    if (n > 16) {
+	qsort(keys, n, sizeof(edgekey_t), edgekeycmpf);
+    } else {
+	/* most nodes have few edges, and this is quicker for those */
+	for (i = 1; i < n; i++) {
+	    key = keys[i];
+	    for (j = i; j > 0 && edgekeycmpf(&keys[j - 1], &key) > 0; j--)
+		keys[j] = keys[j - 1];
+	    keys[j] = key;
+	}
+    }
+    for (i = 0; i < n; i++) {
+	l = (Dtlink_t *) ((char *) keys[i].e + link);
+	l->right = NULL;
+	l->hl._left = NULL;
+	if (prev)
+	    prev->right = l;
+	else
+	    *set = l;
+	prev = l;
+    }
+}
+
+/* make the sets of the new edges that are still empty */
+static void buildsets(Agedge_t ** made, size_t n)
+{
+    Agnode_t *v;
+    Agedge_t *e;
+    Agsubnode_t *sn;
+    edgekey_t *keys;
+    size_t *count, *order;
+    size_t i, j, k, b, nbuckets = 1;
+    int out;
+
+    for (i = 0; i < n; i++) {
+	if ((size_t) AGSEQ(agtail(made[i])) + 2 > nbuckets)
+	    nbuckets = (size_t) AGSEQ(agtail(made[i])) + 2;
+	if ((size_t) AGSEQ(aghead(made[i])) + 2 > nbuckets)
+	    nbuckets = (size_t) AGSEQ(aghead(made[i])) + 2;
+    }
+    count = gv_calloc(nbuckets, sizeof(size_t));
+    order = gv_calloc(n, sizeof(size_t));
+    keys = gv_calloc(n, sizeof(edgekey_t));
+    for (out = 1; out >= 0; out--) {
+	/* group the edges by the node whose set they go in, by counting sort */
+	memset(count, 0, nbuckets * sizeof(size_t));
+	k = 0;
+	for (i = 0; i < n; i++) {
+	    v = out ? agtail(made[i]) : aghead(made[i]);
+	    if ((out ? v->mainsub.out_seq : v->mainsub.in_seq) == NULL) {
+		count[AGSEQ(v) + 1]++;
+		k++;
+	    }
+	}
+	for (b = 1; b < nbuckets; b++)
+	    count[b] += count[b - 1];
+	for (i = 0; i < n; i++) {
+	    v = out ? agtail(made[i]) : aghead(made[i]);
+	    if ((out ? v->mainsub.out_seq : v->mainsub.in_seq) == NULL)
+		order[count[AGSEQ(v)]++] = i;
+	}
+
+	/* then sort each group into the orders of the node's two sets */
+	for (i = 0; i < k; i = j) {
+	    v = out ? agtail(made[order[i]]) : aghead(made[order[i]]);
+	    sn = &v->mainsub;
+	    for (j = i; j < k; j++) {
+		e = out ? made[order[j]] : AGMKIN(made[order[j]]);
+		if ((out ? agtail(e) : aghead(e)) != v)
+		    break;
+		keys[j - i].e = e;
+		keys[j - i].other = AGSEQ(e->node);
+		keys[j - i].self = AGSEQ(e);
+	    }
+	    linkset(keys, j - i, offsetof(Agedge_t, seq_link),
+		    out ? &sn->out_seq : &sn->in_seq);
+	    for (b = 0; b < j - i; b++) {
+		keys[b].other = AGID(keys[b].e->node);
+		keys[b].self = AGID(keys[b].e);
+	    }
+	    linkset(keys, j - i, offsetof(Agedge_t, id_link),
+		    out ? &sn->out_id : &sn->in_id);
+	}
+    }
+    free(keys);
+    free(order);
+    free(count);
+}
+
+/* a pair of nodes to join, for finding repeats in a strict graph */
+typedef struct {
+    uint64_t a, b;	/* AGSEQ of the nodes */
+    size_t i;		/* which of the edges asked for */
+} nodepair_t;
+
+static int nodepaircmpf(const void *x, const void *y)
+{
+    const nodepair_t *p = x;
+    const nodepair_t *q = y;
+
+    if (p->a != q->a) return p->a < q->a ? -1 : 1;
+    if (p->b != q->b) return p->b < q->b ? -1 : 1;
+    if (p->i != q->i) return p->i < q->i ? -1 : 1;
+    return 0;
+}
+
+/* for each edge asked for, the first asked for that joins the same nodes */
+static size_t *firstedges(Agraph_t * g, Agnode_t ** tails,
+			  Agnode_t ** heads, size_t n)
+{
+    nodepair_t *pairs;
+    size_t *first;
+    size_t i, j;
+
+    pairs = gv_calloc(n, sizeof(nodepair_t));
+    for (i = 0; i < n; i++) {
+	pairs[i].a = AGSEQ(tails[i]);
+	pairs[i].b = AGSEQ(heads[i]);
+	if (agisundirected(g) && pairs[i].a > pairs[i].b) {
+	    pairs[i].a = AGSEQ(heads[i]);
+	    pairs[i].b = AGSEQ(tails[i]);
+	}
+	pairs[i].i = i;
+    }
+    qsort(pairs, n, sizeof(nodepair_t), nodepaircmpf);
+    first = gv_calloc(n, sizeof(size_t));
+    for (i = 0; i < n; i = j) {
+	for (j = i; j < n && pairs[j].a == pairs[i].a
+	     && pairs[j].b == pairs[i].b; j++)
+	    first[pairs[j].i] = pairs[i].i;
+    }
+    free(pairs);
+    return first;
+}
+
+void agbuildedges(Agraph_t * g, size_t n, Agnode_t ** tails,
+		  Agnode_t ** heads, Agedge_t ** edges)
+{
+    Agraph_t *root;
+    Agedge_t *e, **made;
+    Agsubnode_t *sn;
+    Agtag_t key = {0};
+    size_t *first = NULL;
+    size_t i, nmade = 0;
+    IDTYPE id;
+
+    root = agroot(g);
+    if (agisstrict(g))
+	first = firstedges(g, tails, heads, n);
+    made = gv_calloc(n, sizeof(Agedge_t *));
+    for (i = 0; i < n; i++) {
+	Agnode_t *t = tails[i];
+	Agnode_t *h = heads[i];
+
+	edges[i] = NULL;
+	if (g->desc.no_loop && t == h)
+	    continue;
+	if (first) {
+	    /* as agedge would, return the edge already joining the nodes */
+	    if (first[i] != i) {
+		edges[i] = edges[first[i]];
+		continue;
+	    }
+	    e = agfindedge_by_key(root, t, h, key);
+	    if (e == NULL && agisundirected(g))
+		e = agfindedge_by_key(root, h, t, key);
+	    if (e) {
+		if (g != root)
+		    subedge(g, e);
+		edges[i] = e;
+		continue;
+	    }
+	}
+	if (!agmapnametoid(g, AGEDGE, NULL, &id, true))
+	    continue;
+	e = allocedge(g, t, h, id);
+	sn = &t->mainsub;
+	if (sn->out_seq) {
+	    dropseq(root, &sn->out_array);
+	    ins(root->e_seq, &sn->out_seq, e);
+	    ins(root->e_id, &sn->out_id, e);
+	}
+	sn = &h->mainsub;
+	if (sn->in_seq) {
+	    dropseq(root, &sn->in_array);
+	    ins(root->e_seq, &sn->in_seq, AGMKIN(e));
+	    ins(root->e_id, &sn->in_id, AGMKIN(e));
+	}
+	if (g->desc.has_attrs) {
+	    (void)agbindrec(e, AgDataRecName, sizeof(Agattr_t), false);
+	    agedgeattr_init(g, e);
+	}
+	made[nmade++] = edges[i] = e;
+    }
+    buildsets(made, nmade);
+
+    for (i = 0; i < nmade; i++) {
+	if (g != root) {
+	    (void)agsubnode(g, agtail(made[i]), 1);
+	    (void)agsubnode(g, aghead(made[i]), 1);
+	    installedge(g, made[i]);
+	}
+	agmethod_init(g, made[i]);
+	agregister(g, AGEDGE, made[i]);
+    }
+    free(made);
+    free(first);
+}
+
 void agdeledgeimage(Agraph_t * g, Agedge_t * e, void *ignored)
 {
     Agedge_t *in, *out;
@@ -318,9 +649,11 @@ void agdeledgeimage(Agraph_t * g, Agedge_t * e, void *ignored)
     t = in->node;
     h = out->node;
     sn = agsubrep(g, t);
+    dropseq(g, &sn->out_array);
     del(g->e_seq, &sn->out_seq, out);
     del(g->e_id, &sn->out_id, out);
     sn = agsubrep(g, h);
+    dropseq(g, &sn->in_array);
     del(g->e_seq, &sn->in_seq, in);
     del(g->e_id, &sn->in_id, in);
 #ifdef DEBUG
@@ -27,6 +27,7 @@
 #include <cghdr.h>
 #include <cgraph/agxbuf.h>
 #include <stddef.h>
+#include <stdlib.h>
 #include <util/alloc.h>
 #include <util/streq.h>
 #include <util/unreachable.h>
@@ -202,7 +203,7 @@ qatom	:  T_qatom {$$ = $1;}
 
 static item *newitem(int tag, void *p0, char *p1)
 {
-	item	*rv = agalloc(G,sizeof(item));
+	item	*rv = gv_alloc(sizeof(item));
 	rv->tag = tag; rv->u.name = (char*)p0; rv->str = p1;
 	return rv;
 }
@@ -221,7 +222,7 @@ static item *cons_subg(Agraph_t *subg)
 
 static gstack_t *push(gstack_t *s, Agraph_t *subg) {
 	gstack_t *rv;
-	rv = agalloc(G,sizeof(gstack_t));
+	rv = gv_alloc(sizeof(gstack_t));
 	rv->down = s;
 	rv->g = subg;
 	return rv;
@@ -231,7 +232,7 @@ static gstack_t *pop(gstack_t *s)
 {
 	gstack_t *rv;
 	rv = s->down;
-	agfree(G,s);
+	free(s);
 	return rv;
 }
 
@@ -242,8 +243,9 @@ static void delete_items(item *ilist)
 	for (p = ilist; p; p = pn) {
 		pn = p->next;
 		if (p->tag == T_list) delete_items(p->u.list);
-		if (p->tag == T_atom) agstrfree(G,p->str);
-		agfree(G,p);
+		if (p->tag == T_atom || p->tag == T_attr || p->tag == T_node)
+			agstrfree_unbound(G,p->str);
+		free(p);
 	}
 }
 
@@ -283,7 +285,7 @@ static void bindattrs(int kind)
 		if ((aptr->u.asym = agattr(S->g,kind,name,NULL)) == NULL)
 			aptr->u.asym = agattr(S->g,kind,name,"");
 		aptr->tag = T_attr;				/* signifies bound attr */
-		agstrfree(G,name);
+		agstrfree_unbound(G,name);
 	}
 }
 
@@ -358,7 +360,7 @@ static void appendnode(char *name, char *port, char *sport)
 	}
 	elt = cons_node(agnode(S->g, name, 1), port);
 	listapp(&(S->nodelist),elt);
-	agstrfree(G,name);
+	agstrfree_unbound(G,name);
 }
 
 /* apply current optional attrs to nodelist and clean up lists */
@@ -444,8 +446,8 @@ concat (char* s1, char* s2)
   strcpy(sym,s1);
   strcat(sym,s2);
   s = agstrdup (G,sym);
-  agstrfree (G,s1);
-  agstrfree (G,s2);
+  agstrfree_unbound (G,s1);
+  agstrfree_unbound (G,s2);
   if (sym != buf) free (sym);
   return s;
 }
@@ -457,8 +459,8 @@ concatPort (char* s1, char* s2)
 
   agxbprint(&buf, "%s:%s", s1, s2);
   char *s = agstrdup(G, agxbuse(&buf));
-  agstrfree (G,s1);
-  agstrfree (G,s2);
+  agstrfree_unbound (G,s1);
+  agstrfree_unbound (G,s2);
   agxbfree(&buf);
   return s;
 }
@@ -524,7 +526,7 @@ static void startgraph(char *name, bool directed, bool strict)
 		Ag_G_global = G;
 	}
 	S = push(S,G);
-	agstrfree(NULL,name);
+	agstrfree_unbound(NULL,name);
 }
 
 static void endgraph(void)
@@ -539,7 +541,7 @@ static void opensubg(char *name)
     agerrorf("subgraphs nested more than %d deep", YYMAXDEPTH);
   }
 	S = push(S, agsubg(S->g, name, 1));
-	agstrfree(G,name);
+	agstrfree_unbound(G,name);
 }
 
 static void closesubg(void)
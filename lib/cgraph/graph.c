@@ -21,7 +21,7 @@
 #include <stdlib.h>
 #include <util/alloc.h>
 
-Agraph_t *Ag_G_global;
+TLS Agraph_t *Ag_G_global;
 
 /*
  * this code sets up the resource management discipline
@@ -33,6 +33,8 @@ static Agclos_t *agclos(Agdisc_t * proto)
 
     /* establish an allocation arena */
     rv = gv_calloc(1, sizeof(Agclos_t));
+    rv->disc.mem = ((proto && proto->mem) ? proto->mem : &AgMemDisc);
+    rv->state.mem = rv->disc.mem->open(proto);
     rv->disc.id = ((proto && proto->id) ? proto->id : &AgIdDisc);
     rv->disc.io = ((proto && proto->io) ? proto->io : &AgIoDisc);
     return rv;
@@ -92,6 +94,9 @@ Agraph_t *agopen1(Agraph_t * g)
 
 /*
  * Close a graph or subgraph, freeing its storage.
+ * A root graph whose memory discipline cannot free single objects is
+ * released in bulk: its nodes and edges are left in place for the
+ * discipline's close to reclaim along with everything else.
  */
 int agclose(Agraph_t * g)
 {
@@ -99,23 +104,26 @@ int agclose(Agraph_t * g)
     Agnode_t *n, *next_n;
 
     par = agparent(g);
+    const bool bulk = !par && !AGDISC(g, mem)->free && !g->clos->cb;
 
     for (subg = agfstsubg(g); subg; subg = next_subg) {
 	next_subg = agnxtsubg(subg);
 	agclose(subg);
     }
 
-    for (n = agfstnode(g); n; n = next_n) {
-	next_n = agnxtnode(g, n);
-	agdelnode(g, n);
+    if (!bulk) {
+	for (n = agfstnode(g); n; n = next_n) {
+	    next_n = agnxtnode(g, n);
+	    agdelnode(g, n);
+	}
     }
 
     aginternalmapclose(g);
     agmethod_delete(g, g);
 
-    assert(node_set_is_empty(g->n_id));
+    assert(bulk || node_set_is_empty(g->n_id));
     node_set_free(&g->n_id);
-    assert(dtsize(g->n_seq) == 0);
+    assert(bulk || dtsize(g->n_seq) == 0);
     if (agdtclose(g, g->n_seq)) return FAILURE;
 
     assert(dtsize(g->e_id) == 0);
@@ -143,6 +151,7 @@ int agclose(Agraph_t * g)
 	    agpopdisc(g, g->clos->cb->f);
 	AGDISC(g, id)->close(AGCLOS(g, id));
 	if (agstrclose(g)) return FAILURE;
+	AGDISC(g, mem)->close(AGCLOS(g, mem));
 	clos = g->clos;
 	free(g);
 	free(clos);
@@ -275,7 +284,7 @@ Agdesc_t Agstrictdirected = {.directed = true, .strict = true, .maingraph = true
 Agdesc_t Agundirected = {.maingraph = true};
 Agdesc_t Agstrictundirected = {.strict = true, .maingraph = true};
 
-Agdisc_t AgDefaultDisc = { &AgIdDisc, &AgIoDisc };
+Agdisc_t AgDefaultDisc = { &AgIdDisc, &AgIoDisc, &AgMemDisc };
 
 /**
  * @dir lib/cgraph
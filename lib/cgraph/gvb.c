@@ -0,0 +1,1013 @@
+/**
+ * @file
+ * @brief reading and writing graphs in the gvb binary format, API: cgraph.h
+ * @ingroup cgraph_core
+ *
+ * A gvb image holds one graph, as a header followed by sections of fixed size
+ * records, each padded to a multiple of 8 bytes:
+ *
+ *   strings    offset of each string in the text, whether each is HTML, and
+ *              the text, the NUL terminated strings one after another
+ *   nodes      name of each node
+ *   edges      tail and head of each edge, then the key of each edge
+ *   subgraphs  parent, name and numbers of nodes and edges of each subgraph,
+ *              in preorder, then the nodes and edges in each of them
+ *   attributes kind, name, default and flags of each attribute
+ *   values     a column of values for each node or edge attribute
+ *   locals     defaults set in subgraphs, which include their graph values
+ *   coords     numbers of node `pos` and graph `bb` values
+ *
+ * Names, keys and values are indices into the strings, or NONE for an
+ * anonymous object or a value that is the default. Nodes and edges are
+ * numbered in the order they were made. Numbers are in the byte order of the
+ * machine that wrote them, so that reading is a matter of checking indices
+ * and handing out pointers into the image, rather than of decoding it.
+ */
+/*************************************************************************
+ * Copyright (c) 2011 AT&T Intellectual Property
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * https://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors: Details at https://graphviz.org
+ *************************************************************************/
+
+#include <cgraph/cghdr.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <util/alloc.h>
+
+static const char MAGIC[8] = "\x89GVB\r\n\x1a\n";
+
+enum { VERSION = 1, BYTE_ORDER_MARK = 0x01020304 };
+
+/// index of no string, node or edge
+#define NONE UINT32_MAX
+
+enum { GVB_DIRECTED = 1, GVB_STRICT = 2, GVB_NO_LOOP = 4, GVB_MAINGRAPH = 8 };
+
+enum { ATTR_PRINT = 1, ATTR_FIXED = 2 };
+
+typedef struct {
+  char magic[8];
+  uint32_t version;
+  uint32_t byte_order; ///< BYTE_ORDER_MARK, as the writer stored it
+  uint64_t size;       ///< of the whole image, header included
+  uint32_t flags;      ///< GVB_DIRECTED etc.
+  uint32_t name;       ///< of the graph
+  uint32_t nstrings;
+  uint32_t strbytes; ///< length of the string text
+  uint32_t nnodes;
+  uint32_t nedges;
+  uint32_t nsubgraphs;
+  uint32_t nmembers; ///< nodes and edges of all subgraphs
+  uint32_t nattrs;
+  uint32_t nvalues; ///< in all of the columns
+  uint32_t nlocals;
+  uint32_t ncoords;
+} header_t;
+
+typedef struct {
+  uint32_t parent; ///< 0 for the graph, or 1 + index of an earlier subgraph
+  uint32_t name;
+  uint32_t nnodes;
+  uint32_t nedges;
+} subgraph_t;
+
+typedef struct {
+  uint32_t kind; ///< AGRAPH, AGNODE or AGEDGE
+  uint32_t name;
+  uint32_t defval;
+  uint32_t flags; ///< ATTR_PRINT, ATTR_FIXED
+} attr_t;
+
+typedef struct {
+  uint32_t graph; ///< 1 + index of the subgraph
+  uint32_t attr;
+  uint32_t value;
+} local_t;
+
+typedef struct {
+  uint32_t kind;   ///< AGNODE for a `pos`, AGRAPH for a `bb`
+  uint32_t object; ///< node, or 0 for the graph and 1 + index of a subgraph
+  double c[4];     ///< x and y of a `pos`, or the corners of a `bb`
+} coord_t;
+
+enum {
+  S_STROFF,
+  S_STRHTML,
+  S_STRTEXT,
+  S_NODES,
+  S_ENDS,
+  S_KEYS,
+  S_SUBGS,
+  S_MEMBERS,
+  S_ATTRS,
+  S_VALUES,
+  S_LOCALS,
+  S_COORDS,
+  S_END
+};
+
+/// where each section starts, and where the last one ends
+typedef struct {
+  uint64_t offset[S_END + 1];
+} layout_t;
+
+static uint64_t pad8(uint64_t n) { return (n + 7) & ~(uint64_t)7; }
+
+static layout_t layout(const header_t *h) {
+  const uint64_t size[S_END] = {
+      [S_STROFF] = (uint64_t)h->nstrings * sizeof(uint32_t),
+      [S_STRHTML] = h->nstrings,
+      [S_STRTEXT] = h->strbytes,
+      [S_NODES] = (uint64_t)h->nnodes * sizeof(uint32_t),
+      [S_ENDS] = (uint64_t)h->nedges * 2 * sizeof(uint32_t),
+      [S_KEYS] = (uint64_t)h->nedges * sizeof(uint32_t),
+      [S_SUBGS] = (uint64_t)h->nsubgraphs * sizeof(subgraph_t),
+      [S_MEMBERS] = (uint64_t)h->nmembers * sizeof(uint32_t),
+      [S_ATTRS] = (uint64_t)h->nattrs * sizeof(attr_t),
+      [S_VALUES] = (uint64_t)h->nvalues * sizeof(uint32_t),
+      [S_LOCALS] = (uint64_t)h->nlocals * sizeof(local_t),
+      [S_COORDS] = (uint64_t)h->ncoords * sizeof(coord_t),
+  };
+  layout_t l = {{pad8(sizeof(header_t))}};
+  for (int i = 0; i < S_END; ++i) {
+    l.offset[i + 1] = l.offset[i] + pad8(size[i]);
+  }
+  return l;
+}
+
+/// read the numbers of a node `pos` of the form "x,y" or "x,y!"
+static bool parse_pos(const char *s, double *c) {
+  char *end;
+  c[0] = strtod(s, &end);
+  if (end == s || *end != ',') {
+    return false;
+  }
+  s = end + 1;
+  c[1] = strtod(s, &end);
+  if (end == s) {
+    return false;
+  }
+  return end[0] == '\0' || (end[0] == '!' && end[1] == '\0');
+}
+
+/// read the numbers of a graph `bb` of the form "llx,lly,urx,ury"
+static bool parse_bb(const char *s, double *c) {
+  for (int i = 0; i < 4; ++i) {
+    char *end;
+    c[i] = strtod(s, &end);
+    if (end == s || *end != (i < 3 ? ',' : '\0')) {
+      return false;
+    }
+    s = end + 1;
+  }
+  return true;
+}
+
+/*
+ * writing
+ */
+
+/// strings of a graph being written, numbered as they are first seen
+///
+/// Strings are looked up by address, as the names and values of a graph are
+/// reference counted strings, so that equal strings are usually one string.
+typedef struct {
+  const char **str; ///< each string
+  size_t size;
+  size_t capacity;
+  uint32_t *slot; ///< open addressed table of 1 + index into `str`, or 0
+  size_t nslots;  ///< a power of 2
+  uint64_t bytes; ///< length of the text
+} strtab_t;
+
+static size_t slot_of(const strtab_t *t, const char *s) {
+  uintptr_t h = (uintptr_t)s;
+  h ^= h >> 17;
+  h *= (uintptr_t)0x9e3779b97f4a7c15ull;
+  return (size_t)(h >> 7) & (t->nslots - 1);
+}
+
+static uint32_t strtab_index(strtab_t *t, const char *s) {
+  if (s == NULL) {
+    return NONE;
+  }
+  if (2 * (t->size + 1) > t->nslots) {
+    const size_t nslots = t->nslots == 0 ? 1024 : 2 * t->nslots;
+    free(t->slot);
+    t->slot = gv_calloc(nslots, sizeof(t->slot[0]));
+    t->nslots = nslots;
+    for (size_t i = 0; i < t->size; ++i) {
+      size_t j = slot_of(t, t->str[i]);
+      while (t->slot[j] != 0) {
+        j = (j + 1) & (t->nslots - 1);
+      }
+      t->slot[j] = (uint32_t)i + 1;
+    }
+  }
+  size_t j = slot_of(t, s);
+  while (t->slot[j] != 0) {
+    if (t->str[t->slot[j] - 1] == s) {
+      return t->slot[j] - 1;
+    }
+    j = (j + 1) & (t->nslots - 1);
+  }
+  if (t->size == t->capacity) {
+    const size_t capacity = t->capacity == 0 ? 1024 : 2 * t->capacity;
+    t->str = gv_recalloc(t->str, t->capacity, capacity, sizeof(t->str[0]));
+    t->capacity = capacity;
+  }
+  t->str[t->size] = s;
+  t->slot[j] = (uint32_t)t->size + 1;
+  t->bytes += strlen(s) + 1;
+  return (uint32_t)t->size++;
+}
+
+/// name of an object, or NONE if it is anonymous
+static uint32_t name_index(strtab_t *t, void *obj) {
+  const char *name = agnameof(obj);
+  if (name == NULL || name[0] == LOCALNAMEPREFIX) {
+    return NONE;
+  }
+  return strtab_index(t, name);
+}
+
+/// what is gathered from a graph before it is written
+typedef struct {
+  Agraph_t *g;
+  strtab_t strings;
+  Agnode_t **node; ///< each node, in order
+  uint32_t *nodeno; ///< number of each node, by sequence number
+  Agedge_t **edge; ///< each edge, in order
+  uint32_t *edgeno; ///< number of each edge, by sequence number
+  Agraph_t **subg; ///< each subgraph, in preorder
+  subgraph_t *subgs;
+  size_t nsubgs;
+  uint32_t *members;
+  size_t nmembers;
+  Agsym_t **sym; ///< each attribute
+  attr_t *attrs;
+  size_t nattrs;
+  uint32_t *attrno[3]; ///< number of each attribute by kind and Agsym_t.id
+  local_t *locals;
+  size_t nlocals;
+  coord_t *coords;
+  size_t ncoords;
+} image_t;
+
+/// AGRAPH, AGNODE or AGEDGE, which are also 0, 1 and 2
+static int kind_of(const Agsym_t *sym) {
+  return sym->kind == AGINEDGE ? AGEDGE : sym->kind;
+}
+
+static size_t count_subgraphs(Agraph_t *g) {
+  size_t n = 0;
+  for (Agraph_t *s = agfstsubg(g); s != NULL; s = agnxtsubg(s)) {
+    n += 1 + count_subgraphs(s);
+  }
+  return n;
+}
+
+static void gather_subgraphs(image_t *im, Agraph_t *g, uint32_t parent) {
+  for (Agraph_t *s = agfstsubg(g); s != NULL; s = agnxtsubg(s)) {
+    const size_t i = im->nsubgs++;
+    im->subg[i] = s;
+    im->subgs[i] = (subgraph_t){.parent = parent,
+                                .name = name_index(&im->strings, s),
+                                .nnodes = (uint32_t)agnnodes(s),
+                                .nedges = (uint32_t)agnedges(s)};
+    im->nmembers += im->subgs[i].nnodes + im->subgs[i].nedges;
+    gather_subgraphs(im, s, (uint32_t)i + 1);
+  }
+}
+
+/// note the defaults a subgraph sets itself, rather than inherits
+static void gather_locals(image_t *im, size_t graph, Dict_t *dict) {
+  Dict_t *view = dtview(dict, NULL);
+  for (Agsym_t *sym = dtfirst(dict); sym; sym = dtnext(dict, sym)) {
+    im->locals = gv_recalloc(im->locals, im->nlocals, im->nlocals + 1,
+                             sizeof(im->locals[0]));
+    im->locals[im->nlocals++] =
+        (local_t){.graph = (uint32_t)graph,
+                  .attr = im->attrno[kind_of(sym)][sym->id],
+                  .value = strtab_index(&im->strings, sym->defval)};
+  }
+  dtview(dict, view);
+}
+
+static void add_coord(image_t *im, int kind, size_t object, const double *c) {
+  im->coords = gv_recalloc(im->coords, im->ncoords, im->ncoords + 1,
+                           sizeof(im->coords[0]));
+  coord_t *co = &im->coords[im->ncoords++];
+  *co = (coord_t){.kind = (uint32_t)kind, .object = (uint32_t)object};
+  memcpy(co->c, c, sizeof(co->c));
+}
+
+static void gather(image_t *im, Agraph_t *g) {
+  const uint64_t nodeseqs = g->clos->seq[AGNODE] + 1;
+  const uint64_t edgeseqs = g->clos->seq[AGEDGE] + 1;
+  const size_t nnodes = (size_t)agnnodes(g);
+  const size_t nedges = (size_t)agnedges(g);
+  im->g = g;
+
+  im->node = gv_calloc(nnodes, sizeof(im->node[0]));
+  im->nodeno = gv_calloc(nodeseqs, sizeof(im->nodeno[0]));
+  size_t i = 0;
+  for (Agnode_t *n = agfstnode(g); n != NULL; n = agnxtnode(g, n)) {
+    im->nodeno[AGSEQ(n)] = (uint32_t)i;
+    im->node[i++] = n;
+  }
+
+  // edges in the order they were made, so that a graph read back numbers
+  // them, and so orders them, as this one does
+  Agedge_t **byseq = gv_calloc(edgeseqs, sizeof(byseq[0]));
+  for (Agnode_t *n = agfstnode(g); n != NULL; n = agnxtnode(g, n)) {
+    for (Agedge_t *e = agfstout(g, n); e != NULL; e = agnxtout(g, e)) {
+      byseq[AGSEQ(e)] = e;
+    }
+  }
+  im->edge = gv_calloc(nedges, sizeof(im->edge[0]));
+  im->edgeno = gv_calloc(edgeseqs, sizeof(im->edgeno[0]));
+  i = 0;
+  for (uint64_t s = 0; s < edgeseqs; ++s) {
+    if (byseq[s] != NULL) {
+      im->edgeno[s] = (uint32_t)i;
+      im->edge[i++] = byseq[s];
+    }
+  }
+  free(byseq);
+
+  const size_t nsubgs = count_subgraphs(g);
+  im->subg = gv_calloc(nsubgs, sizeof(im->subg[0]));
+  im->subgs = gv_calloc(nsubgs, sizeof(im->subgs[0]));
+  gather_subgraphs(im, g, 0);
+  im->members = gv_calloc(im->nmembers, sizeof(im->members[0]));
+  size_t m = 0;
+  for (size_t j = 0; j < im->nsubgs; ++j) {
+    Agraph_t *s = im->subg[j];
+    for (Agnode_t *n = agfstnode(s); n != NULL; n = agnxtnode(s, n)) {
+      im->members[m++] = im->nodeno[AGSEQ(n)];
+    }
+    for (Agnode_t *n = agfstnode(s); n != NULL; n = agnxtnode(s, n)) {
+      for (Agedge_t *e = agfstout(s, n); e != NULL; e = agnxtout(s, e)) {
+        im->members[m++] = im->edgeno[AGSEQ(e)];
+      }
+    }
+  }
+
+  // attributes, as seen from the graph being written, in the order they were
+  // declared
+  static const int kinds[] = {AGRAPH, AGNODE, AGEDGE};
+  for (size_t k = 0; k < 3; ++k) {
+    Agdatadict_t *dd = agdatadict(agroot(g), false);
+    Dict_t *d = dd == NULL ? NULL
+              : kinds[k] == AGRAPH ? dd->dict.g
+              : kinds[k] == AGNODE ? dd->dict.n
+                                   : dd->dict.e;
+    const size_t n = d == NULL ? 0 : (size_t)dtsize(d);
+    im->attrno[k] = gv_calloc(n, sizeof(im->attrno[k][0]));
+    const size_t first = im->nattrs;
+    im->nattrs += n;
+    im->sym = gv_recalloc(im->sym, first, im->nattrs, sizeof(im->sym[0]));
+    for (Agsym_t *sym = agnxtattr(g, kinds[k], NULL); sym != NULL;
+         sym = agnxtattr(g, kinds[k], sym)) {
+      im->sym[first + (size_t)sym->id] = sym;
+    }
+  }
+  im->attrs = gv_calloc(im->nattrs, sizeof(im->attrs[0]));
+  for (size_t a = 0; a < im->nattrs; ++a) {
+    Agsym_t *sym = im->sym[a];
+    im->attrno[kind_of(sym)][sym->id] = (uint32_t)a;
+    im->attrs[a] = (attr_t){.kind = (uint32_t)kind_of(sym),
+                            .name = strtab_index(&im->strings, sym->name),
+                            .defval = strtab_index(&im->strings, sym->defval),
+                            .flags = (sym->print ? ATTR_PRINT : 0) |
+                                     (sym->fixed ? ATTR_FIXED : 0)};
+  }
+
+  for (size_t j = 0; j < im->nsubgs; ++j) {
+    Agdatadict_t *dd = agdatadict(im->subg[j], false);
+    if (dd != NULL) {
+      gather_locals(im, j + 1, dd->dict.g);
+      gather_locals(im, j + 1, dd->dict.n);
+      gather_locals(im, j + 1, dd->dict.e);
+    }
+  }
+
+  double c[4];
+  Agsym_t *pos = agattr(g, AGNODE, "pos", NULL);
+  if (pos != NULL) {
+    for (size_t j = 0; j < nnodes; ++j) {
+      if (parse_pos(agxget(im->node[j], pos), c)) {
+        add_coord(im, AGNODE, j, c);
+      }
+    }
+  }
+  Agsym_t *bb = agattr(g, AGRAPH, "bb", NULL);
+  if (bb != NULL) {
+    if (parse_bb(agxget(g, bb), c)) {
+      add_coord(im, AGRAPH, 0, c);
+    }
+    for (size_t j = 0; j < im->nsubgs; ++j) {
+      if (parse_bb(agxget(im->subg[j], bb), c)) {
+        add_coord(im, AGRAPH, j + 1, c);
+      }
+    }
+  }
+}
+
+static void image_free(image_t *im) {
+  free(im->strings.str);
+  free(im->strings.slot);
+  free(im->node);
+  free(im->nodeno);
+  free(im->edge);
+  free(im->edgeno);
+  free(im->subg);
+  free(im->subgs);
+  free(im->members);
+  free(im->sym);
+  free(im->attrs);
+  for (size_t k = 0; k < 3; ++k) {
+    free(im->attrno[k]);
+  }
+  free(im->locals);
+  free(im->coords);
+}
+
+typedef size_t (*gvbwrite_t)(void *chan, const void *data, size_t size);
+
+static size_t write_file(void *chan, const void *data, size_t size) {
+  return fwrite(data, 1, size, chan);
+}
+
+/// a writer of sections, padding each to a multiple of 8 bytes
+typedef struct {
+  gvbwrite_t write;
+  void *chan;
+  uint64_t offset;
+  bool failed;
+} out_t;
+
+static void put(out_t *out, const void *data, size_t size) {
+  if (!out->failed && size > 0 && out->write(out->chan, data, size) != size) {
+    out->failed = true;
+  }
+  out->offset += size;
+}
+
+static void pad(out_t *out) {
+  static const char zeros[8];
+  put(out, zeros, (size_t)(pad8(out->offset) - out->offset));
+}
+
+int agwritegvb(Agraph_t *g, void *chan, gvbwrite_t write) {
+  image_t im = {0};
+  gather(&im, g);
+  const size_t nnodes = (size_t)agnnodes(g);
+  const size_t nedges = (size_t)agnedges(g);
+
+  // columns of node and edge values
+  size_t nvalues = 0;
+  for (size_t a = 0; a < im.nattrs; ++a) {
+    nvalues += im.attrs[a].kind == AGNODE   ? nnodes
+               : im.attrs[a].kind == AGEDGE ? nedges
+                                            : 0;
+  }
+  uint32_t *values = gv_calloc(nvalues, sizeof(values[0]));
+  size_t v = 0;
+  for (size_t a = 0; a < im.nattrs; ++a) {
+    Agsym_t *sym = im.sym[a];
+    if (kind_of(sym) == AGNODE) {
+      for (size_t i = 0; i < nnodes; ++i) {
+        const char *s = agxget(im.node[i], sym);
+        values[v++] = s == sym->defval ? NONE : strtab_index(&im.strings, s);
+      }
+    } else if (kind_of(sym) == AGEDGE) {
+      for (size_t i = 0; i < nedges; ++i) {
+        const char *s = agxget(im.edge[i], sym);
+        values[v++] = s == sym->defval ? NONE : strtab_index(&im.strings, s);
+      }
+    }
+  }
+
+  uint32_t *names = gv_calloc(nnodes, sizeof(names[0]));
+  for (size_t i = 0; i < nnodes; ++i) {
+    names[i] = name_index(&im.strings, im.node[i]);
+  }
+  uint32_t *ends = gv_calloc(2 * nedges, sizeof(ends[0]));
+  uint32_t *keys = gv_calloc(nedges, sizeof(keys[0]));
+  for (size_t i = 0; i < nedges; ++i) {
+    ends[2 * i] = im.nodeno[AGSEQ(agtail(im.edge[i]))];
+    ends[2 * i + 1] = im.nodeno[AGSEQ(aghead(im.edge[i]))];
+    keys[i] = strtab_index(&im.strings, agnameof(im.edge[i]));
+  }
+  const uint32_t gname = name_index(&im.strings, g);
+
+  int rc = 0;
+  if (im.strings.size >= NONE || im.strings.bytes > UINT32_MAX ||
+      nvalues >= NONE || im.nmembers >= NONE) {
+    agerrorf("agwritegvb: graph is too large for the gvb format\n");
+    rc = -1;
+  }
+
+  uint32_t *offsets = gv_calloc(im.strings.size, sizeof(offsets[0]));
+  unsigned char *html = gv_calloc(im.strings.size, sizeof(html[0]));
+  uint32_t offset = 0;
+  for (size_t i = 0; rc == 0 && i < im.strings.size; ++i) {
+    offsets[i] = offset;
+    offset += (uint32_t)strlen(im.strings.str[i]) + 1;
+    html[i] = aghtmlstr(im.strings.str[i]) ? 1 : 0;
+  }
+
+  header_t h = {.version = VERSION,
+                .byte_order = BYTE_ORDER_MARK,
+                .flags = (g->desc.directed ? GVB_DIRECTED : 0) |
+                         (g->desc.strict ? GVB_STRICT : 0) |
+                         (g->desc.no_loop ? GVB_NO_LOOP : 0) |
+                         (g->desc.maingraph ? GVB_MAINGRAPH : 0),
+                .name = gname,
+                .nstrings = (uint32_t)im.strings.size,
+                .strbytes = (uint32_t)im.strings.bytes,
+                .nnodes = (uint32_t)nnodes,
+                .nedges = (uint32_t)nedges,
+                .nsubgraphs = (uint32_t)im.nsubgs,
+                .nmembers = (uint32_t)im.nmembers,
+                .nattrs = (uint32_t)im.nattrs,
+                .nvalues = (uint32_t)nvalues,
+                .nlocals = (uint32_t)im.nlocals,
+                .ncoords = (uint32_t)im.ncoords};
+  memcpy(h.magic, MAGIC, sizeof(h.magic));
+  h.size = layout(&h).offset[S_END];
+
+  if (rc == 0) {
+    out_t out = {.write = write == NULL ? write_file : write, .chan = chan};
+    put(&out, &h, sizeof(h));
+    pad(&out);
+    put(&out, offsets, im.strings.size * sizeof(offsets[0]));
+    pad(&out);
+    put(&out, html, im.strings.size);
+    pad(&out);
+    for (size_t i = 0; i < im.strings.size; ++i) {
+      put(&out, im.strings.str[i], strlen(im.strings.str[i]) + 1);
+    }
+    pad(&out);
+    put(&out, names, nnodes * sizeof(names[0]));
+    pad(&out);
+    put(&out, ends, 2 * nedges * sizeof(ends[0]));
+    pad(&out);
+    put(&out, keys, nedges * sizeof(keys[0]));
+    pad(&out);
+    put(&out, im.subgs, im.nsubgs * sizeof(im.subgs[0]));
+    pad(&out);
+    put(&out, im.members, im.nmembers * sizeof(im.members[0]));
+    pad(&out);
+    put(&out, im.attrs, im.nattrs * sizeof(im.attrs[0]));
+    pad(&out);
+    put(&out, values, nvalues * sizeof(values[0]));
+    pad(&out);
+    put(&out, im.locals, im.nlocals * sizeof(im.locals[0]));
+    pad(&out);
+    put(&out, im.coords, im.ncoords * sizeof(im.coords[0]));
+    pad(&out);
+    if (out.failed) {
+      rc = EOF;
+    }
+  }
+
+  free(html);
+  free(offsets);
+  free(keys);
+  free(ends);
+  free(names);
+  free(values);
+  image_free(&im);
+  return rc;
+}
+
+/*
+ * reading
+ */
+
+/// numbers of node `pos` and graph `bb` values kept when a graph is read
+typedef struct {
+  Agrec_t h;
+  int pos;              ///< Agsym_t.id of the node `pos` attribute
+  int bb;               ///< Agsym_t.id of the graph `bb` attribute
+  uint64_t nnodes;      ///< entries for nodes, by sequence number
+  uint64_t ngraphs;     ///< entries for graphs, by sequence number
+  struct {
+    const char *str;    ///< value the numbers are of, held, or NULL for none
+    double c[4];
+  } kept[];             ///< node entries, then graph entries
+} coords_t;
+
+static const char CoordsRecName[] = "_AG_coords";
+
+size_t agxget_coords(void *obj, Agsym_t *sym, const double **coords) {
+  coords_t *rec = (coords_t *)aggetrec(agroot(obj), CoordsRecName, 0);
+  if (rec == NULL) {
+    return 0;
+  }
+  const uint64_t seq = AGSEQ(obj);
+  size_t i, n;
+  if (AGTYPE(obj) == AGNODE && sym->kind == AGNODE && sym->id == rec->pos &&
+      seq < rec->nnodes) {
+    i = (size_t)seq;
+    n = 2;
+  } else if (AGTYPE(obj) == AGRAPH && sym->kind == AGRAPH &&
+             sym->id == rec->bb && seq < rec->ngraphs) {
+    i = (size_t)(rec->nnodes + seq);
+    n = 4;
+  } else {
+    return 0;
+  }
+  if (rec->kept[i].str == NULL || rec->kept[i].str != agxget(obj, sym)) {
+    return 0;
+  }
+  *coords = rec->kept[i].c;
+  return n;
+}
+
+bool agisgvb(const void *data, size_t size) {
+  return size >= sizeof(MAGIC) && memcmp(data, MAGIC, sizeof(MAGIC)) == 0;
+}
+
+/// an image being read
+typedef struct {
+  const char *base;
+  layout_t l;
+  const header_t *h;
+  const char *const *str; ///< each string, pointing into the image
+} in_t;
+
+static const void *section(const in_t *in, int s) {
+  return in->base + in->l.offset[s];
+}
+
+static bool check(bool ok, const char *what) {
+  if (!ok) {
+    agerrorf("agreadgvb: invalid %s\n", what);
+  }
+  return ok;
+}
+
+/// check that every index in the image is in range
+static bool validate(const in_t *in) {
+  const header_t *h = in->h;
+  if (!check(h->name == NONE || h->name < h->nstrings, "graph name")) {
+    return false;
+  }
+  const uint32_t *u = section(in, S_NODES);
+  for (uint32_t i = 0; i < h->nnodes; ++i) {
+    if (!check(u[i] == NONE || u[i] < h->nstrings, "node name")) {
+      return false;
+    }
+  }
+  u = section(in, S_ENDS);
+  for (uint64_t i = 0; i < 2 * (uint64_t)h->nedges; ++i) {
+    if (!check(u[i] < h->nnodes, "edge")) {
+      return false;
+    }
+  }
+  u = section(in, S_KEYS);
+  for (uint32_t i = 0; i < h->nedges; ++i) {
+    if (!check(u[i] == NONE || u[i] < h->nstrings, "edge key")) {
+      return false;
+    }
+  }
+  const subgraph_t *sg = section(in, S_SUBGS);
+  uint64_t members = 0;
+  for (uint32_t i = 0; i < h->nsubgraphs; ++i) {
+    if (!check(sg[i].parent <= i, "subgraph parent") ||
+        !check(sg[i].name == NONE || sg[i].name < h->nstrings,
+               "subgraph name")) {
+      return false;
+    }
+    members += (uint64_t)sg[i].nnodes + sg[i].nedges;
+  }
+  if (!check(members == h->nmembers, "subgraph size")) {
+    return false;
+  }
+  u = section(in, S_MEMBERS);
+  for (uint32_t i = 0; i < h->nsubgraphs; ++i) {
+    for (uint32_t j = 0; j < sg[i].nnodes; ++j, ++u) {
+      if (!check(*u < h->nnodes, "subgraph node")) {
+        return false;
+      }
+    }
+    for (uint32_t j = 0; j < sg[i].nedges; ++j, ++u) {
+      if (!check(*u < h->nedges, "subgraph edge")) {
+        return false;
+      }
+    }
+  }
+  const attr_t *a = section(in, S_ATTRS);
+  uint64_t values = 0;
+  for (uint32_t i = 0; i < h->nattrs; ++i) {
+    if (!check(a[i].kind == AGRAPH || a[i].kind == AGNODE ||
+                   a[i].kind == AGEDGE,
+               "attribute kind") ||
+        !check(a[i].name < h->nstrings && a[i].defval < h->nstrings,
+               "attribute")) {
+      return false;
+    }
+    values += a[i].kind == AGNODE   ? h->nnodes
+              : a[i].kind == AGEDGE ? h->nedges
+                                    : 0;
+  }
+  if (!check(values == h->nvalues, "attribute values")) {
+    return false;
+  }
+  u = section(in, S_VALUES);
+  for (uint32_t i = 0; i < h->nvalues; ++i) {
+    if (!check(u[i] == NONE || u[i] < h->nstrings, "attribute value")) {
+      return false;
+    }
+  }
+  const local_t *lo = section(in, S_LOCALS);
+  for (uint32_t i = 0; i < h->nlocals; ++i) {
+    if (!check(lo[i].graph >= 1 && lo[i].graph <= h->nsubgraphs &&
+                   lo[i].attr < h->nattrs && lo[i].value < h->nstrings,
+               "subgraph default")) {
+      return false;
+    }
+  }
+  const coord_t *co = section(in, S_COORDS);
+  for (uint32_t i = 0; i < h->ncoords; ++i) {
+    if (!check((co[i].kind == AGNODE && co[i].object < h->nnodes) ||
+                   (co[i].kind == AGRAPH && co[i].object <= h->nsubgraphs),
+               "coordinates")) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static char *string(const in_t *in, uint32_t i) {
+  // cast away const, as cgraph takes names and values as `char *` but only
+  // copies them
+  return i == NONE ? NULL : (char *)(uintptr_t)in->str[i];
+}
+
+/// keep the numbers of the `pos` and `bb` values of a graph just read
+static void keep_coords(const in_t *in, Agraph_t *g, Agnode_t **node,
+                        Agraph_t **subg) {
+  Agsym_t *pos = agattr(g, AGNODE, "pos", NULL);
+  Agsym_t *bb = agattr(g, AGRAPH, "bb", NULL);
+  const uint64_t nnodes = g->clos->seq[AGNODE] + 1;
+  const uint64_t ngraphs = g->clos->seq[AGRAPH] + 1;
+  const size_t size = sizeof(coords_t) +
+                      (size_t)(nnodes + ngraphs) * sizeof(((coords_t *)0)->kept[0]);
+  if (size > UINT_MAX) {
+    return;
+  }
+  coords_t *rec = agbindrec(g, CoordsRecName, (unsigned)size, false);
+  rec->pos = pos == NULL ? -1 : pos->id;
+  rec->bb = bb == NULL ? -1 : bb->id;
+  rec->nnodes = nnodes;
+  rec->ngraphs = ngraphs;
+  const coord_t *co = section(in, S_COORDS);
+  for (uint32_t i = 0; i < in->h->ncoords; ++i) {
+    void *obj;
+    Agsym_t *sym;
+    uint64_t at;
+    if (co[i].kind == AGNODE) {
+      obj = node[co[i].object];
+      sym = pos;
+      at = AGSEQ(obj);
+    } else {
+      obj = co[i].object == 0 ? g : subg[co[i].object - 1];
+      sym = bb;
+      at = nnodes + AGSEQ(obj);
+    }
+    if (obj == NULL || sym == NULL) {
+      continue;
+    }
+    // hold the string, so that no later value can be allocated where it is
+    // and pass for it
+    rec->kept[at].str = agstrref(g, agxget(obj, sym));
+    memcpy(rec->kept[at].c, co[i].c, sizeof(co[i].c));
+  }
+}
+
+/// make the graph an image describes
+static Agraph_t *build(const in_t *in, Agdisc_t *disc) {
+  const header_t *h = in->h;
+  Agdesc_t desc = {.directed = (h->flags & GVB_DIRECTED) != 0,
+                   .strict = (h->flags & GVB_STRICT) != 0,
+                   .no_loop = (h->flags & GVB_NO_LOOP) != 0,
+                   .maingraph = (h->flags & GVB_MAINGRAPH) != 0};
+  Agraph_t *g = agopen(string(in, h->name), desc, disc);
+  if (g == NULL) {
+    return NULL;
+  }
+
+  // enter HTML strings first, so that copies of them made below find them
+  // and are HTML too
+  const unsigned char *html = section(in, S_STRHTML);
+  char **held = gv_calloc(h->nstrings, sizeof(held[0]));
+  for (uint32_t i = 0; i < h->nstrings; ++i) {
+    if (html[i]) {
+      held[i] = agstrdup_html(g, in->str[i]);
+    }
+  }
+
+  const attr_t *a = section(in, S_ATTRS);
+  Agsym_t **sym = gv_calloc(h->nattrs, sizeof(sym[0]));
+  for (uint32_t i = 0; i < h->nattrs; ++i) {
+    sym[i] = agattr(g, (int)a[i].kind, string(in, a[i].name),
+                    string(in, a[i].defval));
+    if (sym[i] == NULL) {
+      continue;
+    }
+    sym[i]->print = (a[i].flags & ATTR_PRINT) != 0;
+    sym[i]->fixed = (a[i].flags & ATTR_FIXED) != 0;
+  }
+
+  const subgraph_t *sg = section(in, S_SUBGS);
+  const local_t *lo = section(in, S_LOCALS);
+  Agraph_t **subg = gv_calloc(h->nsubgraphs, sizeof(subg[0]));
+  uint32_t l = 0;
+  for (uint32_t i = 0; i < h->nsubgraphs; ++i) {
+    Agraph_t *parent = sg[i].parent == 0 ? g : subg[sg[i].parent - 1];
+    subg[i] = agsubg(parent, string(in, sg[i].name), 1);
+    for (; l < h->nlocals && lo[l].graph == i + 1; ++l) {
+      agattr(subg[i], (int)a[lo[l].attr].kind, string(in, a[lo[l].attr].name),
+             string(in, lo[l].value));
+    }
+  }
+
+  // nodes and edges, with their values, in bulk
+  const char **names = gv_calloc(h->nnodes, sizeof(names[0]));
+  const uint32_t *u = section(in, S_NODES);
+  for (uint32_t i = 0; i < h->nnodes; ++i) {
+    names[i] = string(in, u[i]);
+  }
+  size_t *ends = gv_calloc(2 * (size_t)h->nedges, sizeof(ends[0]));
+  u = section(in, S_ENDS);
+  for (size_t i = 0; i < 2 * (size_t)h->nedges; ++i) {
+    ends[i] = u[i];
+  }
+  const uint32_t *keys = section(in, S_KEYS);
+  bool keyed = false;
+  for (uint32_t i = 0; i < h->nedges; ++i) {
+    keyed |= keys[i] != NONE;
+  }
+  Agnode_t **node = gv_calloc(h->nnodes, sizeof(node[0]));
+  Agedge_t **edge = gv_calloc(h->nedges, sizeof(edge[0]));
+  int rc;
+  if (!keyed) {
+    rc = agbuild(g, h->nnodes, names, h->nedges, ends, 0, NULL, node, edge);
+  } else {
+    // agbuild makes only anonymous edges, so make these one at a time
+    rc = agbuild(g, h->nnodes, names, 0, NULL, 0, NULL, node, NULL);
+    for (uint32_t i = 0; rc == 0 && i < h->nedges; ++i) {
+      edge[i] = agedge(g, node[ends[2 * i]], node[ends[2 * i + 1]],
+                       string(in, keys[i]), 1);
+    }
+  }
+
+  // values, each string interned once and then set by reference, without
+  // hashing it again for every object it is set on
+  u = section(in, S_VALUES);
+  for (uint32_t i = 0, v = 0; rc == 0 && i < h->nattrs; ++i) {
+    if (a[i].kind == AGRAPH) {
+      continue;
+    }
+    const bool is_node = a[i].kind == AGNODE;
+    const uint32_t n = is_node ? h->nnodes : h->nedges;
+    for (uint32_t j = 0; j < n; ++j, ++v) {
+      void *obj = is_node ? (void *)node[j] : (void *)edge[j];
+      if (u[v] == NONE || obj == NULL || sym[i] == NULL) {
+        continue;
+      }
+      if (held[u[v]] == NULL) {
+        held[u[v]] = agstrdup(g, in->str[u[v]]);
+      }
+      agxset_interned(obj, sym[i], held[u[v]]);
+    }
+  }
+
+  u = section(in, S_MEMBERS);
+  for (uint32_t i = 0; rc == 0 && i < h->nsubgraphs; ++i) {
+    for (uint32_t j = 0; j < sg[i].nnodes; ++j) {
+      if (node[*u] != NULL) {
+        agsubnode(subg[i], node[*u], 1);
+      }
+      ++u;
+    }
+    for (uint32_t j = 0; j < sg[i].nedges; ++j) {
+      if (edge[*u] != NULL) {
+        agsubedge(subg[i], edge[*u], 1);
+      }
+      ++u;
+    }
+  }
+
+  if (rc == 0 && h->ncoords > 0) {
+    keep_coords(in, g, node, subg);
+  }
+
+  for (uint32_t i = 0; i < h->nstrings; ++i) {
+    if (held[i] != NULL) {
+      agstrfree(g, held[i]);
+    }
+  }
+  free(edge);
+  free(node);
+  free(ends);
+  free(names);
+  free(subg);
+  free(sym);
+  free(held);
+  if (rc != 0) {
+    agclose(g);
+    return NULL;
+  }
+  return g;
+}
+
+Agraph_t *agmemreadgvb(const void *data, size_t size, size_t *used,
+                       Agdisc_t *disc) {
+  header_t h;
+  if (!check(agisgvb(data, size) && size >= sizeof(h), "header")) {
+    return NULL;
+  }
+  memcpy(&h, data, sizeof(h));
+  if (!check(h.version == VERSION, "version")) {
+    return NULL;
+  }
+  if (h.byte_order != BYTE_ORDER_MARK) {
+    agerrorf("agreadgvb: graph was written with a different byte order\n");
+    return NULL;
+  }
+  const layout_t l = layout(&h);
+  if (!check(h.size == l.offset[S_END] && h.size <= size, "size")) {
+    return NULL;
+  }
+  if (used != NULL) {
+    *used = (size_t)h.size;
+  }
+
+  // the sections are read in place, which needs them to be aligned
+  void *copy = NULL;
+  if ((uintptr_t)data % sizeof(double) != 0) {
+    copy = gv_alloc((size_t)h.size);
+    memcpy(copy, data, (size_t)h.size);
+    data = copy;
+  }
+
+  in_t in = {.base = data, .l = l, .h = data};
+  const uint32_t *offsets = section(&in, S_STROFF);
+  const char *text = section(&in, S_STRTEXT);
+  bool ok = check(h.strbytes == 0 ? h.nstrings == 0 : text[h.strbytes - 1] == '\0',
+                  "strings");
+  const char **str = gv_calloc(h.nstrings, sizeof(str[0]));
+  for (uint32_t i = 0; ok && i < h.nstrings; ++i) {
+    ok = check(offsets[i] < h.strbytes, "string");
+    str[i] = text + offsets[i];
+  }
+  in.str = str;
+
+  Agraph_t *g = ok && validate(&in) ? build(&in, disc) : NULL;
+  free(str);
+  free(copy);
+  return g;
+}
+
+Agraph_t *agreadgvb(FILE *f, Agdisc_t *disc) {
+  header_t h;
+  const size_t got = fread(&h, 1, sizeof(h), f);
+  if (got == 0) {
+    return NULL; // end of input
+  }
+  if (!check(got == sizeof(h) && agisgvb(&h, sizeof(h)), "header")) {
+    return NULL;
+  }
+  if (h.size < sizeof(h) || h.size > SIZE_MAX) {
+    check(false, "size");
+    return NULL;
+  }
+  char *data = malloc((size_t)h.size);
+  if (data == NULL) {
+    agerrorf("agreadgvb: out of memory\n");
+    return NULL;
+  }
+  memcpy(data, &h, sizeof(h));
+  Agraph_t *g = NULL;
+  const size_t rest = (size_t)h.size - sizeof(h);
+  if (check(fread(data + sizeof(h), 1, rest, f) == rest, "size")) {
+    g = agmemreadgvb(data, (size_t)h.size, NULL, disc);
+  }
+  free(data);
+  return g;
+}
@@ -172,7 +172,7 @@ char *agnameof(void *obj)
 	    return rv;
     }
     if (AGTYPE(obj) != AGEDGE) {
-	static char buf[32];
+	static TLS char buf[32];
 	snprintf(buf, sizeof(buf), "%c%" PRIu64, LOCALNAMEPREFIX, AGID(obj));
 	rv = buf;
     }
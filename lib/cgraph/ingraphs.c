@@ -23,7 +23,40 @@
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <util/alloc.h>
 #include <util/gv_fopen.h>
+#include <util/thread.h>
+
+/// graphs being read ahead, on another thread
+typedef struct {
+    ingraph_state reader; ///< state of the reading thread
+    gv_prefetch_t *queue; ///< graphs read, each a `read_t`
+} ahead_t;
+
+/// a graph read ahead, and where the reader was after reading it
+typedef struct {
+    Agraph_t *g;
+    int ctr;
+    unsigned errors;
+} read_t;
+
+static void *read_ahead(void *arg)
+{
+    ingraph_state *reader = arg;
+    Agraph_t *g = nextGraph(reader);
+    if (g == NULL)
+	return NULL;
+    read_t *r = gv_alloc(sizeof(read_t));
+    *r = (read_t){.g = g, .ctr = reader->ctr, .errors = reader->errors};
+    return r;
+}
+
+static void discard(void *item)
+{
+    read_t *r = item;
+    agclose(r->g);
+    free(r);
+}
 
 /* Set next available file.
  * If Files is NULL, we just read from stdin.
@@ -67,6 +100,24 @@ Agraph_t *nextGraph(ingraph_state * sp)
 	if (g) sp->ctr++;
 	return g;
     }
+    if (sp->ahead) {
+	ahead_t *a = sp->ahead;
+	read_t *r = gv_prefetch_next(a->queue);
+	if (r == NULL) {
+	    // the reader has finished, so its state is ours to look at
+	    sp->ctr = a->reader.ctr;
+	    sp->errors = a->reader.errors;
+	    gv_prefetch_stop(a->queue, discard);
+	    free(a);
+	    sp->ahead = NULL;
+	    return NULL;
+	}
+	g = r->g;
+	sp->ctr = r->ctr;
+	sp->errors = r->errors;
+	free(r);
+	return g;
+    }
     if (sp->fp == NULL)
 	nextFile(sp);
     g = NULL;
@@ -107,6 +158,7 @@ new_ing(ingraph_state * sp, char **files, Agraph_t** graphs, Agraph_t *(*readf)(
     sp->ctr = 0;
     sp->errors = 0;
     sp->fp = NULL;
+    sp->ahead = NULL;
     if (!readf) {
 	if (sp->heap)
 	    free(sp);
@@ -141,11 +193,30 @@ ingraph_state *newIngraph(ingraph_state * sp, char **files) {
   return newIng(sp, files, dflt_read);
 }
 
+void prefetchIngraph(ingraph_state *sp, size_t depth)
+{
+    // graphs supplied in memory are already read
+    if (sp->ingraphs || sp->ahead)
+	return;
+    ahead_t *a = gv_alloc(sizeof(ahead_t));
+    a->reader = *sp;
+    a->reader.heap = false;
+    a->queue = gv_prefetch_start(depth, read_ahead, &a->reader);
+    sp->ahead = a;
+}
+
 /* Close any open files and free discipline
  * Free sp if necessary.
  */
 void closeIngraph(ingraph_state * sp)
 {
+    if (sp->ahead) {
+	ahead_t *a = sp->ahead;
+	gv_prefetch_stop(a->queue, discard);
+	closeIngraph(&a->reader);
+	free(a);
+	sp->ahead = NULL;
+    }
     if (!sp->ingraphs && sp->u.Files && sp->fp)
 	(void)fclose(sp->fp);
     if (sp->heap)
@@ -22,6 +22,7 @@
 
 #include "config.h"
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdio.h>
 
 #ifdef __cplusplus
@@ -51,11 +52,24 @@ extern "C" {
 	Agraph_t *(*readf)(void*);
 	bool heap;
 	unsigned errors;
+	void *ahead; ///< graphs being read ahead, if any
     } ingraph_state;
 
 CGHDR_API ingraph_state *newIngraph(ingraph_state *, char **);
 CGHDR_API ingraph_state *newIng(ingraph_state *, char **, Agraph_t *(*readf)(void*));
 CGHDR_API ingraph_state *newIngGraphs(ingraph_state *, Agraph_t**, Agraph_t *(*readf)(void*));
+/// read graphs on another thread, ahead of calls to `nextGraph`
+///
+/// Once this is called, graphs are read from the input files while the caller
+/// works on earlier ones, with at most `depth` read but not yet returned by
+/// `nextGraph`. They are still returned in the order of the input, and
+/// `fileName` and `errors` still describe the last graph returned, but messages
+/// about errors in the input may appear before those about earlier graphs. Call
+/// this after creating `sp` and before the first `nextGraph`. Read functions
+/// must not depend on state the caller changes while working on graphs.
+CGHDR_API void prefetchIngraph(ingraph_state *sp, size_t depth);
+/// a reasonable `depth` for `prefetchIngraph`
+#define INGRAPH_PREFETCH_DEPTH 4
 CGHDR_API void closeIngraph(ingraph_state * sp);
 CGHDR_API Agraph_t *nextGraph(ingraph_state *);
 CGHDR_API char *fileName(ingraph_state *);
@@ -74,7 +74,7 @@ static Agraph_t *agmemread0(Agraph_t *arg_g, const char *cp)
 {
     Agraph_t* g;
     rdr_t rdr;
-    Agdisc_t disc;
+    Agdisc_t disc = {0};
 
     memIoDisc.putstr = AgIoDisc.putstr;
     memIoDisc.flush = AgIoDisc.flush;
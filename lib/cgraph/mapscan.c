@@ -0,0 +1,511 @@
+/**
+ * @file
+ * @brief reading graphs from files mapped into memory
+ * @ingroup cgraph_core
+ *
+ * This is a hand written scanner for the tokens scan.l describes, that works
+ * on the mapped contents of a file rather than pulling the text through an
+ * Agiodisc_t channel into the flex buffer. While agmmapconcat is reading, the
+ * parser takes its tokens from here rather than from flex.
+ *
+ * Names and values are returned as unbound strings (see agstrdup_unbound), so
+ * they only enter the string dictionary when the graph keeps them. HTML
+ * strings are the exception. agxset finds their HTML-ness from the copy
+ * already in the dictionary, so they are entered as soon as they are scanned.
+ */
+/*************************************************************************
+ * Copyright (c) 2011 AT&T Intellectual Property
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * https://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors: Details at https://graphviz.org
+ *************************************************************************/
+
+#include "config.h"
+
+#include <cgraph/agxbuf.h>
+#include <cgraph/cghdr.h>
+#include <cgraph/gv_ctype.h>
+#include <cgraph/mapscan.h>
+#include <cgraph/strview.h>
+#include <errno.h>
+#include <grammar.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <util/alloc.h>
+#include <util/startswith.h>
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+
+/// where the end of the file was reached
+typedef enum {
+  AT_TOKEN,    ///< between tokens
+  IN_COMMENT,  ///< in a `/*...*/` comment
+  IN_QSTRING,  ///< in a quoted string
+  IN_HSTRING,  ///< in an HTML string
+} scan_state_t;
+
+/// how much scanned text to accumulate before releasing its pages
+enum { RELEASE_SIZE = 1 << 24 };
+
+struct Agmmap_s {
+  const char *data;   ///< contents of the file
+  size_t size;        ///< length of `data`
+  size_t pos;         ///< offset in `data` of the next byte to scan
+  size_t released;    ///< length of the prefix of `data` released
+  int graph_type;     ///< `T_graph` or `T_digraph` once the header is seen
+  bool eof_pending;   ///< return end of input next, for `aglexeof`
+  strview_t text;     ///< text of the last token, for error messages
+  scan_state_t state; ///< where the end of the file was reached
+  strview_t partial;  ///< start of an unterminated string
+  agxbuf buf;         ///< scratch space for strings that need rewriting
+};
+
+Agmmap_t *agmmapopen(FILE *f) {
+#ifdef HAVE_SYS_MMAN_H
+  struct stat st;
+  if (fstat(fileno(f), &st) != 0) {
+    return NULL;
+  }
+  if (!S_ISREG(st.st_mode)) {
+    errno = ENODEV;
+    return NULL;
+  }
+
+  Agmmap_t *m = gv_alloc(sizeof(Agmmap_t));
+  m->size = (size_t)st.st_size;
+  // an empty file cannot be mapped, but also needs nothing scanned
+  if (m->size > 0) {
+    void *data = mmap(NULL, m->size, PROT_READ, MAP_PRIVATE, fileno(f), 0);
+    if (data == MAP_FAILED) {
+      free(m);
+      return NULL;
+    }
+#ifdef MADV_SEQUENTIAL
+    (void)madvise(data, m->size, MADV_SEQUENTIAL);
+#endif
+    m->data = data;
+  }
+  return m;
+#else
+  (void)f;
+  errno = ENOTSUP;
+  return NULL;
+#endif
+}
+
+void agmmapclose(Agmmap_t *m) {
+  if (m == NULL) {
+    return;
+  }
+#ifdef HAVE_SYS_MMAN_H
+  if (m->size > 0) {
+    // cast away const, as munmap takes the pointer mmap gave us
+    munmap((void *)(uintptr_t)m->data, m->size);
+  }
+#endif
+  agxbfree(&m->buf);
+  free(m);
+}
+
+Agraph_t *agmmapconcat(Agraph_t *g, Agmmap_t *m, Agdisc_t *disc) {
+  m->graph_type = 0;
+  m->eof_pending = false;
+  aglexmmap(m);
+  g = agconcat(g, NULL, disc);
+  aglexmmap(NULL);
+  agstrclose_unbound();
+  return g;
+}
+
+Agraph_t *agmmapread(Agmmap_t *m, Agdisc_t *disc) {
+  if (m->pos < m->size && agisgvb(m->data + m->pos, m->size - m->pos)) {
+    size_t used = 0;
+    Agraph_t *g = agmemreadgvb(m->data + m->pos, m->size - m->pos, &used, disc);
+    // after a graph that is not valid, there is no telling where the next is
+    m->pos = g == NULL ? m->size : m->pos + used;
+    return g;
+  }
+  return agmmapconcat(NULL, m, disc);
+}
+
+void agmmapeof(Agmmap_t *m) { m->eof_pending = true; }
+
+void agmmapbad(Agmmap_t *m) { m->pos = m->size; }
+
+void agmmapnear(const Agmmap_t *m, agxbuf *xb) {
+  // like aagerror, treat a token starting with NUL as empty
+  if (m->text.size > 0 && m->text.data[0] != '\0') {
+    agxbprint(xb, " near '%.*s'", (int)m->text.size, m->text.data);
+    return;
+  }
+  const int partial = m->partial.size > 80 ? 80 : (int)m->partial.size;
+  switch (m->state) {
+  case IN_QSTRING:
+    agxbput(xb, " scanning a quoted string (missing endquote?)");
+    if (partial > 0) {
+      agxbprint(xb, "\nString starting:\"%.*s", partial, m->partial.data);
+    }
+    break;
+  case IN_HSTRING:
+    agxbput(xb, " scanning a HTML string (missing '>'? bad nesting?)");
+    if (partial > 0) {
+      agxbprint(xb, "\nString starting:<%.*s", partial, m->partial.data);
+    }
+    break;
+  case IN_COMMENT:
+    agxbput(xb, " scanning a /*...*/ comment (missing '*/?)");
+    break;
+  default: // nothing extra to note
+    break;
+  }
+}
+
+/// finish a token spanning `[start, end)`
+static int token(Agmmap_t *m, const char *start, const char *end, int type) {
+  m->text = (strview_t){.data = start, .size = (size_t)(end - start)};
+  m->pos = (size_t)(end - m->data);
+  return type;
+}
+
+/// stop at the end of the file, partway through a token if `state` says so
+static int end_of_file(Agmmap_t *m, scan_state_t state, const char *start) {
+  m->state = state;
+  m->partial = (strview_t){.data = start,
+                           .size = (size_t)(m->data + m->size - start)};
+  return token(m, m->data + m->size, m->data + m->size, 0);
+}
+
+/// the `LETTER` class of scan.l
+static bool is_letter(unsigned char c) {
+  return gv_isalpha(c) || c == '_' || c >= 0200;
+}
+
+/// process a possible line directive, as `ppDirective` in scan.l does
+///
+/// @param text - the directive, from `#` up to the end of the line
+static void directive(Agmmap_t *m, strview_t text, int *line,
+                      const char **file) {
+  static char *filename;
+
+  agxbput_n(&m->buf, text.data, text.size);
+  char *s = agxbuse(&m->buf) + 1; // skip initial #
+  int r, cnt, lineno;
+  char buf[2];
+
+  if (startswith(s, "line"))
+    s += strlen("line");
+  r = sscanf(s, "%d %1[\"]%n", &lineno, buf, &cnt);
+  if (r > 0) { // got line number
+    // ignore if line number was out of range
+    if (lineno <= 0) {
+      return;
+    }
+    *line = lineno - 1;
+    if (r > 1) { // saw quote
+      char *p = s + cnt;
+      char *e = p;
+      while (*e && *e != '"')
+        e++;
+      if (e != p && *e == '"') {
+        *e = '\0';
+        free(filename);
+        filename = gv_strdup(p);
+        *file = filename;
+      }
+    }
+  }
+}
+
+/// scan a number, as the `NUMBER` pattern in scan.l
+///
+/// @param start - the first character, a `-`, `.` or digit
+/// @return the end of the number, or `start` if there is none here
+static const char *number(const char *start, const char *end) {
+  const char *p = start;
+  if (p < end && *p == '-') {
+    ++p;
+  }
+  if (p < end && gv_isdigit(*p)) {
+    while (p < end && gv_isdigit(*p)) {
+      ++p;
+    }
+    if (p < end && *p == '.') {
+      ++p;
+      while (p < end && gv_isdigit(*p)) {
+        ++p;
+      }
+    }
+  } else if (p + 1 < end && *p == '.' && gv_isdigit(p[1])) {
+    ++p;
+    while (p < end && gv_isdigit(*p)) {
+      ++p;
+    }
+  } else {
+    return start;
+  }
+  // the pattern takes one more `.` or letter, for `chkNum` to complain about
+  if (p < end && (*p == '.' || is_letter((unsigned char)*p))) {
+    ++p;
+  }
+  return p;
+}
+
+/// scan the remainder of a quoted string
+///
+/// @param start - the opening quote
+static int qstring(Agmmap_t *m, const char *start, int *line) {
+  const char *const end = m->data + m->size;
+  bool rewrite = false; // are there escapes that change the text?
+  const char *p;
+
+  for (p = start + 1; p < end && *p != '"'; ++p) {
+    if (*p == '\n') {
+      ++*line;
+    } else if (*p == '\\' && p + 1 < end) {
+      if (p[1] == '"') {
+        rewrite = true;
+        ++p;
+      } else if (p[1] == '\\') {
+        ++p;
+      } else if (p[1] == '\n') {
+        rewrite = true;
+        ++*line;
+        ++p;
+      }
+    }
+  }
+  if (p == end) {
+    return end_of_file(m, IN_QSTRING, start + 1);
+  }
+
+  const char *const text = start + 1;
+  const size_t len = (size_t)(p - text);
+  if (!rewrite) {
+    aaglval.str = agstrdup_unbound(text, len);
+  } else {
+    for (size_t i = 0; i < len; ++i) {
+      if (text[i] == '\\' && i + 1 < len) {
+        if (text[i + 1] == '"') { // escaped quote
+          agxbputc(&m->buf, '"');
+          ++i;
+          continue;
+        }
+        if (text[i + 1] == '\\') { // escaped backslash, kept as it is
+          agxbput_n(&m->buf, &text[i], 2);
+          ++i;
+          continue;
+        }
+        if (text[i + 1] == '\n') { // escaped newline, ignored
+          ++i;
+          continue;
+        }
+      }
+      agxbputc(&m->buf, text[i]);
+    }
+    const size_t size = agxblen(&m->buf);
+    aaglval.str = agstrdup_unbound(agxbuse(&m->buf), size);
+  }
+  // as with flex, the text of the token is the closing quote
+  return token(m, p, p + 1, T_qatom);
+}
+
+/// scan the remainder of an HTML string
+///
+/// @param start - the opening `<`
+static int hstring(Agmmap_t *m, const char *start, int *line) {
+  const char *const end = m->data + m->size;
+  int nest = 1;
+  const char *p;
+
+  for (p = start + 1; p < end; ++p) {
+    if (*p == '>') {
+      if (--nest == 0) {
+        break;
+      }
+    } else if (*p == '<') {
+      ++nest;
+    } else if (*p == '\n') {
+      ++*line;
+    }
+  }
+  if (p == end) {
+    return end_of_file(m, IN_HSTRING, start + 1);
+  }
+
+  agxbput_n(&m->buf, start + 1, (size_t)(p - start - 1));
+  aaglval.str = agstrdup_html(Ag_G_global, agxbuse(&m->buf));
+  return token(m, p, p + 1, T_qatom);
+}
+
+int agmmaplex(Agmmap_t *m, int *line, const char **file) {
+  if (m->eof_pending) {
+    m->eof_pending = false;
+    m->text = strview("@", '\0');
+    return EOF;
+  }
+
+#if defined(HAVE_SYS_MMAN_H) && defined(MADV_DONTNEED)
+  // Let go of the pages already scanned, so reading a large file does not
+  // keep all of it resident. They are read back in if touched again.
+  if (m->pos - m->released >= RELEASE_SIZE) {
+    const size_t size = (m->pos - m->released) / RELEASE_SIZE * RELEASE_SIZE;
+    // cast away const, as madvise takes the pointer mmap gave us
+    (void)madvise((void *)(uintptr_t)(m->data + m->released), size,
+                  MADV_DONTNEED);
+    m->released += size;
+  }
+#endif
+
+  const char *const end = m->data + m->size;
+  const char *p = m->data + m->pos;
+  m->state = AT_TOKEN;
+
+  while (p < end) {
+    const char *const start = p;
+    const unsigned char c = (unsigned char)*p;
+
+    switch (c) {
+    case '\n':
+      ++*line;
+      ++p;
+      continue;
+
+    case ' ':
+    case '\t':
+    case '\r':
+      ++p;
+      continue;
+
+    case '@':
+      return token(m, start, p + 1, EOF);
+
+    case '/':
+      if (p + 1 < end && p[1] == '*') {
+        for (p += 2;; ++p) {
+          if (p + 1 >= end) {
+            for (; p < end; ++p) {
+              if (*p == '\n') {
+                ++*line;
+              }
+            }
+            return end_of_file(m, IN_COMMENT, start);
+          }
+          if (*p == '\n') {
+            ++*line;
+          } else if (p[0] == '*' && p[1] == '/') {
+            p += 2;
+            break;
+          }
+        }
+        continue;
+      }
+      if (p + 1 < end && p[1] == '/') {
+        const char *nl = memchr(p, '\n', (size_t)(end - p));
+        p = nl == NULL ? end : nl;
+        continue;
+      }
+      break;
+
+    case '#': {
+      const char *nl = memchr(p, '\n', (size_t)(end - p));
+      p = nl == NULL ? end : nl;
+      // a `#` that starts a line may be a line directive
+      if (start == m->data || start[-1] == '\n') {
+        directive(m, (strview_t){.data = start, .size = (size_t)(p - start)},
+                  line, file);
+      }
+      continue;
+    }
+
+    case '"':
+      return qstring(m, start, line);
+
+    case '<':
+      return hstring(m, start, line);
+
+    case '-':
+      if (p + 1 < end && p[1] == '>') {
+        return token(m, start, p + 2,
+                     m->graph_type == T_digraph ? T_edgeop : '-');
+      }
+      if (p + 1 < end && p[1] == '-') {
+        return token(m, start, p + 2,
+                     m->graph_type == T_graph ? T_edgeop : '-');
+      }
+      break;
+
+    default:
+      break;
+    }
+
+    if (c == '-' || c == '.' || gv_isdigit(c)) {
+      const char *e = number(start, end);
+      if (e != start) {
+        const char last = e[-1];
+        const char *dot = memchr(start, '.', (size_t)(e - start));
+        // was there a dot and was it not the last character?
+        const bool two_dots = dot != NULL && dot != e - 1;
+        if ((!gv_isdigit(last) && last != '.') || (last == '.' && two_dots)) {
+          agwarningf("syntax ambiguity - badly delimited number '%.*s' in "
+                     "line %d of %s splits into two tokens\n",
+                     (int)(e - start), start, *line,
+                     *file ? *file : "input");
+          --e;
+        }
+        aaglval.str = agstrdup_unbound(start, (size_t)(e - start));
+        return token(m, start, e, T_atom);
+      }
+    } else if (is_letter(c)) {
+      while (p < end && (is_letter((unsigned char)*p) || gv_isdigit(*p))) {
+        ++p;
+      }
+      const strview_t name = {.data = start, .size = (size_t)(p - start)};
+      // a byte order mark is ignored, unless it runs into a longer name
+      if (name.size == 3 && memcmp(start, "\xEF\xBB\xBF", 3) == 0) {
+        continue;
+      }
+      if (name.size >= 4 && name.size <= 8) {
+        if (strview_case_str_eq(name, "node")) {
+          return token(m, start, p, T_node);
+        }
+        if (strview_case_str_eq(name, "edge")) {
+          return token(m, start, p, T_edge);
+        }
+        if (strview_case_str_eq(name, "graph")) {
+          if (!m->graph_type) {
+            m->graph_type = T_graph;
+          }
+          return token(m, start, p, T_graph);
+        }
+        if (strview_case_str_eq(name, "digraph")) {
+          if (!m->graph_type) {
+            m->graph_type = T_digraph;
+          }
+          return token(m, start, p, T_digraph);
+        }
+        if (strview_case_str_eq(name, "strict")) {
+          return token(m, start, p, T_strict);
+        }
+        if (strview_case_str_eq(name, "subgraph")) {
+          return token(m, start, p, T_subgraph);
+        }
+      }
+      aaglval.str = agstrdup_unbound(name.data, name.size);
+      return token(m, start, p, T_atom);
+    }
+
+    // any other character is a token of its own
+    return token(m, start, start + 1, c);
+  }
+
+  return end_of_file(m, AT_TOKEN, end);
+}
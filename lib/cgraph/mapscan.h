@@ -0,0 +1,33 @@
+/**
+ * @file
+ * @brief scanner for graph files mapped into memory, see mapscan.c
+ * @ingroup cgraph_core
+ */
+
+#pragma once
+
+#include <cgraph/agxbuf.h>
+#include <cgraph/cgraph.h>
+
+/// take the parser's tokens from a mapped file, or from flex if `m` is NULL
+///
+/// This is defined in scan.l, whose `aaglex` does the switching.
+void aglexmmap(Agmmap_t *m);
+
+/// scan the next token in a mapped file
+///
+/// @param m - mapped file to scan
+/// @param line [inout] - current line number, for messages
+/// @param file [inout] - current file name, for messages, which a line
+///   directive can change
+/// @return the token, as `aaglex` returns it
+int agmmaplex(Agmmap_t *m, int *line, const char **file);
+
+/// make the next token the end of the input, as `aglexeof` does
+void agmmapeof(Agmmap_t *m);
+
+/// discard the rest of a mapped file, after a failed parse
+void agmmapbad(Agmmap_t *m);
+
+/// describe the last token scanned, for a syntax error message
+void agmmapnear(const Agmmap_t *m, agxbuf *xb);
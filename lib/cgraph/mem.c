@@ -14,13 +14,173 @@
  *************************************************************************/
 
 #include <cgraph/cghdr.h>
+#include <stddef.h>
 #include <stdlib.h>
+#include <string.h>
+#include <util/alloc.h>
+
+/* memory management discipline */
+
+static void *memopen(Agdisc_t* disc)
+{
+    (void)disc;
+    return NULL;
+}
+
+static void *memalloc(void *heap, size_t request)
+{
+    (void)heap;
+    return calloc(1, request);
+}
+
+static void *memresize(void *heap, void *ptr, size_t oldsize, size_t request)
+{
+    (void)heap;
+    void *mem = realloc(ptr, request);
+    if (mem != NULL && request > oldsize) {
+	memset((char*)mem + oldsize, 0, request - oldsize);
+    }
+    return mem;
+}
+
+static void memfree(void *heap, void *ptr)
+{
+    (void)heap;
+    free(ptr);
+}
+
+static void memclose(void *heap)
+{
+    (void)heap;
+}
+
+Agmemdisc_t AgMemDisc =
+    { memopen, memalloc, memresize, memfree, memclose };
+
+/* arena discipline:
+ * Objects are carved from chunks that grow geometrically, each zeroed by
+ * calloc, and only released all together when the root graph is closed.
+ * Requests too large to share a chunk get a chunk of their own. The most
+ * recent allocation can grow in place, which is how attribute tables grow.
+ */
+
+enum {
+    CHUNK_MIN = 64 * 1024,	/* first chunk size */
+    CHUNK_MAX = 16 * 1024 * 1024,	/* size chunks stop growing at */
+};
+
+/* a type as strictly aligned as anything malloc returns memory for */
+typedef union {
+    long double ld;
+    long long ll;
+    void *p;
+    void (*fp)(void);
+} align_t;
+
+typedef struct chunk_s {
+    struct chunk_s *next;
+    align_t data[];
+} chunk_t;
+
+typedef struct {
+    chunk_t *chunks;		/* most recent first */
+    char *next;		/* free space in the current chunk */
+    char *end;
+    char *last;			/* most recent allocation, or NULL */
+    size_t chunksize;		/* size of the next chunk */
+} arena_t;
+
+static size_t arenaround(size_t request)
+{
+    const size_t align = sizeof(align_t);
+    return (request + align - 1) / align * align;
+}
+
+static void *arenaopen(Agdisc_t *disc)
+{
+    (void)disc;
+    arena_t *a = gv_alloc(sizeof(arena_t));
+    a->chunksize = CHUNK_MIN;
+    return a;
+}
+
+static char *arenachunk(arena_t *a, size_t size)
+{
+    chunk_t *c = calloc(1, sizeof(chunk_t) + size);
+    if (c == NULL)
+	return NULL;
+    c->next = a->chunks;
+    a->chunks = c;
+    return (char *)c->data;
+}
+
+static void *arenaalloc(void *heap, size_t request)
+{
+    arena_t *a = heap;
+    /* even an empty request gets an address of its own, as from calloc */
+    const size_t size = arenaround(request > 0 ? request : 1);
+
+    if (size > (size_t)(a->end - a->next)) {
+	if (size > a->chunksize / 4)	/* a chunk of its own */
+	    return arenachunk(a, size);
+	char *mem = arenachunk(a, a->chunksize);
+	if (mem == NULL)
+	    return NULL;
+	a->next = mem;
+	a->end = mem + a->chunksize;
+	if (a->chunksize < CHUNK_MAX)
+	    a->chunksize *= 2;
+    }
+    a->last = a->next;
+    a->next += size;
+    return a->last;
+}
+
+static void *arenaresize(void *heap, void *ptr, size_t oldsize,
+			 size_t request)
+{
+    arena_t *a = heap;
+
+    if (ptr != NULL && ptr == a->last) {
+	char *end = a->last + arenaround(request);
+	if (end <= a->end) {
+	    /* free space must stay zeroed, so clear what shrinking gives up */
+	    if (request < oldsize)
+		memset(a->last + request, 0, (size_t)(a->next - a->last) - request);
+	    a->next = end;
+	    return ptr;
+	}
+    }
+    void *mem = arenaalloc(heap, request);
+    if (mem != NULL && ptr != NULL)
+	memcpy(mem, ptr, oldsize < request ? oldsize : request);
+    return mem;
+}
+
+static void arenaclose(void *heap)
+{
+    arena_t *a = heap;
+    if (a == NULL)
+	return;
+    while (a->chunks != NULL) {
+	chunk_t *next = a->chunks->next;
+	free(a->chunks);
+	a->chunks = next;
+    }
+    free(a);
+}
+
+Agmemdisc_t AgArenaMemDisc =
+    { arenaopen, arenaalloc, arenaresize, NULL, arenaclose };
 
 void *agalloc(Agraph_t * g, size_t size)
 {
-    (void)g;
+    void *mem;
 
-    void *mem = calloc(1, size);
+    if (g)
+	mem = AGDISC(g, mem)->alloc(AGCLOS(g, mem), size);
+    else
+	mem = calloc(1, size);
     if (mem == NULL)
 	 agerrorf("memory allocation failure");
     return mem;
@@ -33,12 +193,10 @@ void *agrealloc(Agraph_t * g, void *ptr, size_t oldsize, size_t size)
     if (size > 0) {
 	if (ptr == 0)
 	    mem = agalloc(g, size);
-	else {
-	    mem = realloc(ptr, size);
-	    if (mem != NULL && size > oldsize) {
-	        memset((char*)mem + oldsize, 0, size - oldsize);
-	    }
-	}
+	else if (g)
+	    mem = AGDISC(g, mem)->resize(AGCLOS(g, mem), ptr, oldsize, size);
+	else
+	    mem = memresize(NULL, ptr, oldsize, size);
 	if (mem == NULL)
 	     agerrorf("memory re-allocation failure");
     } else
@@ -48,8 +206,10 @@ void *agrealloc(Agraph_t * g, void *ptr, size_t oldsize, size_t size)
 
 void agfree(Agraph_t * g, void *ptr)
 {
-    (void)g;
-
-    if (ptr)
+    if (ptr == NULL)
+	return;
+    if (g == NULL)
 	free(ptr);
+    else if (AGDISC(g, mem)->free)
+	AGDISC(g, mem)->free(AGCLOS(g, mem), ptr);
 }
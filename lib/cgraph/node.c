@@ -15,9 +15,9 @@
 #include <cgraph/cghdr.h>
 #include <cgraph/node_set.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <util/alloc.h>
-#include <util/unreachable.h>
 
 Agnode_t *agfindnode_by_id(Agraph_t * g, IDTYPE id)
 {
@@ -278,15 +278,6 @@ Agnode_t *agsubnode(Agraph_t * g, Agnode_t * n0, int cflag)
     return n;
 }
 
-/// compare a subnode to an identifier for equality
-///
-/// @param sn0 Operand 1
-/// @param sn1 Operand 2
-/// @return True if nodes are equal
-static bool agsubnodeideq(const Agsubnode_t *sn0, IDTYPE id) {
-  return AGID(sn0->node) == id;
-}
-
 static int agsubnodeseqcmpf(void *arg0, void *arg1) {
     Agsubnode_t *sn0 = arg0;
     Agsubnode_t *sn1 = arg1;
@@ -379,15 +370,21 @@ int agnodebefore(Agnode_t *fst, Agnode_t *snd)
 	return SUCCESS;
 } 
 
+/// a slot in a set
+///
+/// The ID of the node is kept alongside it, so looking for a node only reads
+/// the slots and not the nodes they point to.
+typedef struct {
+  IDTYPE id;         ///< identifier of `item`'s node
+  Agsubnode_t *item; ///< the element, or `NULL` if this slot is empty
+} node_slot_t;
+
 struct graphviz_node_set {
-  Agsubnode_t **slots; ///< backing store for elements
-  size_t size;         ///< number of elements in the set
-  size_t capacity;     ///< size of `slots`
+  node_slot_t *slots; ///< backing store for elements
+  size_t size;        ///< number of elements in the set
+  size_t capacity;    ///< size of `slots`, 0 or a power of 2
 };
 
-/// a sentinel, marking a set slot from which an element has been deleted
-static Agsubnode_t *const TOMBSTONE = (Agsubnode_t *)-1;
-
 node_set_t *node_set_new(void) { return gv_alloc(sizeof(node_set_t)); }
 
 /// compute initial index to attempt to store/find an item in
@@ -396,136 +393,150 @@ node_set_t *node_set_new(void) { return gv_alloc(sizeof(node_set_t)); }
 /// implemented using linear probing, so steps sequentially through indices
 /// following this.
 ///
-/// If the suboptimal choice of using the ID here turns out to be bad for
-/// performance, this could be converted to a more sophisticated hashing
-/// algorithm. None of the callers depend on the exact implementation.
+/// IDs are often pointers, which share their low bits, so they are mixed
+/// before being reduced to an index.
 ///
 /// @param self Set to compute with respect to
-/// @param item Element being sought/added
+/// @param id Identifier of the element being sought/added
 /// @return Initial index to examine
 static size_t node_set_index(const node_set_t *self, IDTYPE id) {
   assert(self != NULL);
   assert(self->capacity != 0);
-  return (size_t)id % self->capacity;
+  uint64_t h = (uint64_t)id * UINT64_C(0x9e3779b97f4a7c15);
+  h ^= h >> 32;
+  return (size_t)h & (self->capacity - 1);
+}
+
+/// a watermark ratio at which the set capacity should be expanded
+static const size_t OCCUPANCY_THRESHOLD_PERCENT = 70;
+
+/// capacity of the backing store when the first element is added
+static const size_t INITIAL_CAPACITY = 16;
+
+/// insert an item that is known not to be in the set, into a free slot
+static void node_set_put(node_set_t *self, IDTYPE id, Agsubnode_t *item) {
+  const size_t mask = self->capacity - 1;
+  size_t i = node_set_index(self, id);
+  while (self->slots[i].item != NULL) {
+    i = (i + 1) & mask;
+  }
+  self->slots[i] = (node_slot_t){.id = id, .item = item};
+  ++self->size;
+}
+
+/// move the elements of a set into a new backing store of the given capacity
+static void node_set_rehash(node_set_t *self, size_t new_c) {
+  assert((new_c & (new_c - 1)) == 0 && "capacity is not a power of 2");
+  node_slot_t *new_slots = gv_calloc(new_c, sizeof(node_slot_t));
+
+  // Construct a new set and copy everything into it. Note we need to rehash
+  // because capacity (and hence modulo wraparound behavior) has changed.
+  node_set_t new_self = {.slots = new_slots, .capacity = new_c};
+  for (size_t i = 0; i < self->capacity; ++i) {
+    // skip empty slots
+    if (self->slots[i].item == NULL) {
+      continue;
+    }
+    node_set_put(&new_self, self->slots[i].id, self->slots[i].item);
+  }
+
+  // replace ourselves with this new set
+  free(self->slots);
+  *self = new_self;
 }
 
 void node_set_add(node_set_t *self, Agsubnode_t *item) {
   assert(self != NULL);
   assert(item != NULL);
 
-  // a watermark ratio at which the set capacity should be expanded
-  static const size_t OCCUPANCY_THRESHOLD_PERCENT = 70;
-
   // do we need to expand the backing store?
   const bool grow =
-      100 * self->size >= OCCUPANCY_THRESHOLD_PERCENT * self->capacity;
+      100 * (self->size + 1) > OCCUPANCY_THRESHOLD_PERCENT * self->capacity;
 
   if (grow) {
-    const size_t new_c = self->capacity == 0 ? 1024 : self->capacity * 2;
-    Agsubnode_t **new_slots = gv_calloc(new_c, sizeof(Agsubnode_t *));
-
-    // Construct a new set and copy everything into it. Note we need to rehash
-    // because capacity (and hence modulo wraparound behavior) has changed. This
-    // conveniently flushes out the tombstones too.
-    node_set_t new_self = {.slots = new_slots, .capacity = new_c};
-    for (size_t i = 0; i < self->capacity; ++i) {
-      // skip empty slots
-      if (self->slots[i] == NULL) {
-        continue;
-      }
-      // skip deleted slots
-      if (self->slots[i] == TOMBSTONE) {
-        continue;
-      }
-      node_set_add(&new_self, self->slots[i]);
-    }
-
-    // replace ourselves with this new set
-    free(self->slots);
-    *self = new_self;
+    node_set_rehash(self, self->capacity == 0 ? INITIAL_CAPACITY
+                                              : self->capacity * 2);
   }
 
   assert(self->capacity > self->size);
 
-  const size_t index = node_set_index(self, item->node->base.tag.id);
+  node_set_put(self, item->node->base.tag.id, item);
+}
 
-  for (size_t i = 0; i < self->capacity; ++i) {
-    const size_t candidate = (index + i) % self->capacity;
+void node_set_reserve(node_set_t *self, size_t size) {
+  assert(self != NULL);
 
-    // if we found an empty slot or a previously deleted slot, we can insert
-    if (self->slots[candidate] == NULL || self->slots[candidate] == TOMBSTONE) {
-      self->slots[candidate] = item;
-      ++self->size;
-      return;
-    }
+  // the capacity `node_set_add` would have grown to, to hold this many
+  size_t new_c = self->capacity == 0 ? INITIAL_CAPACITY : self->capacity;
+  while (100 * size > OCCUPANCY_THRESHOLD_PERCENT * new_c) {
+    new_c *= 2;
   }
 
-  UNREACHABLE();
+  if (new_c > self->capacity) {
+    node_set_rehash(self, new_c);
+  }
 }
 
-Agsubnode_t *node_set_find(node_set_t *self, IDTYPE key) {
-  assert(self != NULL);
-
+/// find the slot holding a node
+///
+/// @param self Set to search
+/// @param key Identifier of node to look for
+/// @return Index of the slot, or `self->capacity` if it was not in the set
+static size_t node_set_slot(const node_set_t *self, IDTYPE key) {
   // early exit to avoid `self->slots == NULL`/`self->capacity == 0`
   // complications
   if (self->size == 0) {
-    return NULL;
+    return self->capacity;
   }
 
-  const size_t index = node_set_index(self, key);
-
-  for (size_t i = 0; i < self->capacity; ++i) {
-    const size_t candidate = (index + i) % self->capacity;
-
+  const size_t mask = self->capacity - 1;
+  for (size_t i = node_set_index(self, key);; i = (i + 1) & mask) {
     // if we found an empty slot, the sought item does not exist
-    if (self->slots[candidate] == NULL) {
-      return NULL;
+    if (self->slots[i].item == NULL) {
+      return self->capacity;
     }
-
-    // if we found a previously deleted slot, skip over it
-    if (self->slots[candidate] == TOMBSTONE) {
-      continue;
-    }
-
-    if (agsubnodeideq(self->slots[candidate], key)) {
-      return self->slots[candidate];
+    if (self->slots[i].id == key) {
+      return i;
     }
   }
+}
 
-  return NULL;
+Agsubnode_t *node_set_find(node_set_t *self, IDTYPE key) {
+  assert(self != NULL);
+
+  const size_t i = node_set_slot(self, key);
+  if (i == self->capacity) {
+    return NULL;
+  }
+  assert(AGID(self->slots[i].item->node) == key);
+  return self->slots[i].item;
 }
 
 void node_set_remove(node_set_t *self, IDTYPE item) {
   assert(self != NULL);
 
-  // early exit to avoid `self->slots == NULL`/`self->capacity == 0`
-  // complications
-  if (self->size == 0) {
+  size_t hole = node_set_slot(self, item);
+  if (hole == self->capacity) {
     return;
   }
-
-  const size_t index = node_set_index(self, item);
-
-  for (size_t i = 0; i < self->capacity; ++i) {
-    const size_t candidate = (index + i) % self->capacity;
-
-    // if we found an empty slot, the sought item does not exist
-    if (self->slots[candidate] == NULL) {
-      return;
-    }
-
-    // if we found a previously deleted slot, skip over it
-    if (self->slots[candidate] == TOMBSTONE) {
-      continue;
-    }
-
-    if (agsubnodeideq(self->slots[candidate], item)) {
-      assert(self->size > 0);
-      self->slots[candidate] = TOMBSTONE;
-      --self->size;
-      return;
+  assert(self->size > 0);
+  --self->size;
+
+  // Rather than leaving a marker in the emptied slot, shift back any later
+  // elements of the same run that would no longer be found past the hole.
+  const size_t mask = self->capacity - 1;
+  for (size_t i = (hole + 1) & mask; self->slots[i].item != NULL;
+       i = (i + 1) & mask) {
+    const size_t home = node_set_index(self, self->slots[i].id);
+    // is `home` cyclically in (hole, i]? if so, this element can stay
+    const bool stays = hole <= i ? hole < home && home <= i
+                                 : hole < home || home <= i;
+    if (!stays) {
+      self->slots[hole] = self->slots[i];
+      hole = i;
     }
   }
+  self->slots[hole] = (node_slot_t){0};
 }
 
 size_t node_set_size(const node_set_t *self) {
@@ -27,6 +27,14 @@ node_set_t *node_set_new(void);
 /// @param item Element to add
 void node_set_add(node_set_t *self, Agsubnode_t *item);
 
+/// make room for a number of items without expanding the backing store
+///
+/// On allocation failure, `exit` is called.
+///
+/// @param self Set to expand
+/// @param size Number of items the set should be able to hold
+void node_set_reserve(node_set_t *self, size_t size);
+
 /// lookup an existing item in a set
 ///
 /// @param self Set to search
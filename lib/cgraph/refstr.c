@@ -16,100 +16,207 @@
 #include <cgraph/cghdr.h>
 #include <stddef.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <util/alloc.h>
+#include <util/thread.h>
 
 /*
  * reference counted strings.
+ *
+ * Each graph's strings, and those of no graph, are kept in a hash table with
+ * linear probing. A string stores its hash, so the table is resized, and a
+ * string found again from its pointer, without hashing its text again.
  */
 
 typedef struct {
-    Dtlink_t link;
-    uint64_t refcnt: sizeof(uint64_t) * 8 - 1;
-    uint64_t is_html: 1;
-    char *s;
+    uint64_t refcnt;		/* 0 for an unbound string */
+    uint32_t hash: 31;
+    uint32_t is_html: 1;
     char store[1];		/* this is actually a dynamic array */
 } refstr_t;
 
-static Dtdisc_t Refstrdisc = {
-    offsetof(refstr_t, s),	/* key */
-    -1,				/* size */
-    0,				/* link offset */
-    NULL,
-    agdictobjfree,
-    NULL,
+/// a string dictionary
+struct graphviz_strdict {
+    refstr_t **slot;
+    size_t size;		///< number of strings
+    size_t capacity;		///< number of slots, 0 or a power of 2
 };
+typedef struct graphviz_strdict strdict_t;
+
+static strdict_t *Refdict_default;
+/// protects `Refdict_default`, which is shared by all threads
+static gv_mutex_t Refdict_lock = GV_MUTEX_INIT;
+
+/// the string whose text is at `s`
+static refstr_t *refstrof(const char *s)
+{
+    return (refstr_t *)(uintptr_t)(s - offsetof(refstr_t, store[0]));
+}
 
-static Dict_t *Refdict_default;
+/// FNV-1a hash of a string, to the 31 bits stored, also finding its length
+static uint32_t strhash(const char *s, size_t *len)
+{
+    uint32_t h = 2166136261u;
+    const char *p;
+    for (p = s; *p != '\0'; ++p)
+	h = (h ^ (unsigned char)*p) * 16777619u;
+    *len = (size_t)(p - s);
+    return h & 0x7fffffff;
+}
 
 /* refdict:
- * Return the string dictionary associated with g.
- * If necessary, create it.
- * As a side-effect, set html masks. This assumes 8-bit bytes.
+ * Return where the string dictionary associated with g is kept.
  */
-static Dict_t *refdict(Agraph_t * g)
+static strdict_t **refdict(Agraph_t * g)
 {
-    Dict_t **dictref;
-
     if (g)
-	dictref = &(g->clos->strdict);
-    else
-	dictref = &Refdict_default;
-    if (*dictref == NULL) {
-	*dictref = agdtopen(g, &Refstrdisc, Dttree);
-    }
-    return *dictref;
+	return &g->clos->strdict;
+    return &Refdict_default;
 }
 
-int agstrclose(Agraph_t * g)
+/// add to a string's reference count, returning the new count
+///
+/// Counts of strings of no graph are changed atomically, as @ref agstrref
+/// changes them without holding `Refdict_lock`.
+static uint64_t refadd(Agraph_t *g, refstr_t *r, int64_t delta)
 {
-    return agdtclose(g, refdict(g));
+    if (g == NULL)
+	return gv_atomic_add(&r->refcnt, delta);
+    r->refcnt += (uint64_t)delta;
+    return r->refcnt;
 }
 
-static refstr_t *refsymbind(Dict_t * strdict, const char *s)
+int agstrclose(Agraph_t * g)
 {
-    refstr_t key, *r;
-// Suppress Clang/GCC -Wcast-qual warning. Casting away const here is acceptable
-// as dtsearch does not modify its input key.
-#ifdef __GNUC__
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wcast-qual"
-#endif
-    key.s = (char*)s;
-#ifdef __GNUC__
-#pragma GCC diagnostic pop
-#endif
-    r = dtsearch(strdict, &key);
-    return r;
+    strdict_t **dictref = refdict(g);
+    strdict_t *d = *dictref;
+
+    if (d == NULL)
+	return 0;
+    for (size_t i = 0; i < d->capacity; ++i) {
+	if (d->slot[i] == NULL)
+	    continue;
+	if (g)
+	    agfree(g, d->slot[i]);
+	else
+	    free(d->slot[i]);
+    }
+    free(d->slot);
+    free(d);
+    *dictref = NULL;
+    return 0;
 }
 
-static char *refstrbind(Dict_t * strdict, const char *s)
+static refstr_t *refsymbind(const strdict_t *d, const char *s, uint32_t hash)
 {
-    refstr_t *r;
-    r = refsymbind(strdict, s);
-    if (r)
-	return r->s;
-    else
+    if (d == NULL || d->capacity == 0)
 	return NULL;
+    const size_t mask = d->capacity - 1;
+    for (size_t i = hash & mask; d->slot[i] != NULL; i = (i + 1) & mask) {
+	refstr_t *r = d->slot[i];
+	if (r->hash == hash && strcmp(r->store, s) == 0)
+	    return r;
+    }
+    return NULL;
+}
+
+/// the slot holding `r`, or `SIZE_MAX` if it is not in the dictionary
+static size_t refslot(const strdict_t *d, const refstr_t *r)
+{
+    if (d == NULL || d->capacity == 0)
+	return SIZE_MAX;
+    const size_t mask = d->capacity - 1;
+    for (size_t i = r->hash & mask; d->slot[i] != NULL; i = (i + 1) & mask) {
+	if (d->slot[i] == r)
+	    return i;
+    }
+    return SIZE_MAX;
+}
+
+/// enter a string, which must not already be in the dictionary
+static void refinsert(strdict_t **dictref, refstr_t *r)
+{
+    if (*dictref == NULL)
+	*dictref = gv_alloc(sizeof(strdict_t));
+    strdict_t *d = *dictref;
+
+    // keep the table at most 3/4 full
+    if ((d->size + 1) * 4 > d->capacity * 3) {
+	const size_t capacity = d->capacity == 0 ? 64 : d->capacity * 2;
+	refstr_t **slot = gv_calloc(capacity, sizeof(slot[0]));
+	for (size_t i = 0; i < d->capacity; ++i) {
+	    refstr_t *old = d->slot[i];
+	    if (old == NULL)
+		continue;
+	    size_t j = old->hash & (capacity - 1);
+	    while (slot[j] != NULL)
+		j = (j + 1) & (capacity - 1);
+	    slot[j] = old;
+	}
+	free(d->slot);
+	d->slot = slot;
+	d->capacity = capacity;
+    }
+
+    const size_t mask = d->capacity - 1;
+    size_t i = r->hash & mask;
+    while (d->slot[i] != NULL)
+	i = (i + 1) & mask;
+    d->slot[i] = r;
+    ++d->size;
+}
+
+/// remove the string in slot `i`
+///
+/// Later strings of the same probe sequence are moved back over the gap, so
+/// that lookups need not step over deleted slots.
+static void refdelete(strdict_t *d, size_t i)
+{
+    const size_t mask = d->capacity - 1;
+    for (size_t j = (i + 1) & mask; d->slot[j] != NULL; j = (j + 1) & mask) {
+	const size_t home = d->slot[j]->hash & mask;
+	// can the string in slot j move to slot i, i.e. is its home slot not
+	// cyclically in (i, j]?
+	const bool stays = i <= j ? (i < home && home <= j)
+				  : (i < home || home <= j);
+	if (!stays) {
+	    d->slot[i] = d->slot[j];
+	    i = j;
+	}
+    }
+    d->slot[i] = NULL;
+    --d->size;
 }
 
 char *agstrbind(Agraph_t * g, const char *s)
 {
-    return refstrbind(refdict(g), s);
+    size_t len;
+    const uint32_t hash = strhash(s, &len);
+    if (g == NULL)
+	gv_mutex_lock(&Refdict_lock);
+    refstr_t *r = refsymbind(*refdict(g), s, hash);
+    if (g == NULL)
+	gv_mutex_unlock(&Refdict_lock);
+    return r ? r->store : NULL;
 }
 
 static char *agstrdup_internal(Agraph_t *g, const char *s, bool is_html) {
     refstr_t *r;
-    Dict_t *strdict;
-    size_t sz;
+    strdict_t **dictref;
+    size_t len, sz;
 
     if (s == NULL)
 	 return NULL;
-    strdict = refdict(g);
-    r = refsymbind(strdict, s);
+    const uint32_t hash = strhash(s, &len);
+    dictref = refdict(g);
+    r = refsymbind(*dictref, s, hash);
     if (r)
-	r->refcnt++;
+	refadd(g, r, 1);
     else {
-	sz = sizeof(refstr_t) + strlen(s);
+	sz = sizeof(refstr_t) + len;
 	if (g)
 	    r = agalloc(g, sz);
 	else {
@@ -119,43 +226,130 @@ static char *agstrdup_internal(Agraph_t *g, const char *s, bool is_html) {
 	    }
 	}
 	r->refcnt = 1;
+	r->hash = hash;
 	r->is_html = is_html;
-	strcpy(r->store, s);
-	r->s = r->store;
-	dtinsert(strdict, r);
+	memcpy(r->store, s, len + 1);
+	refinsert(dictref, r);
     }
-    return r->s;
+    return r->store;
+}
+
+static char *agstrdup_locked(Agraph_t *g, const char *s, bool is_html) {
+    if (g != NULL)
+	return agstrdup_internal(g, s, is_html);
+    gv_mutex_lock(&Refdict_lock);
+    char *rv = agstrdup_internal(g, s, is_html);
+    gv_mutex_unlock(&Refdict_lock);
+    return rv;
 }
 
 char *agstrdup(Agraph_t *g, const char *s) {
-  return agstrdup_internal(g, s, false);
+  return agstrdup_locked(g, s, false);
 }
 
 char *agstrdup_html(Agraph_t *g, const char *s) {
-  return agstrdup_internal(g, s, true);
+  return agstrdup_locked(g, s, true);
 }
 
-int agstrfree(Agraph_t * g, const char *s)
+char *agstrref(Agraph_t *g, const char *s) {
+    if (s == NULL)
+	return NULL;
+    refstr_t *r = refstrof(s);
+    if (g == NULL) {
+	refadd(g, r, 1);
+	return r->store;
+    }
+    // a string of another dictionary, or an unbound one, is copied
+    if (r->refcnt == 0 || refslot(*refdict(g), r) == SIZE_MAX)
+	return agstrdup_internal(g, s, false);
+    refadd(g, r, 1);
+    return r->store;
+}
+
+static int agstrfree_internal(Agraph_t * g, const char *s)
 {
-    refstr_t *r;
-    Dict_t *strdict;
+    strdict_t *strdict = *refdict(g);
+    refstr_t *r = refstrof(s);
+    const size_t i = refslot(strdict, r);
 
+    if (i == SIZE_MAX)
+	return FAILURE;
+    if (refadd(g, r, -1) == 0) {
+	refdelete(strdict, i);
+	if (g)
+	    agfree(g, r);
+	else
+	    free(r);
+    }
+    return SUCCESS;
+}
+
+int agstrfree(Agraph_t * g, const char *s)
+{
     if (s == NULL)
 	 return FAILURE;
+    if (g != NULL)
+	return agstrfree_internal(g, s);
+    gv_mutex_lock(&Refdict_lock);
+    const int rc = agstrfree_internal(g, s);
+    gv_mutex_unlock(&Refdict_lock);
+    return rc;
+}
 
-    strdict = refdict(g);
-    r = refsymbind(strdict, s);
-    if (r && r->s == s) {
-	r->refcnt--;
-	if (r->refcnt == 0) {
-	    agdtdelete(g, strdict, r);
-	}
-    }
-    if (r == NULL)
+/* unbound strings:
+ * Strings laid out like a refstr_t, so that aghtmlstr works on them, but not
+ * entered in any string dictionary. The mapped file scanner returns names and
+ * values as these, leaving whatever keeps them to enter them in a dictionary,
+ * rather than entering every token only for the parser to release most of
+ * them again. A reference count of 0 tells them apart from dictionary strings.
+ * They are kept in a list, so those the parser drops, as it does after a
+ * syntax error, can be released once it is done.
+ */
+typedef struct unbound_s {
+    struct unbound_s *prev, *next;
+    refstr_t r;
+} unbound_t;
+
+static unbound_t *Unbound;
+
+char *agstrdup_unbound(const char *s, size_t len)
+{
+    unbound_t *u = gv_alloc(offsetof(unbound_t, r) + sizeof(refstr_t) + len);
+    memcpy(u->r.store, s, len);
+    u->next = Unbound;
+    if (Unbound)
+	Unbound->prev = u;
+    Unbound = u;
+    return u->r.store;
+}
+
+int agstrfree_unbound(Agraph_t *g, char *s)
+{
+    refstr_t *r;
+    unbound_t *u;
+
+    if (s == NULL)
 	return FAILURE;
+    r = refstrof(s);
+    if (r->refcnt != 0)
+	return agstrfree(g, s);
+    u = (unbound_t *) ((char *) r - offsetof(unbound_t, r));
+    if (u->prev)
+	u->prev->next = u->next;
+    else
+	Unbound = u->next;
+    if (u->next)
+	u->next->prev = u->prev;
+    free(u);
     return SUCCESS;
 }
 
+void agstrclose_unbound(void)
+{
+    while (Unbound)
+	agstrfree_unbound(NULL, Unbound->r.store);
+}
+
 /* aghtmlstr:
  * Return true if s is an HTML string.
  * We assume s points to the datafield store[0] of a refstr.
@@ -166,7 +360,7 @@ int aghtmlstr(const char *s)
 
     if (s == NULL)
 	return 0;
-    key = (const refstr_t *) (s - offsetof(refstr_t, store[0]));
+    key = refstrof(s);
     return key->is_html;
 }
 
@@ -176,20 +370,17 @@ void agmarkhtmlstr(char *s)
 
     if (s == NULL)
 	return;
-    key = (refstr_t *) (s - offsetof(refstr_t, store[0]));
-    key->is_html = 1;
+    key = refstrof(s);
+    key->is_html = true;
 }
 
 #ifdef DEBUG
-static int refstrprint(void *ptr, void *user) {
-    refstr_t *r = ptr;
-    (void)user;
-    fprintf(stderr, "%s\n", r->s);
-    return 0;
-}
-
 void agrefstrdump(Agraph_t * g)
 {
-    dtwalk(refdict(g), refstrprint, 0);
+    const strdict_t *d = *refdict(g);
+    for (size_t i = 0; d != NULL && i < d->capacity; ++i) {
+	if (d->slot[i] != NULL)
+	    fprintf(stderr, "%s\n", d->slot[i]->store);
+    }
 }
 #endif
@@ -16,7 +16,7 @@
 #include <cgraph/cghdr.h>
 #include <stddef.h>
 
-static Agraph_t *Ag_dictop_G;
+static TLS Agraph_t *Ag_dictop_G;
 
 void agdictobjfree(void *p) {
     Agraph_t *g = Ag_dictop_G;
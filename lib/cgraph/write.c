@@ -22,6 +22,7 @@
 #include <stddef.h>
 #include <stdio.h>		/* need sprintf() */
 #include <ctype.h>
+#include <cgraph/agxbuf.h>
 #include <cgraph/cghdr.h>
 #include <cgraph/gv_ctype.h>
 #include <inttypes.h>
@@ -31,12 +32,33 @@
 #define MAX(a,b)     ((a)>(b)?(a):(b))
 #define CHKRV(v)     {if ((v) == EOF) return EOF;}
 
-typedef void iochan_t;
+/// output collected ahead of the I/O discipline
+///
+/// Output is produced a token at a time. Rather than calling the discipline's
+/// `putstr` for each, tokens are gathered in a buffer that is passed on when it
+/// reaches `OUTPUT_BUFSIZE` bytes and at the end of the graph.
+typedef struct {
+    void *chan; ///< channel given to `agwrite`
+    agxbuf buf; ///< output not yet passed to the discipline
+} iochan_t;
 
-static int ioput(Agraph_t * g, iochan_t * ofile, char *str)
-{
-    return AGDISC(g, io)->putstr(ofile, str);
+#define OUTPUT_BUFSIZE (64 * 1024)
+
+static int ioflush(Agraph_t *g, iochan_t *ofile) {
+    if (agxblen(&ofile->buf) == 0)
+	return 0;
+    return AGDISC(g, io)->putstr(ofile->chan, agxbuse(&ofile->buf));
+}
+
+static int ioput_n(Agraph_t *g, iochan_t *ofile, const char *str, size_t len) {
+    agxbput_n(&ofile->buf, str, len);
+    if (agxblen(&ofile->buf) < OUTPUT_BUFSIZE)
+	return 0;
+    return ioflush(g, ofile);
+}
 
+static int ioput(Agraph_t *g, iochan_t *ofile, const char *str) {
+    return ioput_n(g, ofile, str, strlen(str));
 }
 
 #define MAX_OUTPUTLINE		128
@@ -258,16 +280,65 @@ char *agcanon(char *str, int html)
 	return _agstrcanon(str, buf);
 }
 
-static int _write_canonstr(Agraph_t *g, iochan_t *ofile, char *str, bool chk) {
-    if (chk) {
-	str = agcanonStr(str);
+/// would `_agstrcanon` return this string unchanged?
+///
+/// This is a conservative test that lets most IDs be written without the copy
+/// `_agstrcanon` makes. A false result only means the full canonicalization is
+/// needed, so strings long enough to be broken across lines always get it.
+static bool is_plain_id(const char *str, size_t *len) {
+    const char *s = str;
+    if (gv_isdigit(*s) || *s == '.' || *s == '-') {
+	int dots = 0;
+	if (*s == '-')
+	    s++;
+	for (; *s != '\0'; s++) {
+	    if (*s == '.') {
+		if (dots++)
+		    return false;
+	    } else if (!gv_isdigit(*s)) {
+		return false;
+	    }
+	}
+	if (s - str == 1 && !gv_isdigit(*str)) // a lone '.' or '-'
+	    return false;
     } else {
-	char *buffer = getoutputbuffer(str);
-	if (buffer == NULL)
-	    return EOF;
-	str = _agstrcanon(str, buffer);
+	for (; *s != '\0'; s++) {
+	    if (!(gv_isalnum(*s) || *s == '_' || !isascii(*s)))
+		return false;
+	}
+	if (s == str)
+	    return false;
+    }
+    *len = (size_t)(s - str);
+    if (Max_outputline && *len > (size_t)Max_outputline)
+	return false;
+    // keywords, see `_agstrcanon`
+    if (*len >= 4 && *len <= 8 && gv_isalpha(*str)) {
+	static const char *const tokenlist[] = {"node", "edge", "strict", "graph",
+	                                        "digraph", "subgraph"};
+	for (size_t i = 0; i < sizeof(tokenlist) / sizeof(tokenlist[0]); i++)
+	    if (!strcasecmp(tokenlist[i], str))
+		return false;
     }
-    return ioput(g, ofile, str);
+    return true;
+}
+
+/// write a string canonicalized for printing
+///
+/// @param chk Whether `str` is a reference counted string, that may be HTML
+static int _write_canonstr(Agraph_t *g, iochan_t *ofile, char *str, bool chk) {
+    if (chk && aghtmlstr(str)) {
+	CHKRV(ioput(g, ofile, "<"));
+	CHKRV(ioput(g, ofile, str));
+	return ioput(g, ofile, ">");
+    }
+    size_t len;
+    if (is_plain_id(str, &len))
+	return ioput_n(g, ofile, str, len);
+    char *buffer = getoutputbuffer(str);
+    if (buffer == NULL)
+	return EOF;
+    return ioput(g, ofile, _agstrcanon(str, buffer));
 }
 
 static int write_canonstr(Agraph_t * g, iochan_t * ofile, char *str)
@@ -277,6 +348,8 @@ static int write_canonstr(Agraph_t * g, iochan_t * ofile, char *str)
     /* str may not have been allocated by agstrdup, so we first need to turn it
      * into a valid refstr
      */
+    if (agstrbind(g, str) == str)
+	return _write_canonstr(g, ofile, str, true);
     s = agstrdup(g, str);
 
     int r = _write_canonstr(g, ofile, s, true);
@@ -285,6 +358,11 @@ static int write_canonstr(Agraph_t * g, iochan_t * ofile, char *str)
     return r;
 }
 
+/// write an attribute name or value, which is always a refstr of `g`
+static int write_attrstr(Agraph_t *g, iochan_t *ofile, char *str) {
+    return _write_canonstr(g, ofile, str, true);
+}
+
 static int write_dict(Agraph_t * g, iochan_t * ofile, char *name,
                       Dict_t * dict, bool top) {
     int cnt = 0;
@@ -313,9 +391,9 @@ static int write_dict(Agraph_t * g, iochan_t * ofile, char *name,
 	    CHKRV(ioput(g, ofile, ",\n"));
 	    CHKRV(indent(g, ofile));
 	}
-	CHKRV(write_canonstr(g, ofile, sym->name));
+	CHKRV(write_attrstr(g, ofile, sym->name));
 	CHKRV(ioput(g, ofile, "="));
-	CHKRV(write_canonstr(g, ofile, sym->defval));
+	CHKRV(write_attrstr(g, ofile, sym->defval));
     }
     if (cnt > 0) {
 	Level--;
@@ -534,9 +612,9 @@ static int write_nondefault_attrs(void *obj, iochan_t * ofile,
 		    CHKRV(ioput(g, ofile, ",\n"));
 		    CHKRV(indent(g, ofile));
 		}
-		CHKRV(write_canonstr(g, ofile, sym->name));
+		CHKRV(write_attrstr(g, ofile, sym->name));
 		CHKRV(ioput(g, ofile, "="));
-		CHKRV(write_canonstr(g, ofile, data->str[sym->id]));
+		CHKRV(write_attrstr(g, ofile, data->str[sym->id]));
 	    }
 	}
     if (cnt > 0) {
@@ -716,9 +794,17 @@ int agwrite(Agraph_t * g, void *ofile)
 	    Max_outputline = (int)len;
     }
     set_attrwf(g, true, false);
-    CHKRV(write_hdr(g, ofile, true));
-    CHKRV(write_body(g, ofile));
-    CHKRV(write_trl(g, ofile));
+    iochan_t out = {.chan = ofile};
+    int rc = write_hdr(g, &out, true);
+    if (rc != EOF)
+	rc = write_body(g, &out);
+    if (rc != EOF)
+	rc = write_trl(g, &out);
+    if (rc != EOF)
+	rc = ioflush(g, &out);
+    agxbfree(&out.buf);
     Max_outputline = MAX_OUTPUTLINE;
+    if (rc == EOF)
+	return EOF;
     return AGDISC(g, io)->flush(ofile);
 }
@@ -243,6 +243,7 @@ enum {
  * Bit(s):  0     unused
  *          1-3   EDGETYPE_
  *          4     NEW_RANK
+ *          5     INCREMENTAL
  */
 
 /* edge types */
@@ -256,6 +257,9 @@ enum {
 
 /* New ranking is used */
 #define NEW_RANK    	(1 << 4)
+
+/* Layout is seeded from a previous one (dot's incremental attribute) */
+#define INCREMENTAL    	(1 << 5)
 /******/
 
 /* user-specified node position: ND_pinned */
@@ -28,6 +28,7 @@
 #include <util/startswith.h>
 #include <util/strcasecmp.h>
 #include <util/streq.h>
+#include <util/thread.h>
 
 static char *usageFmt =
     "Usage: %s [-Vv?] [-(GNE)name=val] [-(KTlso)<val>] <dot files>\n";
@@ -70,6 +71,9 @@ static char *configItems = "\n\
                with available plugin information.  Needs write privilege.)\n\
  -?          - Print usage and exit\n";
 
+/// graphs to parse ahead of layout, given `--pipeline` without a count
+#define DEFAULT_PARSE_AHEAD 4
+
 /* Print usage information. If GvExitOnUsage is set, exit with
  * given exval, else return exval+1.
  *
@@ -273,6 +277,16 @@ int dotneato_args_initialize(GVC_t * gvc, int argc, char **argv)
 	} else if (argv[i] && startswith(argv[i], "--filepath=")) {
 	    free(Gvfilepath);
 	    Gvfilepath = gv_strdup(argv[i] + strlen("--filepath="));
+	} else if (argv[i] && strcmp(argv[i], "--pipeline") == 0) {
+	    gvc->parse_ahead = DEFAULT_PARSE_AHEAD;
+	} else if (argv[i] && startswith(argv[i], "--pipeline=")) {
+	    v = atoi(argv[i] + strlen("--pipeline="));
+	    if (v <= 0) {
+		fprintf(stderr, "Invalid parameter \"%s\" for --pipeline flag\n",
+		        argv[i] + strlen("--pipeline="));
+		return dotneato_usage(argv[0], 1);
+	    }
+	    gvc->parse_ahead = (size_t)v;
 	} else if (argv[i] && argv[i][0] == '-') {
 	    rest = &argv[i][2];
 	    switch (c = argv[i][1]) {
@@ -503,44 +517,149 @@ void getdouble(graph_t * g, char *name, double *result)
     }
 }
 
-graph_t *gvNextInputGraph(GVC_t *gvc)
+/// where reading input files is up to
+typedef struct {
+    char *fn;
+    FILE *fp;
+    FILE *oldfp;
+    Agmmap_t *mapped;
+    bool gvb; ///< is `fp` in the gvb binary format?
+    int gidx;
+} input_t;
+
+/// what was read next: a graph, a file that could not be opened, or neither at
+/// the end of the input
+typedef struct {
+    graph_t *g;
+    char *fn;
+    int gidx;
+    int err; ///< `errno` from failing to open `fn`, or 0
+} input_item_t;
+
+static input_item_t read_input(GVC_t *gvc, input_t *in)
 {
-    graph_t *g = NULL;
-    static char *fn;
-    static FILE *fp;
-    static FILE *oldfp;
-    static int gidx;
-
-    while (!g) {
-	if (!fp) {
-    	    if (!(fn = gvc->input_filenames[0])) {
+    for (;;) {
+	if (!in->fp) {
+	    if (!(in->fn = gvc->input_filenames[0])) {
 		if (gvc->fidx++ == 0)
-		    fp = stdin;
+		    in->fp = stdin;
 	    }
-	    else {
-		while ((fn = gvc->input_filenames[gvc->fidx++]) && !(fp = gv_fopen(fn, "r")))  {
-		    agerrorf("%s: can't open %s: %s\n", gvc->common.cmdname, fn, strerror(errno));
-		    graphviz_errors++;
-		}
+	    else if ((in->fn = gvc->input_filenames[gvc->fidx])) {
+		gvc->fidx++;
+		if (!(in->fp = gv_fopen(in->fn, "r")))
+		    return (input_item_t){.fn = in->fn, .err = errno};
 	    }
 	}
-	if (fp == NULL)
-	    break;
-	if (oldfp != fp) {
-	    agsetfile(fn ? fn : "<stdin>");
-	    oldfp = fp;
+	if (in->fp == NULL)
+	    return (input_item_t){0};
+	if (in->oldfp != in->fp) {
+	    agsetfile(in->fn ? in->fn : "<stdin>");
+	    in->oldfp = in->fp;
+	    // read named files in place where possible, which is faster
+	    if (in->fp != stdin)
+		in->mapped = agmmapopen(in->fp);
+	    // otherwise look for the first byte of a gvb header, which cannot
+	    // start a DOT file
+	    if (!in->mapped) {
+		const int c = getc(in->fp);
+		in->gvb = c == 0x89;
+		if (c != EOF)
+		    ungetc(c, in->fp);
+	    }
 	}
-	g = agread(fp,NULL);
-	if (g) {
-	    gvg_init(gvc, g, fn, gidx++);
-	    break;
+	graph_t *g = in->mapped ? agmmapread(in->mapped, NULL)
+	           : in->gvb ? agreadgvb(in->fp, NULL)
+	                     : agread(in->fp, NULL);
+	if (g)
+	    return (input_item_t){.g = g, .fn = in->fn, .gidx = in->gidx++};
+	agmmapclose(in->mapped);
+	in->mapped = NULL;
+	if (in->fp != stdin)
+	    fclose(in->fp);
+	in->oldfp = in->fp = NULL;
+	in->gidx = 0;
+    }
+}
+
+/// state of reading input on another thread
+typedef struct {
+    GVC_t *gvc;
+    input_t in;
+    gv_prefetch_t *queue; ///< what has been read, each an `input_item_t`
+} pipeline_t;
+
+static void *read_ahead(void *arg)
+{
+    pipeline_t *p = arg;
+    input_item_t item = read_input(p->gvc, &p->in);
+    if (item.g == NULL && item.err == 0)
+	return NULL;
+    input_item_t *rv = gv_alloc(sizeof(input_item_t));
+    *rv = item;
+    return rv;
+}
+
+static void discard(void *item)
+{
+    input_item_t *it = item;
+    if (it->g)
+	agclose(it->g);
+    free(it);
+}
+
+static void close_pipeline(pipeline_t *p)
+{
+    gv_prefetch_stop(p->queue, discard);
+    agmmapclose(p->in.mapped);
+    if (p->in.fp && p->in.fp != stdin)
+	fclose(p->in.fp);
+    free(p);
+}
+
+void dotneato_close_input(GVC_t *gvc)
+{
+    if (gvc->pipeline) {
+	close_pipeline(gvc->pipeline);
+	gvc->pipeline = NULL;
+    }
+}
+
+graph_t *gvNextInputGraph(GVC_t *gvc)
+{
+    static input_t in;
+    input_item_t item;
+
+    if (gvc->parse_ahead > 0 && !gvc->pipeline && gvc->fidx == 0) {
+	pipeline_t *p = gv_alloc(sizeof(pipeline_t));
+	p->gvc = gvc;
+	p->queue = gv_prefetch_start(gvc->parse_ahead, read_ahead, p);
+	gvc->pipeline = p;
+    }
+
+    for (;;) {
+	if (gvc->pipeline) {
+	    pipeline_t *p = gvc->pipeline;
+	    input_item_t *it = gv_prefetch_next(p->queue);
+	    if (it == NULL) {
+		dotneato_close_input(gvc);
+		return NULL;
+	    }
+	    item = *it;
+	    free(it);
+	} else {
+	    item = read_input(gvc, &in);
 	}
-	if (fp != stdin)
-	    fclose (fp);
-	oldfp = fp = NULL;
-	gidx = 0;
+	// report failures here rather than on the reading thread, so messages
+	// appear in input order
+	if (item.err == 0)
+	    break;
+	agerrorf("%s: can't open %s: %s\n", gvc->common.cmdname, item.fn,
+	         strerror(item.err));
+	graphviz_errors++;
     }
-    return g;
+    if (item.g)
+	gvg_init(gvc, item.g, item.fn, item.gidx);
+    return item.g;
 }
 
 /* Check if the charset attribute is defined for the graph and, if
@@ -17,6 +17,7 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include <string.h>
+#include <util/numfmt.h>
 #include <util/prisize_t.h>
 
 /// state for offset calculations
@@ -96,8 +97,11 @@ static offsets_t setYInvert(graph_t *g) {
  */
 static char* canon (graph_t *g, char* s)
 {
+    /* The result may be the string itself, so canonicalize s rather than the
+     * copy, which could be freed below.
+     */
     char* ns = agstrdup (g, s);
-    char* cs = agcanonStr (ns);
+    char* cs = agcanon (s, aghtmlstr (ns));
     agstrfree (g, ns);
     return cs;
 }
@@ -190,15 +194,32 @@ void write_plain(GVJ_t *job, graph_t *g, FILE *f, bool extend) {
     agputs(putstr, "stop\n", f);
 }
 
+/// append a number as `%.5g`
+///
+/// This is equivalent to `agxbprint(xb, "%.5g", v)` in the C locale, which
+/// `attach_attrs_and_arrows` establishes, but avoids `vsnprintf`.
+static void put_num(agxbuf *xb, double v) {
+  char buf[GV_NUMFMT_SIZE];
+  agxbput_n(xb, buf, gv_numfmt(buf, v));
+}
+
+/// append a point as `%.5g,%.5g`
+static void put_point(agxbuf *xb, double x, double y) {
+  put_num(xb, x);
+  agxbputc(xb, ',');
+  put_num(xb, y);
+}
+
 static void set_record_rects(node_t *n, field_t *f, agxbuf *xb, double yOff) {
     int i;
 
     if (f->n_flds == 0) {
-	agxbprint(xb, "%.5g,%.5g,%.5g,%.5g ",
-		f->b.LL.x + ND_coord(n).x,
-		yDir(f->b.LL.y + ND_coord(n).y, yOff),
-		f->b.UR.x + ND_coord(n).x,
-		yDir(f->b.UR.y + ND_coord(n).y, yOff));
+	put_point(xb, f->b.LL.x + ND_coord(n).x,
+	          yDir(f->b.LL.y + ND_coord(n).y, yOff));
+	agxbputc(xb, ',');
+	put_point(xb, f->b.UR.x + ND_coord(n).x,
+	          yDir(f->b.UR.y + ND_coord(n).y, yOff));
+	agxbputc(xb, ' ');
     }
     for (i = 0; i < f->n_flds; i++)
 	set_record_rects(n, f->fld[i], xb, yOff);
@@ -210,13 +231,13 @@ static void rec_attach_bb(graph_t *g, Agsym_t *bbsym, Agsym_t *lpsym,
     agxbuf buf = {0};
     pointf pt;
 
-    agxbprint(&buf, "%.5g,%.5g,%.5g,%.5g", GD_bb(g).LL.x,
-              yDir(GD_bb(g).LL.y, yOff), GD_bb(g).UR.x,
-              yDir(GD_bb(g).UR.y, yOff));
+    put_point(&buf, GD_bb(g).LL.x, yDir(GD_bb(g).LL.y, yOff));
+    agxbputc(&buf, ',');
+    put_point(&buf, GD_bb(g).UR.x, yDir(GD_bb(g).UR.y, yOff));
     agxset(g, bbsym, agxbuse(&buf));
     if (GD_label(g) && GD_label(g)->text[0]) {
 	pt = GD_label(g)->pos;
-	agxbprint(&buf, "%.5g,%.5g", pt.x, yDir(pt.y, yOff));
+	put_point(&buf, pt.x, yDir(pt.y, yOff));
 	agxset(g, lpsym, agxbuse(&buf));
 	pt = GD_label(g)->dimen;
 	agxbprint(&buf, "%.2f", PS2INCH(pt.x));
@@ -269,24 +290,23 @@ double attach_attrs_and_arrows(graph_t *g, bool *sp, bool *ep) {
 	if (dim3) {
 	    int k;
 
-	    agxbprint(&xb, "%.5g,%.5g,%.5g", ND_coord(n).x,
-	              yDir(ND_coord(n).y, offsets.Y),
-	              POINTS_PER_INCH * ND_pos(n)[2]);
-	    for (k = 3; k < GD_odim(g); k++) {
-		agxbprint(&xb, ",%.5g", POINTS_PER_INCH*(ND_pos(n)[k]));
+	    put_point(&xb, ND_coord(n).x, yDir(ND_coord(n).y, offsets.Y));
+	    for (k = 2; k < GD_odim(g); k++) {
+		agxbputc(&xb, ',');
+		put_num(&xb, POINTS_PER_INCH*(ND_pos(n)[k]));
 	    }
 	    agset(n, "pos", agxbuse(&xb));
 	} else {
-	    agxbprint(&xb, "%.5g,%.5g", ND_coord(n).x, yDir(ND_coord(n).y, offsets.Y));
+	    put_point(&xb, ND_coord(n).x, yDir(ND_coord(n).y, offsets.Y));
 	    agset(n, "pos", agxbuse(&xb));
 	}
-	agxbprint(&xb, "%.5g", PS2INCH(ND_ht(n)));
+	put_num(&xb, PS2INCH(ND_ht(n)));
 	agxset(n, N_height, agxbuse(&xb));
-	agxbprint(&xb, "%.5g", PS2INCH(ND_lw(n) + ND_rw(n)));
+	put_num(&xb, PS2INCH(ND_lw(n) + ND_rw(n)));
 	agxset(n, N_width, agxbuse(&xb));
 	if (ND_xlabel(n) && ND_xlabel(n)->set) {
 	    ptf = ND_xlabel(n)->pos;
-	    agxbprint(&xb, "%.5g,%.5g", ptf.x, yDir(ptf.y, offsets.Y));
+	    put_point(&xb, ptf.x, yDir(ptf.y, offsets.Y));
 	    agset(n, "xlp", agxbuse(&xb));
 	}
 	if (strcmp(ND_shape(n)->name, "record") == 0) {
@@ -310,15 +330,16 @@ double attach_attrs_and_arrows(graph_t *g, bool *sp, bool *ep) {
 		for (size_t i = 0; i < sides; i++) {
 		    if (i > 0)
 			agxbputc(&xb, ' ');
-		    if (poly->sides >= 3)
-			agxbprint(&xb, "%.5g %.5g",
-				PS2INCH(poly->vertices[i].x),
-				YFDIR(offsets, PS2INCH(poly->vertices[i].y)));
-		    else
-			agxbprint(&xb, "%.5g %.5g",
-				ND_width(n) / 2.0 * cos((double)i / (double)sides * M_PI * 2.0),
-				YFDIR(offsets,
-				      ND_height(n) / 2.0 * sin((double)i / (double)sides * M_PI * 2.0)));
+		    if (poly->sides >= 3) {
+			put_num(&xb, PS2INCH(poly->vertices[i].x));
+			agxbputc(&xb, ' ');
+			put_num(&xb, YFDIR(offsets, PS2INCH(poly->vertices[i].y)));
+		    } else {
+			put_num(&xb, ND_width(n) / 2.0 * cos((double)i / (double)sides * M_PI * 2.0));
+			agxbputc(&xb, ' ');
+			put_num(&xb, YFDIR(offsets,
+			                   ND_height(n) / 2.0 * sin((double)i / (double)sides * M_PI * 2.0)));
+		    }
 		}
 		agxset(n, N_vertices, agxbuse(&xb));
 	    }
@@ -334,42 +355,44 @@ double attach_attrs_and_arrows(graph_t *g, bool *sp, bool *ep) {
 			agxbputc(&xb, ';');
 		    if (ED_spl(e)->list[i].sflag) {
 			s_arrows = true;
-			agxbprint(&xb, "s,%.5g,%.5g ",
-				ED_spl(e)->list[i].sp.x,
-				yDir(ED_spl(e)->list[i].sp.y, offsets.Y));
+			agxbput(&xb, "s,");
+			put_point(&xb, ED_spl(e)->list[i].sp.x,
+			          yDir(ED_spl(e)->list[i].sp.y, offsets.Y));
+			agxbputc(&xb, ' ');
 		    }
 		    if (ED_spl(e)->list[i].eflag) {
 			e_arrows = true;
-			agxbprint(&xb, "e,%.5g,%.5g ",
-				ED_spl(e)->list[i].ep.x,
-				yDir(ED_spl(e)->list[i].ep.y, offsets.Y));
+			agxbput(&xb, "e,");
+			put_point(&xb, ED_spl(e)->list[i].ep.x,
+			          yDir(ED_spl(e)->list[i].ep.y, offsets.Y));
+			agxbputc(&xb, ' ');
 		    }
 		    for (size_t j = 0; j < ED_spl(e)->list[i].size; j++) {
 			if (j > 0)
 			    agxbputc(&xb, ' ');
 			ptf = ED_spl(e)->list[i].list[j];
-			agxbprint(&xb, "%.5g,%.5g", ptf.x, yDir(ptf.y, offsets.Y));
+			put_point(&xb, ptf.x, yDir(ptf.y, offsets.Y));
 		    }
 		}
 		agset(e, "pos", agxbuse(&xb));
 		if (ED_label(e)) {
 		    ptf = ED_label(e)->pos;
-		    agxbprint(&xb, "%.5g,%.5g", ptf.x, yDir(ptf.y, offsets.Y));
+		    put_point(&xb, ptf.x, yDir(ptf.y, offsets.Y));
 		    agset(e, "lp", agxbuse(&xb));
 		}
 		if (ED_xlabel(e) && ED_xlabel(e)->set) {
 		    ptf = ED_xlabel(e)->pos;
-		    agxbprint(&xb, "%.5g,%.5g", ptf.x, yDir(ptf.y, offsets.Y));
+		    put_point(&xb, ptf.x, yDir(ptf.y, offsets.Y));
 		    agset(e, "xlp", agxbuse(&xb));
 		}
 		if (ED_head_label(e)) {
 		    ptf = ED_head_label(e)->pos;
-		    agxbprint(&xb, "%.5g,%.5g", ptf.x, yDir(ptf.y, offsets.Y));
+		    put_point(&xb, ptf.x, yDir(ptf.y, offsets.Y));
 		    agset(e, "head_lp", agxbuse(&xb));
 		}
 		if (ED_tail_label(e)) {
 		    ptf = ED_tail_label(e)->pos;
-		    agxbprint(&xb, "%.5g,%.5g", ptf.x, yDir(ptf.y, offsets.Y));
+		    put_point(&xb, ptf.x, yDir(ptf.y, offsets.Y));
 		    agset(e, "tail_lp", agxbuse(&xb));
 		}
 	    }
@@ -18,6 +18,7 @@
 #include <common/geomprocs.h>
 #include <common/render.h>
 #include <float.h>
+#include <inttypes.h>
 #include <limits.h>
 #include <math.h>
 #include <pathplan/pathplan.h>
@@ -27,9 +28,11 @@
 #include <string.h>
 #include <util/alloc.h>
 #include <util/prisize_t.h>
+#include <util/thread.h>
 
-static int nedges; ///< total no. of edges used in routing
-static size_t nboxes; ///< total no. of boxes used in routing
+// updated with gv_atomic_add, as edges may be routed concurrently
+static uint64_t nedges; ///< total no. of edges used in routing
+static uint64_t nboxes; ///< total no. of boxes used in routing
 
 static int routeinit;
 
@@ -235,7 +238,7 @@ void routesplinesterm(void)
     if (--routeinit > 0) return;
     if (Verbose)
 	fprintf(stderr,
-		"routesplines: %d edges, %" PRISIZE_T " boxes %.2f sec\n",
+		"routesplines: %" PRIu64 " edges, %" PRIu64 " boxes %.2f sec\n",
 		nedges, nboxes, elapsed_sec());
 }
 
@@ -311,8 +314,8 @@ static pointf *routesplines_(path *pp, size_t *npoints, int polyline) {
     bool unbounded;
 
     *npoints = 0;
-    nedges++;
-    nboxes += pp->nbox;
+    gv_atomic_add(&nedges, 1);
+    gv_atomic_add(&nboxes, (int64_t)pp->nbox);
 
     for (realedge = pp->data;
 	 realedge && ED_edge_type(realedge) != NORMAL;
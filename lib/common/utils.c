@@ -30,32 +30,25 @@
 #include <util/startswith.h>
 #include <util/strcasecmp.h>
 #include <util/streq.h>
+#include <util/thread.h>
 
 int late_int(void *obj, attrsym_t *attr, int defaultValue, int minimum) {
     if (attr == NULL)
         return defaultValue;
-    char *p = ag_xget(obj, attr);
-    if (!p || p[0] == '\0')
-        return defaultValue;
-    char *endp;
-    long rv = strtol(p, &endp, 10);
-    if (p == endp || rv > INT_MAX)
+    int rv;
+    if (!agxget_int(obj, attr, &rv))
         return defaultValue; /* invalid int format */
     if (rv < minimum)
         return minimum;
-    return (int)rv;
+    return rv;
 }
 
 double late_double(void *obj, attrsym_t *attr, double defaultValue,
                    double minimum) {
     if (!attr || !obj)
         return defaultValue;
-    char *p = ag_xget(obj, attr);
-    if (!p || p[0] == '\0')
-        return defaultValue;
-    char *endp;
-    double rv = strtod(p, &endp);
-    if (p == endp)
+    double rv;
+    if (!agxget_double(obj, attr, &rv))
         return defaultValue; /* invalid double format */
     if (rv < minimum)
         return minimum;
@@ -76,6 +69,13 @@ double get_inputscale(graph_t *g) {
     return d;
 }
 
+size_t late_threads(graph_t *g) {
+    const int threads = late_int(g, agfindgraphattr(g, "threads"), -1, -1);
+    if (threads < 0) return 0;
+    if (threads == 0) return gv_hardware_threads();
+    return (size_t)threads;
+}
+
 char *late_string(void *obj, attrsym_t *attr, char *defaultValue) {
     if (!attr || !obj)
         return defaultValue;
@@ -85,6 +85,13 @@ UTILS_API char *late_string(void *obj, Agsym_t *attr, char *defaultValue);
 UTILS_API bool late_bool(void *obj, Agsym_t *attr, bool defaultValue);
 UTILS_API double get_inputscale(graph_t *g);
 
+/// number of threads a layout may use, from the graph’s `threads` attribute
+///
+/// @param g Root graph
+/// @return 0 if the attribute is unset or invalid, in which case the layout
+///   should proceed sequentially as it always has, otherwise a thread count ≥ 1
+UTILS_API size_t late_threads(graph_t *g);
+
 // routines for supporting “union-find”, a.k.a. “disjoint-set forest”
 // https://en.wikipedia.org/wiki/Disjoint-set_data_structure
 UTILS_API Agnode_t *UF_find(Agnode_t *);
@@ -57,6 +57,8 @@ void acyclic(graph_t * g)
 {
     node_t *n;
 
+    if (GD_flags(dot_root(g)) & INCREMENTAL)
+	dot_seed_acyclic(g);
     for (size_t c = 0; c < GD_comp(g).size; c++) {
 	GD_nlist(g) = GD_comp(g).list[c];
 	for (n = GD_nlist(g); n; n = ND_next(n))
@@ -22,28 +22,37 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <util/alloc.h>
+#include <util/tls.h>
 
-static node_t *Last_node;
-static size_t Cmark;
+/// mark of the current decompose() call
+///
+/// Kept per thread so distinct graphs can be decomposed concurrently.
+static TLS size_t Cmark;
+
+/// state of one decompose() call
+typedef struct {
+  node_t *last_node; ///< tail of the component being built
+  size_t mark;       ///< value of Cmark for this call
+} decompose_t;
 
 static void 
-begin_component(graph_t* g)
+begin_component(decompose_t *dp, graph_t* g)
 {
-    Last_node = GD_nlist(g) = NULL;
+    dp->last_node = GD_nlist(g) = NULL;
 }
 
 static void 
-add_to_component(graph_t* g, node_t * n)
+add_to_component(decompose_t *dp, graph_t* g, node_t * n)
 {
-    ND_mark(n) = Cmark;
-    if (Last_node) {
-	ND_prev(n) = Last_node;
-	ND_next(Last_node) = n;
+    ND_mark(n) = dp->mark;
+    if (dp->last_node) {
+	ND_prev(n) = dp->last_node;
+	ND_next(dp->last_node) = n;
     } else {
 	ND_prev(n) = NULL;
 	GD_nlist(g) = n;
     }
-    Last_node = n;
+    dp->last_node = n;
     ND_next(n) = NULL;
 }
 
@@ -58,8 +67,8 @@ end_component(graph_t* g)
 
 DEFINE_LIST(node_stack, node_t *)
 
-static void push(node_stack_t *sp, node_t *np) {
-  ND_mark(np) = Cmark + 1;
+static void push(decompose_t *dp, node_stack_t *sp, node_t *np) {
+  ND_mark(np) = dp->mark + 1;
   node_stack_push_back(sp, np);
 }
 
@@ -80,17 +89,18 @@ static node_t *pop(node_stack_t *sp) {
  * in this call to decompose will have mark < Cmark; processed nodes will have mark=Cmark;
  * so we use mark = Cmark+1 to indicate nodes on the stack.
  */
-static void search_component(node_stack_t *stk, graph_t *g, node_t *n) {
+static void search_component(decompose_t *dp, node_stack_t *stk, graph_t *g,
+                             node_t *n) {
     int c;
     elist vec[4];
     node_t *other;
     edge_t *e;
     edge_t **ep;
 
-    push(stk, n);
+    push(dp, stk, n);
     while ((n = pop(stk))) {
-	if (ND_mark(n) == Cmark) continue;
-	add_to_component(g, n);
+	if (ND_mark(n) == dp->mark) continue;
+	add_to_component(dp, g, n);
 	vec[0] = ND_out(n);
 	vec[1] = ND_in(n);
 	vec[2] = ND_flat_out(n);
@@ -103,8 +113,8 @@ static void search_component(node_stack_t *stk, graph_t *g, node_t *n) {
 		    e = *ep;
 		    if ((other = aghead(e)) == n)
 			other = agtail(e);
-		    if ((ND_mark(other) != Cmark) && (other == UF_find(other)))
-			push(stk, other);
+		    if ((ND_mark(other) != dp->mark) && (other == UF_find(other)))
+			push(dp, stk, other);
 		}
 	    }
 	}
@@ -119,6 +129,7 @@ void decompose(graph_t * g, int pass)
 
     if (++Cmark == 0)
 	Cmark = 1;
+    decompose_t dp = {.mark = Cmark};
     GD_comp(g).size = 0;
     for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
 	v = n;
@@ -126,9 +137,9 @@ void decompose(graph_t * g, int pass)
 	    v = GD_rankleader(subg)[ND_rank(v)];
 	else if (v != UF_find(v))
 	    continue;
-	if (ND_mark(v) != Cmark) {
-	    begin_component(g);
-	    search_component(&stk, g, v);
+	if (ND_mark(v) != dp.mark) {
+	    begin_component(&dp, g);
+	    search_component(&dp, &stk, g, v);
 	    end_component(g);
 	}
     }
@@ -294,6 +294,8 @@ static void dotLayout(Agraph_t * g)
 {
     int maxphase = late_int(g, agfindgraphattr(g,"phase"), -1, 1);
 
+    if (mapbool(agget(g, "incremental")))
+	GD_flags(g) |= INCREMENTAL;
     setEdgeType (g, EDGETYPE_SPLINE);
     setAspect(g);
 
@@ -321,6 +323,8 @@ static void dotLayout(Agraph_t * g)
     dot_splines(g);
     if (mapbool(agget(g, "compound")))
 	dot_compoundEdges(g);
+    if (GD_flags(g) & INCREMENTAL)
+	attach_phase_attrs (g, 1);  /* ranks to seed the next layout */
 }
 
 static void
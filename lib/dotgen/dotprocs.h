@@ -36,6 +36,26 @@ DEFINE_LIST(node_queue, Agnode_t *)
     extern void dot_layout(Agraph_t * g);
     extern void dot_init_node_edge(graph_t * g);
     extern void dot_scan_ranks(graph_t * g);
+
+    /* incremental layout (incremental.c) */
+
+    /// positions along the ranks of the previous layout's ranks
+    typedef struct {
+	double *along; ///< indexed by previous rank
+	size_t size;
+    } dot_levels_t;
+
+    extern dot_levels_t dot_prev_levels(graph_t *g);
+    extern void dot_free_levels(dot_levels_t *levels);
+    extern bool dot_prev_point(void *obj, Agsym_t *sym, pointf *p);
+    extern bool dot_prev_splines(edge_t *e, Agsym_t *sym, splines *spl);
+    extern void dot_free_prev_splines(splines *spl);
+    extern bool dot_spline_cross(const splines *spl, bool vertical,
+                                 double level, pointf *p);
+    extern void dot_seed_acyclic(graph_t *g);
+    extern void dot_seed_order(graph_t *g, const dot_levels_t *levels);
+    extern void dot_seed_ranks(graph_t *g);
+
     extern void enqueue_neighbors(node_queue_t *q, node_t *n0, int pass);
     extern void expand_cluster(Agraph_t *);
     extern Agedge_t *fast_edge(Agedge_t *);
@@ -19,11 +19,15 @@
 #include <common/boxes.h>
 #include <dotgen/dot.h>
 #include <math.h>
+#include <pathplan/pathutil.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <util/alloc.h>
+#include <util/prisize_t.h>
+#include <util/thread.h>
 
 #ifdef ORTHO
 #include <ortho/ortho.h>
@@ -67,6 +71,29 @@ typedef struct {
 } spline_info_t;
 
 DEFINE_LIST(points, pointf)
+DEFINE_LIST(vnodes, node_t *)
+
+/// a resize of a virtual node, as recover_slack asks for
+typedef struct {
+    node_t *vn;
+    double lx, cx, rx;
+} resize_t;
+
+DEFINE_LIST(resizes, resize_t)
+
+/// the route of a group of equivalent regular edges
+typedef struct {
+    Agedgeinfo_t fwdedgeai, fwdedgebi;
+    Agedgepair_t fwdedgea, fwdedgeb; ///< forward copies of backward edges
+    edge_t *fe;       ///< edge to install the spline on
+    node_t *hn;       ///< node the spline ends at
+    points_t points;  ///< control points of the spline
+    bool routed;      ///< false if routing failed
+    bool deferred;    ///< record resizes instead of doing them
+    vnodes_t reads;   ///< if deferred, virtual nodes whose positions were used
+    resizes_t resizes; ///< resizes of the route's virtual nodes, in order
+    bool conflict;    ///< if deferred, used a node it also resized
+} regular_route_t;
 
 static void adjustregularpath(path *, size_t, size_t);
 static Agedge_t *bot_bound(Agedge_t *, int);
@@ -80,12 +107,18 @@ static void make_flat_edge(graph_t *, spline_info_t *, path *, Agedge_t **,
                            unsigned, unsigned, int);
 static void make_regular_edge(graph_t *g, spline_info_t *, path *, Agedge_t **,
                               unsigned, unsigned, int);
+static void route_regular_edge(graph_t *g, spline_info_t *, path *,
+                               Agedge_t **, unsigned, regular_route_t *, int);
+static void install_regular_edge(spline_info_t *, Agedge_t **, unsigned,
+                                 unsigned, regular_route_t *);
+static void regular_route_free(regular_route_t *);
 static boxf makeregularend(boxf, int, double);
-static boxf maximal_bbox(graph_t* g, spline_info_t*, Agnode_t *, Agedge_t *, Agedge_t *);
+static boxf maximal_bbox(graph_t* g, spline_info_t*, Agnode_t *, Agedge_t *,
+                         Agedge_t *, regular_route_t *);
 static Agnode_t *neighbor(graph_t*, Agnode_t *, Agedge_t *, Agedge_t *, int);
 static void place_vnlabel(Agnode_t *);
 static boxf rank_box(spline_info_t* sp, Agraph_t *, int);
-static void recover_slack(Agedge_t *, path *);
+static void recover_slack(Agedge_t *, path *, regular_route_t *);
 static void resize_vn(Agnode_t *, double, double, double);
 static void setflags(Agedge_t *, int, int, int);
 static int straight_len(Agnode_t *);
@@ -252,6 +285,323 @@ setEdgeLabelPos (graph_t * g)
     }
 }
 
+/// what incremental layout needs to reuse splines from the previous layout
+typedef struct {
+    Agsym_t *N_pos;
+    Agsym_t *N_width;
+    Agsym_t *N_height;
+    Agsym_t *E_pos;
+    int rotation; ///< degrees counterclockwise from dot to output coordinates
+    pointf offset; ///< rotated dot coordinates minus previous output ones
+} reuse_t;
+
+/// are two coordinates equal, up to the precision -Tdot writes them with?
+static bool same_coord(double a, double b) {
+    return fabs(a - b) <= 0.01 + 1e-4 * fabs(b);
+}
+
+static int dblcmp(const void *x, const void *y) {
+    const double *a = x;
+    const double *b = y;
+    return (*a > *b) - (*a < *b);
+}
+
+/// prepare to reuse splines from the previous layout in incremental mode
+///
+/// The translation from dot's coordinates to those of the previous output is
+/// taken as the median over all nodes, so nodes that moved do not disturb it.
+static bool reuse_init(graph_t *g, int et, reuse_t *r) {
+    *r = (reuse_t){0};
+    if (!(GD_flags(g) & INCREMENTAL) || Concentrate || Y_invert)
+	return false;
+    if (et != EDGETYPE_SPLINE && et != EDGETYPE_PLINE && et != EDGETYPE_LINE)
+	return false;
+    if (mapbool(agget(g, "compound")))
+	return false;
+
+    graph_t *root = agroot(g);
+    r->N_pos = agattr(root, AGNODE, "pos", NULL);
+    r->N_width = agattr(root, AGNODE, "width", NULL);
+    r->N_height = agattr(root, AGNODE, "height", NULL);
+    r->E_pos = agattr(root, AGEDGE, "pos", NULL);
+    if (!r->N_pos || !r->N_width || !r->N_height || !r->E_pos)
+	return false;
+    r->rotation = GD_rankdir(g) * 90;
+
+    double *dx = gv_calloc((size_t)agnnodes(g), sizeof(double));
+    double *dy = gv_calloc((size_t)agnnodes(g), sizeof(double));
+    size_t count = 0;
+    for (node_t *n = agfstnode(g); n; n = agnxtnode(g, n)) {
+	pointf p;
+	if (dot_prev_point(n, r->N_pos, &p)) {
+	    const pointf q = ccwrotatepf(ND_coord(n), r->rotation);
+	    dx[count] = q.x - p.x;
+	    dy[count] = q.y - p.y;
+	    ++count;
+	}
+    }
+    if (count > 0) {
+	qsort(dx, count, sizeof(dx[0]), dblcmp);
+	qsort(dy, count, sizeof(dy[0]), dblcmp);
+	r->offset = (pointf){dx[count / 2], dy[count / 2]};
+    }
+    free(dy);
+    free(dx);
+    return count > 0;
+}
+
+/// is a node where it was in the previous layout, and of the same size?
+static bool unmoved(const reuse_t *r, node_t *n) {
+    pointf p;
+    if (ND_node_type(n) != NORMAL || !dot_prev_point(n, r->N_pos, &p))
+	return false;
+    const pointf q = ccwrotatepf(ND_coord(n), r->rotation);
+    return same_coord(q.x - r->offset.x, p.x)
+	&& same_coord(q.y - r->offset.y, p.y)
+	&& same_coord(ND_width(n), late_double(n, r->N_width, 0, 0))
+	&& same_coord(ND_height(n), late_double(n, r->N_height, 0, 0));
+}
+
+/// map a point of the previous output into dot's coordinates
+static pointf to_dot(const reuse_t *r, pointf p) {
+    p.x += r->offset.x;
+    p.y += r->offset.y;
+    return cwrotatepf(p, r->rotation);
+}
+
+/// does a previous spline still pass between the neighbors of a virtual node?
+static bool clears_neighbors(graph_t *g, const splines *spl, node_t *vn) {
+    const rank_t *rank = &GD_rank(g)[ND_rank(vn)];
+    pointf p;
+    if (!dot_spline_cross(spl, true, ND_coord(vn).y, &p))
+	return false;
+    const double x = p.x;
+    if (ND_order(vn) > 0) {
+	node_t *left = rank->v[ND_order(vn) - 1];
+	if (x <= ND_coord(left).x + ND_rw(left))
+	    return false;
+    }
+    if (ND_order(vn) + 1 < rank->n) {
+	node_t *right = rank->v[ND_order(vn) + 1];
+	if (x >= ND_coord(right).x - ND_lw(right))
+	    return false;
+    }
+    return true;
+}
+
+/// give equivalent regular edges their splines from the previous layout
+///
+/// This succeeds only if neither end point moved and the previous splines
+/// still fit through the edges' virtual nodes. Otherwise the edges are left
+/// for make_regular_edge to route.
+static bool reuse_regular_edge(graph_t *g, const reuse_t *r, edge_t **edges,
+                               unsigned ind, unsigned cnt) {
+    edge_t *e = edges[ind];
+    if (!unmoved(r, agtail(e)))
+	return false;
+    node_t *hn = aghead(e);
+    while (ND_node_type(hn) == VIRTUAL) {
+	if (spline_merge(hn) || ND_out(hn).size == 0)
+	    return false;
+	hn = aghead(ND_out(hn).list[0]);
+    }
+    if (!unmoved(r, hn))
+	return false;
+
+    splines *spls = gv_calloc(cnt, sizeof(splines));
+    bool ok = true;
+    for (unsigned j = 0; ok && j < cnt; j++) {
+	edge_t *orig = edges[ind + j];
+	while (ED_edge_type(orig) != NORMAL)
+	    orig = ED_to_orig(orig);
+	if (ED_label(orig) || ED_spl(orig)
+	    || !dot_prev_splines(orig, r->E_pos, &spls[j])) {
+	    ok = false;
+	    break;
+	}
+
+	/* arrowheads may have been added or removed since */
+	uint32_t sflag, eflag;
+	arrow_flags(orig, &sflag, &eflag);
+	splines *spl = &spls[j];
+	if ((spl->list[0].sflag != 0) != (sflag != 0)
+	    || (spl->list[spl->size - 1].eflag != 0) != (eflag != 0)) {
+	    ok = false;
+	    break;
+	}
+	for (size_t i = 0; i < spl->size; i++) {
+	    bezier *bz = &spl->list[i];
+	    for (size_t k = 0; k < bz->size; k++)
+		bz->list[k] = to_dot(r, bz->list[k]);
+	    if (bz->sflag) {
+		bz->sflag = sflag;
+		bz->sp = to_dot(r, bz->sp);
+	    }
+	    if (bz->eflag) {
+		bz->eflag = eflag;
+		bz->ep = to_dot(r, bz->ep);
+	    }
+	}
+
+	for (node_t *vn = aghead(e); ND_node_type(vn) == VIRTUAL;
+	     vn = aghead(ND_out(vn).list[0])) {
+	    if (!clears_neighbors(g, spl, vn)) {
+		ok = false;
+		break;
+	    }
+	}
+    }
+
+    if (ok) {
+	for (unsigned j = 0; j < cnt; j++) {
+	    edge_t *orig = edges[ind + j];
+	    while (ED_edge_type(orig) != NORMAL)
+		orig = ED_to_orig(orig);
+	    for (size_t i = 0; i < spls[j].size; i++) {
+		const bezier *prev = &spls[j].list[i];
+		bezier *bz = new_spline(orig, prev->size);
+		memcpy(bz->list, prev->list, prev->size * sizeof(pointf));
+		bz->sflag = prev->sflag;
+		bz->sp = prev->sp;
+		bz->eflag = prev->eflag;
+		bz->ep = prev->ep;
+	    }
+	    /* edge_normalize will turn back edges around again */
+	    if (sinfo.swapEnds(orig))
+		swap_spline(ED_spl(orig));
+	}
+	/* like recover_slack, free up space the edges do not use */
+	for (node_t *vn = aghead(e); ND_node_type(vn) == VIRTUAL;
+	     vn = aghead(ND_out(vn).list[0])) {
+	    pointf p;
+	    if (dot_spline_cross(&spls[0], true, ND_coord(vn).y, &p))
+		resize_vn(vn, p.x, p.x, p.x);
+	}
+    }
+
+    for (unsigned j = 0; j < cnt; j++)
+	dot_free_prev_splines(&spls[j]);
+    free(spls);
+    return ok;
+}
+
+/// how many groups of regular edges per thread are routed concurrently before
+/// any of them is installed
+///
+/// Larger batches need fewer threads to be started, but more of their routes
+/// use virtual nodes resized by earlier routes of the batch and are redone.
+enum { ROUTE_BATCH = 8 };
+
+/// groups of regular edges being routed concurrently
+///
+/// The routes of a batch are computed from the positions of virtual nodes
+/// before any of them recovers its slack. They are then installed in order,
+/// each after checking that none of the virtual nodes it used was resized by
+/// an earlier route in the batch, and otherwise routed again. So the splines are
+/// the same as if the edges were routed one after the other.
+typedef struct {
+    graph_t *g;
+    spline_info_t *sp;
+    edge_t **edges;
+    int et;
+    size_t threads;
+    path *paths;      ///< one per thread
+    unsigned *ind;    ///< first edge of each group
+    unsigned *cnt;    ///< number of edges in each group
+    regular_route_t *routes;
+    size_t n;         ///< number of groups in the batch
+    size_t size;      ///< maximum number of groups in the batch
+    uint64_t next;    ///< next group for a thread to route
+    size_t stamp;     ///< ND_mark of virtual nodes resized in this batch
+    size_t routed;    ///< total groups routed concurrently
+    size_t rerouted;  ///< those of them routed again
+} route_batch_t;
+
+static route_batch_t *route_batch_new(graph_t *g, spline_info_t *sp,
+                                      edge_t **edges, int et, size_t threads,
+                                      int n_nodes) {
+    route_batch_t *b = gv_alloc(sizeof(route_batch_t));
+    *b = (route_batch_t){.g = g, .sp = sp, .edges = edges, .et = et,
+                         .threads = threads, .size = threads * ROUTE_BATCH};
+    b->ind = gv_calloc(b->size, sizeof(unsigned));
+    b->cnt = gv_calloc(b->size, sizeof(unsigned));
+    b->routes = gv_calloc(b->size, sizeof(regular_route_t));
+    b->paths = gv_calloc(threads, sizeof(path));
+    for (size_t t = 0; t < threads; t++)
+	b->paths[t].boxes = gv_calloc(n_nodes + 20 * 2 * NSUB, sizeof(boxf));
+
+    for (int r = GD_minrank(g); r <= GD_maxrank(g); r++) {
+	/* rank boxes are otherwise filled in as routes need them */
+	if (r < GD_maxrank(g) && GD_rank(g)[r].n > 0 && GD_rank(g)[r + 1].n > 0)
+	    rank_box(sp, g, r);
+	for (int i = 0; i < GD_rank(g)[r].n; i++)
+	    ND_mark(GD_rank(g)[r].v[i]) = 0;
+    }
+    return b;
+}
+
+static void route_job(void *arg, size_t index, size_t worker) {
+    (void)index;
+    route_batch_t *b = arg;
+    for (uint64_t i; (i = gv_atomic_add(&b->next, 1) - 1) < b->n; ) {
+	regular_route_t *rt = &b->routes[i];
+	rt->deferred = true;
+	route_regular_edge(b->g, b->sp, &b->paths[worker], b->edges, b->ind[i],
+	                   rt, b->et);
+    }
+    /* threads other than the caller's end with this batch */
+    if (worker != 0)
+	Pscratch_free();
+}
+
+/// route the groups of a batch and install their splines
+static void route_batch(route_batch_t *b, path *P) {
+    if (b->n == 0)
+	return;
+    b->next = 0;
+    ++b->stamp;
+    gv_parallel_for(b->threads, b->threads, route_job, b);
+
+    for (size_t i = 0; i < b->n; i++) {
+	regular_route_t *rt = &b->routes[i];
+	bool valid = !rt->conflict;
+	for (size_t j = 0; valid && j < vnodes_size(&rt->reads); j++)
+	    valid = ND_mark(vnodes_get(&rt->reads, j)) != b->stamp;
+	if (valid) {
+	    for (size_t j = 0; j < resizes_size(&rt->resizes); j++) {
+		const resize_t r = resizes_get(&rt->resizes, j);
+		resize_vn(r.vn, r.lx, r.cx, r.rx);
+	    }
+	} else {
+	    regular_route_free(rt);
+	    *rt = (regular_route_t){0};
+	    route_regular_edge(b->g, b->sp, P, b->edges, b->ind[i], rt, b->et);
+	    ++b->rerouted;
+	}
+	for (size_t j = 0; j < resizes_size(&rt->resizes); j++)
+	    ND_mark(resizes_get(&rt->resizes, j).vn) = b->stamp;
+	install_regular_edge(b->sp, b->edges, b->ind[i], b->cnt[i], rt);
+	regular_route_free(rt);
+	*rt = (regular_route_t){0};
+    }
+    b->routed += b->n;
+    b->n = 0;
+}
+
+static void route_batch_free(route_batch_t *b) {
+    if (Verbose)
+	fprintf(stderr, "dot_splines: %" PRISIZE_T " edge groups routed with %"
+	        PRISIZE_T " threads, %" PRISIZE_T " routed again\n", b->routed,
+	        b->threads, b->rerouted);
+    for (size_t t = 0; t < b->threads; t++)
+	free(b->paths[t].boxes);
+    free(b->paths);
+    free(b->routes);
+    free(b->cnt);
+    free(b->ind);
+    free(b);
+}
+
 /** Main spline routing code.
  * The normalize parameter allows this function to be called by the
  * recursive call in make_flat_edge without normalization occurring,
@@ -295,6 +645,8 @@ static void dot_splines_(graph_t *g, int normalize) {
     if (routesplinesinit()) return;
     spline_info_t sd = {.Splinesep = GD_nodesep(g) / 4,
                         .Multisep = GD_nodesep(g)};
+    reuse_t reuse;
+    const bool reusing = normalize && reuse_init(g, et, &reuse);
     edges = gv_calloc(CHUNK, sizeof(edge_t*));
 
     /* compute boundaries and list of splines */
@@ -370,6 +722,15 @@ static void dot_splines_(graph_t *g, int normalize) {
     P.boxes = gv_calloc(n_nodes + 20 * 2 * NSUB, sizeof(boxf));
     sd.Rank_box = gv_calloc(i, sizeof(boxf));
 
+    /* route regular edges concurrently if asked to, except where routes share
+     * virtual nodes or previous splines are reused
+     */
+    route_batch_t *batch = NULL;
+    const size_t threads = late_threads(g);
+    if (normalize && threads > 1 && et != EDGETYPE_CURVED && !reusing
+        && !Concentrate)
+	batch = route_batch_new(g, &sd, edges, et, threads, n_nodes);
+
     if (et == EDGETYPE_LINE) {
     /* place regular edge labels */
 	for (n = GD_nlist(g); n; n = ND_next(n)) {
@@ -416,6 +777,11 @@ static void dot_splines_(graph_t *g, int normalize) {
 		break;
 	}
 
+	const bool regular = agtail(e0) != aghead(e0)
+	                     && ND_rank(agtail(e0)) != ND_rank(aghead(e0));
+	if (batch && !regular)
+	    route_batch(batch, &P); /* keep the edges in order */
+
 	if (et == EDGETYPE_CURVED) {
 	    edge_t** edgelist = gv_calloc(cnt, sizeof(edge_t*));
 	    edgelist[0] = getmainedge((edges+ind)[0]);
@@ -453,9 +819,19 @@ static void dot_splines_(graph_t *g, int normalize) {
 	else if (ND_rank(agtail(e0)) == ND_rank(aghead(e0))) {
 	    make_flat_edge(g, &sd, &P, edges, ind, cnt, et);
 	}
-	else
+	else if (batch) {
+	    batch->ind[batch->n] = ind;
+	    batch->cnt[batch->n] = cnt;
+	    if (++batch->n == batch->size)
+		route_batch(batch, &P);
+	}
+	else if (!reusing || !reuse_regular_edge(g, &reuse, edges, ind, cnt))
 	    make_regular_edge(g, &sd, &P, edges, ind, cnt, et);
     }
+    if (batch) {
+	route_batch(batch, &P);
+	route_batch_free(batch);
+    }
 
     /* place regular edge labels */
     for (n = GD_nlist(g); n; n = ND_next(n)) {
@@ -1369,7 +1745,7 @@ makeFlatEnd (graph_t* g, spline_info_t* sp, path* P, node_t* n, edge_t* e, pathe
 {
     boxf b;
 
-    b = endp->nb = maximal_bbox(g, sp, n, NULL, e);
+    b = endp->nb = maximal_bbox(g, sp, n, NULL, e, NULL);
     endp->sidemask = TOP;
     if (isBegin) beginpath(P, e, FLATEDGE, endp, false);
     else endpath(P, e, FLATEDGE, endp, false);
@@ -1386,7 +1762,7 @@ makeBottomFlatEnd (graph_t* g, spline_info_t* sp, path* P, node_t* n, edge_t* e,
 {
     boxf b;
 
-    b = endp->nb = maximal_bbox(g, sp, n, NULL, e);
+    b = endp->nb = maximal_bbox(g, sp, n, NULL, e, NULL);
     endp->sidemask = BOTTOM;
     if (isBegin) beginpath(P, e, FLATEDGE, endp, false);
     else endpath(P, e, FLATEDGE, endp, false);
@@ -1754,63 +2130,67 @@ static int makeLineEdge(graph_t *g, edge_t *fe, points_t *points, node_t** hp) {
     return pn;
 }
 
-static void make_regular_edge(graph_t *g, spline_info_t *sp, path *P,
-                              edge_t **edges, unsigned ind, unsigned cnt,
-                              int et) {
+/// route the edges equivalent to `edges[ind]`
+///
+/// This computes the spline of the first edge and asks for the slack of its
+/// virtual nodes to be recovered, leaving install_regular_edge to give the
+/// splines to the edges. If `rt->deferred`, virtual nodes are not resized but
+/// the resizes are recorded, as are the virtual nodes whose positions the
+/// route depends on, so the route can be computed concurrently with others
+/// and checked against them before being installed.
+static void route_regular_edge(graph_t *g, spline_info_t *sp, path *P,
+                               edge_t **edges, unsigned ind,
+                               regular_route_t *rt, int et) {
     node_t *tn, *hn;
-    Agedgeinfo_t fwdedgeai, fwdedgebi, fwdedgei;
-    Agedgepair_t fwdedgea, fwdedgeb, fwdedge;
     edge_t *e, *fe, *le, *segfirst;
     pathend_t tend, hend;
     boxf b;
     int sl, si;
-    points_t pointfs = {0};
-    points_t pointfs2 = {0};
+    points_t *pointfs = &rt->points;
 
-    fwdedgea.out.base.data = (Agrec_t*)&fwdedgeai;
-    fwdedgeb.out.base.data = (Agrec_t*)&fwdedgebi;
-    fwdedge.out.base.data = (Agrec_t*)&fwdedgei;
+    rt->fwdedgea.out.base.data = (Agrec_t*)&rt->fwdedgeai;
+    rt->fwdedgeb.out.base.data = (Agrec_t*)&rt->fwdedgebi;
 
     sl = 0;
     e = edges[ind];
     bool hackflag = false;
     if (abs(ND_rank(agtail(e)) - ND_rank(aghead(e))) > 1) {
-	fwdedgeai = *(Agedgeinfo_t*)e->base.data;
-	fwdedgea.out = *e;
-	fwdedgea.in = *AGOUT2IN(e);
-	fwdedgea.out.base.data = (Agrec_t*)&fwdedgeai;
+	rt->fwdedgeai = *(Agedgeinfo_t*)e->base.data;
+	rt->fwdedgea.out = *e;
+	rt->fwdedgea.in = *AGOUT2IN(e);
+	rt->fwdedgea.out.base.data = (Agrec_t*)&rt->fwdedgeai;
 	if (ED_tree_index(e) & BWDEDGE) {
-	    MAKEFWDEDGE(&fwdedgeb.out, e);
-	    agtail(&fwdedgea.out) = aghead(e);
-	    ED_tail_port(&fwdedgea.out) = ED_head_port(e);
+	    MAKEFWDEDGE(&rt->fwdedgeb.out, e);
+	    agtail(&rt->fwdedgea.out) = aghead(e);
+	    ED_tail_port(&rt->fwdedgea.out) = ED_head_port(e);
 	} else {
-	    fwdedgebi = *(Agedgeinfo_t*)e->base.data;
-	    fwdedgeb.out = *e;
-	    fwdedgeb.out.base.data = (Agrec_t*)&fwdedgebi;
-	    agtail(&fwdedgea.out) = agtail(e);
-	    fwdedgeb.in = *AGOUT2IN(e);
+	    rt->fwdedgebi = *(Agedgeinfo_t*)e->base.data;
+	    rt->fwdedgeb.out = *e;
+	    rt->fwdedgeb.out.base.data = (Agrec_t*)&rt->fwdedgebi;
+	    agtail(&rt->fwdedgea.out) = agtail(e);
+	    rt->fwdedgeb.in = *AGOUT2IN(e);
 	}
 	le = getmainedge(e);
 	while (ED_to_virt(le))
 	    le = ED_to_virt(le);
-	aghead(&fwdedgea.out) = aghead(le);
-	ED_head_port(&fwdedgea.out).defined = false;
-	ED_edge_type(&fwdedgea.out) = VIRTUAL;
-	ED_head_port(&fwdedgea.out).p.x = ED_head_port(&fwdedgea.out).p.y = 0;
-	ED_to_orig(&fwdedgea.out) = e;
-	e = &fwdedgea.out;
+	aghead(&rt->fwdedgea.out) = aghead(le);
+	ED_head_port(&rt->fwdedgea.out).defined = false;
+	ED_edge_type(&rt->fwdedgea.out) = VIRTUAL;
+	ED_head_port(&rt->fwdedgea.out).p.x = ED_head_port(&rt->fwdedgea.out).p.y = 0;
+	ED_to_orig(&rt->fwdedgea.out) = e;
+	e = &rt->fwdedgea.out;
 	hackflag = true;
     } else {
 	if (ED_tree_index(e) & BWDEDGE) {
-	    MAKEFWDEDGE(&fwdedgea.out, e);
-	    e = &fwdedgea.out;
+	    MAKEFWDEDGE(&rt->fwdedgea.out, e);
+	    e = &rt->fwdedgea.out;
 	}
     }
     fe = e;
 
     /* compute the spline points for the edge */
 
-    if (et == EDGETYPE_LINE && makeLineEdge(g, fe, &pointfs, &hn)) {
+    if (et == EDGETYPE_LINE && makeLineEdge(g, fe, pointfs, &hn)) {
     }
     else {
 	bool is_spline = et == EDGETYPE_SPLINE;
@@ -1818,7 +2198,7 @@ static void make_regular_edge(graph_t *g, spline_info_t *sp, path *P,
 	segfirst = e;
 	tn = agtail(e);
 	hn = aghead(e);
-	b = tend.nb = maximal_bbox(g, sp, tn, NULL, e);
+	b = tend.nb = maximal_bbox(g, sp, tn, NULL, e, rt);
 	beginpath(P, e, REGULAREDGE, &tend, spline_merge(tn));
 	b.UR.y = tend.boxes[tend.boxn - 1].UR.y;
 	b.LL.y = tend.boxes[tend.boxn - 1].LL.y;
@@ -1838,13 +2218,13 @@ static void make_regular_edge(graph_t *g, spline_info_t *sp, path *P,
 	    }
 	    if (!smode || si > 0) {
 	        si--;
-	        boxes_append(&boxes, maximal_bbox(g, sp, hn, e, ND_out(hn).list[0]));
+	        boxes_append(&boxes, maximal_bbox(g, sp, hn, e, ND_out(hn).list[0], rt));
 	        e = ND_out(hn).list[0];
 	        tn = agtail(e);
 	        hn = aghead(e);
 	        continue;
 	    }
-	    hend.nb = maximal_bbox(g, sp, hn, e, ND_out(hn).list[0]);
+	    hend.nb = maximal_bbox(g, sp, hn, e, ND_out(hn).list[0], rt);
 	    endpath(P, e, REGULAREDGE, &hend, spline_merge(aghead(e)));
 	    b = makeregularend(hend.boxes[hend.boxn - 1], TOP,
 	    	       ND_coord(hn).y + GD_rank(g)[ND_rank(hn)].ht2);
@@ -1866,22 +2246,20 @@ static void make_regular_edge(graph_t *g, spline_info_t *sp, path *P,
 	    if (pn == 0) {
 	        free(ps);
 	        boxes_free(&boxes);
-	        points_free(&pointfs);
-	        points_free(&pointfs2);
 	        return;
 	    }
 	
 	    for (size_t i = 0; i < pn; i++) {
-		points_append(&pointfs, ps[i]);
+		points_append(pointfs, ps[i]);
 	    }
 	    free(ps);
-	    e = straight_path(ND_out(hn).list[0], sl, &pointfs);
-	    recover_slack(segfirst, P);
+	    e = straight_path(ND_out(hn).list[0], sl, pointfs);
+	    recover_slack(segfirst, P, rt);
 	    segfirst = e;
 	    tn = agtail(e);
 	    hn = aghead(e);
 	    boxes_clear(&boxes);
-	    tend.nb = maximal_bbox(g, sp, tn, ND_in(tn).list[0], e);
+	    tend.nb = maximal_bbox(g, sp, tn, ND_in(tn).list[0], e, rt);
 	    beginpath(P, e, REGULAREDGE, &tend, spline_merge(tn));
 	    b = makeregularend(tend.boxes[tend.boxn - 1], BOTTOM,
 	    	       ND_coord(tn).y - GD_rank(g)[ND_rank(tn)].ht1);
@@ -1891,8 +2269,8 @@ static void make_regular_edge(graph_t *g, spline_info_t *sp, path *P,
 	    smode = false;
 	}
 	boxes_append(&boxes, rank_box(sp, g, ND_rank(tn)));
-	b = hend.nb = maximal_bbox(g, sp, hn, e, NULL);
-	endpath(P, hackflag ? &fwdedgeb.out : e, REGULAREDGE, &hend,
+	b = hend.nb = maximal_bbox(g, sp, hn, e, NULL, rt);
+	endpath(P, hackflag ? &rt->fwdedgeb.out : e, REGULAREDGE, &hend,
 	        spline_merge(aghead(e)));
 	b.UR.y = hend.boxes[hend.boxn - 1].UR.y;
 	b.LL.y = hend.boxes[hend.boxn - 1].LL.y;
@@ -1917,36 +2295,50 @@ static void make_regular_edge(graph_t *g, spline_info_t *sp, path *P,
         }
 	if (pn == 0) {
 	    free(ps);
-	    points_free(&pointfs);
-	    points_free(&pointfs2);
 	    return;
 	}
 	for (size_t i = 0; i < pn; i++) {
-	    points_append(&pointfs, ps[i]);
+	    points_append(pointfs, ps[i]);
 	}
 	free(ps);
-	recover_slack(segfirst, P);
-	hn = hackflag ? aghead(&fwdedgeb.out) : aghead(e);
+	recover_slack(segfirst, P, rt);
+	hn = hackflag ? aghead(&rt->fwdedgeb.out) : aghead(e);
     }
+    rt->fe = fe;
+    rt->hn = hn;
+    rt->routed = true;
+}
+
+/// give the edges equivalent to `edges[ind]` splines from their route
+static void install_regular_edge(spline_info_t *sp, edge_t **edges,
+                                 unsigned ind, unsigned cnt,
+                                 regular_route_t *rt) {
+    Agedgeinfo_t fwdedgei;
+    Agedgepair_t fwdedge;
+    edge_t *e;
+    points_t *pointfs = &rt->points;
+    points_t pointfs2 = {0};
+
+    if (!rt->routed)
+	return;
+    fwdedge.out.base.data = (Agrec_t*)&fwdedgei;
 
     /* make copies of the spline points, one per multi-edge */
 
     if (cnt == 1) {
-	points_sync(&pointfs);
-	clip_and_install(fe, hn, points_front(&pointfs), points_size(&pointfs),
-	                 &sinfo);
-	points_free(&pointfs);
-	points_free(&pointfs2);
+	points_sync(pointfs);
+	clip_and_install(rt->fe, rt->hn, points_front(pointfs),
+	                 points_size(pointfs), &sinfo);
 	return;
     }
     const double dx = sp->Multisep * (cnt - 1) / 2;
-    for (size_t k = 1; k + 1 < points_size(&pointfs); k++)
-	points_at(&pointfs, k)->x -= dx;
+    for (size_t k = 1; k + 1 < points_size(pointfs); k++)
+	points_at(pointfs, k)->x -= dx;
 
-    for (size_t k = 0; k < points_size(&pointfs); k++)
-	points_append(&pointfs2, points_get(&pointfs, k));
+    for (size_t k = 0; k < points_size(pointfs); k++)
+	points_append(&pointfs2, points_get(pointfs, k));
     points_sync(&pointfs2);
-    clip_and_install(fe, hn, points_front(&pointfs2),
+    clip_and_install(rt->fe, rt->hn, points_front(&pointfs2),
                      points_size(&pointfs2), &sinfo);
     for (unsigned j = 1; j < cnt; j++) {
 	e = edges[ind + j];
@@ -1954,19 +2346,33 @@ static void make_regular_edge(graph_t *g, spline_info_t *sp, path *P,
 	    MAKEFWDEDGE(&fwdedge.out, e);
 	    e = &fwdedge.out;
 	}
-	for (size_t k = 1; k + 1 < points_size(&pointfs); k++)
-	    points_at(&pointfs, k)->x += sp->Multisep;
+	for (size_t k = 1; k + 1 < points_size(pointfs); k++)
+	    points_at(pointfs, k)->x += sp->Multisep;
 	points_clear(&pointfs2);
-	for (size_t k = 0; k < points_size(&pointfs); k++)
-	    points_append(&pointfs2, points_get(&pointfs, k));
+	for (size_t k = 0; k < points_size(pointfs); k++)
+	    points_append(&pointfs2, points_get(pointfs, k));
 	points_sync(&pointfs2);
 	clip_and_install(e, aghead(e), points_front(&pointfs2),
 	                 points_size(&pointfs2), &sinfo);
     }
-    points_free(&pointfs);
     points_free(&pointfs2);
 }
 
+static void regular_route_free(regular_route_t *rt) {
+    points_free(&rt->points);
+    vnodes_free(&rt->reads);
+    resizes_free(&rt->resizes);
+}
+
+static void make_regular_edge(graph_t *g, spline_info_t *sp, path *P,
+                              edge_t **edges, unsigned ind, unsigned cnt,
+                              int et) {
+    regular_route_t rt = {0};
+    route_regular_edge(g, sp, P, edges, ind, &rt, et);
+    install_regular_edge(sp, edges, ind, cnt, &rt);
+    regular_route_free(&rt);
+}
+
 /* regular edges */
 
 static void completeregularpath(path *P, edge_t *first, edge_t *last,
@@ -2116,7 +2522,10 @@ static edge_t *straight_path(edge_t *e, int cnt, points_t *plist) {
     return f;
 }
 
-static void recover_slack(edge_t * e, path * p)
+/// resize the virtual nodes of a route to the space it uses
+///
+/// The resizes are recorded in `rt`, and not done if `rt->deferred`.
+static void recover_slack(edge_t *e, path *p, regular_route_t *rt)
 {
     node_t *vn;
 
@@ -2130,13 +2539,17 @@ static void recover_slack(edge_t * e, path * p)
 	    break;
 	if (p->boxes[b].UR.y < ND_coord(vn).y)
 	    continue;
-	if (ND_label(vn))
-	    resize_vn(vn, p->boxes[b].LL.x, p->boxes[b].UR.x,
-		      p->boxes[b].UR.x + ND_rw(vn));
-	else
-	    resize_vn(vn, p->boxes[b].LL.x, (p->boxes[b].LL.x +
-					     p->boxes[b].UR.x) / 2,
-		      p->boxes[b].UR.x);
+	resize_t r = {.vn = vn, .lx = p->boxes[b].LL.x};
+	if (ND_label(vn)) {
+	    r.cx = p->boxes[b].UR.x;
+	    r.rx = p->boxes[b].UR.x + ND_rw(vn);
+	} else {
+	    r.cx = (p->boxes[b].LL.x + p->boxes[b].UR.x) / 2;
+	    r.rx = p->boxes[b].UR.x;
+	}
+	if (!rt->deferred)
+	    resize_vn(vn, r.lx, r.cx, r.rx);
+	resizes_append(&rt->resizes, r);
     }
 }
 
@@ -2229,6 +2642,17 @@ static Agraph_t *cl_bound(graph_t* g,  node_t *n, node_t *adj)
     return rv;
 }
 
+/// note that a deferred route used the position of a node
+static void used_position(regular_route_t *rt, node_t *n) {
+    if (rt == NULL || !rt->deferred || ND_node_type(n) != VIRTUAL)
+	return;
+    for (size_t i = 0; i < resizes_size(&rt->resizes); i++) {
+	if (resizes_get(&rt->resizes, i).vn == n)
+	    rt->conflict = true;
+    }
+    vnodes_append(&rt->reads, n);
+}
+
 /* maximal_bbox:
  * Return an initial bounding box to be used for building the
  * beginning or ending of the path of boxes.
@@ -2236,10 +2660,12 @@ static Agraph_t *cl_bound(graph_t* g,  node_t *n, node_t *adj)
  * The extra space provided by FUDGE allows begin/endpath to create a box
  * FUDGE-2 away from the node, so the routing can avoid the node and the
  * box is at least 2 wide.
+ * The virtual nodes whose positions are used are noted in rt, if given.
  */
 #define FUDGE 4
 
-static boxf maximal_bbox(graph_t* g, spline_info_t* sp, node_t* vn, edge_t* ie, edge_t* oe)
+static boxf maximal_bbox(graph_t* g, spline_info_t* sp, node_t* vn, edge_t* ie,
+                         edge_t* oe, regular_route_t *rt)
 {
     double b, nb;
     graph_t *left_cl, *right_cl;
@@ -2247,10 +2673,12 @@ static boxf maximal_bbox(graph_t* g, spline_info_t* sp, node_t* vn, edge_t* ie,
     boxf rv;
 
     left_cl = right_cl = NULL;
+    used_position(rt, vn);
 
     /* give this node all the available space up to its neighbors */
     b = (double)(ND_coord(vn).x - ND_lw(vn) - FUDGE);
     if ((left = neighbor(g, vn, ie, oe, -1))) {
+	used_position(rt, left);
 	if ((left_cl = cl_bound(g, vn, left)))
 	    nb = GD_bb(left_cl).UR.x + sp->Splinesep;
 	else {
@@ -2272,6 +2700,7 @@ static boxf maximal_bbox(graph_t* g, spline_info_t* sp, node_t* vn, edge_t* ie,
     else
 	b = (double)(ND_coord(vn).x + ND_rw(vn) + FUDGE);
     if ((right = neighbor(g, vn, ie, oe, 1))) {
+	used_position(rt, right);
 	if ((right_cl = cl_bound(g, vn, right)))
 	    nb = GD_bb(right_cl).LL.x - sp->Splinesep;
 	else {
@@ -0,0 +1,515 @@
+/// @file
+/// @brief seeding dot's phases from a previous layout
+///
+/// When the `incremental` graph attribute is true, dot treats the positions in
+/// its input as an earlier layout of the same graph, as written by `-Tdot`, and
+/// changes as little of it as the edits allow:
+///
+///   - ranking starts from each node's previous `rank` attribute, repaired to
+///     be feasible for the edited graph, rather than from scratch
+///   - the order of each rank follows the previous node and edge positions,
+///     and mincross only refines it by transposing neighbors, instead of
+///     searching for a new order with fewer crossings
+///   - regular edges whose end points did not move keep their previous spline
+///     (see dotsplines.c)
+
+#include <cgraph/gv_ctype.h>
+#include <cgraph/list.h>
+#include <common/render.h>
+#include <dotgen/dot.h>
+#include <limits.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <util/alloc.h>
+
+DEFINE_LIST(pointfs, pointf)
+DEFINE_LIST(beziers, bezier)
+
+bool dot_prev_point(void *obj, Agsym_t *sym, pointf *p) {
+  if (sym == NULL) {
+    return false;
+  }
+  return sscanf(agxget(obj, sym), "%lf,%lf", &p->x, &p->y) == 2;
+}
+
+bool dot_prev_splines(edge_t *e, Agsym_t *sym, splines *spl) {
+  *spl = (splines){0};
+  if (sym == NULL) {
+    return false;
+  }
+
+  const char *pos = agxget(e, sym);
+  beziers_t bzs = {0};
+  bool ok = true;
+  while (ok && *pos != '\0') {
+    bezier bz = {0};
+    double x, y;
+    int nc;
+    if (sscanf(pos, " s,%lf,%lf%n", &x, &y, &nc) == 2) {
+      bz.sflag = 1;
+      bz.sp = (pointf){x, y};
+      pos += nc;
+    }
+    if (sscanf(pos, " e,%lf,%lf%n", &x, &y, &nc) == 2) {
+      bz.eflag = 1;
+      bz.ep = (pointf){x, y};
+      pos += nc;
+    }
+    pointfs_t ps = {0};
+    while (sscanf(pos, " %lf,%lf%n", &x, &y, &nc) == 2) {
+      pointfs_append(&ps, (pointf){x, y});
+      pos += nc;
+    }
+    bz.size = pointfs_size(&ps);
+    bz.list = pointfs_detach(&ps);
+    beziers_append(&bzs, bz);
+
+    // a Bézier needs 3n+1 control points
+    ok = bz.size >= 4 && bz.size % 3 == 1;
+
+    while (gv_isspace(*pos)) {
+      ++pos;
+    }
+    if (*pos == ';') {
+      ++pos;
+    } else if (*pos != '\0') {
+      ok = false;
+    }
+  }
+
+  spl->size = beziers_size(&bzs);
+  spl->list = beziers_detach(&bzs);
+  if (!ok || spl->size == 0) {
+    dot_free_prev_splines(spl);
+    return false;
+  }
+  return true;
+}
+
+void dot_free_prev_splines(splines *spl) {
+  for (size_t i = 0; i < spl->size; ++i) {
+    free(spl->list[i].list);
+  }
+  free(spl->list);
+  *spl = (splines){0};
+}
+
+/// does the given graph lay out its ranks left to right (or right to left)?
+static bool is_horizontal(graph_t *g) {
+  const int rankdir = GD_rankdir(dot_root(g));
+  return rankdir == RANKDIR_LR || rankdir == RANKDIR_RL;
+}
+
+/// coordinate of a previous output position across the ranks
+///
+/// This increases with `ND_order` for every `rankdir`.
+static double across(graph_t *g, pointf p) {
+  if (is_horizontal(g)) {
+    return Y_invert ? -p.y : p.y;
+  }
+  return p.x;
+}
+
+/// coordinate of a previous output position along the ranks
+static double along(graph_t *g, pointf p) {
+  return is_horizontal(g) ? p.x : p.y;
+}
+
+bool dot_spline_cross(const splines *spl, bool vertical, double level,
+                      pointf *p) {
+  for (size_t i = 0; i < spl->size; ++i) {
+    const bezier *bz = &spl->list[i];
+    for (size_t j = 0; j + 3 < bz->size; j += 3) {
+      pointf *V = &bz->list[j];
+      const double a0 = (vertical ? V[0].y : V[0].x) - level;
+      const double a3 = (vertical ? V[3].y : V[3].x) - level;
+      if ((a0 > 0 && a3 > 0) || (a0 < 0 && a3 < 0)) {
+        continue;
+      }
+      if (a0 == 0) {
+        *p = V[0];
+        return true;
+      }
+      // bisect for the crossing, taking the curve to be monotone in between
+      double lo = 0, hi = 1;
+      for (int k = 0; k < 32; ++k) {
+        const double mid = (lo + hi) / 2;
+        const pointf q = Bezier(V, mid, NULL, NULL);
+        const double a = (vertical ? q.y : q.x) - level;
+        if ((a < 0) == (a0 < 0)) {
+          lo = mid;
+        } else {
+          hi = mid;
+        }
+      }
+      *p = Bezier(V, (lo + hi) / 2, NULL, NULL);
+      return true;
+    }
+  }
+  return false;
+}
+
+/// rank of a node in the previous layout
+static bool prev_rank(node_t *n, Agsym_t *sym, int *rank) {
+  if (ND_node_type(n) != NORMAL) {
+    return false;
+  }
+  const char *s = agxget(n, sym);
+  char *end;
+  const long r = strtol(s, &end, 10);
+  if (end == s || r < 0 || r >= INT_MAX / 2) {
+    return false;
+  }
+  *rank = (int)r;
+  return true;
+}
+
+dot_levels_t dot_prev_levels(graph_t *g) {
+  dot_levels_t levels = {0};
+  graph_t *root = agroot(g);
+  Agsym_t *N_pos = agattr(root, AGNODE, "pos", NULL);
+  Agsym_t *rank = agattr(root, AGNODE, "rank", NULL);
+  if (N_pos == NULL || rank == NULL) {
+    return levels;
+  }
+
+  int max_rank = -1;
+  for (node_t *n = agfstnode(g); n != NULL; n = agnxtnode(g, n)) {
+    int r;
+    if (prev_rank(n, rank, &r)) {
+      max_rank = MAX(max_rank, r);
+    }
+  }
+  if (max_rank < 0) {
+    return levels;
+  }
+
+  levels.size = (size_t)max_rank + 1;
+  levels.along = gv_calloc(levels.size, sizeof(double));
+  for (size_t r = 0; r < levels.size; ++r) {
+    levels.along[r] = NAN;
+  }
+  for (node_t *n = agfstnode(g); n != NULL; n = agnxtnode(g, n)) {
+    int r;
+    pointf p;
+    if (prev_rank(n, rank, &r) && isnan(levels.along[r]) &&
+        dot_prev_point(n, N_pos, &p)) {
+      levels.along[r] = along(g, p);
+    }
+  }
+
+  // ranks holding only virtual nodes lie between their neighbors
+  size_t last = SIZE_MAX;
+  for (size_t r = 0; r < levels.size; ++r) {
+    if (isnan(levels.along[r])) {
+      continue;
+    }
+    if (last != SIZE_MAX) {
+      for (size_t i = last + 1; i < r; ++i) {
+        const double f = (double)(i - last) / (double)(r - last);
+        levels.along[i] =
+            levels.along[last] + f * (levels.along[r] - levels.along[last]);
+      }
+    }
+    last = r;
+  }
+  if (last == SIZE_MAX) { // no node has a previous position
+    dot_free_levels(&levels);
+  }
+  return levels;
+}
+
+void dot_free_levels(dot_levels_t *levels) {
+  free(levels->along);
+  *levels = (dot_levels_t){0};
+}
+
+/// position along the ranks of a fractional previous rank
+static bool level_at(const dot_levels_t *levels, double rank, double *level) {
+  if (rank < 0 || rank > (double)levels->size - 1) {
+    return false;
+  }
+  const size_t i = (size_t)rank;
+  const double f = rank - (double)i;
+  if (f == 0) {
+    *level = levels->along[i];
+  } else {
+    *level = levels->along[i] + f * (levels->along[i + 1] - levels->along[i]);
+  }
+  return !isnan(*level);
+}
+
+/// attributes holding the previous layout
+typedef struct {
+  Agsym_t *N_pos;
+  Agsym_t *E_pos;
+  Agsym_t *rank;
+  const dot_levels_t *levels;
+} prev_t;
+
+/// position of a virtual node of an edge chain in the previous layout
+///
+/// This is where the previous spline of the chain's original edge crossed the
+/// level between its end points corresponding to the virtual node's rank.
+static bool vnode_key(graph_t *g, const prev_t *prev, node_t *v,
+                      double *key) {
+  edge_t *e = ND_out(v).size > 0   ? ND_out(v).list[0]
+              : ND_in(v).size > 0 ? ND_in(v).list[0]
+                                  : NULL;
+  if (e == NULL) {
+    return false;
+  }
+  while (ED_to_orig(e) != NULL) {
+    e = ED_to_orig(e);
+  }
+  node_t *t = agtail(e);
+  node_t *h = aghead(e);
+  if (ND_node_type(t) != NORMAL || ND_node_type(h) != NORMAL ||
+      ND_rank(t) == ND_rank(h)) {
+    return false;
+  }
+
+  pointf tp, hp;
+  if (!dot_prev_point(t, prev->N_pos, &tp) ||
+      !dot_prev_point(h, prev->N_pos, &hp)) {
+    return false;
+  }
+  // Where the virtual node was is found by scaling its place between the end
+  // points to their previous ranks, or to their positions if their ranks are
+  // not known.
+  const double f =
+      (double)(ND_rank(v) - ND_rank(t)) / (ND_rank(h) - ND_rank(t));
+  double level;
+  int tr, hr;
+  if (prev->rank == NULL || !prev_rank(t, prev->rank, &tr) ||
+      !prev_rank(h, prev->rank, &hr) ||
+      !level_at(prev->levels, tr + f * (hr - tr), &level)) {
+    level = along(g, tp) + f * (along(g, hp) - along(g, tp));
+  }
+
+  splines spl;
+  if (!dot_prev_splines(e, prev->E_pos, &spl)) {
+    return false;
+  }
+  pointf p;
+  const bool found = dot_spline_cross(&spl, !is_horizontal(g), level, &p);
+  if (found) {
+    *key = across(g, p);
+  }
+  dot_free_prev_splines(&spl);
+  return found;
+}
+
+/// position of a cluster's skeleton node in the previous layout
+///
+/// This is the mean position of the cluster's nodes on the same rank.
+static bool skeleton_key(graph_t *g, const prev_t *prev, node_t *v,
+                         double *key) {
+  graph_t *clust = ND_clust(v);
+  double sum = 0;
+  size_t count = 0;
+  for (node_t *n = agfstnode(clust); n != NULL; n = agnxtnode(clust, n)) {
+    pointf p;
+    if (ND_rank(n) == ND_rank(v) && dot_prev_point(n, prev->N_pos, &p)) {
+      sum += across(g, p);
+      ++count;
+    }
+  }
+  if (count == 0) {
+    return false;
+  }
+  *key = sum / (double)count;
+  return true;
+}
+
+/// position of a node across its rank in the previous layout
+static bool prev_key(graph_t *g, const prev_t *prev, node_t *v, double *key) {
+  if (ND_node_type(v) == NORMAL) {
+    pointf p;
+    if (!dot_prev_point(v, prev->N_pos, &p)) {
+      return false;
+    }
+    *key = across(g, p);
+    return true;
+  }
+  if (ND_ranktype(v) == CLUSTER && ND_clust(v) != NULL) {
+    return skeleton_key(g, prev, v, key);
+  }
+  return vnode_key(g, prev, v, key);
+}
+
+typedef struct {
+  node_t *v;
+  double key;
+  int slot; ///< index in the rank before seeding, to keep the sort stable
+} keyed_t;
+
+static int keycmp(const void *x, const void *y) {
+  const keyed_t *a = x;
+  const keyed_t *b = y;
+  if (a->key < b->key) {
+    return -1;
+  }
+  if (a->key > b->key) {
+    return 1;
+  }
+  return (a->slot > b->slot) - (a->slot < b->slot);
+}
+
+void dot_seed_order(graph_t *g, const dot_levels_t *levels) {
+  graph_t *root = agroot(g);
+  const prev_t prev = {.N_pos = agattr(root, AGNODE, "pos", NULL),
+                       .E_pos = agattr(root, AGEDGE, "pos", NULL),
+                       .rank = agattr(root, AGNODE, "rank", NULL),
+                       .levels = levels};
+  if (prev.N_pos == NULL) {
+    return;
+  }
+
+  for (int r = GD_minrank(g); r <= GD_maxrank(g); r++) {
+    rank_t *rk = &GD_rank(g)[r];
+    if (rk->n < 2) {
+      continue;
+    }
+
+    // Nodes from the previous layout are sorted by their old position and put
+    // back into the slots they occupy between them. New nodes keep the slot
+    // build_ranks gave them.
+    keyed_t *known = gv_calloc((size_t)rk->n, sizeof(keyed_t));
+    int *orders = gv_calloc((size_t)rk->n, sizeof(int));
+    int *slots = gv_calloc((size_t)rk->n, sizeof(int));
+    size_t n_known = 0;
+    for (int i = 0; i < rk->n; i++) {
+      orders[i] = ND_order(rk->v[i]);
+      double key;
+      if (prev_key(g, &prev, rk->v[i], &key)) {
+        known[n_known] = (keyed_t){.v = rk->v[i], .key = key, .slot = i};
+        slots[n_known] = i;
+        ++n_known;
+      }
+    }
+    qsort(known, n_known, sizeof(known[0]), keycmp);
+    for (size_t k = 0; k < n_known; ++k) {
+      const int i = slots[k];
+      rk->v[i] = known[k].v;
+      ND_order(rk->v[i]) = orders[i];
+    }
+    free(slots);
+    free(orders);
+    free(known);
+  }
+}
+
+DEFINE_LIST(nodes, node_t *)
+
+void dot_seed_acyclic(graph_t *g) {
+  Agsym_t *rank = agattr(agroot(g), AGNODE, "rank", NULL);
+  if (rank == NULL) {
+    return;
+  }
+  // Turn around edges that pointed upwards in the previous layout, so cycles
+  // are broken the same way they were then, regardless of the order edges
+  // are now visited in.
+  for (size_t c = 0; c < GD_comp(g).size; c++) {
+    for (node_t *n = GD_comp(g).list[c]; n != NULL; n = ND_next(n)) {
+      int tr, hr;
+      if (!prev_rank(n, rank, &tr)) {
+        continue;
+      }
+      for (size_t i = 0; i < ND_out(n).size;) {
+        edge_t *e = ND_out(n).list[i];
+        if (prev_rank(aghead(e), rank, &hr) && hr < tr) {
+          reverse_edge(e); // removes e from ND_out(n)
+        } else {
+          ++i;
+        }
+      }
+    }
+  }
+}
+
+/// make the ranks of one component feasible, moving seeded nodes as little as
+/// possible
+static void seed_component(node_t *list, Agsym_t *rank) {
+  // order the component topologically
+  nodes_t order = {0};
+  size_t count = 0;
+  for (node_t *n = list; n != NULL; n = ND_next(n)) {
+    ND_priority(n) = (int)ND_in(n).size;
+    if (ND_priority(n) == 0) {
+      nodes_append(&order, n);
+    }
+    ++count;
+  }
+  for (size_t i = 0; i < nodes_size(&order); ++i) {
+    node_t *n = nodes_get(&order, i);
+    for (size_t j = 0; j < ND_out(n).size; ++j) {
+      node_t *h = aghead(ND_out(n).list[j]);
+      if (--ND_priority(h) == 0) {
+        nodes_append(&order, h);
+      }
+    }
+  }
+  if (nodes_size(&order) != count) { // not acyclic; leave ranking to rank2
+    nodes_free(&order);
+    return;
+  }
+
+  // take ranks from the previous layout
+  for (size_t i = 0; i < count; ++i) {
+    node_t *n = nodes_get(&order, i);
+    int r;
+    ND_mark(n) = prev_rank(n, rank, &r);
+    if (ND_mark(n)) {
+      ND_rank(n) = r;
+    }
+  }
+
+  // place new nodes as close as possible above their seeded successors
+  for (size_t i = count; i-- > 0;) {
+    node_t *n = nodes_get(&order, i);
+    if (ND_mark(n)) {
+      continue;
+    }
+    for (size_t j = 0; j < ND_out(n).size; ++j) {
+      edge_t *e = ND_out(n).list[j];
+      if (!ND_mark(aghead(e))) {
+        continue;
+      }
+      const int r = ND_rank(aghead(e)) - ED_minlen(e);
+      if (!ND_mark(n) || r < ND_rank(n)) {
+        ND_rank(n) = r;
+        ND_mark(n) = true;
+      }
+    }
+  }
+
+  // push nodes down until every edge is long enough
+  for (size_t i = 0; i < count; ++i) {
+    node_t *n = nodes_get(&order, i);
+    if (!ND_mark(n)) {
+      ND_rank(n) = ND_in(n).size > 0 ? INT_MIN : 0;
+    }
+    for (size_t j = 0; j < ND_in(n).size; ++j) {
+      edge_t *e = ND_in(n).list[j];
+      ND_rank(n) = MAX(ND_rank(n), ND_rank(agtail(e)) + ED_minlen(e));
+    }
+    ND_mark(n) = false;
+  }
+
+  nodes_free(&order);
+}
+
+void dot_seed_ranks(graph_t *g) {
+  Agsym_t *rank = agattr(agroot(g), AGNODE, "rank", NULL);
+  if (rank == NULL) {
+    return;
+  }
+  for (size_t c = 0; c < GD_comp(g).size; c++) {
+    seed_component(GD_comp(g).list[c], rank);
+  }
+}
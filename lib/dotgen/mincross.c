@@ -29,6 +29,7 @@
 #include <util/alloc.h>
 #include <util/exit.h>
 #include <util/streq.h>
+#include <util/thread.h>
 
 struct adjmatrix_t {
   size_t nrows;
@@ -83,8 +84,42 @@ static const double Convergence = .995;
 static graph_t *Root;
 static int GlobalMinRank, GlobalMaxRank;
 static edge_t **TE_list;
-static int *TI_list;
 static bool ReMincross;
+static dot_levels_t Levels; ///< previous layout's ranks, in incremental mode
+
+/* With the threads attribute set, transpose works on alternate ranks at a
+ * time, so that it gives the same result however many threads run it, and
+ * medians and ncross spread their (order independent) work across threads.
+ */
+static size_t Threads; ///< threads attribute, 0 if unset
+
+/// the far end of an edge, for counting crossings by sorting
+typedef struct {
+  int order;   ///< order of the node at the far end
+  double port; ///< x coordinate of the port at the far end
+  int weight;  ///< crossing penalty of the edge
+} edge_end_t;
+
+DEFINE_LIST(edge_ends, edge_end_t)
+
+/// per-thread scratch space, the first of which is used when single threaded
+typedef struct {
+  ints_t count; ///< for rcross
+  int *list;    ///< for medians, with room for any node's edges
+  /// sorted far ends of in- (`[1]`) or out-edges (`[0]`) of two nodes, for
+  /// pair_cross
+  edge_ends_t ends[2][2];
+  node_t *ends_of[2][2]; ///< which node each of `ends` is for
+} worker_t;
+static worker_t *Workers;
+
+/// fewest nodes worth handing out to threads in one sweep
+enum { PARALLEL_MIN = 2048 };
+
+/// how many threads to use on a sweep over `nodes` nodes
+static size_t sweep_threads(size_t nodes) {
+  return nodes >= PARALLEL_MIN ? Threads : 1;
+}
 
 #if defined(DEBUG) && DEBUG > 1
 static void indent(graph_t* g)
@@ -368,6 +403,8 @@ void dot_mincross(graph_t *g) {
     }
 
     init_mincross(g);
+    if (GD_flags(g) & INCREMENTAL)
+	Levels = dot_prev_levels(g);
 
     ints_t scratch = {0};
 
@@ -398,6 +435,7 @@ void dot_mincross(graph_t *g) {
 #endif
     }
     ints_free(&scratch);
+    dot_free_levels(&Levels);
     cleanup2(g, nc);
 }
 
@@ -621,6 +659,107 @@ static int out_cross(node_t * v, node_t * w)
 
 }
 
+static int edge_end_cmp(const edge_end_t *a, const edge_end_t *b)
+{
+    if (a->order != b->order)
+	return a->order < b->order ? -1 : 1;
+    if (a->port != b->port)
+	return a->port < b->port ? -1 : 1;
+    return 0;
+}
+
+/* edge_ends:
+ * Collect the far ends of the edges in l, which are in-edges if in, sorted
+ * by position.
+ */
+static void edge_ends(edge_ends_t *ends, elist l, bool in)
+{
+    edge_ends_clear(ends);
+    for (size_t i = 0; i < l.size; i++) {
+	edge_t *e = l.list[i];
+	const edge_end_t end = {
+	    .order = ND_order(in ? agtail(e) : aghead(e)),
+	    .port = (in ? ED_tail_port(e) : ED_head_port(e)).p.x,
+	    .weight = ED_xpenalty(e)};
+	edge_ends_append(ends, end);
+    }
+    edge_ends_sort(ends, edge_end_cmp);
+}
+
+/* merge_cross:
+ * Given the sorted far ends of the edges of v and w, count the crossings
+ * between them with v left of w: those pairs where v's end is right of w's.
+ */
+static int merge_cross(const edge_ends_t *v, const edge_ends_t *w)
+{
+    int total = 0;
+    for (size_t i = 0; i < edge_ends_size(v); i++)
+	total += edge_ends_get(v, i).weight;
+
+    int cross = 0, left = 0;
+    size_t i = 0;
+    for (size_t j = 0; j < edge_ends_size(w); j++) {
+	const edge_end_t b = edge_ends_get(w, j);
+	for (; i < edge_ends_size(v); i++) {
+	    const edge_end_t a = edge_ends_get(v, i);
+	    if (edge_end_cmp(&a, &b) > 0)
+		break;
+	    left += a.weight;
+	}
+	cross += (total - left) * b.weight;
+    }
+    return cross;
+}
+
+/// most edge pairs for which pair_cross compares every pair
+enum { PAIR_CROSS_DIRECT = 64 };
+
+/* sorted_ends:
+ * Get the sorted far ends of the in-edges (if in) or out-edges of n, reusing
+ * them if they were the last or next to last requested, and otherwise
+ * replacing those of any node other than keep. Ends are only valid while the
+ * neighboring rank is unchanged.
+ */
+static const edge_ends_t *sorted_ends(worker_t * scratch, node_t * n,
+				      node_t * keep, bool in)
+{
+    edge_ends_t *ends = scratch->ends[in];
+    node_t **of = scratch->ends_of[in];
+
+    for (int k = 0; k < 2; k++) {
+	if (of[k] == n)
+	    return &ends[k];
+    }
+    const int k = of[0] == keep ? 1 : 0;
+    edge_ends(&ends[k], in ? ND_in(n) : ND_out(n), in);
+    of[k] = n;
+    return &ends[k];
+}
+
+/* pair_cross:
+ * Set *vw to the number of crossings between the in-edges (if in) or
+ * out-edges of v and w with v left of w, and *wv to the number with w left
+ * of v. These are what in_cross or out_cross give, but for nodes of high
+ * degree the far ends of the edges are sorted and merged, taking
+ * O(E log E) time rather than O(E^2).
+ */
+static void pair_cross(node_t * v, node_t * w, bool in, worker_t * scratch,
+		       int *vw, int *wv)
+{
+    const elist lv = in ? ND_in(v) : ND_out(v);
+    const elist lw = in ? ND_in(w) : ND_out(w);
+
+    if (lv.size * lw.size <= PAIR_CROSS_DIRECT) {
+	*vw = in ? in_cross(v, w) : out_cross(v, w);
+	*wv = in ? in_cross(w, v) : out_cross(w, v);
+	return;
+    }
+    const edge_ends_t *ev = sorted_ends(scratch, v, w, in);
+    const edge_ends_t *ew = sorted_ends(scratch, w, v, in);
+    *vw = merge_cross(ev, ew);
+    *wv = merge_cross(ew, ev);
+}
+
 static void exchange(node_t * v, node_t * w)
 {
     int vi, wi, r;
@@ -634,13 +773,21 @@ static void exchange(node_t * v, node_t * w)
     GD_rank(Root)[r].v[vi] = w;
 }
 
-static int transpose_step(graph_t * g, int r, bool reverse)
+/* transpose_rank:
+ * Exchange adjacent nodes of rank r wherever that reduces crossings, setting
+ * *changed if any were exchanged. Returns the reduction in crossings.
+ * Only rank r is written, so ranks that are not adjacent can be done
+ * concurrently.
+ */
+static int transpose_rank(graph_t * g, int r, bool reverse, bool *changed,
+			  worker_t * scratch)
 {
-    int i, c0, c1, rv;
+    int i, c0, c1, vw, wv, rv;
     node_t *v, *w;
 
     rv = 0;
-    GD_rank(g)[r].candidate = false;
+    *changed = false;
+    memset(scratch->ends_of, 0, sizeof(scratch->ends_of));
     for (i = 0; i < GD_rank(g)[r].n - 1; i++) {
 	v = GD_rank(g)[r].v[i];
 	w = GD_rank(g)[r].v[i + 1];
@@ -649,30 +796,109 @@ static int transpose_step(graph_t * g, int r, bool reverse)
 	    continue;
 	c0 = c1 = 0;
 	if (r > 0) {
-	    c0 += in_cross(v, w);
-	    c1 += in_cross(w, v);
+	    pair_cross(v, w, true, scratch, &vw, &wv);
+	    c0 += vw;
+	    c1 += wv;
 	}
 	if (GD_rank(g)[r + 1].n > 0) {
-	    c0 += out_cross(v, w);
-	    c1 += out_cross(w, v);
+	    pair_cross(v, w, false, scratch, &vw, &wv);
+	    c0 += vw;
+	    c1 += wv;
 	}
 	if (c1 < c0 || (c0 > 0 && reverse && c1 == c0)) {
 	    exchange(v, w);
 	    rv += c0 - c1;
-	    GD_rank(Root)[r].valid = false;
-	    GD_rank(g)[r].candidate = true;
+	    *changed = true;
+	}
+    }
+    return rv;
+}
+
+/* mark_changed:
+ * Note that the order of rank r has changed, invalidating the crossing counts
+ * of it and its neighbors and making them candidates for another transpose.
+ */
+static void mark_changed(graph_t * g, int r)
+{
+    GD_rank(Root)[r].valid = false;
+    GD_rank(g)[r].candidate = true;
+
+    if (r > GD_minrank(g)) {
+	GD_rank(Root)[r - 1].valid = false;
+	GD_rank(g)[r - 1].candidate = true;
+    }
+    if (r < GD_maxrank(g)) {
+	GD_rank(Root)[r + 1].valid = false;
+	GD_rank(g)[r + 1].candidate = true;
+    }
+}
+
+static int transpose_step(graph_t * g, int r, bool reverse)
+{
+    bool changed;
+
+    GD_rank(g)[r].candidate = false;
+    const int rv = transpose_rank(g, r, reverse, &changed, &Workers[0]);
+    if (changed)
+	mark_changed(g, r);
+    return rv;
+}
 
-	    if (r > GD_minrank(g)) {
-		GD_rank(Root)[r - 1].valid = false;
-		GD_rank(g)[r - 1].candidate = true;
+/// one half of a transpose sweep, over alternate ranks
+typedef struct {
+    graph_t *g;
+    bool reverse;
+    int *ranks;    ///< ranks to transpose
+    int *delta;    ///< reduction in crossings of each rank
+    bool *changed; ///< whether each rank changed
+} transpose_job_t;
+
+static void transpose_job(void *arg, size_t index, size_t worker)
+{
+    transpose_job_t *job = arg;
+    job->delta[index] = transpose_rank(job->g, job->ranks[index], job->reverse,
+				       &job->changed[index], &Workers[worker]);
+}
+
+/* transpose_alternate:
+ * Like transpose, but each sweep first does every other rank, and then the
+ * ranks in between, with the ranks of each half done concurrently. The
+ * result depends on this order of the ranks, but not on the number of
+ * threads.
+ */
+static void transpose_alternate(graph_t * g, bool reverse)
+{
+    const size_t n_ranks = (size_t)(GD_maxrank(g) - GD_minrank(g) + 1);
+    int *ranks = gv_calloc(n_ranks, sizeof(int));
+    int *deltas = gv_calloc(n_ranks, sizeof(int));
+    bool *changed = gv_calloc(n_ranks, sizeof(bool));
+    int delta;
+
+    do {
+	delta = 0;
+	for (int parity = 0; parity < 2; parity++) {
+	    size_t n = 0, nodes = 0;
+	    for (int r = GD_minrank(g) + parity; r <= GD_maxrank(g); r += 2) {
+		if (GD_rank(g)[r].candidate) {
+		    GD_rank(g)[r].candidate = false;
+		    ranks[n++] = r;
+		    nodes += (size_t)GD_rank(g)[r].n;
+		}
 	    }
-	    if (r < GD_maxrank(g)) {
-		GD_rank(Root)[r + 1].valid = false;
-		GD_rank(g)[r + 1].candidate = true;
+	    transpose_job_t job = {.g = g, .reverse = reverse, .ranks = ranks,
+				   .delta = deltas, .changed = changed};
+	    gv_parallel_for(n, sweep_threads(nodes), transpose_job, &job);
+	    for (size_t i = 0; i < n; i++) {
+		delta += deltas[i];
+		if (changed[i])
+		    mark_changed(g, ranks[i]);
 	    }
 	}
-    }
-    return rv;
+    } while (delta >= 1);
+
+    free(changed);
+    free(deltas);
+    free(ranks);
 }
 
 static void transpose(graph_t * g, bool reverse)
@@ -681,6 +907,10 @@ static void transpose(graph_t * g, bool reverse)
 
     for (r = GD_minrank(g); r <= GD_maxrank(g); r++)
 	GD_rank(g)[r].candidate = true;
+    if (Threads > 0) {
+	transpose_alternate(g, reverse);
+	return;
+    }
     do {
 	delta = 0;
 	for (r = GD_minrank(g); r <= GD_maxrank(g); r++) {
@@ -696,6 +926,17 @@ static int mincross(graph_t *g, int startpass, ints_t *scratch) {
     int maxthispass = 0, iter, trying, pass;
     int cur_cross, best_cross;
 
+    if (Levels.size > 0) {
+	/* keep the previous layout's order, only removing crossings locally */
+	if (startpass <= 1) {
+	    build_ranks(g, 0, scratch);
+	    flat_breakcycles(g);
+	    flat_reorder(g);
+	}
+	if (ncross(scratch) > 0)
+	    transpose(g, false);
+	return ncross(scratch);
+    }
     if (startpass > 1) {
 	cur_cross = best_cross = ncross(scratch);
 	save_best(g);
@@ -839,14 +1080,20 @@ static void cleanup2(graph_t * g, int nc)
     node_t *v;
     edge_t *e;
 
-    if (TI_list) {
-	free(TI_list);
-	TI_list = NULL;
-    }
     if (TE_list) {
 	free(TE_list);
 	TE_list = NULL;
     }
+    if (Workers) {
+	for (size_t t = 0; t < MAX(Threads, 1); t++) {
+	    ints_free(&Workers[t].count);
+	    free(Workers[t].list);
+	    for (int k = 0; k < 4; k++)
+		edge_ends_free(&Workers[t].ends[k / 2][k % 2]);
+	}
+	free(Workers);
+	Workers = NULL;
+    }
     /* fix vlists of clusters */
     for (c = 1; c <= GD_n_cluster(g); c++)
 	rec_reset_vlists(GD_clust(g)[c]);
@@ -1040,8 +1287,10 @@ static void init_mincross(graph_t * g)
     /* alloc +1 for the null terminator usage in do_ordering() */
     size = agnedges(dot_root(g)) + 1;
     TE_list = gv_calloc(size, sizeof(edge_t*));
-    TI_list = gv_calloc(size, sizeof(int));
     mincross_options(g);
+    Workers = gv_calloc(MAX(Threads, 1), sizeof(worker_t));
+    for (size_t t = 0; t < MAX(Threads, 1); t++)
+	Workers[t].list = gv_calloc(size, sizeof(int));
     if (GD_flags(g) & NEW_RANK)
 	fillRanks (g);
     class2(g);
@@ -1288,6 +1537,9 @@ void build_ranks(graph_t *g, int pass, ints_t *scratch) {
 	}
     }
 
+    if (Levels.size > 0)
+	dot_seed_order(g, &Levels);
+
     if (g == dot_root(g) && ncross(scratch) > 0)
 	transpose(g, false);
     node_queue_free(&q);
@@ -1519,36 +1771,45 @@ static int local_cross(elist l, int dir)
     return cross;
 }
 
+/* rcross:
+ * Count the crossings between ranks r and r+1. Edges are visited in order of
+ * their tails, and an accumulator tree (a Fenwick tree over the positions in
+ * rank r+1, after Barth, Jünger and Mutzel) holds the weights of the edges
+ * seen so far ending at each position, so that the weight of those ending to
+ * the right of a new edge's head takes O(log V) time to sum.
+ */
 static int rcross(graph_t *g, int r, ints_t *Count) {
-    int top, bot, cross, max, i, k;
+    int top, bot, cross, i, total;
     node_t **rtop, *v;
+    edge_t *e;
 
     cross = 0;
-    max = 0;
+    total = 0;
     rtop = GD_rank(g)[r].v;
 
+    size_t n = 0;
+    for (top = 0; top < GD_rank(g)[r].n; top++) {
+	for (i = 0; (e = ND_out(rtop[top]).list[i]); i++)
+	    n = MAX(n, (size_t)ND_order(aghead(e)) + 1);
+    }
+
     // discard any data from previous runs
     ints_clear(Count);
+    ints_resize(Count, n + 1, 0);
+    int *tree = ints_front(Count);
 
     for (top = 0; top < GD_rank(g)[r].n; top++) {
-	edge_t *e;
-	if (max > 0) {
-	    for (i = 0; (e = ND_out(rtop[top]).list[i]); i++) {
-		for (k = ND_order(aghead(e)) + 1; k <= max; k++)
-		    cross += ints_size(Count) <= (size_t)k
-		             ? 0
-		             : ints_get(Count, (size_t)k) * ED_xpenalty(e);
-	    }
+	for (i = 0; (e = ND_out(rtop[top]).list[i]); i++) {
+	    // weight of earlier edges ending at or left of this one's head
+	    int left = 0;
+	    for (size_t k = (size_t)ND_order(aghead(e)) + 1; k > 0; k &= k - 1)
+		left += tree[k];
+	    cross += (total - left) * ED_xpenalty(e);
 	}
 	for (i = 0; (e = ND_out(rtop[top]).list[i]); i++) {
-	    int inv = ND_order(aghead(e));
-	    if (inv > max)
-		max = inv;
-	    const size_t inv_z = (size_t)inv;
-	    if (ints_size(Count) <= inv_z) {
-		ints_resize(Count, inv_z + 1, 0);
-	    }
-	    ints_set(Count, inv_z, ints_get(Count, inv_z) + ED_xpenalty(e));
+	    for (size_t k = (size_t)ND_order(aghead(e)) + 1; k <= n; k += k & -k)
+		tree[k] += ED_xpenalty(e);
+	    total += ED_xpenalty(e);
 	}
     }
     for (top = 0; top < GD_rank(g)[r].n; top++) {
@@ -1564,11 +1825,48 @@ static int rcross(graph_t *g, int r, ints_t *Count) {
     return cross;
 }
 
+/// crossing counts of several ranks, computed concurrently
+typedef struct {
+    int *ranks; ///< ranks to count crossings below
+} ncross_job_t;
+
+static void ncross_job(void *arg, size_t index, size_t worker)
+{
+    ncross_job_t *job = arg;
+    const int r = job->ranks[index];
+    GD_rank(Root)[r].cache_nc = rcross(Root, r, &Workers[worker].count);
+    GD_rank(Root)[r].valid = true;
+}
+
+/* ncross_parallel:
+ * Bring the cached crossing counts of all ranks up to date, spreading the
+ * ranks whose counts are stale across threads.
+ */
+static void ncross_parallel(void)
+{
+    graph_t *g = Root;
+    const size_t n_ranks = (size_t)(GD_maxrank(g) - GD_minrank(g));
+    int *ranks = gv_calloc(n_ranks, sizeof(int));
+    size_t n = 0, nodes = 0;
+
+    for (int r = GD_minrank(g); r < GD_maxrank(g); r++) {
+	if (!GD_rank(g)[r].valid) {
+	    ranks[n++] = r;
+	    nodes += (size_t)GD_rank(g)[r].n;
+	}
+    }
+    ncross_job_t job = {.ranks = ranks};
+    gv_parallel_for(n, sweep_threads(nodes), ncross_job, &job);
+    free(ranks);
+}
+
 static int ncross(ints_t *scratch) {
     assert(scratch != NULL);
     int r, count, nc;
 
     graph_t *g = Root;
+    if (Threads > 1 && GD_maxrank(g) > GD_minrank(g))
+	ncross_parallel();
     count = 0;
     for (r = GD_minrank(g); r < GD_maxrank(g); r++) {
 	if (GD_rank(g)[r].valid)
@@ -1636,57 +1934,91 @@ static bool flat_mval(node_t * n)
 
 #define VAL(node,port) (MC_SCALE * ND_order(node) + (port).order)
 
-static bool medians(graph_t * g, int r0, int r1)
+/* median_value:
+ * Set the median value of node n, on rank r0, from its neighbors on rank r1,
+ * using list as scratch space.
+ */
+static void median_value(node_t * n, int r0, int r1, int *list)
 {
-    int i, j0, lspan, rspan, *list;
-    node_t *n, **v;
+    int j0, lspan, rspan;
     edge_t *e;
-    bool hasfixed = false;
 
-    list = TI_list;
-    v = GD_rank(g)[r0].v;
-    for (i = 0; i < GD_rank(g)[r0].n; i++) {
-	n = v[i];
-	size_t j = 0;
-	if (r1 > r0)
-	    for (j0 = 0; (e = ND_out(n).list[j0]); j0++) {
-		if (ED_xpenalty(e) > 0)
-		    list[j++] = VAL(aghead(e), ED_head_port(e));
-	} else
-	    for (j0 = 0; (e = ND_in(n).list[j0]); j0++) {
-		if (ED_xpenalty(e) > 0)
-		    list[j++] = VAL(agtail(e), ED_tail_port(e));
-	    }
-	switch (j) {
-	case 0:
-	    ND_mval(n) = -1;
-	    break;
-	case 1:
-	    ND_mval(n) = list[0];
-	    break;
-	case 2:
-	    ND_mval(n) = (list[0] + list[1]) / 2;
-	    break;
-	default:
-	    qsort(list, j, sizeof(int), ordercmpf);
-	    if (j % 2)
-		ND_mval(n) = list[j / 2];
+    size_t j = 0;
+    if (r1 > r0)
+	for (j0 = 0; (e = ND_out(n).list[j0]); j0++) {
+	    if (ED_xpenalty(e) > 0)
+		list[j++] = VAL(aghead(e), ED_head_port(e));
+    } else
+	for (j0 = 0; (e = ND_in(n).list[j0]); j0++) {
+	    if (ED_xpenalty(e) > 0)
+		list[j++] = VAL(agtail(e), ED_tail_port(e));
+	}
+    switch (j) {
+    case 0:
+	ND_mval(n) = -1;
+	break;
+    case 1:
+	ND_mval(n) = list[0];
+	break;
+    case 2:
+	ND_mval(n) = (list[0] + list[1]) / 2;
+	break;
+    default:
+	qsort(list, j, sizeof(int), ordercmpf);
+	if (j % 2)
+	    ND_mval(n) = list[j / 2];
+	else {
+	    /* weighted median */
+	    size_t rm = j / 2;
+	    size_t lm = rm - 1;
+	    rspan = list[j - 1] - list[rm];
+	    lspan = list[lm] - list[0];
+	    if (lspan == rspan)
+		ND_mval(n) = (list[lm] + list[rm]) / 2;
 	    else {
-		/* weighted median */
-		size_t rm = j / 2;
-		size_t lm = rm - 1;
-		rspan = list[j - 1] - list[rm];
-		lspan = list[lm] - list[0];
-		if (lspan == rspan)
-		    ND_mval(n) = (list[lm] + list[rm]) / 2;
-		else {
-		    double w = list[lm] * (double)rspan + list[rm] * (double)lspan;
-		    ND_mval(n) = w / (lspan + rspan);
-		}
+		double w = list[lm] * (double)rspan + list[rm] * (double)lspan;
+		ND_mval(n) = w / (lspan + rspan);
 	    }
 	}
     }
-    for (i = 0; i < GD_rank(g)[r0].n; i++) {
+}
+
+/// nodes per work item when computing medians concurrently
+enum { MEDIAN_BLOCK = 256 };
+
+/// median values of one rank, computed concurrently
+typedef struct {
+    node_t **v; ///< nodes of the rank
+    int n;      ///< number of nodes
+    int r0, r1;
+} medians_job_t;
+
+static void medians_job(void *arg, size_t index, size_t worker)
+{
+    medians_job_t *job = arg;
+    const int start = (int)index * MEDIAN_BLOCK;
+    const int end = MIN(job->n, start + MEDIAN_BLOCK);
+    for (int i = start; i < end; i++)
+	median_value(job->v[i], job->r0, job->r1, Workers[worker].list);
+}
+
+static bool medians(graph_t * g, int r0, int r1)
+{
+    int i;
+    node_t *n, **v;
+    bool hasfixed = false;
+
+    v = GD_rank(g)[r0].v;
+    const int nv = GD_rank(g)[r0].n;
+    if (Threads > 1 && nv >= 2 * MEDIAN_BLOCK) {
+	medians_job_t job = {.v = v, .n = nv, .r0 = r0, .r1 = r1};
+	gv_parallel_for(((size_t)nv + MEDIAN_BLOCK - 1) / MEDIAN_BLOCK,
+			sweep_threads((size_t)nv), medians_job, &job);
+    } else {
+	for (i = 0; i < nv; i++)
+	    median_value(v[i], r0, r1, Workers[0].list);
+    }
+    for (i = 0; i < nv; i++) {
 	n = v[i];
 	if ((ND_out(n).size == 0) && (ND_in(n).size == 0))
 	    hasfixed |= flat_mval(n);
@@ -1830,6 +2162,7 @@ static void mincross_options(graph_t * g)
     /* set default values */
     MinQuit = 8;
     MaxIter = 24;
+    Threads = late_threads(g);
 
     p = agget(g, "mclimit");
     if (p && (f = atof(p)) > 0.0) {
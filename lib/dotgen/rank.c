@@ -440,6 +440,8 @@ static void dot1_rank(graph_t *g)
     if (minmax_edges2(g, p))
 	decompose(g, 0);
 
+    if (GD_flags(dot_root(g)) & INCREMENTAL)
+	dot_seed_ranks(g);
     rank1(g);
 
     expand_ranksets(g);
@@ -655,34 +657,39 @@ static bool is_internal_to_cluster(edge_t * e)
     return false;
 }
 
-static node_t* Last_node;
-static node_t* makeXnode (graph_t* G, char* name)
+/// state for building the level assignment constraint graph
+typedef struct {
+  node_t *last_node; ///< tail of the node list being built
+  int weak_id;       ///< counter for naming weak constraint nodes
+} xgraph_state_t;
+
+static node_t *makeXnode(xgraph_state_t *st, graph_t *G, char *name)
 {
     node_t *n = agnode(G, name, 1);
     alloc_elist(4, ND_in(n));
     alloc_elist(4, ND_out(n));
-    if (Last_node) {
-	ND_prev(n) = Last_node;
-	ND_next(Last_node) = n;
+    if (st->last_node) {
+	ND_prev(n) = st->last_node;
+	ND_next(st->last_node) = n;
     } else {
 	ND_prev(n) = NULL;
 	GD_nlist(G) = n;
     }
-    Last_node = n;
+    st->last_node = n;
     ND_next(n) = NULL;
     
     return n;
 }
 
-static void compile_nodes(graph_t * g, graph_t * Xg)
+static void compile_nodes(xgraph_state_t *st, graph_t *g, graph_t *Xg)
 {
     /* build variables */
     node_t *n;
 
-    Last_node = NULL;
+    st->last_node = NULL;
     for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
 	if (find(n) == n)
-	    ND_rep(n) = makeXnode (Xg, agnameof(n));
+	    ND_rep(n) = makeXnode(st, Xg, agnameof(n));
     }
     for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
 	if (ND_rep(n) == 0)
@@ -707,11 +714,11 @@ static void strong(graph_t * g, node_t * t, node_t * h, edge_t * orig)
 	    agnameof(t), agnameof(h));
 }
 
-static void weak(graph_t * g, node_t * t, node_t * h, edge_t * orig)
+static void weak(xgraph_state_t *st, graph_t *g, node_t *t, node_t *h,
+                 edge_t *orig)
 {
     node_t *v;
     edge_t *e, *f;
-    static int id;
     char buf[100];
 
     for (e = agfstin(g, t); e; e = agnxtin(g, e)) {
@@ -722,8 +729,8 @@ static void weak(graph_t * g, node_t * t, node_t * h, edge_t * orig)
 	}
     }
     if (!e) {
-	snprintf(buf, sizeof(buf), "_weak_%d", id++);
-	v = makeXnode(g, buf);
+	snprintf(buf, sizeof(buf), "_weak_%d", st->weak_id++);
+	v = makeXnode(st, g, buf);
 	e = agedge(g, v, t, 0, 1);
 	f = agedge(g, v, h, 0, 1);
     }
@@ -733,7 +740,7 @@ static void weak(graph_t * g, node_t * t, node_t * h, edge_t * orig)
     ED_weight(f) += ED_weight(orig);
 }
 
-static void compile_edges(graph_t * ug, graph_t * Xg)
+static void compile_edges(xgraph_state_t *st, graph_t *ug, graph_t *Xg)
 {
     node_t *n;
     edge_t *e;
@@ -766,7 +773,7 @@ static void compile_edges(graph_t * ug, graph_t * Xg)
 		strong(Xg, Xt, Xh, e);
 	    } else {
 		if (is_a_strong_cluster(tc) || is_a_strong_cluster(hc))
-		    weak(Xg, Xt, Xh, e);
+		    weak(st, Xg, Xt, Xh, e);
 		else
 		    strong(Xg, Xt, Xh, e);
 	    }
@@ -774,7 +781,8 @@ static void compile_edges(graph_t * ug, graph_t * Xg)
     }
 }
 
-static void compile_clusters(graph_t* g, graph_t* Xg, node_t* top, node_t* bot)
+static void compile_clusters(xgraph_state_t *st, graph_t *g, graph_t *Xg,
+                             node_t *top, node_t *bot)
 {
     node_t *n;
     node_t *rep;
@@ -785,12 +793,12 @@ static void compile_clusters(graph_t* g, graph_t* Xg, node_t* top, node_t* bot)
 	for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
 	    if (agfstin(g, n) == 0) {
 		rep = ND_rep(find(n));
-		if (!top) top = makeXnode(Xg,TOPNODE);
+		if (!top) top = makeXnode(st, Xg, TOPNODE);
 		agedge(Xg, top, rep, 0, 1);
 	    }
 	    if (agfstout(g, n) == 0) {
 		rep = ND_rep(find(n));
-		if (!bot)  bot = makeXnode(Xg,BOTNODE);
+		if (!bot)  bot = makeXnode(st, Xg, BOTNODE);
 		agedge(Xg, rep, bot, 0, 1);
 	    }
 	}
@@ -800,7 +808,7 @@ static void compile_clusters(graph_t* g, graph_t* Xg, node_t* top, node_t* bot)
 	}
     }
     for (sub = agfstsubg(g); sub; sub = agnxtsubg(sub))
-	compile_clusters(sub, Xg, top, bot);
+	compile_clusters(st, sub, Xg, top, bot);
 }
 
 static void reverse_edge2(graph_t * g, edge_t * e)
@@ -954,7 +962,7 @@ static void dfscc(graph_t * g, node_t * n, int cc)
     }
 }
 
-static int connect_components(graph_t * g)
+static int connect_components(xgraph_state_t *st, graph_t *g)
 {
     int cc = 0;
     node_t *n;
@@ -965,7 +973,7 @@ static int connect_components(graph_t * g)
 	if (ND_comp(n) == 0)
 	    dfscc(g, n, ++cc);
     if (cc > 1) {
-	node_t *root = makeXnode(g, ROOT);
+	node_t *root = makeXnode(st, g, ROOT);
 	int ncc = 1;
 	for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
 	    if (ND_comp(n) == ncc) {
@@ -1008,8 +1016,8 @@ void dot2_rank(graph_t *g) {
     int ncc, maxiter = INT_MAX;
     char *s;
     graph_t *Xg;
+    xgraph_state_t st = {0};
 
-    Last_node = NULL;
     Xg = agopen("level assignment constraints", Agstrictdirected, 0);
     agbindrec(Xg,"level graph rec",sizeof(Agraphinfo_t),true);
     agpushdisc(Xg,&mydisc,infosizes);
@@ -1022,11 +1030,11 @@ void dot2_rank(graph_t *g) {
 	maxiter = INT_MAX;
 
     compile_samerank(g, 0);
-    compile_nodes(g, Xg);
-    compile_edges(g, Xg);
-    compile_clusters(g, Xg, 0, 0);
+    compile_nodes(&st, g, Xg);
+    compile_edges(&st, g, Xg);
+    compile_clusters(&st, g, Xg, 0, 0);
     break_cycles(Xg);
-    ncc = connect_components(Xg);
+    ncc = connect_components(&st, Xg);
     add_fast_edges (Xg);
 
     if ((s = agget(g, "searchsize")))
@@ -86,8 +86,10 @@ extern "C" {
 	/* gvParseArgs */
 	char **input_filenames; /* null terminated array of input filenames */
 	int fidx; /* index of input_filenames to be processed next */
+	size_t parse_ahead; /* graphs to parse ahead of layout, or 0 */
 
 	/* gvNextInputGraph() */
+	void *pipeline;	/* input being parsed on another thread, if any */
 	GVG_t *gvgs;	/* linked list of graphs */
 	GVG_t *gvg;	/* current graph */
 
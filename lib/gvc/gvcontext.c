@@ -68,6 +68,7 @@ int gvFreeContext(GVC_t * gvc)
     gvplugin_available_t *api, *api_next;
 
     emit_once_reset();
+    dotneato_close_input(gvc);
     gvg_next = gvc->gvgs;
     while ((gvg = gvg_next)) {
 	gvg_next = gvg->next;
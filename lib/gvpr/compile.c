@@ -78,9 +78,9 @@ static int ioflush(void *chan)
 static Agiodisc_t gprIoDisc = { iofread, ioputstr, ioflush };
 
 #ifdef GVDLL
-static Agdisc_t gprDisc = { 0, &gprIoDisc };
+static Agdisc_t gprDisc = { 0, &gprIoDisc, 0 };
 #else
-static Agdisc_t gprDisc = { &AgIdDisc, &gprIoDisc };
+static Agdisc_t gprDisc = { &AgIdDisc, &gprIoDisc, &AgMemDisc };
 #endif
 
 /* nameOf:
@@ -24,6 +24,15 @@
 
 void bfs(int vertex, vtx_data *graph, int n, DistType *dist)
  /* compute vector 'dist' of distances of all nodes from 'vertex' */
+{
+    Queue Q;
+    mkQueue(&Q, n);
+    bfs_queue(vertex, graph, n, dist, &Q);
+    freeQueue(&Q);
+}
+
+void bfs_queue(int vertex, vtx_data *graph, int n, DistType *dist, Queue *Q)
+ /* as bfs, using Q, which has room for n nodes, instead of allocating one */
 {
     int closestVertex, neighbor;
     DistType closestDist = INT_MAX;
@@ -33,23 +42,21 @@ void bfs(int vertex, vtx_data *graph, int n, DistType *dist)
 	dist[i] = -1;
     dist[vertex] = 0;
 
-    Queue Q;
-    mkQueue(&Q, n);
-    initQueue(&Q, vertex);
+    initQueue(Q, vertex);
 
     if (graph[0].ewgts == NULL) {
-	while (deQueue(&Q, &closestVertex)) {
+	while (deQueue(Q, &closestVertex)) {
 	    closestDist = dist[closestVertex];
 	    for (size_t i = 1; i < graph[closestVertex].nedges; i++) {
 		neighbor = graph[closestVertex].edges[i];
 		if (dist[neighbor] < -0.5) {	/* first time to reach neighbor */
 		    dist[neighbor] = closestDist + 1;
-		    enQueue(&Q, neighbor);
+		    enQueue(Q, neighbor);
 		}
 	    }
 	}
     } else {
-	while (deQueue(&Q, &closestVertex)) {
+	while (deQueue(Q, &closestVertex)) {
 	    closestDist = dist[closestVertex];
 	    for (size_t i = 1; i < graph[closestVertex].nedges; i++) {
 		neighbor = graph[closestVertex].edges[i];
@@ -57,7 +64,7 @@ void bfs(int vertex, vtx_data *graph, int n, DistType *dist)
 		    dist[neighbor] =
 			closestDist +
 			(DistType) graph[closestVertex].ewgts[i];
-		    enQueue(&Q, neighbor);
+		    enQueue(Q, neighbor);
 		}
 	    }
 	}
@@ -67,8 +74,6 @@ void bfs(int vertex, vtx_data *graph, int n, DistType *dist)
     for (int i = 0; i < n; i++)
 	if (dist[i] < -0.5)	/* 'i' is not connected to 'vertex' */
 	    dist[i] = closestDist + 10;
-
-    freeQueue(&Q);
 }
 
 void mkQueue(Queue * qp, int size)
@@ -32,6 +32,7 @@ extern "C" {
     extern bool enQueue(Queue *, int);
 
     extern void bfs(int, vtx_data*, int, DistType*);
+    extern void bfs_queue(int, vtx_data*, int, DistType*, Queue*);
 
 #ifdef __cplusplus
 }
@@ -90,7 +90,7 @@ int stress_majorization_with_hierarchy(vtx_data * graph,	/* Input graph in spars
     if (!directionalityExist) {
 	return stress_majorization_kD_mkernel(graph, n,
 					      d_coords, nodes, dim, opts,
-					      model, maxi);
+					      model, maxi, 1);
     }
 
 	/******************************************************************
@@ -104,7 +104,7 @@ int stress_majorization_with_hierarchy(vtx_data * graph,	/* Input graph in spars
 	    /* the dim==2 case is handled below                      */
 	    if (stress_majorization_kD_mkernel(graph, n,
 					   d_coords + 1, nodes, dim - 1,
-					   opts, model, 15) < 0)
+					   opts, model, 15, 1) < 0)
 		return -1;
 	    /* now copy the y-axis into the (dim-1)-axis */
 	    for (i = 0; i < n; i++) {
@@ -128,7 +128,7 @@ int stress_majorization_with_hierarchy(vtx_data * graph,	/* Input graph in spars
 	    free(levels);
 	    return stress_majorization_kD_mkernel(graph, n,
 						  d_coords, nodes, dim,
-						  opts, model, maxi);
+						  opts, model, maxi, 1);
 	}
 
 	if (levels_gap > 0) {
@@ -183,7 +183,7 @@ int stress_majorization_with_hierarchy(vtx_data * graph,	/* Input graph in spars
 	/* and perform slower Dijkstra-based computation */
 	if (Verbose)
 	    fprintf(stderr, "Calculating subset model");
-	Dij = compute_apsp_artificial_weights_packed(graph, n);
+	Dij = compute_apsp_artificial_weights_packed(graph, n, 1);
     } else if (model == MODEL_CIRCUIT) {
 	Dij = circuitModel(graph, n);
 	if (!Dij) {
@@ -195,12 +195,12 @@ int stress_majorization_with_hierarchy(vtx_data * graph,	/* Input graph in spars
     } else if (model == MODEL_MDS) {
 	if (Verbose)
 	    fprintf(stderr, "Calculating MDS model");
-	Dij = mdsModel(graph, n);
+	Dij = mdsModel(graph, n, 1);
     }
     if (!Dij) {
 	if (Verbose)
 	    fprintf(stderr, "Calculating shortest paths");
-	Dij = compute_apsp_packed(graph, n);
+	Dij = compute_apsp_packed(graph, n, 1);
     }
     if (Verbose) {
 	fprintf(stderr, ": %.2f sec\n", elapsed_sec());
@@ -125,7 +125,7 @@ int stress_majorization_cola(vtx_data * graph,	/* Input graph in sparse represen
 	/* and perform slower Dijkstra-based computation */
 	if (Verbose)
 	    fprintf(stderr, "Calculating subset model");
-	Dij = compute_apsp_artificial_weights_packed(graph, n);
+	Dij = compute_apsp_artificial_weights_packed(graph, n, 1);
     } else if (model == MODEL_CIRCUIT) {
 	Dij = circuitModel(graph, n);
 	if (!Dij) {
@@ -137,12 +137,12 @@ int stress_majorization_cola(vtx_data * graph,	/* Input graph in sparse represen
     } else if (model == MODEL_MDS) {
 	if (Verbose)
 	    fprintf(stderr, "Calculating MDS model");
-	Dij = mdsModel(graph, n);
+	Dij = mdsModel(graph, n, 1);
     }
     if (!Dij) {
 	if (Verbose)
 	    fprintf(stderr, "Calculating shortest paths");
-	Dij = compute_apsp_packed(graph, n);
+	Dij = compute_apsp_packed(graph, n, 1);
     }
     if (Verbose) {
 	fprintf(stderr, ": %.2f sec\n", elapsed_sec());
@@ -19,6 +19,7 @@
 #include <neatogen/delaunay.h>
 #include <util/alloc.h>
 #include <util/sort.h>
+#include <util/thread.h>
 
 #ifdef HAVE_GTS
 #include <gts.h>
@@ -141,6 +142,11 @@ destroy (GtsVertex* v)
 static GtsSurface*
 tri(double *x, double *y, int npt, int *segs, int nsegs, int sepArr)
 {
+    // GTS lazily creates its classes and we toggle its global
+    // gts_allow_floating_* flags, so only one triangulation can be built at a
+    // time
+    gv_global_lock();
+
     int i;
     GtsSurface *surface;
     GVertex **vertices = gv_calloc(npt, sizeof(GVertex *));
@@ -220,9 +226,18 @@ tri(double *x, double *y, int npt, int *segs, int nsegs, int sepArr)
 
     free (edges);
     free(vertices);
+    gv_global_unlock();
     return surface;
 }
 
+/// destroy a surface created by `tri`
+static void surface_destroy(GtsSurface *s) {
+    // destruction consults the gts_allow_floating_* flags `tri` modifies
+    gv_global_lock();
+    gts_object_destroy(GTS_OBJECT(s));
+    gv_global_unlock();
+}
+
 typedef struct {
     int n;
     v_data *delaunay;
@@ -288,7 +303,7 @@ static v_data *delaunay_triangulation(double *x, double *y, int n) {
     }
     gts_surface_foreach_edge(s, add_edge, delaunay);
 
-    gts_object_destroy (GTS_OBJECT (s));
+    surface_destroy(s);
 
     return delaunay;
 }
@@ -381,7 +396,7 @@ int *delaunay_tri(double *x, double *y, int n, int* pnedges)
 	free (vs);
     }
 
-    gts_object_destroy (GTS_OBJECT (s));
+    surface_destroy(s);
 
     return edges;
 }
@@ -501,7 +516,7 @@ mkSurface (double *x, double *y, int n, int* segs, int nsegs)
     sf->faces = faces;
     sf->neigh = neigh;
 
-    gts_object_destroy (GTS_OBJECT (s));
+    surface_destroy(s);
 
     return sf;
 }
@@ -529,7 +544,7 @@ get_triangles (double *x, int n, int* tris)
     statf.faces = gv_calloc(3 * nfaces, sizeof(int));
     gts_surface_foreach_face(s, addTri, &statf);
 
-    gts_object_destroy (GTS_OBJECT (s));
+    surface_destroy(s);
 
     *tris = nfaces;
     return statf.faces;
@@ -591,7 +606,10 @@ get_triangles (double *x, int n, int* tris)
     /*   produce an edge list (e), a Voronoi diagram (v), and a triangle */
     /*   neighbor list (n).                                              */
 
+    // Triangle keeps its working state in globals
+    gv_global_lock();
     triangulate("Qenv", &in, &mid, &vorout);
+    gv_global_unlock();
     assert (mid.numberofcorners == 3);
 
     *tris = mid.numberoftriangles;
@@ -664,7 +682,10 @@ delaunay_tri (double *x, double *y, int n, int* nedges)
     out.edgemarkerlist = NULL;
     out.normlist = NULL;
 
+    // Triangle keeps its working state in globals
+    gv_global_lock();
     triangulate("zQNEeB", &in, &out, NULL);
+    gv_global_unlock();
 
     *nedges = out.numberofedges;
     free (in.pointlist);
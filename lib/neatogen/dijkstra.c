@@ -196,11 +196,12 @@ static void heapify_f(heap * h, int i, int index[], float dist[])
 }
 
 static void
-initHeap_f(heap * h, int startVertex, int index[], float dist[], int n)
+initHeap_f(heap * h, int startVertex, int index[], float dist[], int n,
+	   int *data)
 {
     int i, count;
     int j;			/* We cannot use an unsigned value in this loop */
-    h->data = gv_calloc(n - 1, sizeof(int));
+    h->data = data;
     h->heapSize = n - 1;
 
     for (count = 0, i = 0; i < n; i++)
@@ -251,16 +252,42 @@ increaseKey_f(heap * h, int increasedVertex, float newDist, int index[],
     index[increasedVertex] = i;
 }
 
+void dijkstra_scratch_init(dijkstra_scratch_t *scratch, int n)
+{
+    scratch->heap = gv_calloc(n, sizeof(int));
+    scratch->index = gv_calloc(n, sizeof(int));
+    scratch->dist = gv_calloc(n, sizeof(float));
+}
+
+void dijkstra_scratch_free(dijkstra_scratch_t *scratch)
+{
+    free(scratch->heap);
+    free(scratch->index);
+    free(scratch->dist);
+}
+
 /* dijkstra_f:
  * Weighted shortest paths from vertex.
  * Assume graph is connected.
  */
 void dijkstra_f(int vertex, vtx_data * graph, int n, float *dist)
+{
+    dijkstra_scratch_t scratch;
+    dijkstra_scratch_init(&scratch, n);
+    dijkstra_f_scratch(vertex, graph, n, dist, &scratch);
+    dijkstra_scratch_free(&scratch);
+}
+
+/* dijkstra_f_scratch:
+ * As dijkstra_f, using the heap space in scratch rather than allocating it.
+ */
+void dijkstra_f_scratch(int vertex, vtx_data *graph, int n, float *dist,
+			dijkstra_scratch_t *scratch)
 {
     heap H;
     int closestVertex = 0, neighbor;
     float closestDist;
-    int *index = gv_calloc(n, sizeof(int));
+    int *index = scratch->index;
 
     /* initial distances with edge weights: */
     for (int i = 0; i < n; i++)
@@ -269,7 +296,7 @@ void dijkstra_f(int vertex, vtx_data * graph, int n, float *dist)
     for (size_t i = 1; i < graph[vertex].nedges; i++)
 	dist[graph[vertex].edges[i]] = graph[vertex].ewgts[i];
 
-    initHeap_f(&H, vertex, index, dist, n);
+    initHeap_f(&H, vertex, index, dist, n, scratch->heap);
 
     while (extractMax_f(&H, &closestVertex, index, dist)) {
 	closestDist = dist[closestVertex];
@@ -281,18 +308,16 @@ void dijkstra_f(int vertex, vtx_data * graph, int n, float *dist)
 			  index, dist);
 	}
     }
-
-    freeHeap(&H);
-    free(index);
 }
 
 // single source shortest paths that also builds terms as it goes
 // mostly copied from dijkstra_f above
 // returns the number of terms built
-int dijkstra_sgd(graph_sgd *graph, int source, term_sgd *terms) {
+int dijkstra_sgd(graph_sgd *graph, int source, terms_sgd terms,
+                 dijkstra_scratch_t *scratch) {
     heap h;
-    int *indices = gv_calloc(graph->n, sizeof(int));
-    float *dists = gv_calloc(graph->n, sizeof(float));
+    int *indices = scratch->index;
+    float *dists = scratch->dist;
     for (size_t i= 0; i < graph->n; i++) {
         dists[i] = FLT_MAX;
     }
@@ -303,7 +328,7 @@ int dijkstra_sgd(graph_sgd *graph, int source, term_sgd *terms) {
         dists[target] = graph->weights[i];
     }
     assert(graph->n <= INT_MAX);
-    initHeap_f(&h, source, indices, dists, (int)graph->n);
+    initHeap_f(&h, source, indices, dists, (int)graph->n, scratch->heap);
 
     int closest = 0, offset = 0;
     while (extractMax_f(&h, &closest, indices, dists)) {
@@ -314,10 +339,10 @@ int dijkstra_sgd(graph_sgd *graph, int source, term_sgd *terms) {
         // if the target is fixed then always create a term as shortest paths are not calculated from there
         // if not fixed then only create a term if the target index is lower
         if (bitarray_get(graph->pinneds, closest) || closest<source) {
-            terms[offset].i = source;
-            terms[offset].j = closest;
-            terms[offset].d = d;
-            terms[offset].w = 1 / (d*d);
+            terms.i[offset] = source;
+            terms.j[offset] = closest;
+            terms.d[offset] = d;
+            terms.w[offset] = 1 / (d*d);
             offset++;
         }
         for (size_t i = graph->sources[closest]; i < graph->sources[closest + 1];
@@ -328,8 +353,5 @@ int dijkstra_sgd(graph_sgd *graph, int source, term_sgd *terms) {
             increaseKey_f(&h, (int)target, d+weight, indices, dists);
         }
     }
-    freeHeap(&h);
-    free(indices);
-    free(dists);
     return offset;
 }
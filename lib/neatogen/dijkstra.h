@@ -17,9 +17,22 @@ extern "C" {
 #include <neatogen/defs.h>
 #include <neatogen/sgd.h>
 
+    /// space for searches from many sources over a graph of n nodes, saving
+    /// its allocation for each
+    typedef struct {
+	int *heap;   ///< room for n - 1 heap entries
+	int *index;  ///< per node, its position in the heap
+	float *dist; ///< per node, its distance from the source
+    } dijkstra_scratch_t;
+
+    extern void dijkstra_scratch_init(dijkstra_scratch_t *, int n);
+    extern void dijkstra_scratch_free(dijkstra_scratch_t *);
+
     extern void dijkstra(int, vtx_data *, int, DistType *);
     extern void dijkstra_f(int, vtx_data *, int, float *);
-    extern int dijkstra_sgd(graph_sgd *, int, term_sgd *);
+    extern void dijkstra_f_scratch(int, vtx_data *, int, float *,
+                                   dijkstra_scratch_t *);
+    extern int dijkstra_sgd(graph_sgd *, int, terms_sgd, dijkstra_scratch_t *);
 
 #ifdef __cplusplus
 }
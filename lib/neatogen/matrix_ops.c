@@ -14,6 +14,7 @@
 #include <stdio.h>
 #include <math.h>
 #include <util/alloc.h>
+#include <util/random.h>
 
 static double p_iteration_threshold = 1e-3;
 
@@ -44,7 +45,7 @@ bool power_iteration(double **square_mat, int n, int neigs, double **eigs,
 	/* guess the i-th eigen vector */
       choose:
         for (j = 0; j < n; j++)
-            curr_vector[j] = rand() % 100;
+            curr_vector[j] = gv_rand() % 100;
 	/* orthogonalize against higher eigenvectors */
 	for (j = 0; j < i; j++) {
 	    alpha = -vectors_inner_product(n, eigs[j], curr_vector);
@@ -91,7 +92,7 @@ bool power_iteration(double **square_mat, int n, int neigs, double **eigs,
 	curr_vector = eigs[i];
 	/* guess the i-th eigen vector */
 	for (j = 0; j < n; j++)
-	    curr_vector[j] = rand() % 100;
+	    curr_vector[j] = gv_rand() % 100;
 	/* orthogonalize against higher eigenvectors */
 	for (j = 0; j < i; j++) {
 	    alpha = -vectors_inner_product(n, eigs[j], curr_vector);
@@ -257,7 +258,7 @@ void init_vec_orth1(int n, double *vec)
     int i;
 
     for (i = 0; i < n; i++)
-	vec[i] = rand() % RANGE;
+	vec[i] = gv_rand() % RANGE;
 
     orthog1(n, vec);
 }
@@ -22,6 +22,8 @@
 #define MODE_HIER        2
 #define MODE_IPSEP       3
 #define MODE_SGD         4
+#define MODE_SPARSE      5
+#define MODE_HOGWILD     6
 
 #define INIT_ERROR       -1
 #define INIT_SELF        0
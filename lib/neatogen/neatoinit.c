@@ -39,16 +39,15 @@
 #include <float.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <string.h>
 #include <util/alloc.h>
 #include <util/bitarray.h>
 #include <util/prisize_t.h>
+#include <util/random.h>
 #include <util/startswith.h>
 #include <util/strcasecmp.h>
 #include <util/streq.h>
-
-#ifndef HAVE_SRAND48
-#define srand48 srand
-#endif
+#include <util/thread.h>
 
 static attrsym_t *N_pos;
 static int Pack;		/* If >= 0, layout components separately and pack together
@@ -71,6 +70,23 @@ static void neato_init_edge(edge_t * e)
     ED_factor(e) = late_double(e, E_weight, 1.0, 1.0);
 }
 
+/* kept_pos:
+ * Take a 2D position kept as numbers by agreadgvb, rather than parsing it
+ * again, setting c as sscanf would.
+ */
+static bool kept_pos(node_t *np, attrsym_t *posptr, const char *p,
+                     double *pvec, char *c)
+{
+    const double *kept;
+
+    if (agxget_coords(np, posptr, &kept) != 2)
+	return false;
+    pvec[0] = kept[0];
+    pvec[1] = kept[1];
+    *c = p[strlen(p) - 1] == '!' ? '!' : '\0';
+    return true;
+}
+
 bool user_pos(attrsym_t *posptr, attrsym_t *pinptr, node_t *np, int nG) {
     double *pvec;
     char *p, c;
@@ -95,7 +111,8 @@ bool user_pos(attrsym_t *posptr, attrsym_t *pinptr, node_t *np, int nG) {
 		ND_pinned(np) = P_PIN;
 	    return true;
 	}
-	else if (sscanf(p, "%lf,%lf%c", pvec, pvec + 1, &c) >= 2) {
+	else if (kept_pos(np, posptr, p, pvec, &c) ||
+		 sscanf(p, "%lf,%lf%c", pvec, pvec + 1, &c) >= 2) {
 	    ND_pinned(np) = P_SET;
 	    if (PSinputscale > 0.0) {
 		int i;
@@ -103,7 +120,7 @@ bool user_pos(attrsym_t *posptr, attrsym_t *pinptr, node_t *np, int nG) {
 		    pvec[i] /= PSinputscale;
 	    }
 	    if (Ndim > 2) {
-		if (N_z && (p = agxget(np, N_z)) && sscanf(p,"%lf",&z) == 1) {
+		if (N_z && agxget_double(np, N_z, &z)) {
 		    if (PSinputscale > 0.0) {
 			pvec[2] = z / PSinputscale;
 		    }
@@ -436,22 +453,24 @@ static int chkBB(Agraph_t * g, attrsym_t * G_bb, boxf* bbp)
 {
     char *s;
     boxf bb;
+    const double *kept;
 
     s = agxget(g, G_bb);
-    if (sscanf(s, BS, &bb.LL.x, &bb.LL.y, &bb.UR.x, &bb.UR.y) == 4) {
-	if (bb.LL.y > bb.UR.y) {
+    if (agxget_coords(g, G_bb, &kept) == 4)
+	bb = (boxf){{kept[0], kept[1]}, {kept[2], kept[3]}};
+    else if (sscanf(s, BS, &bb.LL.x, &bb.LL.y, &bb.UR.x, &bb.UR.y) != 4)
+	return 0;
+    if (bb.LL.y > bb.UR.y) {
 	/* If the LL.y coordinate is bigger than the UR.y coordinate,
          * we assume the input was produced using -y, so we normalize
 	 * the bb.
 	 */
-	    double tmp = bb.LL.y;
-	    bb.LL.y = bb.UR.y;
-	    bb.UR.y = tmp;
-	}
-	*bbp = bb;
-	return 1;
-    } else
-	return 0;
+	double tmp = bb.LL.y;
+	bb.LL.y = bb.UR.y;
+	bb.UR.y = tmp;
+    }
+    *bbp = bb;
+    return 1;
 }
 
 static void add_cluster(Agraph_t * g, Agraph_t * subg)
@@ -670,6 +689,12 @@ static int neatoMode(graph_t * g)
 	    mode = MODE_MAJOR;
 	else if (streq(str, "sgd"))
 		mode = MODE_SGD;
+	else if (streq(str, "hogwild"))
+	    mode = MODE_HOGWILD;
+#ifdef SFDP
+	else if (streq(str, "sparse"))
+	    mode = MODE_SPARSE;
+#endif
 #ifdef DIGCOLA
 	else if (streq(str, "hier"))
 	    mode = MODE_HIER;
@@ -1009,6 +1034,23 @@ static int checkExp (graph_t * G)
     return exp;
 }
 
+/* startSeed:
+ * As for checkStart, but return the seed in seedp rather than
+ * setting the RNG seed.
+ */
+static int startSeed(graph_t * G, int nG, int dflt, long* seedp)
+{
+    int init;
+
+    *seedp = 1;
+    init = setSeed (G, dflt, seedp);
+    if (N_pos && init != INIT_RANDOM) {
+	agwarningf("node positions are ignored unless start=random\n");
+    }
+    if (init == INIT_REGULAR) initRegular(G, nG);
+    return init;
+}
+
 /* checkStart:
  * Analyzes start attribute, setting seed.
  * If set,
@@ -1022,15 +1064,8 @@ static int checkExp (graph_t * G)
 int checkStart(graph_t * G, int nG, int dflt)
 {
     long seed;
-    int init;
-
-    seed = 1;
-    init = setSeed (G, dflt, &seed);
-    if (N_pos && init != INIT_RANDOM) {
-	agwarningf("node positions are ignored unless start=random\n");
-    }
-    if (init == INIT_REGULAR) initRegular(G, nG);
-    srand48(seed);
+    int init = startSeed(G, nG, dflt, &seed);
+    gv_srand48(seed);
     return init;
 }
 
@@ -1113,61 +1148,113 @@ void dumpOpts (ipsep_options* opp, int nv)
 }
 #endif
 
-/* majorization:
- * Solve stress using majorization.
- * Old neato attributes to incorporate:
- *  weight
- * mode will be MODE_MAJOR, MODE_HIER or MODE_IPSEP
- */
-static void
-majorization(graph_t *mg, graph_t * g, int nv, int mode, int model, int dim, adjust_data* am)
-{
+/// state for a stress majorization layout of one graph or component
+///
+/// The layout is split into three phases so that, for `mode=major`, the middle
+/// one, which does not touch the graph, can run concurrently with that of other
+/// components.
+typedef struct {
+    graph_t *mg;
+    graph_t *g;
+    adjust_data *am;
+    int nv;
+    int mode;
+    int model;
+    int opts;
+    int maxiter;
+    long seed; ///< random number generator seed
+    bool private_rand; ///< use a generator unaffected by other components?
+    size_t threads; ///< threads for the shortest paths of the component
     int ne;
-    int rv = 0;
-    node_t *v;
     vtx_data *gp;
-    node_t** nodes;
-#ifdef DIGCOLA
-#ifdef IPSEPCOLA
-    expand_t margin;
-#endif
-#endif
-    int init = checkStart(g, nv, mode == MODE_HIER ? INIT_SELF : INIT_RANDOM);
-    int opts = checkExp (g);
+    node_t **nodes;
+    double **coords;
+    int rv; ///< result of the solver
+} major_job_t;
+
+/* major_prepare:
+ * Collect the input for the solver from the graph.
+ * mode will be MODE_MAJOR, MODE_SPARSE, MODE_HIER or MODE_IPSEP
+ */
+static void major_prepare(major_job_t *job, graph_t *mg, graph_t *g, int nv,
+                          int mode, int model, adjust_data *am,
+                          bool private_rand, size_t threads)
+{
+    if (mode == MODE_SPARSE && model != MODEL_SHORTPATH) {
+	agwarningf("only the shortest path model is supported in mode=sparse - "
+	           "reverting to it\n");
+	model = MODEL_SHORTPATH;
+    }
+    *job = (major_job_t){.mg = mg, .g = g, .am = am, .nv = nv, .mode = mode,
+                         .model = model, .maxiter = MaxIter,
+                         .private_rand = private_rand, .threads = threads};
+
+    // the sparse model has too few terms to untangle a random start
+    const bool smart = mode == MODE_HIER || mode == MODE_SPARSE;
+    int init = startSeed(g, nv, smart ? INIT_SELF : INIT_RANDOM, &job->seed);
+    job->opts = checkExp (g);
 
     if (init == INIT_SELF)
-	opts |= opt_smart_init;
+	job->opts |= opt_smart_init;
 
-    double **coords = gv_calloc(dim, sizeof(double *));
-    coords[0] = gv_calloc(nv * dim, sizeof(double));
+    job->coords = gv_calloc(Ndim, sizeof(double *));
+    job->coords[0] = gv_calloc(nv * Ndim, sizeof(double));
     for (int i = 1; i < Ndim; i++) {
-	coords[i] = coords[0] + i * nv;
+	job->coords[i] = job->coords[0] + i * nv;
     }
     if (Verbose) {
 	fprintf(stderr, "model %d smart_init %d stresswt %d iterations %d tol %f\n",
-		model, init == INIT_SELF, opts & opt_exp_flag, MaxIter, Epsilon);
+		model, init == INIT_SELF, job->opts & opt_exp_flag, MaxIter, Epsilon);
 	fprintf(stderr, "convert graph: ");
 	start_timer();
         fprintf(stderr, "majorization\n");
     }
-    gp = makeGraphData(g, nv, &ne, mode, model, &nodes);
+    job->gp = makeGraphData(g, nv, &job->ne, mode, model, &job->nodes);
 
     if (Verbose) {
 	fprintf(stderr, "%d nodes %.2f sec\n", nv, elapsed_sec());
     }
+}
+
+/* major_solve:
+ * Solve stress using majorization.
+ * For MODE_MAJOR and MODE_SPARSE, this does not access the graph.
+ */
+static void major_solve(major_job_t *job)
+{
+    const int nv = job->nv;
+    const int model = job->model;
+    const int opts = job->opts;
+    double **coords = job->coords;
+    node_t **nodes = job->nodes;
+    vtx_data *gp = job->gp;
+    int rv = 0;
 
+    if (job->private_rand)
+	gv_rand_private(true);
+    gv_srand48(job->seed);
+
+#ifdef SFDP
+    if (job->mode == MODE_SPARSE)
+	rv = stress_majorization_sparse(gp, nv, coords, nodes, Ndim, opts,
+	                                job->maxiter);
+    else
+#endif
 #ifdef DIGCOLA
-    if (mode != MODE_MAJOR) {
+    if (job->mode != MODE_MAJOR) {
+        graph_t *g = job->g;
         double lgap = late_double(g, agfindgraphattr(g, "levelsgap"), 0.0, -DBL_MAX);
-        if (mode == MODE_HIER) {
+        if (job->mode == MODE_HIER) {
             rv = stress_majorization_with_hierarchy(gp, nv, coords, nodes, Ndim,
-                       opts, model, MaxIter, lgap);
+                       opts, model, job->maxiter, lgap);
         }
 #ifdef IPSEPCOLA
 	else {
             char* str;
             ipsep_options opt;
-	    cluster_data cs = cluster_map(mg,g);
+            node_t *v;
+            expand_t margin;
+	    cluster_data cs = cluster_map(job->mg,g);
             pointf *nsize = gv_calloc(nv, sizeof(pointf));
             opt.edge_gap = lgap;
             opt.nsize = nsize;
@@ -1183,11 +1270,11 @@ majorization(graph_t *mg, graph_t * g, int nv, int mode, int model, int dim, adj
                     fprintf(stderr,"Generating DiG-CoLa Edge Constraints...\n");
             }
 	    else opt.diredges = 0;
-	    if (am->mode == AM_IPSEP) {
+	    if (job->am->mode == AM_IPSEP) {
                 opt.noverlap = 1;
                 if(Verbose)
                     fprintf(stderr,"Generating Non-overlap Constraints...\n");
-            } else if (am->mode == AM_VPSC) {
+            } else if (job->am->mode == AM_VPSC) {
                 opt.noverlap = 2;
                 if(Verbose)
                     fprintf(stderr,"Removing overlaps as postprocess...\n");
@@ -1211,17 +1298,17 @@ majorization(graph_t *mg, graph_t * g, int nv, int mode, int model, int dim, adj
             }
 
 #ifdef DEBUG_COLA
-	    fprintf (stderr, "nv %d ne %d Ndim %d model %d MaxIter %d\n", nv, ne, Ndim, model, MaxIter);
+	    fprintf (stderr, "nv %d ne %d Ndim %d model %d MaxIter %d\n", nv, job->ne, Ndim, model, job->maxiter);
 	    fprintf (stderr, "Nodes:\n");
 	    for (int i = 0; i < nv; i++) {
 		fprintf (stderr, "  %s (%f,%f)\n", nodes[i]->name, coords[0][i],  coords[1][i]);
 	    }
 	    fprintf (stderr, "\n");
-	    dumpData(g, gp, nv, ne);
+	    dumpData(g, gp, nv, job->ne);
 	    fprintf (stderr, "\n");
 	    dumpOpts (&opt, nv);
 #endif
-            rv = stress_majorization_cola(gp, nv, coords, nodes, Ndim, model, MaxIter, &opt);
+            rv = stress_majorization_cola(gp, nv, coords, nodes, Ndim, model, job->maxiter, &opt);
 	    freeClusterData(cs);
 	    free (nsize);
         }
@@ -1229,21 +1316,50 @@ majorization(graph_t *mg, graph_t * g, int nv, int mode, int model, int dim, adj
     }
     else
 #endif
-	rv = stress_majorization_kD_mkernel(gp, nv, coords, nodes, Ndim, opts, model, MaxIter);
+	rv = stress_majorization_kD_mkernel(gp, nv, coords, nodes, Ndim, opts, model, job->maxiter,
+	                                    job->threads);
+
+    if (job->private_rand)
+	gv_rand_private(false);
+    job->rv = rv;
+}
+
+/* major_commit:
+ * Store the computed positions back in the graph.
+ */
+static void major_commit(major_job_t *job)
+{
+    node_t *v;
 
-    if (rv < 0) {
+    if (job->rv < 0) {
 	agerr(AGPREV, "layout aborted\n");
     }
-    else for (v = agfstnode(g); v; v = agnxtnode(g, v)) { /* store positions back in nodes */
+    else for (v = agfstnode(job->g); v; v = agnxtnode(job->g, v)) { /* store positions back in nodes */
 	int idx = ND_id(v);
 	for (int i = 0; i < Ndim; i++) {
-	    ND_pos(v)[i] = coords[i][idx];
+	    ND_pos(v)[i] = job->coords[i][idx];
 	}
     }
-    freeGraphData(gp);
-    free(coords[0]);
-    free(coords);
-    free(nodes);
+    freeGraphData(job->gp);
+    free(job->coords[0]);
+    free(job->coords);
+    free(job->nodes);
+}
+
+/* majorization:
+ * Solve stress using majorization.
+ * Old neato attributes to incorporate:
+ *  weight
+ * mode will be MODE_MAJOR, MODE_SPARSE, MODE_HIER or MODE_IPSEP
+ */
+static void
+majorization(graph_t *mg, graph_t * g, int nv, int mode, int model, adjust_data* am,
+             bool private_rand, size_t threads)
+{
+    major_job_t job;
+    major_prepare(&job, mg, g, nv, mode, model, am, private_rand, threads);
+    major_solve(&job);
+    major_commit(&job);
 }
 
 static void subset_model(Agraph_t * G, int nG)
@@ -1318,34 +1434,99 @@ static void kkNeato(Agraph_t * g, int nG, int model)
     solve_model(g, nG);
 }
 
-/* neatoLayout:
- * Use stress optimization to layout a single component
+/* neatoScan:
+ * Set MaxIter and scan the graph in preparation for layout.
+ * Return the number of nodes to lay out, or 0 if there is nothing to do.
  */
-static void
-neatoLayout(Agraph_t * mg, Agraph_t * g, int layoutMode, int layoutModel,
-  adjust_data* am)
+static int neatoScan(Agraph_t * g, int layoutMode)
 {
     int nG;
     char *str;
 
     if ((str = agget(g, "maxiter")))
 	MaxIter = atoi(str);
-    else if (layoutMode == MODE_MAJOR)
+    else if (layoutMode == MODE_MAJOR || layoutMode == MODE_SPARSE)
 	MaxIter = DFLT_ITERATIONS;
-    else if (layoutMode == MODE_SGD)
+    else if (layoutMode == MODE_SGD || layoutMode == MODE_HOGWILD)
 	MaxIter = 30;
     else
 	MaxIter = 100 * agnnodes(g);
 
     nG = scan_graph_mode(g, layoutMode);
     if (nG < 2 || MaxIter < 0)
+	return 0;
+    return nG;
+}
+
+/* neatoLayout:
+ * Use stress optimization to layout a single component.
+ * For stress majorization and SGD, shortest paths are computed using up
+ * to threads threads. Hogwild SGD also updates positions using them, and
+ * uses one per processor if threads is 0.
+ */
+static void
+neatoLayout(Agraph_t * mg, Agraph_t * g, int layoutMode, int layoutModel,
+  adjust_data* am, bool private_rand, size_t threads)
+{
+    int nG = neatoScan(g, layoutMode);
+    if (nG == 0)
 	return;
     if (layoutMode == MODE_KK)
 	kkNeato(g, nG, layoutModel);
     else if (layoutMode == MODE_SGD)
-	sgd(g, layoutModel);
+	sgd(g, layoutModel, threads, false);
+    else if (layoutMode == MODE_HOGWILD)
+	sgd(g, layoutModel, threads > 0 ? threads : gv_hardware_threads(), true);
     else
-	majorization(mg, g, nG, layoutMode, layoutModel, Ndim, am);
+	majorization(mg, g, nG, layoutMode, layoutModel, am, private_rand,
+	             threads);
+}
+
+/* canLayoutConcurrently:
+ * Can components be laid out concurrently with the given mode and model?
+ * Only stress majorization separates reading the graph from solving, and
+ * the circuit and MDS models can emit diagnostics from within the solver.
+ */
+static bool canLayoutConcurrently(int layoutMode, int layoutModel)
+{
+    return (layoutMode == MODE_MAJOR || layoutMode == MODE_SPARSE)
+        && (layoutModel == MODEL_SHORTPATH || layoutModel == MODEL_SUBSET);
+}
+
+static void solve_component(void *jobs, size_t index, size_t worker)
+{
+    (void)worker;
+    major_job_t *job = (major_job_t *)jobs + index;
+    if (job->g != NULL)
+	major_solve(job);
+}
+
+/* neatoLayoutComponents:
+ * Lay out the components of a graph using up to threads threads.
+ * Each component uses its own random number generator, so the result does
+ * not depend on the number of threads or how components are scheduled.
+ */
+static void
+neatoLayoutComponents(Agraph_t * mg, size_t n_cc, Agraph_t ** cc,
+  int layoutMode, int layoutModel, adjust_data* am, size_t threads)
+{
+    major_job_t *jobs = gv_calloc(n_cc, sizeof(jobs[0]));
+
+    for (size_t i = 0; i < n_cc; i++) {
+	(void)graphviz_node_induce(cc[i], NULL);
+	int nG = neatoScan(cc[i], layoutMode);
+	if (nG > 0)
+	    major_prepare(&jobs[i], mg, cc[i], nG, layoutMode, layoutModel, am,
+	                  true, 1);
+    }
+
+    gv_parallel_for(n_cc, threads, solve_component, jobs);
+
+    for (size_t i = 0; i < n_cc; i++) {
+	if (jobs[i].g != NULL)
+	    major_commit(&jobs[i]);
+    }
+    free(jobs);
 }
 
 /* addZ;
@@ -1419,6 +1600,9 @@ void neato_layout(Agraph_t * g)
 	layoutMode = neatoMode(g);
 	graphAdjustMode (g, &am, 0);
 	model = neatoModel(g);
+	const size_t threads = late_threads(g);
+	const bool parallel = threads > 0
+	                   && canLayoutConcurrently(layoutMode, model);
 	mode = getPackModeInfo (g, l_undef, &pinfo);
 	Pack = getPack(g, -1, CL_OFFSET);
 	/* pack if just packmode defined. */
@@ -1441,10 +1625,17 @@ void neato_layout(Agraph_t * g)
 
 	    if (n_cc > 1) {
 		bool *bp;
+		// with diagnostics on, run sequentially to keep their output in
+		// order
+		if (parallel)
+		    neatoLayoutComponents(g, n_cc, cc, layoutMode, model, &am,
+		                          Verbose ? 1 : threads);
 		for (size_t i = 0; i < n_cc; i++) {
 		    gc = cc[i];
-		    (void)graphviz_node_induce(gc, NULL);
-		    neatoLayout(g, gc, layoutMode, model, &am);
+		    if (!parallel) {
+			(void)graphviz_node_induce(gc, NULL);
+			neatoLayout(g, gc, layoutMode, model, &am, false, threads);
+		    }
 		    removeOverlapWith(gc, &am);
 		    setEdgeType (gc, EDGETYPE_LINE);
 		    if (noTranslate) doEdges(gc);
@@ -1462,7 +1653,7 @@ void neato_layout(Agraph_t * g)
 		free(bp);
 	    }
 	    else {
-		neatoLayout(g, g, layoutMode, model, &am);
+		neatoLayout(g, g, layoutMode, model, &am, parallel, threads);
 		removeOverlapWith(g, &am);
 		if (noTranslate) doEdges(g);
 		else spline_edges(g);
@@ -1482,7 +1673,7 @@ void neato_layout(Agraph_t * g)
 	    addCluster (g);
 #endif
 	} else {
-	    neatoLayout(g, g, layoutMode, model, &am);
+	    neatoLayout(g, g, layoutMode, model, &am, parallel, threads);
 	    removeOverlapWith(g, &am);
 	    addZ (g);
 	    if (noTranslate) doEdges(g);
@@ -581,6 +581,7 @@ void remove_overlap(int dim, SparseMatrix A, double *x, double *label_sizes, int
 #else
 #include <common/types.h>
 #include <sparse/SparseMatrix.h>
+#include <util/thread.h>
 void remove_overlap(int dim, SparseMatrix A, double *x, double *label_sizes, int ntry, double initial_scaling,
 		    int edge_labeling_scheme, int n_constr_nodes, int *constr_nodes, SparseMatrix A_constr, bool do_shrinking)
 {
@@ -598,9 +599,12 @@ void remove_overlap(int dim, SparseMatrix A, double *x, double *label_sizes, int
     (void)A_constr;
     (void)do_shrinking;
 
+    // components may be laid out concurrently
+    gv_global_lock();
     if (once == 0) {
 	once = 1;
 	agerrorf("remove_overlap: Graphviz not built with triangulation library\n");
     }
+    gv_global_unlock();
 }
 #endif
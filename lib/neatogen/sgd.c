@@ -7,29 +7,123 @@
 #include <neatogen/neatoprocs.h>
 #include <math.h>
 #include <stdlib.h>
+#include <string.h>
 #include <util/alloc.h>
+#include <util/thread.h>
 #include <util/bitarray.h>
 
-static float calculate_stress(float *pos, term_sgd *terms, int n_terms) {
+static float calculate_stress(const float *pos, const terms_sgd *terms,
+                              int n_terms) {
     float stress = 0;
     int ij;
     for (ij=0; ij<n_terms; ij++) {
-        float dx = pos[2*terms[ij].i] - pos[2*terms[ij].j];
-        float dy = pos[2*terms[ij].i+1] - pos[2*terms[ij].j+1];
-        float r = hypotf(dx, dy) - terms[ij].d;
-        stress += terms[ij].w * (r * r);
+        float dx = pos[2*terms->i[ij]] - pos[2*terms->j[ij]];
+        float dy = pos[2*terms->i[ij]+1] - pos[2*terms->j[ij]+1];
+        float r = hypotf(dx, dy) - terms->d[ij];
+        stress += terms->w[ij] * (r * r);
     }
     return stress;
 }
-// it is much faster to shuffle term rather than pointers to term, even though the swap is more expensive
-static void fisheryates_shuffle(term_sgd *terms, int n_terms, rk_state *rstate) {
-    int i;
-    for (i=n_terms-1; i>=1; i--) {
-        int j = rk_interval(i, rstate);
-
-        term_sgd temp = terms[i];
-        terms[i] = terms[j];
-        terms[j] = temp;
+
+// the terms from offset on
+static terms_sgd terms_at(terms_sgd terms, size_t offset) {
+    return (terms_sgd){.i = terms.i + offset, .j = terms.j + offset,
+                       .d = terms.d + offset, .w = terms.w + offset};
+}
+
+static terms_sgd terms_new(size_t n_terms) {
+    return (terms_sgd){.i = gv_calloc(n_terms, sizeof(int)),
+                       .j = gv_calloc(n_terms, sizeof(int)),
+                       .d = gv_calloc(n_terms, sizeof(float)),
+                       .w = gv_calloc(n_terms, sizeof(float))};
+}
+
+static void terms_free(terms_sgd *terms) {
+    free(terms->i);
+    free(terms->j);
+    free(terms->d);
+    free(terms->w);
+}
+
+// move the n terms at from to to, which may overlap
+static void terms_move(terms_sgd *terms, size_t to, size_t from, size_t n) {
+    memmove(terms->i + to, terms->i + from, sizeof(int) * n);
+    memmove(terms->j + to, terms->j + from, sizeof(int) * n);
+    memmove(terms->d + to, terms->d + from, sizeof(float) * n);
+    memmove(terms->w + to, terms->w + from, sizeof(float) * n);
+}
+
+#ifdef __GNUC__
+#define PREFETCH(p) __builtin_prefetch(p, 1)
+#else
+#define PREFETCH(p) /* nothing */
+#endif
+
+/// swaps of a shuffle whose positions are drawn before they are made
+enum { SHUFFLE_AHEAD = 16 };
+
+// it is much faster to shuffle the terms themselves rather than an index into
+// them, even though the swap is more expensive, as the updates then read them
+// in order
+// Each swap touches a random position in every array. The positions do not
+// depend on the terms, so they are drawn a few swaps ahead, letting the terms
+// there be fetched in the meantime.
+static void fisheryates_shuffle(terms_sgd *terms, int n_terms, rk_state *rstate) {
+    int ahead[SHUFFLE_AHEAD];
+    for (int i = n_terms - 1; i >= 1; i -= SHUFFLE_AHEAD) {
+        const int batch = MIN(i, SHUFFLE_AHEAD);
+        for (int k = 0; k < batch; k++) {
+            const int j = ahead[k] = (int)rk_interval((unsigned long)(i - k), rstate);
+            PREFETCH(&terms->i[j]);
+            PREFETCH(&terms->j[j]);
+            PREFETCH(&terms->d[j]);
+            PREFETCH(&terms->w[j]);
+        }
+        for (int k = 0; k < batch; k++) {
+            const int a = i - k;
+            const int b = ahead[k];
+
+            int node = terms->i[a];
+            terms->i[a] = terms->i[b];
+            terms->i[b] = node;
+            node = terms->j[a];
+            terms->j[a] = terms->j[b];
+            terms->j[b] = node;
+            float x = terms->d[a];
+            terms->d[a] = terms->d[b];
+            terms->d[b] = x;
+            x = terms->w[a];
+            terms->w[a] = terms->w[b];
+            terms->w[b] = x;
+        }
+    }
+}
+
+// move the nodes of term ij towards their ideal distance from each other
+static void apply_term(float *pos, const bool *unfixed, const terms_sgd *terms,
+                       int ij, float eta) {
+    // cap step size
+    float mu = eta * terms->w[ij];
+    if (mu > 1)
+        mu = 1;
+
+    const int i = terms->i[ij];
+    const int j = terms->j[ij];
+    float dx = pos[2*i] - pos[2*j];
+    float dy = pos[2*i+1] - pos[2*j+1];
+    float mag = hypotf(dx, dy);
+
+    float r = (mu * (mag-terms->d[ij])) / (2*mag);
+    float r_x = r * dx;
+    float r_y = r * dy;
+
+    if (unfixed[i]) {
+        pos[2*i] -= r_x;
+        pos[2*i+1] -= r_y;
+    }
+    if (unfixed[j]) {
+        pos[2*j] += r_x;
+        pos[2*j+1] += r_y;
     }
 }
 
@@ -139,9 +233,163 @@ static void free_adjacency(graph_sgd *graph) {
     free(graph);
 }
 
+/// computation of the stress terms, one shortest path search per source
+typedef struct {
+    graph_sgd *graph;
+    terms_sgd terms;
+    size_t *starts; // per source, the start of the space for its terms
+    int *counts; // per source, the number of terms it built
+    dijkstra_scratch_t *scratch; // per worker search space
+} terms_job_t;
+
+static void terms_source(void *arg, size_t index, size_t worker) {
+    terms_job_t *job = arg;
+    if (bitarray_get(job->graph->pinneds, index)) {
+        return;
+    }
+    job->counts[index] = dijkstra_sgd(job->graph, (int)index,
+                                      terms_at(job->terms, job->starts[index]),
+                                      &job->scratch[worker]);
+}
+
+// build the terms from every source that is not fixed, using up to threads
+// threads, and return how many were built
+// A source i builds at most a term for each node before it and each pinned
+// node after it, so each is given that much space. The terms are then closed
+// up in order of source, giving the same result as searching from each source
+// in turn.
+static int build_terms(graph_sgd *graph, terms_sgd *terms, size_t threads) {
+    const size_t n = graph->n;
+    const size_t workers = MAX(MIN(threads, n), 1);
+    terms_job_t job = {.graph = graph, .terms = *terms};
+    job.starts = gv_calloc(n, sizeof(size_t));
+    job.counts = gv_calloc(n, sizeof(int));
+    job.scratch = gv_calloc(workers, sizeof(dijkstra_scratch_t));
+    for (size_t w = 0; w < workers; w++) {
+        dijkstra_scratch_init(&job.scratch[w], (int)n);
+    }
+
+    size_t pinned_after = 0;
+    for (size_t i = n; i-- > 0; ) {
+        job.starts[i] = i + pinned_after; // space needed, for now
+        if (bitarray_get(graph->pinneds, i)) {
+            pinned_after++;
+        }
+    }
+    size_t start = 0;
+    for (size_t i = 0; i < n; i++) {
+        const size_t space = bitarray_get(graph->pinneds, i) ? 0 : job.starts[i];
+        job.starts[i] = start;
+        start += space;
+    }
+
+    gv_parallel_for(n, workers, terms_source, &job);
+
+    // close up any space left by sources that could not reach every node
+    size_t offset = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (offset != job.starts[i]) {
+            terms_move(terms, offset, job.starts[i], (size_t)job.counts[i]);
+        }
+        offset += (size_t)job.counts[i];
+    }
+
+    for (size_t w = 0; w < workers; w++) {
+        dijkstra_scratch_free(&job.scratch[w]);
+    }
+    free(job.scratch);
+    free(job.counts);
+    free(job.starts);
+    assert(offset <= INT_MAX);
+    return (int)offset;
+}
+
+/// terms in the sample used to check Hogwild SGD for convergence
+enum { HOGWILD_SAMPLE = 1 << 16 };
+
+/// relative change in the sampled stress at which Hogwild SGD stops
+#define HOGWILD_TOLERANCE 1e-4
+
+/// one iteration of Hogwild SGD
+typedef struct {
+    terms_sgd terms;
+    int n_terms;
+    size_t batches;
+    rk_state *rstates; // per batch random number generator
+    float *pos;
+    const bool *unfixed;
+    float eta;
+} hogwild_job_t;
+
+// shuffle and apply one batch of terms, updating positions shared with the
+// other batches without synchronization
+static void hogwild_batch(void *arg, size_t index, size_t worker) {
+    (void)worker;
+    hogwild_job_t *job = arg;
+    const size_t start = index * (size_t)job->n_terms / job->batches;
+    const size_t end = (index + 1) * (size_t)job->n_terms / job->batches;
+    terms_sgd batch = terms_at(job->terms, start);
+    fisheryates_shuffle(&batch, (int)(end - start), &job->rstates[index]);
+    for (int ij = 0; ij < (int)(end - start); ij++) {
+        apply_term(job->pos, job->unfixed, &batch, ij, job->eta);
+    }
+}
+
+// SGD with the terms split into one batch per thread, after Hogwild! (Niu et
+// al.). Threads update the positions of any nodes their terms touch, without
+// locks, so the result depends on how they interleave. As the terms are
+// shuffled within their batch only, they are first shuffled across batches.
+// Rather than always running MaxIter iterations, this stops when the stress of
+// a fixed sample of terms stops improving.
+static void hogwild_solve(terms_sgd *terms, int n_terms, float *pos,
+                          const bool *unfixed, float eta_max, float lambda,
+                          size_t threads) {
+    const size_t batches = MAX(MIN(threads, (size_t)n_terms), 1);
+    hogwild_job_t job = {.terms = *terms, .n_terms = n_terms,
+                         .batches = batches, .pos = pos, .unfixed = unfixed};
+    job.rstates = gv_calloc(batches, sizeof(rk_state));
+    rk_seed(0, &job.rstates[0]);
+    fisheryates_shuffle(terms, n_terms, &job.rstates[0]);
+    for (size_t b = 0; b < batches; b++) {
+        rk_seed((unsigned long)b + 1, &job.rstates[b]);
+    }
+
+    // the sample is a copy, so it is unaffected by shuffling
+    const int stride = MAX(n_terms / HOGWILD_SAMPLE, 1);
+    const int n_sample = (n_terms + stride - 1) / stride;
+    terms_sgd sample = terms_new((size_t)n_sample);
+    for (int s = 0; s < n_sample; s++) {
+        sample.i[s] = terms->i[s * stride];
+        sample.j[s] = terms->j[s * stride];
+        sample.d[s] = terms->d[s * stride];
+        sample.w[s] = terms->w[s * stride];
+    }
+
+    float prev = calculate_stress(pos, &sample, n_sample);
+    for (int t = 0; t < MaxIter; t++) {
+        job.eta = eta_max * exp(-lambda * t);
+        gv_parallel_for(batches, batches, hogwild_batch, &job);
+        const float stress = calculate_stress(pos, &sample, n_sample);
+        if (Verbose) {
+            fprintf(stderr, " %.3f", stress);
+        }
+        if (fabsf(prev - stress) <= HOGWILD_TOLERANCE * prev) {
+            if (Verbose) {
+                fprintf(stderr, "\nconverged after %d iterations", t + 1);
+            }
+            break;
+        }
+        prev = stress;
+    }
+
+    terms_free(&sample);
+    free(job.rstates);
+}
 
 void sgd(graph_t *G, /* input graph */
-        int model /* distance model */)
+        int model, /* distance model */
+        size_t threads, /* threads for shortest paths and Hogwild updates */
+        bool hogwild /* update positions from threads concurrently? */)
 {
     if (model == MODEL_CIRCUIT) {
         agwarningf("circuit model not yet supported in Gmode=sgd, reverting to shortpath model\n");
@@ -165,27 +413,23 @@ void sgd(graph_t *G, /* input graph */
             n_terms += n-n_fixed;
         }
     }
-    term_sgd *terms = gv_calloc(n_terms, sizeof(term_sgd));
+    terms_sgd terms = terms_new((size_t)n_terms);
     // calculate term values through shortest paths
-    int offset = 0;
     graph_sgd *graph = extract_adjacency(G, model);
-    for (i=0; i<n; i++) {
-        if (!isFixed(GD_neato_nlist(G)[i])) {
-            offset += dijkstra_sgd(graph, i, terms+offset);
-        }
-    }
-    assert(offset == n_terms);
+    const int built = build_terms(graph, &terms, threads);
+    assert(built == n_terms);
+    (void)built;
     free_adjacency(graph);
     if (Verbose) {
         fprintf(stderr, " %.2f sec\n", elapsed_sec());
     }
 
     // initialise annealing schedule
-    float w_min = terms[0].w, w_max = terms[0].w;
+    float w_min = terms.w[0], w_max = terms.w[0];
     int ij;
     for (ij=1; ij<n_terms; ij++) {
-        w_min = fminf(w_min, terms[ij].w);
-        w_max = fmaxf(w_max, terms[ij].w);
+        w_min = fminf(w_min, terms.w[ij]);
+        w_max = fmaxf(w_max, terms.w[ij]);
     }
     // note: Epsilon is different from MODE_KK and MODE_MAJOR as it is a minimum step size rather than energy threshold
     //       MaxIter is also different as it is a fixed number of iterations rather than a maximum
@@ -210,43 +454,27 @@ void sgd(graph_t *G, /* input graph */
         fprintf(stderr, "solving model:");
         start_timer();
     }
-    int t;
-    rk_state rstate;
-    rk_seed(0, &rstate); // TODO: get seed from graph
-    for (t=0; t<MaxIter; t++) {
-        fisheryates_shuffle(terms, n_terms, &rstate);
-        float eta = eta_max * exp(-lambda * t);
-        for (ij=0; ij<n_terms; ij++) {
-            // cap step size
-            float mu = eta * terms[ij].w;
-            if (mu > 1)
-                mu = 1;
-
-            float dx = pos[2*terms[ij].i] - pos[2*terms[ij].j];
-            float dy = pos[2*terms[ij].i+1] - pos[2*terms[ij].j+1];
-            float mag = hypotf(dx, dy);
-
-            float r = (mu * (mag-terms[ij].d)) / (2*mag);
-            float r_x = r * dx;
-            float r_y = r * dy;
-
-            if (unfixed[terms[ij].i]) {
-                pos[2*terms[ij].i] -= r_x;
-                pos[2*terms[ij].i+1] -= r_y;
+    if (hogwild) {
+        hogwild_solve(&terms, n_terms, pos, unfixed, eta_max, lambda, threads);
+    } else {
+        int t;
+        rk_state rstate;
+        rk_seed(0, &rstate); // TODO: get seed from graph
+        for (t=0; t<MaxIter; t++) {
+            fisheryates_shuffle(&terms, n_terms, &rstate);
+            float eta = eta_max * exp(-lambda * t);
+            for (ij=0; ij<n_terms; ij++) {
+                apply_term(pos, unfixed, &terms, ij, eta);
             }
-            if (unfixed[terms[ij].j]) {
-                pos[2*terms[ij].j] += r_x;
-                pos[2*terms[ij].j+1] += r_y;
+            if (Verbose) {
+                fprintf(stderr, " %.3f", calculate_stress(pos, &terms, n_terms));
             }
         }
-        if (Verbose) {
-            fprintf(stderr, " %.3f", calculate_stress(pos, terms, n_terms));
-        }
     }
     if (Verbose) {
         fprintf(stderr, "\nfinished in %.2f sec\n", elapsed_sec());
     }
-    free(terms);
+    terms_free(&terms);
 
     // copy temporary positions back into graph_t
     for (i=0; i<n; i++) {
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <util/bitarray.h>
 
@@ -7,10 +8,12 @@
 extern "C" {
 #endif
 
-typedef struct term_sgd {
-    int i, j;
-    float d, w;
-} term_sgd;
+// stress terms, with each field in an array of its own
+typedef struct terms_sgd {
+    int *i, *j; // the pair of nodes of each term
+    float *d; // ideal distance between them
+    float *w; // weight of each term
+} terms_sgd;
 
 typedef struct graph_sgd {
     size_t n; // number of nodes
@@ -21,7 +24,7 @@ typedef struct graph_sgd {
     float *weights; // weights of edges (length sources[n])
 } graph_sgd;
 
-extern void sgd(graph_t *, int);
+extern void sgd(graph_t *, int, size_t threads, bool hogwild);
 
 #ifdef __cplusplus
 }
@@ -21,8 +21,15 @@
 #include <math.h>
 #include <stdbool.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 #include <util/alloc.h>
+#include <util/random.h>
+#include <util/thread.h>
+#ifdef SFDP
+#include <sparse/SparseMatrix.h>
+#include <sfdpgen/sparse_solve.h>
+#endif
 
 // the terms in the stress energy are normalized by dᵢⱼ¯²
 
@@ -150,11 +157,11 @@ int initLayout(int n, int dim, double **coords, node_t **nodes) {
 	    if (isFixed(np))
 		pinned = 1;
 	} else {
-	    *xp++ = drand48();
-	    *yp++ = drand48();
+	    *xp++ = gv_drand48();
+	    *yp++ = gv_drand48();
 	    if (dim > 2) {
 		for (d = 2; d < dim; d++)
-		    coords[d][i] = drand48();
+		    coords[d][i] = gv_drand48();
 	    }
 	}
     }
@@ -344,7 +351,7 @@ static int sparse_stress_subspace_majorization_kD(vtx_data * graph,	/* Input gra
     /* select 'num_centers' pivots that are uniformaly spread over the graph */
 
     /* the first pivots is selected randomly */
-    node = rand() % n;
+    node = gv_rand() % n;
     CenterIndex[node] = 0;
     invCenterIndex[0] = node;
 
@@ -376,7 +383,7 @@ static int sparse_stress_subspace_majorization_kD(vtx_data * graph,	/* Input gra
 	for (int j = 0; j < n; j++) {
 	    dist[j] = MIN(dist[j], Dij[i][j]);
 	    if (dist[j] > max_dist
-		|| (dist[j] == max_dist && rand() % (j + 1) == 0)) {
+		|| (dist[j] == max_dist && gv_rand() % (j + 1) == 0)) {
 		node = j;
 		max_dist = dist[j];
 	    }
@@ -531,7 +538,7 @@ static int sparse_stress_subspace_majorization_kD(vtx_data * graph,	/* Input gra
 	/* random initialization */
 	for (k = 0; k < dim; k++) {
 	    for (i = 0; i < subspace_dim; i++) {
-		directions[k][i] = (double) rand() / RAND_MAX;
+		directions[k][i] = (double) gv_rand() / RAND_MAX;
 	    }
 	}
     }
@@ -639,32 +646,99 @@ finish0:
     return iterations;
 }
 
-/* compute_weighted_apsp_packed:
- * Edge lengths can be any float > 0
+/// computation of the packed shortest path distances from each node
+typedef struct {
+    vtx_data *graph;
+    int n;
+    bool weighted; ///< use Dijkstra on the edge weights rather than BFS
+    float *Dij;    ///< output, row i holding the distances from i to i … n-1
+    Queue *queues; ///< per worker, BFS queue
+    DistType **hops; ///< per worker, BFS distances
+    dijkstra_scratch_t *heaps; ///< per worker, Dijkstra heap
+    float **dists; ///< per worker, Dijkstra distances
+} apsp_job_t;
+
+static void apsp_source(void *arg, size_t index, size_t worker)
+{
+    apsp_job_t *job = arg;
+    const int n = job->n;
+    const int i = (int)index;
+    // rows before i take n + (n - 1) + … + (n - i + 1) entries
+    float *row = job->Dij + index * (size_t)n - index * (index - 1) / 2;
+
+    if (job->weighted) {
+	float *Di = job->dists[worker];
+	dijkstra_f_scratch(i, job->graph, n, Di, &job->heaps[worker]);
+	memcpy(row, Di + i, sizeof(float) * (size_t)(n - i));
+    } else {
+	DistType *Di = job->hops[worker];
+	bfs_queue(i, job->graph, n, Di, &job->queues[worker]);
+	for (int j = i; j < n; j++)
+	    row[j - i] = (float)Di[j];
+    }
+}
+
+/* compute_apsp_packed_with:
+ * Compute the shortest path distances between all pairs of nodes, one row of
+ * the packed result per source, using up to threads threads. Each thread has
+ * its own search space and writes to the rows of the sources it is given, so
+ * the result does not depend on the number of threads.
  */
-static float *compute_weighted_apsp_packed(vtx_data * graph, int n)
+static float *compute_apsp_packed_with(vtx_data *graph, int n, bool weighted,
+                                       size_t threads)
 {
-    int i, j, count;
-    float *Dij = gv_calloc(n * (n + 1) / 2, sizeof(float));
+    const size_t workers = MAX(MIN(threads, (size_t)n), 1);
+    apsp_job_t job = {.graph = graph, .n = n, .weighted = weighted};
+
+    job.Dij = gv_calloc((size_t)n * (size_t)(n + 1) / 2, sizeof(float));
+    if (weighted) {
+	job.heaps = gv_calloc(workers, sizeof(job.heaps[0]));
+	job.dists = gv_calloc(workers, sizeof(job.dists[0]));
+	for (size_t w = 0; w < workers; w++) {
+	    dijkstra_scratch_init(&job.heaps[w], n);
+	    job.dists[w] = gv_calloc(n, sizeof(float));
+	}
+    } else {
+	job.queues = gv_calloc(workers, sizeof(job.queues[0]));
+	job.hops = gv_calloc(workers, sizeof(job.hops[0]));
+	for (size_t w = 0; w < workers; w++) {
+	    mkQueue(&job.queues[w], n);
+	    job.hops[w] = gv_calloc(n, sizeof(DistType));
+	}
+    }
 
-    float *Di = gv_calloc(n, sizeof(float));
+    gv_parallel_for((size_t)n, workers, apsp_source, &job);
 
-    count = 0;
-    for (i = 0; i < n; i++) {
-	dijkstra_f(i, graph, n, Di);
-	for (j = i; j < n; j++) {
-	    Dij[count++] = Di[j];
+    for (size_t w = 0; w < workers; w++) {
+	if (weighted) {
+	    dijkstra_scratch_free(&job.heaps[w]);
+	    free(job.dists[w]);
+	} else {
+	    freeQueue(&job.queues[w]);
+	    free(job.hops[w]);
 	}
     }
-    free(Di);
-    return Dij;
+    free(job.heaps);
+    free(job.dists);
+    free(job.queues);
+    free(job.hops);
+    return job.Dij;
+}
+
+/* compute_weighted_apsp_packed:
+ * Edge lengths can be any float > 0
+ */
+static float *compute_weighted_apsp_packed(vtx_data *graph, int n,
+                                           size_t threads)
+{
+    return compute_apsp_packed_with(graph, n, true, threads);
 }
 
 
 /* mdsModel:
  * Update matrix with actual edge lengths
  */
-float *mdsModel(vtx_data * graph, int nG)
+float *mdsModel(vtx_data * graph, int nG, size_t threads)
 {
     int i, j;
     float *Dij;
@@ -675,7 +749,7 @@ float *mdsModel(vtx_data * graph, int nG)
 	return 0;
 
     /* first, compute shortest paths to fill in non-edges */
-    Dij = compute_weighted_apsp_packed(graph, nG);
+    Dij = compute_weighted_apsp_packed(graph, nG, threads);
 
     /* then, replace edge entries will user-supplied len */
     for (i = 0; i < nG; i++) {
@@ -697,25 +771,13 @@ float *mdsModel(vtx_data * graph, int nG)
 /* compute_apsp_packed:
  * Assumes integral weights > 0.
  */
-float *compute_apsp_packed(vtx_data * graph, int n)
+float *compute_apsp_packed(vtx_data *graph, int n, size_t threads)
 {
-    int i, j, count;
-    float *Dij = gv_calloc(n * (n + 1) / 2, sizeof(float));
-
-    DistType *Di = gv_calloc(n, sizeof(DistType));
-
-    count = 0;
-    for (i = 0; i < n; i++) {
-	bfs(i, graph, n, Di);
-	for (j = i; j < n; j++) {
-	    Dij[count++] = (float)Di[j];
-	}
-    }
-    free(Di);
-    return Dij;
+    return compute_apsp_packed_with(graph, n, false, threads);
 }
 
-float *compute_apsp_artificial_weights_packed(vtx_data *graph, int n) {
+float *compute_apsp_artificial_weights_packed(vtx_data *graph, int n,
+                                              size_t threads) {
     /* compute all-pairs-shortest-path-length while weighting the graph */
     /* so high-degree nodes are distantly located */
 
@@ -747,7 +809,7 @@ float *compute_apsp_artificial_weights_packed(vtx_data *graph, int n) {
 	    graph[i].ewgts = weights;
 	    weights += graph[i].nedges;
 	}
-	Dij = compute_weighted_apsp_packed(graph, n);
+	Dij = compute_weighted_apsp_packed(graph, n, threads);
     } else {
 	for (i = 0; i < n; i++) {
 	    graph[i].ewgts = weights;
@@ -762,7 +824,7 @@ float *compute_apsp_artificial_weights_packed(vtx_data *graph, int n) {
 	    empty_neighbors_vec(graph, i, vtx_vec);
 	    weights += graph[i].nedges;
 	}
-	Dij = compute_apsp_packed(graph, n);
+	Dij = compute_apsp_packed(graph, n, threads);
     }
 
     free(vtx_vec);
@@ -805,7 +867,8 @@ int stress_majorization_kD_mkernel(vtx_data * graph,	/* Input graph in sparse re
 				   int dim,	/* dimemsionality of layout */
 				   int opts,    /* options */
 				   int model,	/* model */
-				   int maxi	/* max iterations */
+				   int maxi,	/* max iterations */
+				   size_t threads	/* threads for shortest paths */
     )
 {
     int iterations;		/* output: number of iteration of the process */
@@ -854,7 +917,7 @@ int stress_majorization_kD_mkernel(vtx_data * graph,	/* Input graph in sparse re
 	/* and perform slower Dijkstra-based computation */
 	if (Verbose)
 	    fprintf(stderr, "Calculating subset model");
-	Dij = compute_apsp_artificial_weights_packed(graph, n);
+	Dij = compute_apsp_artificial_weights_packed(graph, n, threads);
     } else if (model == MODEL_CIRCUIT) {
 	Dij = circuitModel(graph, n);
 	if (!Dij) {
@@ -866,15 +929,15 @@ int stress_majorization_kD_mkernel(vtx_data * graph,	/* Input graph in sparse re
     } else if (model == MODEL_MDS) {
 	if (Verbose)
 	    fprintf(stderr, "Calculating MDS model");
-	Dij = mdsModel(graph, n);
+	Dij = mdsModel(graph, n, threads);
     }
     if (!Dij) {
 	if (Verbose)
 	    fprintf(stderr, "Calculating shortest paths");
 	if (graph->ewgts)
-	    Dij = compute_weighted_apsp_packed(graph, n);
+	    Dij = compute_weighted_apsp_packed(graph, n, threads);
 	else
-	    Dij = compute_apsp_packed(graph, n);
+	    Dij = compute_apsp_packed(graph, n, threads);
     }
 
     if (Verbose) {
@@ -913,7 +976,7 @@ int stress_majorization_kD_mkernel(vtx_data * graph,	/* Input graph in sparse re
 	    }
 	    /* add small random noise */
 	    for (j = 0; j < n; j++) {
-		d_coords[i][j] += 1e-6 * (drand48() - 0.5);
+		d_coords[i][j] += 1e-6 * (gv_drand48() - 0.5);
 	    }
 	    orthog1(n, d_coords[i]);
 	}
@@ -1133,3 +1196,603 @@ finish1:
     free(lap1);
     return iterations;
 }
+
+#ifdef SFDP
+/* pivot_distances:
+ * Choose k pivots by max-min selection, starting from a random node, and
+ * store the shortest path distances from pivot p to all nodes in
+ * dist[p * n ... p * n + n - 1]. Return the number of pivots chosen, which is
+ * less than k if every node is already a pivot.
+ */
+static int pivot_distances(vtx_data *graph, int n, int k, int *pivots,
+                           float *dist)
+{
+    float *nearest = gv_calloc(n, sizeof(float));
+    DistType *hops = graph[0].ewgts ? NULL : gv_calloc(n, sizeof(DistType));
+    int node = gv_rand() % n;
+    int p;
+
+    for (int i = 0; i < n; i++)
+	nearest[i] = FLT_MAX;
+    for (p = 0; p < k; p++) {
+	float *d = dist + (size_t)p * n;
+	pivots[p] = node;
+	if (hops) {
+	    bfs(node, graph, n, hops);
+	    for (int i = 0; i < n; i++)
+		d[i] = (float)hops[i];
+	} else {
+	    dijkstra_f(node, graph, n, d);
+	}
+	float max_dist = 0;
+	for (int i = 0; i < n; i++) {
+	    nearest[i] = fminf(nearest[i], d[i]);
+	    if (nearest[i] > max_dist) {
+		node = i;
+		max_dist = nearest[i];
+	    }
+	}
+	if (max_dist == 0) {
+	    p++;
+	    break;
+	}
+    }
+    free(hops);
+    free(nearest);
+    return p;
+}
+
+/// the pivot terms of a sparse stress model
+typedef struct {
+    int n;        ///< number of nodes
+    int k;        ///< number of pivots
+    float *dist;  ///< distances from each pivot to all nodes, k × n
+    int *start;   ///< start of each pivot's region in region_dist
+    float *region_dist; ///< sorted distances of each region's nodes from its pivot
+    int exp;      ///< exponent of the distance scaling of weights
+} pivot_terms_t;
+
+static int floatcmp(const void *x, const void *y)
+{
+    const float a = *(const float *)x;
+    const float b = *(const float *)y;
+    if (a < b)
+	return -1;
+    if (a > b)
+	return 1;
+    return 0;
+}
+
+/* pivot_regions:
+ * Assign each node to the region of its nearest pivot, and record the
+ * distances of the members of each region from its pivot, in order.
+ */
+static void pivot_regions(pivot_terms_t *pt)
+{
+    const int n = pt->n;
+    const int k = pt->k;
+    int *region = gv_calloc(n, sizeof(int));
+    int *fill = gv_calloc(k, sizeof(int));
+
+    pt->start = gv_calloc(k + 1, sizeof(int));
+    pt->region_dist = gv_calloc(n, sizeof(float));
+    for (int i = 0; i < n; i++) {
+	int nearest = 0;
+	for (int p = 1; p < k; p++) {
+	    if (pt->dist[(size_t)p * n + i] < pt->dist[(size_t)nearest * n + i])
+		nearest = p;
+	}
+	region[i] = nearest;
+	pt->start[nearest + 1]++;
+    }
+    for (int p = 0; p < k; p++)
+	pt->start[p + 1] += pt->start[p];
+    for (int i = 0; i < n; i++) {
+	const int p = region[i];
+	pt->region_dist[pt->start[p] + fill[p]++] = pt->dist[(size_t)p * n + i];
+    }
+    for (int p = 0; p < k; p++)
+	qsort(pt->region_dist + pt->start[p], (size_t)fill[p], sizeof(float),
+	      floatcmp);
+    free(fill);
+    free(region);
+}
+
+/* pivot_mds:
+ * Place the nodes by classical scaling of their distances from the pivots,
+ * after Brandes and Pich's PivotMDS. The sparse model has too few terms to
+ * untangle a poor start, and this uses only the distances it needs anyway.
+ */
+static void pivot_mds(const pivot_terms_t *pt, int dim, double **coords)
+{
+    const int n = pt->n;
+    const int k = pt->k;
+    double *C = gv_calloc((size_t)k * n, sizeof(double));
+    double *col_mean = gv_calloc(n, sizeof(double));
+    double grand_mean = 0;
+
+    // double center the squared distances, treating unreachable nodes as at
+    // the furthest reachable distance
+    float far = 0;
+    for (size_t i = 0; i < (size_t)k * n; i++) {
+	if (pt->dist[i] < FLT_MAX)
+	    far = fmaxf(far, pt->dist[i]);
+    }
+    for (int p = 0; p < k; p++) {
+	double *c = C + (size_t)p * n;
+	double row_mean = 0;
+	for (int i = 0; i < n; i++) {
+	    const double d = fminf(pt->dist[(size_t)p * n + i], far);
+	    c[i] = d * d;
+	    row_mean += c[i];
+	}
+	row_mean /= n;
+	for (int i = 0; i < n; i++) {
+	    c[i] -= row_mean;
+	    col_mean[i] += c[i] / k;
+	}
+    }
+    for (int i = 0; i < n; i++)
+	grand_mean += col_mean[i] / n;
+    for (int p = 0; p < k; p++) {
+	double *c = C + (size_t)p * n;
+	for (int i = 0; i < n; i++)
+	    c[i] = -0.5 * (c[i] - col_mean[i] + grand_mean);
+    }
+
+    // the top eigenvectors of C Cᵀ give the directions of the layout
+    double **M = gv_calloc(k, sizeof(double *));
+    M[0] = gv_calloc((size_t)k * k, sizeof(double));
+    for (int p = 1; p < k; p++)
+	M[p] = M[0] + (size_t)p * k;
+    for (int p = 0; p < k; p++) {
+	for (int q = p; q < k; q++) {
+	    const double *cp = C + (size_t)p * n;
+	    const double *cq = C + (size_t)q * n;
+	    double sum = 0;
+	    for (int i = 0; i < n; i++)
+		sum += cp[i] * cq[i];
+	    M[p][q] = M[q][p] = sum;
+	}
+    }
+    const int neigs = MIN(dim, k);
+    double **eigs = gv_calloc(neigs, sizeof(double *));
+    for (int e = 0; e < neigs; e++)
+	eigs[e] = gv_calloc(k, sizeof(double));
+    double *evals = gv_calloc(neigs, sizeof(double));
+    power_iteration(M, k, neigs, eigs, evals);
+
+    // project, with a little noise so that nodes the pivots cannot tell
+    // apart do not coincide
+    for (int e = 0; e < dim; e++) {
+	for (int i = 0; i < n; i++) {
+	    double x = 0;
+	    for (int p = 0; e < neigs && p < k; p++)
+		x += C[(size_t)p * n + i] * eigs[e][p];
+	    coords[e][i] = x + 1e-3 * (gv_drand48() - 0.5);
+	}
+    }
+
+    for (int e = 0; e < neigs; e++)
+	free(eigs[e]);
+    free(eigs);
+    free(evals);
+    free(M[0]);
+    free(M);
+    free(col_mean);
+    free(C);
+}
+
+/* pivot_weight:
+ * Weight of the term between node i and pivot p. This stands in for the
+ * terms between i and the nodes of p's region that are no further from p
+ * than halfway to i, so it is scaled by their number.
+ */
+static double pivot_weight(const pivot_terms_t *pt, int i, int p)
+{
+    const double d = pt->dist[(size_t)p * pt->n + i];
+    if (d <= 0 || d >= FLT_MAX)
+	return 0;
+    const float *lo = pt->region_dist + pt->start[p];
+    size_t count = (size_t)(pt->start[p + 1] - pt->start[p]);
+    // count the region's distances ≤ d/2 by binary search
+    size_t below = 0;
+    while (count > 0) {
+	const size_t half = count / 2;
+	if (lo[below + half] <= d / 2) {
+	    below += half + 1;
+	    count -= half + 1;
+	} else {
+	    count = half;
+	}
+    }
+    return (double)below / (pt->exp == 2 ? d * d : d);
+}
+
+/// search for the nodes within a few hops of a node
+typedef struct {
+    int *found;  ///< nodes reached, starting with the source
+    int size;    ///< number of nodes reached
+    int *stamp;  ///< per node, source + 1 of the last search to reach it
+    int *hops;   ///< per node, fewest hops from the source
+    float *dist; ///< per node, shortest distance within the hops allowed
+    float *prev; ///< per node, the same with one hop fewer
+} hood_t;
+
+/// how far, and through how many edges, to search for a node's neighborhood
+enum { HOOD_HOPS = 2, HOOD_EDGES = 200 };
+
+/* neighborhood:
+ * Find the nodes within HOOD_HOPS hops of source, with the length of the
+ * shortest path to each using at most that many edges. Return false, leaving
+ * the search incomplete, if it would have to look at more than HOOD_EDGES
+ * edges.
+ */
+static bool neighborhood(vtx_data *graph, int source, hood_t *h)
+{
+    size_t budget = HOOD_EDGES;
+
+    h->found[0] = source;
+    h->size = 1;
+    h->stamp[source] = source + 1;
+    h->hops[source] = 0;
+    h->dist[source] = 0;
+    for (int hop = 1; hop <= HOOD_HOPS; hop++) {
+	const int reached = h->size;
+	for (int f = 0; f < reached; f++)
+	    h->prev[h->found[f]] = h->dist[h->found[f]];
+	for (int f = 0; f < reached; f++) {
+	    const int u = h->found[f];
+	    if (h->prev[u] == FLT_MAX)
+		continue;
+	    if (graph[u].nedges - 1 > budget)
+		return false;
+	    budget -= graph[u].nedges - 1;
+	    for (size_t e = 1; e < graph[u].nedges; e++) {
+		const int j = graph[u].edges[e];
+		const float d = h->prev[u] + (graph[u].ewgts ? graph[u].ewgts[e] : 1);
+		if (h->stamp[j] != source + 1) {
+		    h->stamp[j] = source + 1;
+		    h->hops[j] = hop;
+		    h->dist[j] = d;
+		    h->prev[j] = FLT_MAX;
+		    h->found[h->size++] = j;
+		} else if (d < h->dist[j]) {
+		    h->dist[j] = d;
+		}
+	    }
+	}
+    }
+    return true;
+}
+
+/* sparse_terms:
+ * Collect the terms of the sparse stress model. Row i of the result holds the
+ * weights of node i's terms, and ideal their ideal distances.
+ *
+ * Node i has a term for each neighbor and, unless that would take too long to
+ * find, for each node within a few hops of it that can do the same. Their
+ * ideal distances are those of the shortest paths within that many hops. i
+ * also has a term for each pivot that it does not have one for already.
+ */
+static SparseMatrix sparse_terms(vtx_data *graph, const pivot_terms_t *pt,
+                                 const int *pivots, float **ideal)
+{
+    const int n = pt->n;
+    const int k = pt->k;
+    bool *local = gv_calloc(n, sizeof(bool));
+    // a search finds at most as many nodes as the edges it looks at, or, from
+    // a node that is not local, as its neighbors
+    size_t max_found = HOOD_EDGES;
+    for (int i = 0; i < n; i++)
+	max_found = MAX(max_found, graph[i].nedges - 1);
+    hood_t h = {.found = gv_calloc(max_found + 1, sizeof(int)),
+                .stamp = gv_calloc(n, sizeof(int)),
+                .hops = gv_calloc(n, sizeof(int)),
+                .dist = gv_calloc(n, sizeof(float)),
+                .prev = gv_calloc(n, sizeof(float))};
+
+    // which nodes have terms for their whole neighborhood
+    for (int i = 0; i < n; i++)
+	local[i] = neighborhood(graph, i, &h);
+
+    // Search from each node twice, first to count its terms, then to fill
+    // them in. Searches from the same node stamp the same nodes, so clear the
+    // stamps of the previous pass before each.
+    SparseMatrix T = NULL;
+    double *weight = NULL;
+    float *d = NULL;
+    for (int pass = 0; pass < 2; pass++) {
+	memset(h.stamp, 0, sizeof(int) * n);
+	size_t at = 0;
+	for (int i = 0; i < n; i++) {
+	    if (local[i]) {
+		(void)neighborhood(graph, i, &h);
+	    } else {
+		h.found[0] = i;
+		h.size = 1;
+		h.stamp[i] = i + 1;
+	    }
+	    // whether or not i is local, the ideal distance to a neighbor is the
+	    // length of the edge between them
+	    for (size_t e = 1; e < graph[i].nedges; e++) {
+		const int j = graph[i].edges[e];
+		if (h.stamp[j] != i + 1) {
+		    h.stamp[j] = i + 1;
+		    h.found[h.size++] = j;
+		}
+		h.hops[j] = 1;
+		h.dist[j] = FLT_MAX;
+	    }
+	    for (size_t e = 1; e < graph[i].nedges; e++) {
+		const int j = graph[i].edges[e];
+		const float len = graph[i].ewgts ? graph[i].ewgts[e] : 1;
+		h.dist[j] = fminf(h.dist[j], len);
+	    }
+
+	    for (int f = 1; f < h.size; f++) {
+		const int j = h.found[f];
+		if (h.hops[j] > 1 && !local[j]) {
+		    h.stamp[j] = 0;
+		    continue;
+		}
+		if (T != NULL) {
+		    const double len = h.dist[j];
+		    T->ja[at] = j;
+		    weight[at] = 1 / (pt->exp == 2 ? len * len : len);
+		    d[at] = (float)len;
+		}
+		at++;
+	    }
+	    for (int p = 0; p < k; p++) {
+		if (h.stamp[pivots[p]] == i + 1)
+		    continue;
+		if (T != NULL) {
+		    T->ja[at] = pivots[p];
+		    weight[at] = pivot_weight(pt, i, p);
+		    d[at] = pt->dist[(size_t)p * n + i];
+		}
+		at++;
+	    }
+	    if (T != NULL)
+		T->ia[i + 1] = (int)at;
+	}
+	if (T == NULL) {
+	    assert(at <= INT_MAX);
+	    T = SparseMatrix_new(n, n, (int)at, MATRIX_TYPE_REAL, FORMAT_CSR);
+	    T->nz = (int)at;
+	    weight = T->a;
+	    d = *ideal = gv_calloc(at, sizeof(float));
+	}
+    }
+
+    free(h.found);
+    free(h.stamp);
+    free(h.hops);
+    free(h.dist);
+    free(h.prev);
+    free(local);
+    return T;
+}
+
+/* sparse_system:
+ * Build the matrix of the linear system solved in each iteration. Nodes that
+ * do not move with the others, the pivots and pinned nodes, have a row of
+ * their own. Terms with them only add to the diagonal, leaving a symmetric
+ * system coupling the remaining nodes through their neighborhoods.
+ */
+static SparseMatrix sparse_system(SparseMatrix T, const bool *held)
+{
+    const int n = T->m;
+    size_t nz = 0;
+
+    for (int i = 0; i < n; i++) {
+	nz++;
+	if (held[i])
+	    continue;
+	for (int e = T->ia[i]; e < T->ia[i + 1]; e++) {
+	    if (!held[T->ja[e]])
+		nz++;
+	}
+    }
+    assert(nz <= INT_MAX);
+
+    SparseMatrix A = SparseMatrix_new(n, n, (int)nz, MATRIX_TYPE_REAL,
+                                      FORMAT_CSR);
+    const double *w = T->a;
+    double *a = A->a;
+    int at = 0;
+    for (int i = 0; i < n; i++) {
+	const int diag = at++;
+	A->ja[diag] = i;
+	a[diag] = 1;
+	if (!held[i]) {
+	    double degree = 0;
+	    for (int e = T->ia[i]; e < T->ia[i + 1]; e++) {
+		const int j = T->ja[e];
+		degree += w[e];
+		if (held[j])
+		    continue;
+		A->ja[at] = j;
+		a[at] = -w[e];
+		at++;
+	    }
+	    a[diag] = degree;
+	}
+	A->ia[i + 1] = at;
+    }
+    A->nz = at;
+    return A;
+}
+
+/* stress_majorization_sparse:
+ * Stress majorization over a sparse set of terms, after the sparse stress
+ * model of Ortmann, Klimenta and Brandes. Each node has terms for the nodes
+ * near it and for a fixed number of pivots, which stand in for the nodes of
+ * their regions. Unlike stress_majorization_kD_mkernel, this never holds the
+ * distances between all pairs of nodes, so its memory is linear in the size
+ * of the graph. Only the shortest path model is supported.
+ *
+ * In each iteration, the pivots are moved by their own terms alone, and the
+ * other nodes by solving the majorizing system for all of them, with the
+ * pivots held in their new positions.
+ */
+int stress_majorization_sparse(vtx_data *graph, int n, double **d_coords,
+                               node_t **nodes, int dim, int opts, int maxi)
+{
+    int iterations = 0;
+    const int exp = opts & opt_exp_flag;
+
+    if (maxi < 0)
+	return 0;
+
+    if (Verbose) {
+	fprintf(stderr, "Calculating pivot distances");
+	start_timer();
+    }
+    const int max_pivots = MIN(n, num_pivots_stress);
+    int *pivots = gv_calloc(max_pivots, sizeof(int));
+    pivot_terms_t pt = {.n = n, .exp = exp};
+    pt.dist = gv_calloc((size_t)max_pivots * n, sizeof(float));
+    pt.k = pivot_distances(graph, n, max_pivots, pivots, pt.dist);
+    pivot_regions(&pt);
+    if (Verbose) {
+	fprintf(stderr, ": %d pivots %.2f sec\n", pt.k, elapsed_sec());
+	fprintf(stderr, "Setting initial positions");
+	start_timer();
+    }
+
+    int havePinned = 0;
+    if (opts & opt_smart_init)
+	pivot_mds(&pt, dim, d_coords);
+    else
+	havePinned = initLayout(n, dim, d_coords, nodes);
+    if (Verbose) {
+	fprintf(stderr, ": %.2f sec\n", elapsed_sec());
+	fprintf(stderr, "Setting up sparse model");
+	start_timer();
+    }
+
+    float *ideal;
+    SparseMatrix T = sparse_terms(graph, &pt, pivots, &ideal);
+    free(pt.dist);
+    free(pt.start);
+    free(pt.region_dist);
+
+    bool *pivot = gv_calloc(n, sizeof(bool));
+    bool *held = gv_calloc(n, sizeof(bool));
+    for (int p = 0; p < pt.k; p++)
+	pivot[pivots[p]] = held[pivots[p]] = true;
+    free(pivots);
+    for (int i = 0; havePinned && i < n; i++) {
+	if (isFixed(nodes[i]))
+	    held[i] = true;
+    }
+    SparseMatrix A = sparse_system(T, held);
+    if (Verbose) {
+	fprintf(stderr, ": %d terms %.2f sec\n", T->nz, elapsed_sec());
+	fprintf(stderr, "Solving model: ");
+	start_timer();
+    }
+
+    // SparseMatrix_solve works on node-major coordinates
+    double *x = gv_calloc((size_t)n * dim, sizeof(double));
+    double *b = gv_calloc((size_t)n * dim, sizeof(double));
+    for (int i = 0; i < n; i++)
+	for (int k = 0; k < dim; k++)
+	    x[i * dim + k] = d_coords[k][i];
+
+    const int *ia = T->ia;
+    const int *ja = T->ja;
+    const double *w = T->a;
+    const double maxit_cg = floor(sqrt(n));
+    double old_stress = DBL_MAX; // at least one iteration
+    double stress = 0;
+    for (bool converged = false; iterations < maxi && !converged;
+         iterations++) {
+	// b := L_Z(x) x, the right hand side of the majorizing system
+	memset(b, 0, sizeof(double) * n * dim);
+	stress = 0;
+	for (int i = 0; i < n; i++) {
+	    for (int e = ia[i]; e < ia[i + 1]; e++) {
+		const int j = ja[e];
+		double dist = 0;
+		for (int k = 0; k < dim; k++) {
+		    const double delta = x[i * dim + k] - x[j * dim + k];
+		    dist += delta * delta;
+		}
+		dist = sqrt(dist);
+		const double r = dist - ideal[e];
+		stress += w[e] * r * r;
+		if (dist > 0) {
+		    const double f = w[e] * ideal[e] / dist;
+		    for (int k = 0; k < dim; k++)
+			b[i * dim + k] += f * (x[i * dim + k] - x[j * dim + k]);
+		}
+	    }
+	}
+
+	converged = fabs(old_stress - stress) / old_stress < Epsilon
+	         || stress < Epsilon;
+	old_stress = stress;
+
+	// move each pivot to the minimum of the majorization of its own terms
+	for (int i = 0; i < n; i++) {
+	    if (!held[i])
+		continue;
+	    if (!pivot[i] || (havePinned && isFixed(nodes[i]))) {
+		for (int k = 0; k < dim; k++)
+		    b[i * dim + k] = x[i * dim + k];
+		continue;
+	    }
+	    double degree = 0;
+	    for (int e = ia[i]; e < ia[i + 1]; e++) {
+		degree += w[e];
+		for (int k = 0; k < dim; k++)
+		    b[i * dim + k] += w[e] * x[ja[e] * dim + k];
+	    }
+	    for (int k = 0; k < dim; k++)
+		b[i * dim + k] = degree > 0 ? b[i * dim + k] / degree
+		                            : x[i * dim + k];
+	}
+	// terms with held nodes move to the right hand side of the others
+	for (int i = 0; i < n; i++) {
+	    if (held[i])
+		continue;
+	    for (int e = ia[i]; e < ia[i + 1]; e++) {
+		const int j = ja[e];
+		if (!held[j])
+		    continue;
+		for (int k = 0; k < dim; k++)
+		    b[i * dim + k] += w[e] * b[j * dim + k];
+	    }
+	}
+
+	// solve A x' = b, leaving x' in b
+	SparseMatrix_solve(A, dim, x, b, tolerance_cg, maxit_cg);
+	memcpy(x, b, sizeof(double) * n * dim);
+	if (Verbose && iterations % 5 == 0) {
+	    fprintf(stderr, "%.3f ", stress);
+	    if ((iterations + 5) % 50 == 0)
+		fprintf(stderr, "\n");
+	}
+    }
+    if (Verbose) {
+	fprintf(stderr, "\nfinal e = %f %d iterations %.2f sec\n", stress,
+	        iterations, elapsed_sec());
+    }
+
+    for (int i = 0; i < n; i++)
+	for (int k = 0; k < dim; k++)
+	    d_coords[k][i] = x[i * dim + k];
+
+    free(b);
+    free(x);
+    free(held);
+    free(pivot);
+    free(ideal);
+    SparseMatrix_delete(A);
+    SparseMatrix_delete(T);
+    return iterations;
+}
+#endif
@@ -37,13 +37,23 @@ extern "C" {
 					      int dim,	/* dimemsionality of layout */
 					      int opts,	/* option flags */
 					      int model,	/* model */
-					      int maxi	/* max iterations */
+					      int maxi,	/* max iterations */
+					      size_t threads	/* threads for shortest paths */
 	);
 
-extern float *compute_apsp_packed(vtx_data * graph, int n);
-extern float *compute_apsp_artificial_weights_packed(vtx_data *graph, int n);
+#ifdef SFDP
+    /* Stress optimization over edges and a fixed number of pivots per node */
+    /* Memory is linear in the size of the graph */
+    extern int stress_majorization_sparse(vtx_data *graph, int n,
+                                          double **coords, node_t **nodes,
+                                          int dim, int opts, int maxi);
+#endif
+
+extern float *compute_apsp_packed(vtx_data * graph, int n, size_t threads);
+extern float *compute_apsp_artificial_weights_packed(vtx_data *graph, int n,
+                                                     size_t threads);
 extern float* circuitModel(vtx_data * graph, int nG);
-extern float* mdsModel (vtx_data * graph, int nG);
+extern float* mdsModel (vtx_data * graph, int nG, size_t threads);
 extern int initLayout(int n, int dim, double **coords, node_t **nodes);
 
 #ifdef __cplusplus
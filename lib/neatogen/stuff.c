@@ -115,7 +115,7 @@ static int lenattr(edge_t* e, Agsym_t* index, double* val)
     s = agxget(e, index);
     if (*s == '\0') return 1;
 
-    if (sscanf(s, "%lf", val) < 1 || *val < 0 || (*val == 0 && !Nop)) {
+    if (!agxget_double(e, index, val) || *val < 0 || (*val == 0 && !Nop)) {
 	agwarningf("bad edge len \"%s\"", s);
 	return 2;
     }
@@ -259,7 +259,7 @@ int scan_graph_mode(graph_t * G, int mode)
 	    ND_heapindex(np) = -1;
 	    total_len += setEdgeLen(G, np, lenx, dfltlen);
 	}
-    } else if (mode == MODE_SGD) {
+    } else if (mode == MODE_SGD || mode == MODE_HOGWILD) {
 	Epsilon = .01;
 	getdouble(G, "epsilon", &Epsilon);
 	GD_neato_nlist(G) = gv_calloc(nV + 1, sizeof(node_t*)); // not sure why but sometimes needs the + 1
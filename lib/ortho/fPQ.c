@@ -8,24 +8,34 @@
  * Contributors: Details at https://graphviz.org
  *************************************************************************/
 
-/* Priority Queue Code for shortest path in graph */
+/* Priority Queue Code for shortest path in graph
+ *
+ * Nodes are ordered by N_EST, least first. Of nodes with the same estimate,
+ * the one farthest along its path comes first, which is the one closer to
+ * the goal.
+ */
 
 #include "config.h"
 #include <assert.h>
+#include <float.h>
+#include <stdbool.h>
 #include <util/alloc.h>
+#include <util/tls.h>
 
 #include <ortho/fPQ.h>
 
-static snode**  pq;
-static int     PQcnt;
-static snode    guard;
-static int     PQsize;
+/* one queue per thread */
+static TLS snode**  pq;
+static TLS int     PQcnt;
+static TLS snode    guard;
+static TLS int     PQsize;
 
 void
 PQgen(int sz)
 {
   if (!pq) {
     pq = gv_calloc(sz + 1, sizeof(snode*));
+    guard.n_est = -DBL_MAX;
     pq[0] = &guard;
     PQsize = sz;
   }
@@ -58,15 +68,21 @@ PQcheck (void)
   }
 }
 
+/// does `a` come out of the queue before `b`?
+static bool before(const snode *a, const snode *b) {
+  if (N_EST(a) != N_EST(b))
+    return N_EST(a) < N_EST(b);
+  return N_VAL(a) > N_VAL(b);
+}
+
 void
 PQupheap(int k)
 {
   snode* x = pq[k];
-  int     v = x->n_val;
   int     next = k/2;
   snode*  n;
   
-  while (N_VAL(n = pq[next]) < v) {
+  while (before(x, n = pq[next])) {
     pq[k] = n;
     N_IDX(n) = k;
     k = next;
@@ -94,7 +110,6 @@ void
 PQdownheap (int k)
 {
   snode*    x = pq[k];
-  int      v = N_VAL(x);
   int      lim = PQcnt/2;
   snode*    n;
   int      j;
@@ -103,12 +118,12 @@ PQdownheap (int k)
     j = k+k;
     n = pq[j];
     if (j < PQcnt) {
-      if (N_VAL(n) < N_VAL(pq[j+1])) {
+      if (before(pq[j+1], n)) {
         j++;
         n = pq[j];
       }
     }
-    if (v >= N_VAL(n)) break;
+    if (!before(n, x)) break;
     pq[k] = n;
     N_IDX(n) = k;
     k = j;
@@ -124,6 +139,7 @@ PQremove (void)
 
   if (PQcnt) {
     n = pq[1];
+    N_IDX(n) = 0;
     pq[1] = pq[PQcnt];
     PQcnt--;
     if (PQcnt) PQdownheap (1);
@@ -133,9 +149,13 @@ PQremove (void)
   else return 0;
 }
 
+/// lowers the weight of the path to `n` to `d`, keeping the bound on the
+/// weight still to go
+
 void
-PQupdate (snode* n, int d)
+PQupdate (snode* n, double d)
 {
+  N_EST(n) -= N_VAL(n) - d;
   N_VAL(n) = d;
   PQupheap (n->n_idx);
   PQcheck();
@@ -150,8 +170,8 @@ PQprint (void)
   fprintf (stderr, "Q: ");
   for (i = 1; i <= PQcnt; i++) {
     n = pq[i];
-    fprintf (stderr, "%d(%d:%d) ",  
-      n->index, N_IDX(n), N_VAL(n));
+    fprintf (stderr, "%d(%d:%f) ",  
+      n->index, N_IDX(n), N_EST(n));
   }
   fprintf (stderr, "\n");
 }
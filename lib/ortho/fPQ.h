@@ -19,7 +19,9 @@
 #include <util/alloc.h>
 
 #define N_VAL(n) (n)->n_val
+#define N_EST(n) (n)->n_est
 #define N_IDX(n) (n)->n_idx
+#define N_GEN(n) (n)->n_gen
 #define N_DAD(n) (n)->n_dad
 #define N_EDGE(n) (n)->n_edge
 #define E_WT(e) (e->weight)
@@ -32,5 +34,5 @@ void PQupheap(int);
 int PQ_insert(snode* np);
 void PQdownheap (int k);
 snode* PQremove (void);
-void PQupdate (snode* n, int d);
+void PQupdate (snode* n, double d);
 void PQprint (void);
@@ -296,6 +296,7 @@ findSVert (sgraph* g, Dt_t* cdt, pointf p, snodeitem* ditems, bool isVert)
 	n->p = p;
 	n->np = np;
 	np->isVert = isVert;
+	np->p = p;
 	dtinsert (cdt, n);
     }
 
@@ -318,11 +319,34 @@ chkSgraph (sgraph* g)
     
 }
 
+/**
+ * @brief sets @ref sgraph::dist_wt
+ *
+ * Crossing a cell costs at least its width or height, but a bend across a
+ * large cell can cost less than the distance between the segment ends, so
+ * the ratio is taken over all edges. Weights only grow after this.
+ */
+
+static void
+setDistWt (sgraph* g)
+{
+    double wt = delta;
+    for (int i = 0; i < g->nedges; i++) {
+	const sedge* e = g->edges + i;
+	const pointf p = g->nodes[e->v1].p;
+	const pointf q = g->nodes[e->v2].p;
+	const double d = fabs(p.x - q.x) + fabs(p.y - q.y);
+	if (d > 0)
+	    wt = fmin(wt, e->weight / d);
+    }
+    g->dist_wt = wt;
+}
+
 /**
  * @brief creates and fills @ref sgraph for @ref maze
  *
  * Subroutines: @ref createSGraph, @ref findSVert with @ref createSNode,
- * @ref initSEdges and @ref chkSgraph
+ * @ref initSEdges, @ref chkSgraph and @ref setDistWt
  */
 
 static sgraph*
@@ -375,7 +399,9 @@ mkMazeGraph (maze* mp, boxf bb)
     }
 
     /* For each gcell, corresponding to a node in the input graph,
-     * connect it to its corresponding search nodes.
+     * connect it to its corresponding search nodes. These are the nodes
+     * starting on each side short of its far corner, with points compared
+     * within the same tolerance as in the dictionaries.
      */
     maxdeg = 0;
     sides = gv_calloc(g->nnodes, sizeof(snode*));
@@ -388,25 +414,33 @@ mkMazeGraph (maze* mp, boxf bb)
 	cp->sides = sides+nsides;
         pt = cp->bb.LL;
 	np = dtmatch (hdict, &pt);
-	for (; np && np->p.x < cp->bb.UR.x; np = dtnext (hdict, np)) {
+	for (; np && dfp_cmp(np->p.y, pt.y) == 0 &&
+	     dfp_cmp(np->p.x, cp->bb.UR.x) < 0;
+	     np = dtnext (hdict, np)) {
 	    cp->sides[cp->nsides++] = np->np;
 	    np->np->cells[1] = cp;
 	}
 	np = dtmatch (vdict, &pt);
-	for (; np && np->p.y < cp->bb.UR.y; np = dtnext (vdict, np)) {
+	for (; np && dfp_cmp(np->p.x, pt.x) == 0 &&
+	     dfp_cmp(np->p.y, cp->bb.UR.y) < 0;
+	     np = dtnext (vdict, np)) {
 	    cp->sides[cp->nsides++] = np->np;
 	    np->np->cells[1] = cp;
 	}
 	pt.y = cp->bb.UR.y;
 	np = dtmatch (hdict, &pt);
-	for (; np && np->p.x < cp->bb.UR.x; np = dtnext (hdict, np)) {
+	for (; np && dfp_cmp(np->p.y, pt.y) == 0 &&
+	     dfp_cmp(np->p.x, cp->bb.UR.x) < 0;
+	     np = dtnext (hdict, np)) {
 	    cp->sides[cp->nsides++] = np->np;
 	    np->np->cells[0] = cp;
 	}
 	pt.x = cp->bb.UR.x;
 	pt.y = cp->bb.LL.y;
 	np = dtmatch (vdict, &pt);
-	for (; np && np->p.y < cp->bb.UR.y; np = dtnext (vdict, np)) {
+	for (; np && dfp_cmp(np->p.x, pt.x) == 0 &&
+	     dfp_cmp(np->p.y, cp->bb.UR.y) < 0;
+	     np = dtnext (vdict, np)) {
 	    cp->sides[cp->nsides++] = np->np;
 	    np->np->cells[0] = cp;
 	}
@@ -443,6 +477,7 @@ mkMazeGraph (maze* mp, boxf bb)
     free (ditems);
 
 chkSgraph (g);
+    setDistWt (g);
     /* save core graph state */
     gsave(g);
     return g;
@@ -27,6 +27,8 @@
 #include <math.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
+#include <cgraph/list.h>
 #include <ortho/maze.h>
 #include <ortho/fPQ.h>
 #include <ortho/ortho.h>
@@ -36,6 +38,8 @@
 #include <common/pointset.h>
 #include <util/alloc.h>
 #include <util/exit.h>
+#include <util/prisize_t.h>
+#include <util/thread.h>
 #include <util/unused.h>
 
 typedef struct {
@@ -43,6 +47,22 @@ typedef struct {
     Agedge_t* e;
 } epair_t;
 
+/// a call to @ref updateWts put off until the route making it is accepted
+typedef struct {
+    cell* cp;
+    int edge; ///< index of the traversed edge in the search graph
+} wt_update_t;
+
+DEFINE_LIST(wt_updates, wt_update_t)
+DEFINE_LIST(edge_ids, int)
+
+/// what a route found against a snapshot of the edge weights depends on
+typedef struct {
+    wt_updates_t updates; ///< weight updates the route makes, in order
+    edge_ids_t edges;     ///< edges of the search graph along the path
+    double weight;        ///< weight of the path in the snapshot
+} pending_t;
+
 #ifdef DEBUG
 #define DEBUG_FN /* nothing */
 #else
@@ -143,7 +163,7 @@ setSeg (segment* sp, bool dir, double fix, double b1, double b2, int l1, int l2)
  * and the two nodes on the boundary of the two real nodes.
  */
 static route
-convertSPtoRoute (sgraph* g, snode* fst, snode* lst)
+convertSPtoRoute (sgraph* g, snode* fst, snode* lst, pending_t* pending)
 {
     route rte;
     snode* ptr;
@@ -159,6 +179,16 @@ convertSPtoRoute (sgraph* g, snode* fst, snode* lst)
 
 	/* count no. of nodes in shortest path */
     for (ptr = fst; ptr; ptr = N_DAD(ptr)) sz++;
+    if (pending) {
+	/* record the path, so its weight can be checked against later routes */
+	pending->weight = 0;
+	for (ptr = fst; N_DAD(ptr); ptr = N_DAD(ptr)) {
+	    const int idx = (int)(N_EDGE(ptr) - g->edges);
+	    if (idx >= g->save_nedges) continue;  /* temporary edge */
+	    edge_ids_append(&pending->edges, idx);
+	    pending->weight += g->edges[idx].weight;
+	}
+    }
     rte.n = 0;
     assert(sz >= 2);
     rte.segs = gv_calloc(sz - 2, sizeof(segment));  /* at most sz-2 segments */
@@ -173,7 +203,13 @@ convertSPtoRoute (sgraph* g, snode* fst, snode* lst)
     bp1 = sidePt (ptr, cp);
     while (N_DAD(next)!=NULL) {
 	ncp = cellOf (prev, next);
-	updateWts (g, ncp, N_EDGE(ptr));
+	if (pending) {
+	    const int idx = (int)(N_EDGE(ptr) - g->edges);
+	    assert(idx < g->save_nedges);
+	    wt_updates_append(&pending->updates, (wt_update_t){ncp, idx});
+	}
+	else
+	    updateWts (g, ncp, N_EDGE(ptr));
 
         /* add seg if path bends or at end */
 	if (ptr->isVert != next->isVert || N_DAD(next) == lst) {
@@ -452,7 +488,8 @@ addLoop (sgraph* sg, cell* cp, snode* dp, snode* sp)
     int onTop;
 
     for (i = 0; i < cp->nsides; i++) {
-	snode* onp = cp->sides[i];
+	/* cp->sides refers to the maze's own search graph, sg may be a copy */
+	snode* onp = sg->nodes + cp->sides[i]->index;
 
 	if (onp->isVert) continue;
 	if (onp->cells[0] == cp) {
@@ -479,7 +516,7 @@ addNodeEdges (sgraph* sg, cell* cp, snode* np)
     int i;
 
     for (i = 0; i < cp->nsides; i++) {
-	snode* onp = cp->sides[i];
+	snode* onp = sg->nodes + cp->sides[i]->index;
 
 	createSEdge (sg, np, onp, 0);  /* FIX weight */
     }
@@ -1223,6 +1260,153 @@ static bool swap_ends_p(edge_t * e)
 
 static splineInfo sinfo = { swap_ends_p, spline_merge, true, true };
 
+/* findRoute:
+ * Find the shortest path for e through sg, which may be a copy of the maze's
+ * search graph made by cloneSGraph, and convert it to a route. If pending is
+ * NULL, the edge weights are updated for the new route; otherwise, the
+ * updates are recorded in pending. Return non-zero on failure.
+ */
+static int
+findRoute (sgraph* sg, Agedge_t* e, route* rte, pending_t* pending)
+{
+    const int gstart = sg->nnodes;
+    snode* sn = &sg->nodes[gstart];
+    snode* dn = &sg->nodes[gstart+1];
+    cell* start = CELL(agtail(e));
+    cell* dest = CELL(aghead(e));
+
+    if (start == dest)
+	addLoop (sg, start, dn, sn);
+    else {
+	addNodeEdges (sg, dest, dn);
+	addNodeEdges (sg, start, sn);
+    }
+    if (shortPath (sg, dn, sn)) return 1;
+    *rte = convertSPtoRoute(sg, sn, dn, pending);
+    reset (sg);
+    return 0;
+}
+
+/// how many edges are routed against the same edge weights
+///
+/// This is fixed, rather than depending on the number of threads, so the
+/// routes found do not depend on it either.
+enum { ORTHO_ROUND = 64 };
+
+/// a round of edges routed concurrently
+typedef struct {
+    sgraph** sgs;      ///< search graph of each worker, the maze's own first
+    epair_t* es;       ///< all edges being routed
+    size_t* round;     ///< edges of this round, as indices into es
+    size_t n;          ///< number of edges in this round
+    route* routes;     ///< route found for each edge of this round
+    pending_t* pending; ///< weight updates of each route of this round
+    uint64_t next;     ///< next edge of this round for a worker to take
+    uint64_t failed;   ///< number of searches that failed
+} ortho_round_t;
+
+static void route_job(void *arg, size_t index, size_t worker) {
+    (void)index;
+    ortho_round_t *r = arg;
+    sgraph* sg = r->sgs[worker];
+    /* the caller's queue is already set up for the maze's search graph */
+    if (worker != 0)
+	PQgen (sg->nnodes+2);
+    for (uint64_t i; (i = gv_atomic_add(&r->next, 1) - 1) < r->n; ) {
+	if (findRoute(sg, r->es[r->round[i]].e, &r->routes[i], &r->pending[i]))
+	    gv_atomic_add(&r->failed, 1);
+    }
+    if (worker != 0)
+	PQfree ();
+}
+
+/* routeRounds:
+ * Route the edges in rounds, in the style of negotiated congestion routing.
+ * The edges of a round are routed concurrently, each against the edge weights
+ * left by the rounds before it. The routes are then accepted in order, each
+ * applying its weight updates, unless the updates of routes accepted earlier
+ * in the round have made its path heavier. Such an edge is routed again at the
+ * start of the next round, so the first edge of every round is accepted.
+ * Return non-zero on failure.
+ */
+static int
+routeRounds (sgraph* sg, size_t n_edges, epair_t* es, route* route_list,
+             size_t threads)
+{
+    sgraph** sgs = gv_calloc(threads, sizeof(sgraph*));
+    size_t round[ORTHO_ROUND];
+    route routes[ORTHO_ROUND];
+    pending_t pending[ORTHO_ROUND] = {0};
+    size_t n = 0, next = 0, rounds = 0, rerouted = 0;
+    int rv = 0;
+
+    sgs[0] = sg;
+    for (size_t t = 1; t < threads; t++)
+	sgs[t] = cloneSGraph(sg);
+
+    while (n > 0 || next < n_edges) {
+	/* edges put off from the last round go first */
+	while (n < ORTHO_ROUND && next < n_edges)
+	    round[n++] = next++;
+	for (size_t i = 0; i < n; i++) {
+	    routes[i] = (route){0};
+	    wt_updates_clear(&pending[i].updates);
+	    edge_ids_clear(&pending[i].edges);
+	}
+
+	ortho_round_t r = {.sgs = sgs, .es = es, .round = round, .n = n,
+	                   .routes = routes, .pending = pending};
+	gv_parallel_for(threads, threads, route_job, &r);
+	rounds++;
+	if (r.failed != 0) {
+	    for (size_t i = 0; i < n; i++)
+		free(routes[i].segs);
+	    rv = 1;
+	    break;
+	}
+
+	size_t deferred = 0;
+	for (size_t i = 0; i < n; i++) {
+	    const pending_t *p = &pending[i];
+	    double weight = 0;
+	    for (size_t j = 0; j < edge_ids_size(&p->edges); j++)
+		weight += sg->edges[edge_ids_get(&p->edges, j)].weight;
+	    if (weight > p->weight) {
+		free(routes[i].segs);
+		round[deferred++] = round[i];
+		continue;
+	    }
+	    for (size_t j = 0; j < wt_updates_size(&p->updates); j++) {
+		const wt_update_t u = wt_updates_get(&p->updates, j);
+		updateWts(sg, u.cp, sg->edges + u.edge);
+		/* pass the new weights on to the other workers' copies */
+		for (size_t t = 1; t < threads; t++)
+		    for (int k = 0; k < u.cp->nedges; k++) {
+			const ptrdiff_t idx = u.cp->edges[k] - sg->edges;
+			sgs[t]->edges[idx] = sg->edges[idx];
+		    }
+	    }
+	    route_list[round[i]] = routes[i];
+	}
+	rerouted += deferred;
+	n = deferred;
+    }
+
+    if (Verbose)
+	fprintf(stderr, "orthoEdges: %" PRISIZE_T " edges routed in %" PRISIZE_T
+	        " rounds with %" PRISIZE_T " threads, %" PRISIZE_T
+	        " routed again\n", n_edges, rounds, threads, rerouted);
+
+    for (size_t i = 0; i < ORTHO_ROUND; i++) {
+	wt_updates_free(&pending[i].updates);
+	edge_ids_free(&pending[i].edges);
+    }
+    for (size_t t = 1; t < threads; t++)
+	freeSGraph(sgs[t]);
+    free(sgs);
+    return rv;
+}
+
 /* orthoEdges:
  * For edges without position information, construct an orthogonal routing.
  * If useLbls is true, use edge label info when available to guide routing, 
@@ -1232,16 +1416,10 @@ void orthoEdges(Agraph_t *g, bool useLbls) {
     sgraph* sg;
     maze* mp;
     route* route_list;
-    int gstart;
     Agnode_t* n;
     Agedge_t* e;
-    snode* sn;
-    snode* dn;
     epair_t* es = gv_calloc(agnedges(g), sizeof(epair_t));
-    cell* start;
-    cell* dest;
     PointSet* ps = NULL;
-    textlabel_t* lbl;
 
     if (Concentrate) 
 	ps = newPS();
@@ -1280,8 +1458,13 @@ void orthoEdges(Agraph_t *g, bool useLbls) {
 	agwarningf("Orthogonal edges do not currently handle edge labels. Try using xlabels.\n");
 	useLbls = false;
     }
+    if (Verbose)
+	start_timer();
     mp = mkMaze(g);
     sg = mp->sg;
+    if (Verbose)
+	fprintf(stderr, "orthoEdges: maze of %d cells around %d nodes in %.2f sec\n",
+	        mp->ncells, mp->ngcells, elapsed_sec());
 #ifdef DEBUG
     if (odb_flags & ODB_SGRAPH) emitSearchGraph (stderr, sg);
 #endif
@@ -1313,34 +1496,29 @@ void orthoEdges(Agraph_t *g, bool useLbls) {
 
     qsort(es, n_edges, sizeof(epair_t), edgecmp);
 
-    gstart = sg->nnodes;
+    if (Verbose)
+	start_timer();
     PQgen (sg->nnodes+2);
-    sn = &sg->nodes[gstart];
-    dn = &sg->nodes[gstart+1];
-    for (size_t i = 0; i < n_edges; i++) {
+    const size_t threads = late_threads(g);
+    if (threads > 0) {
+	if (routeRounds(sg, n_edges, es, route_list, threads)) {
+	    PQfree ();
+	    goto orthofinish;
+	}
+    }
+    else for (size_t i = 0; i < n_edges; i++) {
 #ifdef DEBUG
 	if (i > 0 && (odb_flags & ODB_IGRAPH)) emitSearchGraph (stderr, sg);
 #endif
-	e = es[i].e;
-        start = CELL(agtail(e));
-        dest = CELL(aghead(e));
-
-	if (useLbls && (lbl = ED_label(e)) && lbl->set) {
-	}
-	else {
-	    if (start == dest)
-		addLoop (sg, start, dn, sn);
-	    else {
-       		addNodeEdges (sg, dest, dn);
-		addNodeEdges (sg, start, sn);
-	    }
-       	    if (shortPath (sg, dn, sn)) goto orthofinish;
+	if (findRoute(sg, es[i].e, &route_list[i], NULL)) {
+	    PQfree ();
+	    goto orthofinish;
 	}
-	    
-       	route_list[i] = convertSPtoRoute(sg, sn, dn);
-       	reset (sg);
     }
     PQfree ();
+    if (Verbose)
+	fprintf(stderr, "orthoEdges: %" PRISIZE_T " shortest paths in %.2f sec\n",
+	        n_edges, elapsed_sec());
 
     mp->hchans = extractHChans (mp);
     mp->vchans = extractVChans (mp);
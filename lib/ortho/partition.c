@@ -14,8 +14,10 @@
 #include <ortho/trap.h>
 #include <math.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <util/alloc.h>
 #include <util/bitarray.h>
 #include <util/prisize_t.h>
@@ -42,13 +44,6 @@
 #define CROSS_SINE(v0, v1) ((v0).x * (v1).y - (v1).x * (v0).y)
 #define LENGTH(v0) hypot((v0).x, (v0).y)
 
-#ifndef HAVE_SRAND48
-#define srand48 srand
-#endif
-#ifdef _WIN32
-extern double drand48(void);
-#endif
-
 typedef struct {
   int vnum;
   int next;         /* Circularly linked list  */
@@ -63,26 +58,49 @@ typedef struct {
   int nextfree;
 } vertexchain_t;
 
-static int chain_idx, mon_idx;
+/// state of splitting the trapezoids of one decomposition into monotone polygons
+typedef struct {
+  int chain_idx, mon_idx;
 	/* Table to hold all the monotone */
 	/* polygons . Each monotone polygon */
 	/* is a circularly linked list */
-static monchain_t* mchain;
+  monchain_t* mchain;
 	/* chain init. information. This */
 	/* is used to decide which */
 	/* monotone polygon to split if */
 	/* there are several other */
 	/* polygons touching at the same */
 	/* vertex  */
-static vertexchain_t* vert;
+  vertexchain_t* vert;
 	/* contains position of any vertex in */
 	/* the monotone chain for the polygon */
-static int* mon;
+  int* mon;
+} monotone_t;
 
 /* return a new mon structure from the table */
-#define newmon() (++mon_idx)
+#define newmon(m) (++(m)->mon_idx)
 /* return a new chain element from the table */
-#define new_chain_element() (++chain_idx)
+#define new_chain_element(m) (++(m)->chain_idx)
+
+/// @brief generator of the random order in which segments are inserted
+///
+/// This is the linear congruential generator of `drand48`, kept here rather
+/// than shared with the rest of the process, so partitioning neither depends
+/// on nor disturbs other users of `drand48`.
+typedef struct {
+  uint64_t x; ///< 48-bit state
+} rand48_t;
+
+/// `srand48` equivalent
+static rand48_t rand48_seed(uint32_t seed) {
+  return (rand48_t){((uint64_t)seed << 16) | 0x330E};
+}
+
+/// `drand48` equivalent
+static double rand48_next(rand48_t *r) {
+  r->x = (UINT64_C(0x5DEECE66D) * r->x + 0xB) & ((UINT64_C(1) << 48) - 1);
+  return ldexp((double)r->x, -48);
+}
 
 static void
 convert (boxf bb, int flip, int ccw, pointf* pts)
@@ -152,13 +170,13 @@ genSegments (cell* cells, int ncells, boxf bb, segment_t* seg, int flip)
 
 /* Generate a random permutation of the segments 1..n */
 static void 
-generateRandomOrdering(int n, int* permute)
+generateRandomOrdering(rand48_t *rng, int n, int* permute)
 {
     int i, j, tmp;
     for (i = 0; i <= n; i++) permute[i] = i;
 
     for (i = 1; i <= n; i++) {
-	j = i + drand48() * (n + 1 - i);
+	j = i + rand48_next(rng) * (n + 1 - i);
 	if (j != i) {
 	    tmp = permute[i];
 	    permute [i] = permute[j];
@@ -186,7 +204,7 @@ inside_polygon (trap_t *t, segment_t* seg)
 }
 
 static double
-get_angle (pointf *vp0, pointf *vpnext, pointf *vp1)
+get_angle (const pointf *vp0, const pointf *vpnext, const pointf *vp1)
 {
   pointf v0, v1;
   
@@ -205,9 +223,10 @@ get_angle (pointf *vp0, pointf *vpnext, pointf *vp1)
 /* (v0, v1) is the new diagonal to be added to the polygon. Find which */
 /* chain to use and return the positions of v0 and v1 in p and q */ 
 static void
-get_vertex_positions (int v0, int v1, int *ip, int *iq)
+get_vertex_positions (const monotone_t *m, int v0, int v1, int *ip, int *iq)
 {
-  vertexchain_t *vp0, *vp1;
+  const vertexchain_t *vert = m->vert;
+  const vertexchain_t *vp0, *vp1;
   int i;
   double angle, temp;
   int tp = 0, tq = 0;
@@ -257,17 +276,18 @@ get_vertex_positions (int v0, int v1, int *ip, int *iq)
  * two polygons using the diagonal (v0, v1) 
  */
 static int 
-make_new_monotone_poly (int mcur, int v0, int v1)
+make_new_monotone_poly (monotone_t *m, int mcur, int v0, int v1)
 {
   int p, q, ip, iq;
-  int mnew = newmon();
+  int mnew = newmon(m);
   int i, j, nf0, nf1;
   vertexchain_t *vp0, *vp1;
+  monchain_t *mchain = m->mchain;
   
-  vp0 = &vert[v0];
-  vp1 = &vert[v1];
+  vp0 = &m->vert[v0];
+  vp1 = &m->vert[v1];
 
-  get_vertex_positions(v0, v1, &ip, &iq);
+  get_vertex_positions(m, v0, v1, &ip, &iq);
 
   p = vp0->vpos[ip];
   q = vp1->vpos[iq];
@@ -275,8 +295,8 @@ make_new_monotone_poly (int mcur, int v0, int v1)
   /* At this stage, we have got the positions of v0 and v1 in the */
   /* desired chain. Now modify the linked lists */
 
-  i = new_chain_element();	/* for the new list */
-  j = new_chain_element();
+  i = new_chain_element(m);	/* for the new list */
+  j = new_chain_element(m);
 
   mchain[i].vnum = v0;
   mchain[j].vnum = v1;
@@ -309,15 +329,15 @@ make_new_monotone_poly (int mcur, int v0, int v1)
   fprintf(stderr, "next posns = (p, q) = (%d, %d)\n", p, q);
 #endif
 
-  mon[mcur] = p;
-  mon[mnew] = i;
+  m->mon[mcur] = p;
+  m->mon[mnew] = i;
   return mnew;
 }
 
 /* recursively visit all the trapezoids */
-static void traverse_polygon(bitarray_t *visited, boxes_t *decomp,
-                             segment_t *seg, traps_t *tr, int mcur, int trnum,
-                             int from, int flip, int dir) {
+static void traverse_polygon(monotone_t *m, bitarray_t *visited,
+                             boxes_t *decomp, segment_t *seg, traps_t *tr,
+                             int mcur, int trnum, int from, int flip, int dir) {
   trap_t *t;
   int mnew;
   int v0, v1;
@@ -364,24 +384,24 @@ static void traverse_polygon(bitarray_t *visited, boxes_t *decomp,
 	  v1 = t->lseg;
 	  if (from == t->d1)
 	    {
-	      mnew = make_new_monotone_poly(mcur, v1, v0);
-	      traverse_polygon(visited, decomp, seg, tr, mcur, t->d1, trnum, flip, TR_FROM_UP);
-	      traverse_polygon(visited, decomp, seg, tr, mnew, t->d0, trnum, flip, TR_FROM_UP);
+	      mnew = make_new_monotone_poly(m, mcur, v1, v0);
+	      traverse_polygon(m, visited, decomp, seg, tr, mcur, t->d1, trnum, flip, TR_FROM_UP);
+	      traverse_polygon(m, visited, decomp, seg, tr, mnew, t->d0, trnum, flip, TR_FROM_UP);
 	    }
 	  else
 	    {
-	      mnew = make_new_monotone_poly(mcur, v0, v1);
-	      traverse_polygon (visited, decomp, seg, tr, mcur, t->d0, trnum, flip, TR_FROM_UP);
-	      traverse_polygon (visited, decomp, seg, tr, mnew, t->d1, trnum, flip, TR_FROM_UP);
+	      mnew = make_new_monotone_poly(m, mcur, v0, v1);
+	      traverse_polygon(m, visited, decomp, seg, tr, mcur, t->d0, trnum, flip, TR_FROM_UP);
+	      traverse_polygon(m, visited, decomp, seg, tr, mnew, t->d1, trnum, flip, TR_FROM_UP);
 	    }
 	}
       else
 	{
 	  /* Just traverse all neighbours */
-	  traverse_polygon(visited, decomp, seg, tr, mcur, t->u0, trnum, flip, TR_FROM_DN);
-	  traverse_polygon(visited, decomp, seg, tr, mcur, t->u1, trnum, flip, TR_FROM_DN);
-	  traverse_polygon(visited, decomp, seg, tr, mcur, t->d0, trnum, flip, TR_FROM_UP);
-	  traverse_polygon(visited, decomp, seg, tr, mcur, t->d1, trnum, flip, TR_FROM_UP);
+	  traverse_polygon(m, visited, decomp, seg, tr, mcur, t->u0, trnum, flip, TR_FROM_DN);
+	  traverse_polygon(m, visited, decomp, seg, tr, mcur, t->u1, trnum, flip, TR_FROM_DN);
+	  traverse_polygon(m, visited, decomp, seg, tr, mcur, t->d0, trnum, flip, TR_FROM_UP);
+	  traverse_polygon(m, visited, decomp, seg, tr, mcur, t->d1, trnum, flip, TR_FROM_UP);
 	}
     }
   
@@ -393,24 +413,24 @@ static void traverse_polygon(bitarray_t *visited, boxes_t *decomp,
 	  v1 = tr->data[t->u0].rseg;
 	  if (from == t->u1)
 	    {
-	      mnew = make_new_monotone_poly(mcur, v1, v0);
-	      traverse_polygon(visited, decomp, seg, tr, mcur, t->u1, trnum, flip, TR_FROM_DN);
-	      traverse_polygon(visited, decomp, seg, tr, mnew, t->u0, trnum, flip, TR_FROM_DN);
+	      mnew = make_new_monotone_poly(m, mcur, v1, v0);
+	      traverse_polygon(m, visited, decomp, seg, tr, mcur, t->u1, trnum, flip, TR_FROM_DN);
+	      traverse_polygon(m, visited, decomp, seg, tr, mnew, t->u0, trnum, flip, TR_FROM_DN);
 	    }
 	  else
 	    {
-	      mnew = make_new_monotone_poly(mcur, v0, v1);
-	      traverse_polygon(visited, decomp, seg, tr, mcur, t->u0, trnum, flip, TR_FROM_DN);
-	      traverse_polygon(visited, decomp, seg, tr, mnew, t->u1, trnum, flip, TR_FROM_DN);
+	      mnew = make_new_monotone_poly(m, mcur, v0, v1);
+	      traverse_polygon(m, visited, decomp, seg, tr, mcur, t->u0, trnum, flip, TR_FROM_DN);
+	      traverse_polygon(m, visited, decomp, seg, tr, mnew, t->u1, trnum, flip, TR_FROM_DN);
 	    }
 	}
       else
 	{
 	  /* Just traverse all neighbours */
-	  traverse_polygon(visited, decomp, seg, tr, mcur, t->u0, trnum, flip, TR_FROM_DN);
-	  traverse_polygon(visited, decomp, seg, tr, mcur, t->u1, trnum, flip, TR_FROM_DN);
-	  traverse_polygon(visited, decomp, seg, tr, mcur, t->d0, trnum, flip, TR_FROM_UP);
-	  traverse_polygon(visited, decomp, seg, tr, mcur, t->d1, trnum, flip, TR_FROM_UP);
+	  traverse_polygon(m, visited, decomp, seg, tr, mcur, t->u0, trnum, flip, TR_FROM_DN);
+	  traverse_polygon(m, visited, decomp, seg, tr, mcur, t->u1, trnum, flip, TR_FROM_DN);
+	  traverse_polygon(m, visited, decomp, seg, tr, mcur, t->d0, trnum, flip, TR_FROM_UP);
+	  traverse_polygon(m, visited, decomp, seg, tr, mcur, t->d1, trnum, flip, TR_FROM_UP);
 	}
     }
   
@@ -423,19 +443,19 @@ static void traverse_polygon(bitarray_t *visited, boxes_t *decomp,
 	  if ((dir == TR_FROM_DN && t->d1 == from) ||
 	      (dir == TR_FROM_UP && t->u1 == from))
 	    {
-	      mnew = make_new_monotone_poly(mcur, v1, v0);
-	      traverse_polygon(visited, decomp, seg, tr, mcur, t->u1, trnum, flip, TR_FROM_DN);
-	      traverse_polygon(visited, decomp, seg, tr, mcur, t->d1, trnum, flip, TR_FROM_UP);
-	      traverse_polygon(visited, decomp, seg, tr, mnew, t->u0, trnum, flip, TR_FROM_DN);
-	      traverse_polygon(visited, decomp, seg, tr, mnew, t->d0, trnum, flip, TR_FROM_UP);
+	      mnew = make_new_monotone_poly(m, mcur, v1, v0);
+	      traverse_polygon(m, visited, decomp, seg, tr, mcur, t->u1, trnum, flip, TR_FROM_DN);
+	      traverse_polygon(m, visited, decomp, seg, tr, mcur, t->d1, trnum, flip, TR_FROM_UP);
+	      traverse_polygon(m, visited, decomp, seg, tr, mnew, t->u0, trnum, flip, TR_FROM_DN);
+	      traverse_polygon(m, visited, decomp, seg, tr, mnew, t->d0, trnum, flip, TR_FROM_UP);
 	    }
 	  else
 	    {
-	      mnew = make_new_monotone_poly(mcur, v0, v1);
-	      traverse_polygon(visited, decomp, seg, tr, mcur, t->u0, trnum, flip, TR_FROM_DN);
-	      traverse_polygon(visited, decomp, seg, tr, mcur, t->d0, trnum, flip, TR_FROM_UP);
-	      traverse_polygon(visited, decomp, seg, tr, mnew, t->u1, trnum, flip, TR_FROM_DN);
-	      traverse_polygon(visited, decomp, seg, tr, mnew, t->d1, trnum, flip, TR_FROM_UP);
+	      mnew = make_new_monotone_poly(m, mcur, v0, v1);
+	      traverse_polygon(m, visited, decomp, seg, tr, mcur, t->u0, trnum, flip, TR_FROM_DN);
+	      traverse_polygon(m, visited, decomp, seg, tr, mcur, t->d0, trnum, flip, TR_FROM_UP);
+	      traverse_polygon(m, visited, decomp, seg, tr, mnew, t->u1, trnum, flip, TR_FROM_DN);
+	      traverse_polygon(m, visited, decomp, seg, tr, mnew, t->d1, trnum, flip, TR_FROM_UP);
 	    }
 	}
       else			/* only downward cusp */
@@ -447,19 +467,19 @@ static void traverse_polygon(bitarray_t *visited, boxes_t *decomp,
 
 	      if (dir == TR_FROM_UP && t->u0 == from)
 		{
-		  mnew = make_new_monotone_poly(mcur, v1, v0);
-		  traverse_polygon(visited, decomp, seg, tr, mcur, t->u0, trnum, flip, TR_FROM_DN);
-		  traverse_polygon(visited, decomp, seg, tr, mnew, t->d0, trnum, flip, TR_FROM_UP);
-		  traverse_polygon(visited, decomp, seg, tr, mnew, t->u1, trnum, flip, TR_FROM_DN);
-		  traverse_polygon(visited, decomp, seg, tr, mnew, t->d1, trnum, flip, TR_FROM_UP);
+		  mnew = make_new_monotone_poly(m, mcur, v1, v0);
+		  traverse_polygon(m, visited, decomp, seg, tr, mcur, t->u0, trnum, flip, TR_FROM_DN);
+		  traverse_polygon(m, visited, decomp, seg, tr, mnew, t->d0, trnum, flip, TR_FROM_UP);
+		  traverse_polygon(m, visited, decomp, seg, tr, mnew, t->u1, trnum, flip, TR_FROM_DN);
+		  traverse_polygon(m, visited, decomp, seg, tr, mnew, t->d1, trnum, flip, TR_FROM_UP);
 		}
 	      else
 		{
-		  mnew = make_new_monotone_poly(mcur, v0, v1);
-		  traverse_polygon(visited, decomp, seg, tr, mcur, t->u1, trnum, flip, TR_FROM_DN);
-		  traverse_polygon(visited, decomp, seg, tr, mcur, t->d0, trnum, flip, TR_FROM_UP);
-		  traverse_polygon(visited, decomp, seg, tr, mcur, t->d1, trnum, flip, TR_FROM_UP);
-		  traverse_polygon(visited, decomp, seg, tr, mnew, t->u0, trnum, flip, TR_FROM_DN);
+		  mnew = make_new_monotone_poly(m, mcur, v0, v1);
+		  traverse_polygon(m, visited, decomp, seg, tr, mcur, t->u1, trnum, flip, TR_FROM_DN);
+		  traverse_polygon(m, visited, decomp, seg, tr, mcur, t->d0, trnum, flip, TR_FROM_UP);
+		  traverse_polygon(m, visited, decomp, seg, tr, mcur, t->d1, trnum, flip, TR_FROM_UP);
+		  traverse_polygon(m, visited, decomp, seg, tr, mnew, t->u0, trnum, flip, TR_FROM_DN);
 		}
 	    }
 	  else
@@ -468,19 +488,19 @@ static void traverse_polygon(bitarray_t *visited, boxes_t *decomp,
 	      v1 = tr->data[t->u0].rseg;	
 	      if (dir == TR_FROM_UP && t->u1 == from)
 		{
-		  mnew = make_new_monotone_poly(mcur, v1, v0);
-		  traverse_polygon(visited, decomp, seg, tr, mcur, t->u1, trnum, flip, TR_FROM_DN);
-		  traverse_polygon(visited, decomp, seg, tr, mnew, t->d1, trnum, flip, TR_FROM_UP);
-		  traverse_polygon(visited, decomp, seg, tr, mnew, t->d0, trnum, flip, TR_FROM_UP);
-		  traverse_polygon(visited, decomp, seg, tr, mnew, t->u0, trnum, flip, TR_FROM_DN);
+		  mnew = make_new_monotone_poly(m, mcur, v1, v0);
+		  traverse_polygon(m, visited, decomp, seg, tr, mcur, t->u1, trnum, flip, TR_FROM_DN);
+		  traverse_polygon(m, visited, decomp, seg, tr, mnew, t->d1, trnum, flip, TR_FROM_UP);
+		  traverse_polygon(m, visited, decomp, seg, tr, mnew, t->d0, trnum, flip, TR_FROM_UP);
+		  traverse_polygon(m, visited, decomp, seg, tr, mnew, t->u0, trnum, flip, TR_FROM_DN);
 		}
 	      else
 		{
-		  mnew = make_new_monotone_poly(mcur, v0, v1);
-		  traverse_polygon(visited, decomp, seg, tr, mcur, t->u0, trnum, flip, TR_FROM_DN);
-		  traverse_polygon(visited, decomp, seg, tr, mcur, t->d0, trnum, flip, TR_FROM_UP);
-		  traverse_polygon(visited, decomp, seg, tr, mcur, t->d1, trnum, flip, TR_FROM_UP);
-		  traverse_polygon(visited, decomp, seg, tr, mnew, t->u1, trnum, flip, TR_FROM_DN);
+		  mnew = make_new_monotone_poly(m, mcur, v0, v1);
+		  traverse_polygon(m, visited, decomp, seg, tr, mcur, t->u0, trnum, flip, TR_FROM_DN);
+		  traverse_polygon(m, visited, decomp, seg, tr, mcur, t->d0, trnum, flip, TR_FROM_UP);
+		  traverse_polygon(m, visited, decomp, seg, tr, mcur, t->d1, trnum, flip, TR_FROM_UP);
+		  traverse_polygon(m, visited, decomp, seg, tr, mnew, t->u1, trnum, flip, TR_FROM_DN);
 		}
 	    }
 	}
@@ -495,19 +515,19 @@ static void traverse_polygon(bitarray_t *visited, boxes_t *decomp,
 	      v1 = t->lseg;
 	      if (!(dir == TR_FROM_DN && t->d0 == from))
 		{
-		  mnew = make_new_monotone_poly(mcur, v1, v0);
-		  traverse_polygon(visited, decomp, seg, tr, mcur, t->u1, trnum, flip, TR_FROM_DN);
-		  traverse_polygon(visited, decomp, seg, tr, mcur, t->d1, trnum, flip, TR_FROM_UP);
-		  traverse_polygon(visited, decomp, seg, tr, mcur, t->u0, trnum, flip, TR_FROM_DN);
-		  traverse_polygon(visited, decomp, seg, tr, mnew, t->d0, trnum, flip, TR_FROM_UP);
+		  mnew = make_new_monotone_poly(m, mcur, v1, v0);
+		  traverse_polygon(m, visited, decomp, seg, tr, mcur, t->u1, trnum, flip, TR_FROM_DN);
+		  traverse_polygon(m, visited, decomp, seg, tr, mcur, t->d1, trnum, flip, TR_FROM_UP);
+		  traverse_polygon(m, visited, decomp, seg, tr, mcur, t->u0, trnum, flip, TR_FROM_DN);
+		  traverse_polygon(m, visited, decomp, seg, tr, mnew, t->d0, trnum, flip, TR_FROM_UP);
 		}
 	      else
 		{
-		  mnew = make_new_monotone_poly(mcur, v0, v1);
-		  traverse_polygon(visited, decomp, seg, tr, mcur, t->d0, trnum, flip, TR_FROM_UP);
-		  traverse_polygon(visited, decomp, seg, tr, mnew, t->u0, trnum, flip, TR_FROM_DN);
-		  traverse_polygon(visited, decomp, seg, tr, mnew, t->u1, trnum, flip, TR_FROM_DN);
-		  traverse_polygon(visited, decomp, seg, tr, mnew, t->d1, trnum, flip, TR_FROM_UP);
+		  mnew = make_new_monotone_poly(m, mcur, v0, v1);
+		  traverse_polygon(m, visited, decomp, seg, tr, mcur, t->d0, trnum, flip, TR_FROM_UP);
+		  traverse_polygon(m, visited, decomp, seg, tr, mnew, t->u0, trnum, flip, TR_FROM_DN);
+		  traverse_polygon(m, visited, decomp, seg, tr, mnew, t->u1, trnum, flip, TR_FROM_DN);
+		  traverse_polygon(m, visited, decomp, seg, tr, mnew, t->d1, trnum, flip, TR_FROM_UP);
 		}
 	    }
 	  else
@@ -517,19 +537,19 @@ static void traverse_polygon(bitarray_t *visited, boxes_t *decomp,
 
 	      if (dir == TR_FROM_DN && t->d1 == from)
 		{
-		  mnew = make_new_monotone_poly(mcur, v1, v0);
-		  traverse_polygon(visited, decomp, seg, tr, mcur, t->d1, trnum, flip, TR_FROM_UP);
-		  traverse_polygon(visited, decomp, seg, tr, mnew, t->u1, trnum, flip, TR_FROM_DN);
-		  traverse_polygon(visited, decomp, seg, tr, mnew, t->u0, trnum, flip, TR_FROM_DN);
-		  traverse_polygon(visited, decomp, seg, tr, mnew, t->d0, trnum, flip, TR_FROM_UP);
+		  mnew = make_new_monotone_poly(m, mcur, v1, v0);
+		  traverse_polygon(m, visited, decomp, seg, tr, mcur, t->d1, trnum, flip, TR_FROM_UP);
+		  traverse_polygon(m, visited, decomp, seg, tr, mnew, t->u1, trnum, flip, TR_FROM_DN);
+		  traverse_polygon(m, visited, decomp, seg, tr, mnew, t->u0, trnum, flip, TR_FROM_DN);
+		  traverse_polygon(m, visited, decomp, seg, tr, mnew, t->d0, trnum, flip, TR_FROM_UP);
 		}
 	      else
 		{
-		  mnew = make_new_monotone_poly(mcur, v0, v1);
-		  traverse_polygon(visited, decomp, seg, tr, mcur, t->u0, trnum, flip, TR_FROM_DN);
-		  traverse_polygon(visited, decomp, seg, tr, mcur, t->d0, trnum, flip, TR_FROM_UP);
-		  traverse_polygon(visited, decomp, seg, tr, mcur, t->u1, trnum, flip, TR_FROM_DN);
-		  traverse_polygon(visited, decomp, seg, tr, mnew, t->d1, trnum, flip, TR_FROM_UP);
+		  mnew = make_new_monotone_poly(m, mcur, v0, v1);
+		  traverse_polygon(m, visited, decomp, seg, tr, mcur, t->u0, trnum, flip, TR_FROM_DN);
+		  traverse_polygon(m, visited, decomp, seg, tr, mcur, t->d0, trnum, flip, TR_FROM_UP);
+		  traverse_polygon(m, visited, decomp, seg, tr, mcur, t->u1, trnum, flip, TR_FROM_DN);
+		  traverse_polygon(m, visited, decomp, seg, tr, mnew, t->d1, trnum, flip, TR_FROM_UP);
 		}
 	    }
 	}
@@ -542,19 +562,19 @@ static void traverse_polygon(bitarray_t *visited, boxes_t *decomp,
 	      v1 = t->lseg;
 	      if (dir == TR_FROM_UP)
 		{
-		  mnew = make_new_monotone_poly(mcur, v1, v0);
-		  traverse_polygon(visited, decomp, seg, tr, mcur, t->u0, trnum, flip, TR_FROM_DN);
-		  traverse_polygon(visited, decomp, seg, tr, mcur, t->u1, trnum, flip, TR_FROM_DN);
-		  traverse_polygon(visited, decomp, seg, tr, mnew, t->d1, trnum, flip, TR_FROM_UP);
-		  traverse_polygon(visited, decomp, seg, tr, mnew, t->d0, trnum, flip, TR_FROM_UP);
+		  mnew = make_new_monotone_poly(m, mcur, v1, v0);
+		  traverse_polygon(m, visited, decomp, seg, tr, mcur, t->u0, trnum, flip, TR_FROM_DN);
+		  traverse_polygon(m, visited, decomp, seg, tr, mcur, t->u1, trnum, flip, TR_FROM_DN);
+		  traverse_polygon(m, visited, decomp, seg, tr, mnew, t->d1, trnum, flip, TR_FROM_UP);
+		  traverse_polygon(m, visited, decomp, seg, tr, mnew, t->d0, trnum, flip, TR_FROM_UP);
 		}
 	      else
 		{
-		  mnew = make_new_monotone_poly(mcur, v0, v1);
-		  traverse_polygon(visited, decomp, seg, tr, mcur, t->d1, trnum, flip, TR_FROM_UP);
-		  traverse_polygon(visited, decomp, seg, tr, mcur, t->d0, trnum, flip, TR_FROM_UP);
-		  traverse_polygon(visited, decomp, seg, tr, mnew, t->u0, trnum, flip, TR_FROM_DN);
-		  traverse_polygon(visited, decomp, seg, tr, mnew, t->u1, trnum, flip, TR_FROM_DN);
+		  mnew = make_new_monotone_poly(m, mcur, v0, v1);
+		  traverse_polygon(m, visited, decomp, seg, tr, mcur, t->d1, trnum, flip, TR_FROM_UP);
+		  traverse_polygon(m, visited, decomp, seg, tr, mcur, t->d0, trnum, flip, TR_FROM_UP);
+		  traverse_polygon(m, visited, decomp, seg, tr, mnew, t->u0, trnum, flip, TR_FROM_DN);
+		  traverse_polygon(m, visited, decomp, seg, tr, mnew, t->u1, trnum, flip, TR_FROM_DN);
 		}
 	    }
 	  else if (_equal_to(&t->hi, &seg[t->rseg].v1) &&
@@ -565,27 +585,27 @@ static void traverse_polygon(bitarray_t *visited, boxes_t *decomp,
 
 	      if (dir == TR_FROM_UP)
 		{
-		  mnew = make_new_monotone_poly(mcur, v1, v0);
-		  traverse_polygon(visited, decomp, seg, tr, mcur, t->u0, trnum, flip, TR_FROM_DN);
-		  traverse_polygon(visited, decomp, seg, tr, mcur, t->u1, trnum, flip, TR_FROM_DN);
-		  traverse_polygon(visited, decomp, seg, tr, mnew, t->d1, trnum, flip, TR_FROM_UP);
-		  traverse_polygon(visited, decomp, seg, tr, mnew, t->d0, trnum, flip, TR_FROM_UP);
+		  mnew = make_new_monotone_poly(m, mcur, v1, v0);
+		  traverse_polygon(m, visited, decomp, seg, tr, mcur, t->u0, trnum, flip, TR_FROM_DN);
+		  traverse_polygon(m, visited, decomp, seg, tr, mcur, t->u1, trnum, flip, TR_FROM_DN);
+		  traverse_polygon(m, visited, decomp, seg, tr, mnew, t->d1, trnum, flip, TR_FROM_UP);
+		  traverse_polygon(m, visited, decomp, seg, tr, mnew, t->d0, trnum, flip, TR_FROM_UP);
 		}
 	      else
 		{
-		  mnew = make_new_monotone_poly(mcur, v0, v1);
-		  traverse_polygon(visited, decomp, seg, tr, mcur, t->d1, trnum, flip, TR_FROM_UP);
-		  traverse_polygon(visited, decomp, seg, tr, mcur, t->d0, trnum, flip, TR_FROM_UP);
-		  traverse_polygon(visited, decomp, seg, tr, mnew, t->u0, trnum, flip, TR_FROM_DN);
-		  traverse_polygon(visited, decomp, seg, tr, mnew, t->u1, trnum, flip, TR_FROM_DN);
+		  mnew = make_new_monotone_poly(m, mcur, v0, v1);
+		  traverse_polygon(m, visited, decomp, seg, tr, mcur, t->d1, trnum, flip, TR_FROM_UP);
+		  traverse_polygon(m, visited, decomp, seg, tr, mcur, t->d0, trnum, flip, TR_FROM_UP);
+		  traverse_polygon(m, visited, decomp, seg, tr, mnew, t->u0, trnum, flip, TR_FROM_DN);
+		  traverse_polygon(m, visited, decomp, seg, tr, mnew, t->u1, trnum, flip, TR_FROM_DN);
 		}
 	    }
 	  else			/* no split possible */
 	    {
-	      traverse_polygon(visited, decomp, seg, tr, mcur, t->u0, trnum, flip, TR_FROM_DN);
-	      traverse_polygon(visited, decomp, seg, tr, mcur, t->d0, trnum, flip, TR_FROM_UP);
-	      traverse_polygon(visited, decomp, seg, tr, mcur, t->u1, trnum, flip, TR_FROM_DN);
-	      traverse_polygon(visited, decomp, seg, tr, mcur, t->d1, trnum, flip, TR_FROM_UP);
+	      traverse_polygon(m, visited, decomp, seg, tr, mcur, t->u0, trnum, flip, TR_FROM_DN);
+	      traverse_polygon(m, visited, decomp, seg, tr, mcur, t->d0, trnum, flip, TR_FROM_UP);
+	      traverse_polygon(m, visited, decomp, seg, tr, mcur, t->u1, trnum, flip, TR_FROM_DN);
+	      traverse_polygon(m, visited, decomp, seg, tr, mcur, t->d1, trnum, flip, TR_FROM_UP);
 	    }
 	}
     }
@@ -597,10 +617,13 @@ monotonate_trapezoids(int nsegs, segment_t *seg, traps_t *tr,
     int i;
     int tr_start;
     bitarray_t visited = bitarray_new(tr->length);
+    monotone_t m = {0};
 
-    mchain = gv_calloc(tr->length, sizeof(monchain_t));
-    vert = gv_calloc(nsegs + 1, sizeof(vertexchain_t));
-    mon = gv_calloc(nsegs, sizeof(int));
+    m.mchain = gv_calloc(tr->length, sizeof(monchain_t));
+    m.vert = gv_calloc(nsegs + 1, sizeof(vertexchain_t));
+    m.mon = gv_calloc(nsegs, sizeof(int));
+    monchain_t *mchain = m.mchain;
+    vertexchain_t *vert = m.vert;
 
   /* First locate a trapezoid which lies inside the polygon */
   /* and which is triangular */
@@ -621,23 +644,23 @@ monotonate_trapezoids(int nsegs, segment_t *seg, traps_t *tr,
 	vert[i].nextfree = 1;
     }
 
-    chain_idx = nsegs;
-    mon_idx = 0;
-    mon[0] = 1;			/* position of any vertex in the first */
+    m.chain_idx = nsegs;
+    m.mon_idx = 0;
+    m.mon[0] = 1;			/* position of any vertex in the first */
 				/* chain  */
   
   /* traverse the polygon */
     if (tr->data[tr_start].u0 > 0)
-	traverse_polygon(&visited, decomp, seg, tr, 0, tr_start,
+	traverse_polygon(&m, &visited, decomp, seg, tr, 0, tr_start,
 	                 tr->data[tr_start].u0, flip, TR_FROM_UP);
     else if (tr->data[tr_start].d0 > 0)
-	traverse_polygon(&visited, decomp, seg, tr, 0, tr_start,
+	traverse_polygon(&m, &visited, decomp, seg, tr, 0, tr_start,
 	                 tr->data[tr_start].d0, flip, TR_FROM_DN);
   
     bitarray_reset(&visited);
-    free (mchain);
-    free (vert);
-    free (mon);
+    free (m.mchain);
+    free (m.vert);
+    free (m.mon);
 }
 
 static bool rectIntersect(boxf *d, const boxf r0, const boxf r1) {
@@ -652,6 +675,148 @@ static bool rectIntersect(boxf *d, const boxf r0, const boxf r1) {
     return !(d->LL.x >= d->UR.x || d->LL.y >= d->UR.y);
 }
 
+/// a tile of the vertical decomposition meeting one of the horizontal
+typedef struct {
+    size_t v, h;
+} tile_pair_t;
+
+DEFINE_LIST(tile_pairs, tile_pair_t)
+
+static int paircmp(const tile_pair_t *a, const tile_pair_t *b) {
+    if (a->v != b->v)
+	return a->v < b->v ? -1 : 1;
+    if (a->h != b->h)
+	return a->h < b->h ? -1 : 1;
+    return 0;
+}
+
+/// a box of a decomposition with the coordinate it is swept by
+typedef struct {
+    double key;
+    size_t index;
+} sweep_item_t;
+
+static int sweepcmp(const void *x, const void *y) {
+    const sweep_item_t *a = x;
+    const sweep_item_t *b = y;
+    if (a->key != b->key)
+	return a->key < b->key ? -1 : 1;
+    if (a->index != b->index)
+	return a->index < b->index ? -1 : 1;
+    return 0;
+}
+
+static double left_x(boxf b) { return b.LL.x; }
+static double right_x(boxf b) { return b.UR.x; }
+static double mid_x(boxf b) { return (b.LL.x + b.UR.x) / 2; }
+
+/// sort boxes by the given coordinate
+static sweep_item_t *sortBoxes(const boxes_t *bs, double (*key)(boxf)) {
+    sweep_item_t *order = gv_calloc(boxes_size(bs), sizeof(sweep_item_t));
+    for (size_t i = 0; i < boxes_size(bs); ++i)
+	order[i] = (sweep_item_t){key(boxes_get(bs, i)), i};
+    qsort(order, boxes_size(bs), sizeof(sweep_item_t), sweepcmp);
+    return order;
+}
+
+/// position in `active`, ordered by bottom and then index, of the first
+/// horizontal tile not before `LL.y`, `h`
+static size_t findActive(const boxes_t *hor, const size_t *active, size_t n,
+                         double y, size_t h) {
+    size_t lo = 0, hi = n;
+    while (lo < hi) {
+	const size_t mid = lo + (hi - lo) / 2;
+	const double my = boxes_get(hor, active[mid]).LL.y;
+	if (my < y || (my == y && active[mid] < h))
+	    lo = mid + 1;
+	else
+	    hi = mid;
+    }
+    return lo;
+}
+
+/* intersectDecomps:
+ * Intersect the tiles of the vertical decomposition with those of the
+ * horizontal one. A horizontal tile runs between the obstacles on its left
+ * and right, so any horizontal tile meeting a vertical tile spans its width
+ * and contains the middle of it. Sweeping left to right, the horizontal tiles
+ * containing the current position are kept ordered by height, and each
+ * vertical tile is only tested against those overlapping it vertically.
+ * The result is in the same order as testing every pair would give.
+ */
+static boxes_t intersectDecomps(const boxes_t *vert, const boxes_t *hor) {
+    const size_t nv = boxes_size(vert);
+    const size_t nh = boxes_size(hor);
+    boxes_t rs = {0};
+    if (nv == 0 || nh == 0)
+	return rs;
+
+    sweep_item_t *by_mid = sortBoxes(vert, mid_x);
+    sweep_item_t *by_left = sortBoxes(hor, left_x);
+    sweep_item_t *by_right = sortBoxes(hor, right_x);
+    size_t *active = gv_calloc(nh, sizeof(size_t));
+    size_t nactive = 0;
+    size_t left = 0, right = 0;
+    tile_pairs_t pairs = {0};
+
+    for (size_t k = 0; k < nv; ++k) {
+	const size_t v = by_mid[k].index;
+	const boxf vb = boxes_get(vert, v);
+	const double mx = by_mid[k].key;
+
+	/* add the tiles starting before the middle of vb, then drop those
+	 * ending by it
+	 */
+	for (; left < nh && by_left[left].key < mx; ++left) {
+	    const size_t h = by_left[left].index;
+	    const size_t at = findActive(hor, active, nactive,
+	                                 boxes_get(hor, h).LL.y, h);
+	    memmove(active + at + 1, active + at,
+	            (nactive - at) * sizeof(size_t));
+	    active[at] = h;
+	    ++nactive;
+	}
+	for (; right < nh && by_right[right].key <= mx; ++right) {
+	    const size_t h = by_right[right].index;
+	    const size_t at = findActive(hor, active, nactive,
+	                                 boxes_get(hor, h).LL.y, h);
+	    if (at < nactive && active[at] == h) {
+		memmove(active + at, active + at + 1,
+		        (nactive - at - 1) * sizeof(size_t));
+		--nactive;
+	    }
+	}
+
+	/* the active tiles do not overlap, so only the one below the first
+	 * starting at or above the bottom of vb can reach into it from below
+	 */
+	size_t at = findActive(hor, active, nactive, vb.LL.y, 0);
+	if (at > 0)
+	    --at;
+	for (; at < nactive && boxes_get(hor, active[at]).LL.y < vb.UR.y; ++at) {
+	    boxf newbox;
+	    if (!rectIntersect(&newbox, vb, boxes_get(hor, active[at])))
+		continue;
+	    tile_pairs_append(&pairs, (tile_pair_t){v, active[at]});
+	}
+    }
+
+    tile_pairs_sort(&pairs, paircmp);
+    for (size_t i = 0; i < tile_pairs_size(&pairs); ++i) {
+	const tile_pair_t p = tile_pairs_get(&pairs, i);
+	boxf newbox = {0};
+	rectIntersect(&newbox, boxes_get(vert, p.v), boxes_get(hor, p.h));
+	boxes_append(&rs, newbox);
+    }
+
+    tile_pairs_free(&pairs);
+    free(active);
+    free(by_right);
+    free(by_left);
+    free(by_mid);
+    return rs;
+}
+
 #if DEBUG > 1
 static void
 dumpTrap (trap_t* tr, int n)
@@ -699,8 +864,8 @@ boxf *partition(cell *cells, int ncells, size_t *nrects, boxf bb) {
 	    if (i%4 == 0) fprintf(stderr, "\n");
 	}
     }
-    srand48(173);
-    generateRandomOrdering (nsegs, permute);
+    rand48_t rng = rand48_seed(173);
+    generateRandomOrdering (&rng, nsegs, permute);
     traps_t hor_traps = construct_trapezoids(nsegs, segs, permute);
     if (DEBUG) {
 	fprintf (stderr, "hor traps = %" PRISIZE_T "\n", hor_traps.length);
@@ -710,7 +875,7 @@ boxf *partition(cell *cells, int ncells, size_t *nrects, boxf bb) {
     free(hor_traps.data);
 
     genSegments (cells, ncells, bb, segs, 1);
-    generateRandomOrdering (nsegs, permute);
+    generateRandomOrdering (&rng, nsegs, permute);
     traps_t ver_traps = construct_trapezoids(nsegs, segs, permute);
     if (DEBUG) {
 	fprintf (stderr, "ver traps = %" PRISIZE_T "\n", ver_traps.length);
@@ -719,14 +884,7 @@ boxf *partition(cell *cells, int ncells, size_t *nrects, boxf bb) {
     monotonate_trapezoids(nsegs, segs, &ver_traps, 1, &vert_decomp);
     free(ver_traps.data);
 
-    boxes_t rs = {0};
-    for (size_t i = 0; i < boxes_size(&vert_decomp); ++i)
-	for (size_t j = 0; j < boxes_size(&hor_decomp); ++j) {
-	    boxf newbox = {0};
-	    if (rectIntersect(&newbox, boxes_get(&vert_decomp, i),
-	                      boxes_get(&hor_decomp, j)))
-		boxes_append(&rs, newbox);
-	}
+    boxes_t rs = intersectDecomps(&vert_decomp, &hor_decomp);
 
     free (segs);
     free (permute);
@@ -10,7 +10,9 @@
 
 
 #include "config.h"
-#include <limits.h>
+#include <float.h>
+#include <math.h>
+#include <string.h>
 #include <ortho/sgraph.h>
 #include <ortho/fPQ.h>
 #include <util/alloc.h>
@@ -25,16 +27,22 @@ gsave (sgraph* G)
 	G->nodes[i].save_n_adj =  G->nodes[i].n_adj;
 }
 
+/* Restore the graph to the state saved by gsave, dropping the
+ * temporary nodes and edges added since. Only the nodes at the ends of
+ * the dropped edges have changed, so only these are visited.
+ */
 void 
 reset(sgraph* G)
 {
     int i;
+    for (i = G->save_nedges; i < G->nedges; i++) {
+	snode* v1 = &G->nodes[G->edges[i].v1];
+	snode* v2 = &G->nodes[G->edges[i].v2];
+	v1->n_adj = v1->save_n_adj;
+	v2->n_adj = v2->save_n_adj;
+    }
     G->nnodes = G->save_nnodes;
     G->nedges = G->save_nedges;
-    for (i = 0; i < G->nnodes; i++)
-	G->nodes[i].n_adj = G->nodes[i].save_n_adj;
-    for (; i < G->nnodes+2; i++)
-	G->nodes[i].n_adj = 0;
 }
 
 void
@@ -42,7 +50,9 @@ initSEdges (sgraph* g, int maxdeg)
 {
     int i;
     int* adj = gv_calloc(6 * g->nnodes + 2 * maxdeg, sizeof(int));
-    g->edges = gv_calloc(3 * g->nnodes + maxdeg, sizeof(sedge));
+    g->maxdeg = maxdeg;
+    /* the 2 temporary nodes have up to maxdeg edges each */
+    g->edges = gv_calloc(3 * g->nnodes + 2 * maxdeg, sizeof(sedge));
     for (i = 0; i < g->nnodes; i++) {
 	g->nodes[i].adj_edge_list = adj;
 	adj += 6;
@@ -107,29 +117,52 @@ freeSGraph (sgraph* g)
     free (g);
 }
 
+/* Copy a graph saved by gsave, with no temporary nodes or edges, so it
+ * can be searched by another thread.
+ */
+sgraph*
+cloneSGraph (const sgraph* g)
+{
+    const int nadj = 6 * g->nnodes + 2 * g->maxdeg;
+    const int nedges = 3 * g->nnodes + 2 * g->maxdeg;
+    sgraph* copy = gv_alloc(sizeof(sgraph));
+    int* adj = gv_calloc(nadj, sizeof(int));
+
+    *copy = *g;
+    copy->nodes = gv_calloc(g->nnodes + 2, sizeof(snode));
+    memcpy(copy->nodes, g->nodes, (g->nnodes + 2) * sizeof(snode));
+    memcpy(adj, g->nodes[0].adj_edge_list, nadj * sizeof(int));
+    for (int i = 0; i < g->nnodes + 2; i++)
+	copy->nodes[i].adj_edge_list =
+	    adj + (g->nodes[i].adj_edge_list - g->nodes[0].adj_edge_list);
+    copy->edges = gv_calloc(nedges, sizeof(sedge));
+    memcpy(copy->edges, g->edges, g->nedges * sizeof(sedge));
+    return copy;
+}
+
 #include <ortho/fPQ.h>
 
 /* shortest path:
  * Constructs the path of least weight between from and to.
- * 
- * Assumes graph, node and edge type, and that nodes
- * have associated values N_VAL, N_IDX, and N_DAD, the first two
- * being ints, the last being a node*. Edges have a E_WT function 
- * to specify the edge length or weight.
- * 
- * Assumes there are functions:
- *  agnnodes: graph -> int           number of nodes in the graph
- *  agfstnode, agnxtnode : iterators over the nodes in the graph
- *  agfstedge, agnxtedge : iterators over the edges attached to a node
- *  adjacentNode : given an edge e and an endpoint n of e, returns the
- *                 other endpoint.
- * 
+ *
+ * This is an A* search: nodes are taken from the queue in order of the
+ * weight of the path found to them plus a lower bound on the weight from
+ * them to to. The bound is g->dist_wt times the Manhattan distance from
+ * the end of the node's segment to the region of to, which is the
+ * bounding box of the segment ends of its neighbors when to is one of the
+ * temporary nodes added for a cell. As g->dist_wt is no more than the
+ * weight of any edge per unit of distance between its nodes, the bound
+ * never increases by more than the weight of the edge crossed, so a node
+ * is never reached by a lighter path after it has been taken from the
+ * queue.
+ *
+ * Node state belongs to the search whose number is in N_GEN, so
+ * nothing need be cleared between searches.
+ *
  * The path is given by
  *  to, N_DAD(to), N_DAD(N_DAD(to)), ..., from
  */
 
-#define UNSEEN INT_MIN
-
 static snode*
 adjacentNode(sgraph* g, sedge* e, snode* n)
 {
@@ -139,55 +172,81 @@ adjacentNode(sgraph* g, sedge* e, snode* n)
 	return &g->nodes[e->v1];
 }
 
+/// region that every path to `to` ends in, or no region if it has no end
+static bool goalRegion(sgraph *g, snode *to, boxf *bb) {
+    if (to->index < g->save_nnodes) {
+	bb->LL = bb->UR = to->p;
+	return true;
+    }
+    if (to->n_adj == 0)
+	return false;
+    *bb = (boxf){.LL = {.x = DBL_MAX, .y = DBL_MAX},
+                 .UR = {.x = -DBL_MAX, .y = -DBL_MAX}};
+    for (int y = 0; y < to->n_adj; y++) {
+	const pointf p = adjacentNode(g, &g->edges[to->adj_edge_list[y]], to)->p;
+	bb->LL.x = fmin(bb->LL.x, p.x);
+	bb->LL.y = fmin(bb->LL.y, p.y);
+	bb->UR.x = fmax(bb->UR.x, p.x);
+	bb->UR.y = fmax(bb->UR.y, p.y);
+    }
+    return true;
+}
+
+/// lower bound on the weight of a path from `n` to the region `bb`
+static double lowerBound(sgraph *g, double wt, const boxf *bb, const snode *n) {
+    if (n->index >= g->save_nnodes) /* temporary nodes have no segment */
+	return 0;
+    const double dx = fmax(0, fmax(bb->LL.x - n->p.x, n->p.x - bb->UR.x));
+    const double dy = fmax(0, fmax(bb->LL.y - n->p.y, n->p.y - bb->UR.y));
+    return wt * (dx + dy);
+}
+
 int
 shortPath (sgraph* g, snode* from, snode* to)
 {
     snode* n;
     sedge* e;
     snode* adjn;
-    int d;
-    int   x, y;
+    double d;
+    int   y;
+    boxf bb = {0};
+    const double wt = goalRegion(g, to, &bb) ? g->dist_wt : 0;
+    const unsigned gen = ++g->gen;
 
-    for (x = 0; x<g->nnodes; x++) {
-	snode* temp = &g->nodes[x];
-	N_VAL(temp) = UNSEEN;
-    }
-    
     PQinit();
-    if (PQ_insert (from)) return 1;
     N_DAD(from) = NULL;
     N_VAL(from) = 0;
+    N_EST(from) = lowerBound(g, wt, &bb, from);
+    N_GEN(from) = gen;
+    if (PQ_insert (from)) return 1;
     
     while ((n = PQremove())) {
 #ifdef DEBUG
 	fprintf (stderr, "process %d\n", n->index);
 #endif
-	N_VAL(n) *= -1;
 	if (n == to) break;
 	for (y=0; y<n->n_adj; y++) {
 	    e = &g->edges[n->adj_edge_list[y]];
 	    adjn = adjacentNode(g, e, n);
-	    if (N_VAL(adjn) < 0) {
-		d = -(N_VAL(n) + E_WT(e));
-		if (N_VAL(adjn) == UNSEEN) {
+	    d = N_VAL(n) + E_WT(e);
+	    if (N_GEN(adjn) != gen) {
 #ifdef DEBUG
-		    fprintf (stderr, "new %d (%d)\n", adjn->index, -d);
+		fprintf (stderr, "new %d (%f)\n", adjn->index, d);
 #endif
-		    N_VAL(adjn) = d;
-		    if (PQ_insert(adjn)) return 1;
-		    N_DAD(adjn) = n;
-		    N_EDGE(adjn) = e;
-            	}
-		else {
-		    if (N_VAL(adjn) < d) {
+		N_GEN(adjn) = gen;
+		N_VAL(adjn) = d;
+		N_EST(adjn) = d + lowerBound(g, wt, &bb, adjn);
+		if (PQ_insert(adjn)) return 1;
+		N_DAD(adjn) = n;
+		N_EDGE(adjn) = e;
+	    }
+	    else if (N_IDX(adjn) != 0 && d < N_VAL(adjn)) {
 #ifdef DEBUG
-			fprintf (stderr, "adjust %d (%d)\n", adjn->index, -d);
+		fprintf (stderr, "adjust %d (%f)\n", adjn->index, d);
 #endif
-			PQupdate(adjn, d);
-			N_DAD(adjn) = n;
-			N_EDGE(adjn) = e;
-		    }
-		}
+		PQupdate(adjn, d);
+		N_DAD(adjn) = n;
+		N_EDGE(adjn) = e;
 	    }
 	}
     }
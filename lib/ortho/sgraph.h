@@ -24,7 +24,10 @@ typedef struct sedge sedge;
  */
 
 struct snode {
-  int n_val, n_idx;
+  double n_val; ///< weight of the least path found to this node so far
+  double n_est; ///< n_val plus a lower bound on the weight still to go
+  int n_idx;    ///< position in the priority queue, 0 once removed from it
+  unsigned n_gen; ///< search in which this node was last reached
   snode* n_dad;
   sedge* n_edge;
   short   n_adj;
@@ -37,6 +40,7 @@ struct snode {
   int* adj_edge_list;
   int index;
   bool isVert;  /* true if node corresponds to vertical segment */
+  pointf p; ///< lower or left end of the segment, common to both cells
 };
 
 struct sedge {
@@ -53,12 +57,18 @@ typedef struct {
   int save_nnodes, save_nedges;
   snode* nodes;
   sedge* edges;
+  /// least weight of an edge per unit of Manhattan distance between the ends
+  /// of its nodes, used to bound the weight of a path from below
+  double dist_wt;
+  unsigned gen; ///< number of searches done so far
+  int maxdeg;   ///< most edges of either temporary node
 } sgraph;
 
 extern void reset(sgraph*);
 extern void gsave(sgraph*);
 extern sgraph* createSGraph(int);
 extern void freeSGraph (sgraph*);
+extern sgraph* cloneSGraph (const sgraph*);
 extern void initSEdges (sgraph* g, int maxdeg);
 extern int shortPath (sgraph* g, snode* from, snode* to);
 extern snode* createSNode (sgraph*);
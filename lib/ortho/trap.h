@@ -47,6 +47,7 @@ typedef struct {
 /// an array of trapezoids
 typedef struct {
   size_t length;
+  size_t capacity; ///< number of trapezoids `data` has room for
   trap_t *data;
 } traps_t;
 
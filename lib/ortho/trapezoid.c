@@ -57,19 +57,28 @@ typedef struct {
 /// an array of qnodes
 typedef struct {
   size_t length;
+  size_t capacity; ///< number of nodes `data` has room for
   qnode_t *data;
 } qnodes_t;
 
 /* Return a new node to be added into the query tree */
 static int newnode(qnodes_t *qs) {
-  qs->data = gv_recalloc(qs->data, qs->length, qs->length + 1, sizeof(qnode_t));
+  if (qs->length == qs->capacity) {
+    const size_t c = qs->capacity == 0 ? 1 : 2 * qs->capacity;
+    qs->data = gv_recalloc(qs->data, qs->capacity, c, sizeof(qnode_t));
+    qs->capacity = c;
+  }
   ++qs->length;
   return qs->length - 1;
 }
 
 /* Return a free trapezoid */
 static int newtrap(traps_t *tr) {
-  tr->data = gv_recalloc(tr->data, tr->length, tr->length + 1, sizeof(trap_t));
+  if (tr->length == tr->capacity) {
+    const size_t c = tr->capacity == 0 ? 1 : 2 * tr->capacity;
+    tr->data = gv_recalloc(tr->data, tr->capacity, c, sizeof(trap_t));
+    tr->capacity = c;
+  }
   ++tr->length;
   return tr->length - 1;
 }
@@ -928,11 +937,13 @@ traps_t construct_trapezoids(int nseg, segment_t *seg, int *permute) {
 
     // We will append later nodes by expanding this on-demand. First node is a
     // sentinel.
-    qnodes_t qs = {.length = 1, .data = gv_calloc(1, sizeof(qnode_t))};
+    qnodes_t qs = {.length = 1, .capacity = 1,
+                   .data = gv_calloc(1, sizeof(qnode_t))};
 
     // First trapezoid is reserved as a sentinel. We will append later
     // trapezoids by expanding this on-demand.
-    traps_t tr = {.length = 1, .data = gv_calloc(1, sizeof(trap_t))};
+    traps_t tr = {.length = 1, .capacity = 1,
+                  .data = gv_calloc(1, sizeof(trap_t))};
 
   /* Add the first segment and get the query structure and trapezoid */
   /* list initialised */
@@ -35,6 +35,17 @@ PATHUTIL_API COORD dist2(Ppoint_t, Ppoint_t);
 
 PATHUTIL_API bool in_poly(const Ppoly_t poly, Ppoint_t q);
 
+/// release the scratch space of Pshortestpath, Proutespline and make_polyline
+///
+/// Each thread has its own, and the results of these functions point into it,
+/// so this must not be called while such a result is in use. A thread other
+/// than the main one that calls them should call this before it exits.
+PATHUTIL_API void Pscratch_free(void);
+
+/// the parts of Pscratch_free kept by shortest.c and route.c
+void Pshortestpath_free(void);
+void Proutespline_free(void);
+
 #undef PATHUTIL_API
 #ifdef __cplusplus
 }
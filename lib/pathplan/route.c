@@ -15,6 +15,7 @@
 #include <math.h>
 #include <pathplan/pathutil.h>
 #include <pathplan/solvers.h>
+#include <util/tls.h>
 
 #define EPSILON1 1E-3
 #define EPSILON2 1E-6
@@ -30,8 +31,11 @@ typedef struct tna_t {
 
 #define POINTSIZE sizeof (Ppoint_t)
 
-static Ppoint_t *ops;
-static size_t opn, opl;
+// scratch space, per thread so routing can run concurrently
+static TLS Ppoint_t *ops;
+static TLS size_t opn, opl;
+static TLS tna_t *tnabuf;
+static TLS int tnan;
 
 static int reallyroutespline(Pedge_t *, size_t,
 			     Ppoint_t *, int, Ppoint_t, Ppoint_t);
@@ -93,6 +97,15 @@ int Proutespline(Pedge_t *barriers, size_t n_barriers, Ppolyline_t input_route,
     return 0;
 }
 
+void Proutespline_free(void) {
+    free(ops);
+    ops = NULL;
+    opn = opl = 0;
+    free(tnabuf);
+    tnabuf = NULL;
+    tnan = 0;
+}
+
 static int reallyroutespline(Pedge_t *edges, size_t edgen, Ppoint_t *inps,
                              int inpn, Ppoint_t ev0, Ppoint_t ev1) {
     Ppoint_t p1, p2, cp1, cp2, p;
@@ -100,26 +113,23 @@ static int reallyroutespline(Pedge_t *edges, size_t edgen, Ppoint_t *inps,
     double maxd, d, t;
     int maxi, i, spliti;
 
-    static tna_t *tnas;
-    static int tnan;
-
     if (tnan < inpn) {
-	tna_t *new_tnas = realloc(tnas, sizeof(tna_t) * (size_t)inpn);
-	if (new_tnas == NULL)
+	tna_t *new_tnabuf = realloc(tnabuf, sizeof(tna_t) * (size_t)inpn);
+	if (new_tnabuf == NULL)
 	    return -1;
-	tnas = new_tnas;
+	tnabuf = new_tnabuf;
 	tnan = inpn;
     }
-    tnas[0].t = 0;
+    tnabuf[0].t = 0;
     for (i = 1; i < inpn; i++)
-	tnas[i].t = tnas[i - 1].t + dist(inps[i], inps[i - 1]);
+	tnabuf[i].t = tnabuf[i - 1].t + dist(inps[i], inps[i - 1]);
     for (i = 1; i < inpn; i++)
-	tnas[i].t /= tnas[inpn - 1].t;
+	tnabuf[i].t /= tnabuf[inpn - 1].t;
     for (i = 0; i < inpn; i++) {
-	tnas[i].a[0] = scale(ev0, B1(tnas[i].t));
-	tnas[i].a[1] = scale(ev1, B2(tnas[i].t));
+	tnabuf[i].a[0] = scale(ev0, B1(tnabuf[i].t));
+	tnabuf[i].a[1] = scale(ev1, B2(tnabuf[i].t));
     }
-    if (mkspline(inps, inpn, tnas, ev0, ev1, &p1, &v1, &p2, &v2) == -1)
+    if (mkspline(inps, inpn, tnabuf, ev0, ev1, &p1, &v1, &p2, &v2) == -1)
 	return -1;
     int fit = splinefits(edges, edgen, p1, v1, p2, v2, inps, inpn);
     if (fit > 0) {
@@ -131,7 +141,7 @@ static int reallyroutespline(Pedge_t *edges, size_t edgen, Ppoint_t *inps,
     cp1 = add(p1, scale(v1, 1 / 3.0));
     cp2 = sub(p2, scale(v2, 1 / 3.0));
     for (maxd = -1, maxi = -1, i = 1; i < inpn - 1; i++) {
-	t = tnas[i].t;
+	t = tnabuf[i].t;
 	p.x = B0(t) * p1.x + B1(t) * cp1.x + B2(t) * cp2.x + B3(t) * p2.x;
 	p.y = B0(t) * p1.y + B1(t) * cp1.y + B2(t) * cp2.y + B3(t) * p2.y;
 	if ((d = dist(p, inps[i])) > maxd)
@@ -14,6 +14,7 @@
 #include <stdlib.h>
 #include <pathplan/pathutil.h>
 #include <util/alloc.h>
+#include <util/tls.h>
 
 void freePath(Ppolyline_t* p)
 {
@@ -53,13 +54,15 @@ int Ppolybarriers(Ppoly_t ** polys, int npolys, Pedge_t ** barriers,
     return 1;
 }
 
+// scratch space of make_polyline, per thread so routing can run concurrently
+static TLS size_t isz;
+static TLS Ppoint_t *ispline;
+
 /* make_polyline:
  */
 void
 make_polyline(Ppolyline_t line, Ppolyline_t* sline)
 {
-    static size_t isz = 0;
-    static Ppoint_t* ispline = 0;
     const size_t npts = 4 + 3 * (line.pn - 2);
 
     if (npts > isz) {
@@ -82,6 +85,14 @@ make_polyline(Ppolyline_t line, Ppolyline_t* sline)
     sline->ps = ispline;
 }
 
+void Pscratch_free(void) {
+    Pshortestpath_free();
+    Proutespline_free();
+    free(ispline);
+    ispline = NULL;
+    isz = 0;
+}
+
 /**
  * @dir lib/pathplan
  * @brief finds and smooths shortest paths, API pathplan.h
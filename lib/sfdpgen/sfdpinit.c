@@ -25,7 +25,9 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include <util/alloc.h>
+#include <util/random.h>
 #include <util/strcasecmp.h>
+#include <util/thread.h>
 
 static void sfdp_init_edge(edge_t * e)
 {
@@ -82,38 +84,106 @@ static double *getPos(Agraph_t * g)
     return pos;
 }
 
-static void sfdpLayout(graph_t * g, spring_electrical_control ctrl,
-                       pointf pad) {
+/// state for laying out one graph or component
+///
+/// The layout is split into three phases so that the middle one, which does
+/// not touch the graph, can run concurrently with that of other components.
+typedef struct {
+    graph_t *g;
+    SparseMatrix A;
     double *sizes;
     double *pos;
-    Agnode_t *n;
-    int flag, i;
-    int n_edge_label_nodes = 0, *edge_label_nodes = NULL;
-    SparseMatrix A = makeMatrix(g);
+    int n_edge_label_nodes;
+    int *edge_label_nodes;
+    /// private copy of the control parameters, as the solver modifies them
+    struct spring_electrical_control_struct ctrl;
+    /// use a random number generator unaffected by other components?
+    bool private_rand;
+} sfdp_job_t;
+
+/// collect the input for the solver from the graph
+static void sfdp_prepare(sfdp_job_t *job, graph_t *g,
+                         spring_electrical_control ctrl, pointf pad,
+                         bool private_rand) {
+    *job = (sfdp_job_t){.g = g, .ctrl = *ctrl, .private_rand = private_rand};
+    job->A = makeMatrix(g);
 
     if (ctrl->overlap >= 0) {
 	if (ctrl->edge_labeling_scheme > 0)
-	    sizes = getSizes(g, pad, &n_edge_label_nodes, &edge_label_nodes);
+	    job->sizes = getSizes(g, pad, &job->n_edge_label_nodes,
+	                          &job->edge_label_nodes);
 	else
-	    sizes = getSizes(g, pad, NULL, NULL);
+	    job->sizes = getSizes(g, pad, NULL, NULL);
     }
     else
-	sizes = NULL;
-    pos = getPos(g);
+	job->sizes = NULL;
+    job->pos = getPos(g);
+}
 
-    multilevel_spring_electrical_embedding(Ndim, A, ctrl, sizes, pos, n_edge_label_nodes, edge_label_nodes, &flag);
+/// compute positions, without reference to the graph
+static void sfdp_solve(sfdp_job_t *job) {
+    int flag;
+
+    if (job->private_rand)
+	gv_rand_private(true);
+    multilevel_spring_electrical_embedding(Ndim, job->A, &job->ctrl, job->sizes,
+                                           job->pos, job->n_edge_label_nodes,
+                                           job->edge_label_nodes, &flag);
+    if (job->private_rand)
+	gv_rand_private(false);
+}
 
-    for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
-	double *npos = pos + (Ndim * ND_id(n));
+/// store computed positions back into the graph
+static void sfdp_commit(sfdp_job_t *job) {
+    Agnode_t *n;
+    int i;
+
+    for (n = agfstnode(job->g); n; n = agnxtnode(job->g, n)) {
+	double *npos = job->pos + (Ndim * ND_id(n));
 	for (i = 0; i < Ndim; i++) {
 	    ND_pos(n)[i] = npos[i];
 	}
     }
 
-    free(sizes);
-    free(pos);
-    SparseMatrix_delete (A);
-    free(edge_label_nodes);
+    free(job->sizes);
+    free(job->pos);
+    SparseMatrix_delete(job->A);
+    free(job->edge_label_nodes);
+}
+
+static void sfdpLayout(graph_t * g, spring_electrical_control ctrl,
+                       pointf pad, bool private_rand) {
+    sfdp_job_t job;
+    sfdp_prepare(&job, g, ctrl, pad, private_rand);
+    sfdp_solve(&job);
+    sfdp_commit(&job);
+}
+
+static void solve_component(void *jobs, size_t index, size_t worker) {
+    (void)worker;
+    sfdp_solve((sfdp_job_t *)jobs + index);
+}
+
+/// lay out the components of a graph using up to `threads` threads
+///
+/// Each component uses its own random number generator, so the result does not
+/// depend on the number of threads or how components are scheduled.
+static void sfdpLayoutComponents(size_t ncc, graph_t **ccs,
+                                 spring_electrical_control ctrl, pointf pad,
+                                 size_t threads) {
+    sfdp_job_t *jobs = gv_calloc(ncc, sizeof(jobs[0]));
+
+    for (size_t i = 0; i < ncc; i++) {
+	(void)graphviz_node_induce(ccs[i], NULL);
+	sfdp_prepare(&jobs[i], ccs[i], ctrl, pad, true);
+    }
+
+    gv_parallel_for(ncc, threads, solve_component, jobs);
+
+    for (size_t i = 0; i < ncc; i++) {
+	sfdp_commit(&jobs[i]);
+    }
+    free(jobs);
 }
 
 static int
@@ -267,10 +337,15 @@ void sfdp_layout(graph_t * g)
 	if (Verbose)
 	    spring_electrical_control_print(ctrl);
 
+	const size_t threads = late_threads(g);
+	const bool parallel = threads > 0;
+
 	size_t ncc;
 	ccs = ccomps(g, &ncc, 0);
 	if (ncc == 1) {
-	    sfdpLayout(g, ctrl, pad);
+	    // with a single component, spread its force computation across threads
+	    ctrl->threads = threads;
+	    sfdpLayout(g, ctrl, pad, parallel);
 	    if (doAdjust) removeOverlapWith(g, &am);
 	    spline_edges(g);
 	} else {
@@ -278,10 +353,15 @@ void sfdp_layout(graph_t * g)
 	    getPackInfo(g, l_node, CL_OFFSET, &pinfo);
 	    pinfo.doSplines = true;
 
+	    // with diagnostics on, run sequentially to keep their output in order
+	    if (parallel)
+		sfdpLayoutComponents(ncc, ccs, ctrl, pad, Verbose ? 1 : threads);
 	    for (size_t i = 0; i < ncc; i++) {
 		sg = ccs[i];
-		(void)graphviz_node_induce(sg, NULL);
-		sfdpLayout(sg, ctrl, pad);
+		if (!parallel) {
+		    (void)graphviz_node_induce(sg, NULL);
+		    sfdpLayout(sg, ctrl, pad, false);
+		}
 		if (doAdjust) removeOverlapWith(sg, &am);
 		setEdgeType(sg, EDGETYPE_LINE);
 		spline_edges(sg);
@@ -27,6 +27,8 @@
 #include <time.h>
 #include <util/alloc.h>
 #include <util/bitarray.h>
+#include <util/random.h>
+#include <util/thread.h>
 
 /// another parameter
 /// fₐ(i, j) = C × dist(i , j)² ÷ K × dᵢⱼ, fᵣ(i, j) = K³⁻ᵖ ÷ dist(i, j)⁻ᵖ
@@ -66,6 +68,7 @@ spring_electrical_control spring_electrical_control_new(void){
   ctrl->initial_scaling = -4;
   ctrl->rotation = 0.;
   ctrl->edge_labeling_scheme = 0;
+  ctrl->threads = 0;
   return ctrl;
 }
 
@@ -98,6 +101,7 @@ void spring_electrical_control_print(spring_electrical_control ctrl){
     smoothings[ctrl->smoothing], ctrl->overlap, ctrl->initial_scaling, (int)ctrl->do_shrinking);
   fprintf (stderr, "  octree scheme %s\n", tschemes[ctrl->tscheme]);
   fprintf (stderr, "  edge_labeling_scheme %d\n", ctrl->edge_labeling_scheme);
+  fprintf(stderr, "  threads %zu\n", ctrl->threads);
 }
 
 enum { MAX_I = 20, OPT_UP = 1, OPT_DOWN = -1, OPT_INIT = 0 };
@@ -243,14 +247,51 @@ static void beautify_leaves(int dim, SparseMatrix A, double *x){
   bitarray_reset(&checked);
 }
 
+/// input and output of the attractive force computation
+typedef struct {
+  int dim;
+  int n;
+  const int *ia;
+  const int *ja;
+  double *x;
+  double *force;
+  double CRK;
+} attract_t;
+
+/// how many nodes to compute attractive forces for as one unit of work
+enum { ATTRACT_BLOCK = 1024 };
+
+/// add attractive forces to a block of nodes
+///
+/// Each node’s force only depends on the positions of its neighbors, so blocks
+/// can be processed concurrently and in any order.
+static void attract_block(void *arg, size_t index, size_t worker) {
+  (void)worker;
+  const attract_t *a = arg;
+  const int dim = a->dim;
+  const int lo = (int)(index * ATTRACT_BLOCK);
+  const int hi = a->n - lo < ATTRACT_BLOCK ? a->n : lo + ATTRACT_BLOCK;
+
+  for (int i = lo; i < hi; i++) {
+    double *f = &a->force[i * dim];
+    for (int j = a->ia[i]; j < a->ia[i + 1]; j++) {
+      if (a->ja[j] == i) continue;
+      const double dist = distance(a->x, dim, i, a->ja[j]);
+      for (int k = 0; k < dim; k++) {
+        f[k] -= a->CRK * (a->x[i * dim + k] - a->x[a->ja[j] * dim + k]) * dist;
+      }
+    }
+  }
+}
+
 void spring_electrical_embedding_fast(int dim, SparseMatrix A0, spring_electrical_control ctrl, double *x, int *flag){
   /* x is a point to a 1D array, x[i*dim+j] gives the coordinate of the i-th node at dimension j.  */
   SparseMatrix A = A0;
   int m, n;
-  int i, j, k;
+  int i, k;
   double p = ctrl->p, K = ctrl->K, CRK, maxiter = ctrl->maxiter, step = ctrl->step, KP;
   int *ia = NULL, *ja = NULL;
-  double *f = NULL, dist, F, Fnorm = 0, Fnorm0;
+  double *f = NULL, F, Fnorm = 0, Fnorm0;
   int iter = 0;
   const bool adaptive_cooling = ctrl->adaptive_cooling;
   double counts[4], *force = NULL;
@@ -280,7 +321,7 @@ void spring_electrical_embedding_fast(int dim, SparseMatrix A0, spring_electrica
   ja = A->ja;
 
   if (ctrl->random_start){
-    srand(ctrl->random_seed);
+    gv_srand(ctrl->random_seed);
     for (i = 0; i < dim*n; i++) x[i] = drand();
   }
   if (K < 0){
@@ -313,7 +354,8 @@ void spring_electrical_embedding_fast(int dim, SparseMatrix A0, spring_electrica
     start = clock();
 #endif
 
-    QuadTree_get_repulsive_force(qt, force, x, bh, p, KP, counts);
+    QuadTree_get_repulsive_force(qt, force, x, bh, p, KP, counts,
+                                 ctrl->threads);
 
 #ifdef TIME
     end = clock();
@@ -321,16 +363,10 @@ void spring_electrical_embedding_fast(int dim, SparseMatrix A0, spring_electrica
 #endif
 
     /* attractive force   C^((2-p)/3) ||x_i-x_j||/K * (x_j - x_i) */
-    for (i = 0; i < n; i++){
-      f = &(force[i*dim]);
-      for (j = ia[i]; j < ia[i+1]; j++){
-	if (ja[j] == i) continue;
-	dist = distance(x, dim, i, ja[j]);
-	for (k = 0; k < dim; k++){
-	  f[k] -= CRK*(x[i*dim+k] - x[ja[j]*dim+k])*dist;
-	}
-      }
-    }
+    attract_t attract = {.dim = dim, .n = n, .ia = ia, .ja = ja, .x = x,
+                         .force = force, .CRK = CRK};
+    gv_parallel_for(((size_t)n + ATTRACT_BLOCK - 1) / ATTRACT_BLOCK,
+                    ctrl->threads, attract_block, &attract);
 
 
     /* move */
@@ -424,7 +460,7 @@ static void spring_electrical_embedding_slow(int dim, SparseMatrix A0, spring_el
   ja = A->ja;
 
   if (ctrl->random_start){
-    srand(ctrl->random_seed);
+    gv_srand(ctrl->random_seed);
     for (i = 0; i < dim*n; i++) x[i] = drand();
   }
   if (K < 0){
@@ -561,7 +597,7 @@ void spring_electrical_embedding(int dim, SparseMatrix A0, spring_electrical_con
   ja = A->ja;
 
   if (ctrl->random_start){
-    srand(ctrl->random_seed);
+    gv_srand(ctrl->random_seed);
     for (i = 0; i < dim*n; i++) x[i] = drand();
   }
   if (K < 0){
@@ -727,7 +763,7 @@ void spring_electrical_spring_embedding(int dim, SparseMatrix A0, SparseMatrix D
   d = D->a;
 
   if (ctrl->random_start){
-    srand(ctrl->random_seed);
+    gv_srand(ctrl->random_seed);
     for (i = 0; i < dim*n; i++) x[i] = drand();
   }
   if (K < 0){
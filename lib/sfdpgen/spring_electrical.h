@@ -12,6 +12,7 @@
 
 #include <sparse/SparseMatrix.h>
 #include <stdbool.h>
+#include <stddef.h>
 
 enum {ERROR_NOT_SQUARE_MATRIX = -100};
 
@@ -48,6 +49,7 @@ struct spring_electrical_control_struct {
 			       0 (no action, default), 1 (penalty based method to make that kind of node close to the center of its neighbor), 
 			       1 (penalty based method to make that kind of node close to the old center of its neighbor),
 			       3 (two step process of overlap removal and straightening) */
+  size_t threads; ///< maximum threads for computing forces, ≤ 1 for serial
 };
 
 typedef struct  spring_electrical_control_struct  *spring_electrical_control; 
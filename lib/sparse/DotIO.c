@@ -81,16 +81,14 @@ SparseMatrix SparseMatrix_import_dot(Agraph_t *g, int dim,
                                      double **x, int format) {
   SparseMatrix A = 0;
   Agnode_t* n;
-  Agedge_t* e;
   Agsym_t *sym;
   Agsym_t *psym;
   int nnodes;
   int nedges;
-  int i, row;
+  int i;
   int* I;
   int* J;
   double *val;
-  double v;
   int type = MATRIX_TYPE_REAL;
 
   if (!g) return NULL;
@@ -118,25 +116,17 @@ SparseMatrix SparseMatrix_import_dot(Agraph_t *g, int dim,
     val = gv_calloc(nedges, sizeof(double));
   }
 
+  /* nodes are numbered in the same order in the snapshot as ND_id */
   sym = agattr(g, AGEDGE, "weight", NULL);
-  i = 0;
-  for (n = agfstnode (g); n; n = agnxtnode (g, n)) {
-    row = ND_id(n);
-    for (e = agfstout (g, n); e; e = agnxtout (g, e)) {
-      I[i] = row;
-      J[i] = ND_id(aghead(e));
-
-      /* edge weight */
-      if (sym) {
-        if (sscanf (agxget(e,sym), "%lf", &v) != 1) v = 1;
-      } else {
-        v = 1;
-      }
-      val[i] = v;
-
-      i++;
+  Agcsr_t *csr = agcsr(g, sym, 1);
+  for (size_t r = 0; r < csr->nnodes; r++) {
+    for (size_t k = csr->out[r]; k < csr->out[r + 1]; k++) {
+      I[k] = (int)r;
+      J[k] = (int)csr->head[k];
+      val[k] = csr->weight ? csr->weight[k] : 1;
     }
   }
+  agcsrfree(csr);
   
   if (x && (psym = agattr(g, AGNODE, "pos", NULL))) {
     bool has_positions = true;
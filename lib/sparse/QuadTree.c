@@ -15,7 +15,9 @@
 #include <sparse/QuadTree.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <cgraph/list.h>
 #include <util/alloc.h>
+#include <util/thread.h>
 
 extern double distance_cropped(double *x, int dim, int i, int j);
 
@@ -47,6 +49,547 @@ static void check_or_realloc_arrays(int dim, int *nsuper, int *nsupermax, double
   }
 }
 
+static int QuadTree_get_quadrant(int dim, double *center, double *coord);
+
+/// contiguous storage of a quadtree built by `QuadTree_new_from_point_list`
+///
+/// Cells are numbered so that the children of each cell are consecutive, in
+/// quadrant order, and the points of each leaf are consecutive, in the order
+/// of its list. So walking the tree visits points in Morton order. Cell and
+/// point attributes are kept in separate arrays, which the force and supernode
+/// computations work on directly. The `QuadTree_struct` cells and
+/// `node_data_struct` points seen by other code are views into these arrays.
+struct QuadTree_flat {
+  int dim;
+  int n_cells;
+  int n_points;
+
+  // per cell
+  double *center;   ///< `dim` per cell
+  double *average;  ///< `dim` per cell
+  double *width;
+  double *weight;   ///< total weight
+  int *n;           ///< number of points
+  int *quadrant;    ///< which quadrant of its parent a cell is in
+  int *first_child; ///< children are `[first_child, first_child + n_children)`
+  int *n_children;  ///< number of non-empty children, 0 for a leaf
+  int *first_point; ///< for a leaf, start of its points
+
+  // per point, in leaf order
+  int *id;
+  double *coord; ///< `dim` per point
+  double *node_weight;
+
+  // views for code that walks the tree through pointers
+  struct QuadTree_struct *cells;
+  QuadTree *qts;
+  struct node_data_struct *nodes;
+};
+
+/// state for building a `QuadTree_flat`
+typedef struct {
+  struct QuadTree_flat *t;
+  int capacity;        ///< allocated length of the per cell arrays
+  int max_level;
+  const double *coord; ///< input coordinates, `dim` per point
+  int *seq;            ///< points, partitioned as the build proceeds
+  int *quad;           ///< scratch: quadrant of each point in `seq`
+  int *tmp;            ///< scratch: partitioning output
+  int *counts;         ///< scratch: points per quadrant, per level
+} flat_builder_t;
+
+/// append `count` cells, returning the index of the first
+static int flat_new_cells(flat_builder_t *b, int count) {
+  struct QuadTree_flat *t = b->t;
+  const size_t dim = (size_t)t->dim;
+
+  if (t->n_cells + count > b->capacity) {
+    const size_t old = (size_t)b->capacity;
+    const size_t cap = (size_t)MAX(2 * b->capacity, t->n_cells + count);
+    t->center = gv_recalloc(t->center, dim * old, dim * cap, sizeof(double));
+    t->average = gv_recalloc(t->average, dim * old, dim * cap, sizeof(double));
+    t->width = gv_recalloc(t->width, old, cap, sizeof(double));
+    t->weight = gv_recalloc(t->weight, old, cap, sizeof(double));
+    t->n = gv_recalloc(t->n, old, cap, sizeof(int));
+    t->quadrant = gv_recalloc(t->quadrant, old, cap, sizeof(int));
+    t->first_child = gv_recalloc(t->first_child, old, cap, sizeof(int));
+    t->n_children = gv_recalloc(t->n_children, old, cap, sizeof(int));
+    t->first_point = gv_recalloc(t->first_point, old, cap, sizeof(int));
+    b->capacity = (int)cap;
+  }
+
+  const int first = t->n_cells;
+  t->n_cells += count;
+  return first;
+}
+
+/// fill in cell `c` at depth `level`, containing the `k` points `seq[lo..]`
+///
+/// The points are expected in the order `QuadTree_add` would have seen them
+/// arrive in this cell. Its running totals are replayed in that order, so the
+/// result is identical to building the tree point by point.
+static void flat_build(flat_builder_t *b, int c, int lo, int k, int level) {
+  struct QuadTree_flat *t = b->t;
+  const int dim = t->dim;
+  const int *seq = &b->seq[lo];
+  double *avg = &t->average[c * dim];
+  int i, j;
+
+  t->n[c] = k;
+  t->weight[c] = 1;
+  for (i = 0; i < dim; i++) avg[i] = b->coord[seq[0] * dim + i];
+  const bool leaf = k == 1 || level >= b->max_level;
+  for (j = 1; j < k; j++) {
+    const double *coord = &b->coord[seq[j] * dim];
+    const int n = leaf ? j + 1 : j;
+    t->weight[c] += 1;
+    for (i = 0; i < dim; i++) avg[i] = (avg[i] * n + coord[i]) / (n + 1);
+  }
+
+  if (leaf) {
+    // lists are built by prepending, so are in reverse order of arrival
+    t->n_children[c] = 0;
+    t->first_point[c] = t->n_points;
+    for (j = k - 1; j >= 0; j--) {
+      const int p = t->n_points++;
+      t->id[p] = seq[j];
+      t->node_weight[p] = 1;
+      for (i = 0; i < dim; i++) t->coord[p * dim + i] = b->coord[seq[j] * dim + i];
+    }
+    return;
+  }
+
+  // the first point to arrive is only pushed down into a child when the
+  // second arrives, after it
+  int *s = &b->seq[lo];
+  const int first = s[0];
+  s[0] = s[1];
+  s[1] = first;
+
+  // stable partition by quadrant
+  int *quad = &b->quad[lo];
+  int *counts = &b->counts[level << dim];
+  int m = 0;
+  for (i = 0; i < 1 << dim; i++) counts[i] = 0;
+  for (j = 0; j < k; j++) {
+    quad[j] = QuadTree_get_quadrant(dim, &t->center[c * dim],
+                                    (double *)&b->coord[s[j] * dim]);
+    if (counts[quad[j]]++ == 0) m++;
+  }
+  int *tmp = &b->tmp[lo];
+  int start = 0;
+  for (i = 0; i < 1 << dim; i++) {
+    const int cnt = counts[i];
+    counts[i] = start;
+    start += cnt;
+  }
+  for (j = 0; j < k; j++) tmp[counts[quad[j]]++] = s[j];
+  for (j = 0; j < k; j++) s[j] = tmp[j];
+
+  // counts[i] is now the end of quadrant i’s points
+  const int child = flat_new_cells(b, m);
+  t->first_child[c] = child;
+  t->n_children[c] = m;
+  int cc = child;
+  for (i = 0; i < 1 << dim; i++) {
+    const int begin = i == 0 ? 0 : counts[i - 1];
+    if (counts[i] == begin) continue;
+    // as for QuadTree_new_in_quadrant
+    const double width = t->width[c] / 2;
+    t->width[cc] = width;
+    t->quadrant[cc] = i;
+    for (int q = i, d = 0; d < dim; d++) {
+      t->center[cc * dim + d] = t->center[c * dim + d];
+      if (q % 2 == 0) {
+        t->center[cc * dim + d] -= width;
+      } else {
+        t->center[cc * dim + d] += width;
+      }
+      q = (q - q % 2) / 2;
+    }
+    cc++;
+  }
+
+  cc = child;
+  for (i = 0; i < 1 << dim; i++) {
+    const int begin = i == 0 ? 0 : counts[i - 1];
+    const int end = counts[i];
+    if (end == begin) continue;
+    flat_build(b, cc++, lo + begin, end - begin, level + 1);
+  }
+}
+
+/// set up the pointer views of a built tree
+static void flat_link(struct QuadTree_flat *t, int max_level) {
+  const int dim = t->dim;
+  int c, n_internal = 0;
+
+  for (c = 0; c < t->n_cells; c++) {
+    if (t->n_children[c] > 0) n_internal++;
+  }
+  t->cells = gv_calloc((size_t)t->n_cells, sizeof(t->cells[0]));
+  t->qts = gv_calloc((size_t)n_internal << dim, sizeof(t->qts[0]));
+  t->nodes = gv_calloc((size_t)t->n_points, sizeof(t->nodes[0]));
+
+  QuadTree *qts = t->qts;
+  for (c = 0; c < t->n_cells; c++) {
+    QuadTree q = &t->cells[c];
+    q->n = t->n[c];
+    q->total_weight = t->weight[c];
+    q->dim = dim;
+    q->center = &t->center[c * dim];
+    q->width = t->width[c];
+    q->average = &t->average[c * dim];
+    q->max_level = max_level;
+    if (t->n_children[c] > 0) {
+      q->qts = qts;
+      qts += 1 << dim;
+      for (int cc = t->first_child[c];
+           cc < t->first_child[c] + t->n_children[c]; cc++) {
+        q->qts[t->quadrant[cc]] = &t->cells[cc];
+      }
+    } else {
+      const int end = t->first_point[c] + t->n[c];
+      for (int p = t->first_point[c]; p < end; p++) {
+        node_data nd = &t->nodes[p];
+        nd->node_weight = t->node_weight[p];
+        nd->coord = &t->coord[p * dim];
+        nd->id = t->id[p];
+        nd->next = p + 1 < end ? &t->nodes[p + 1] : NULL;
+      }
+      q->l = &t->nodes[t->first_point[c]];
+    }
+  }
+  t->cells[0].flat = t;
+}
+
+static QuadTree flat_new(int dim, int n, int max_level, double *coord,
+                         double *center, double width) {
+  struct QuadTree_flat *t = gv_alloc(sizeof(*t));
+  t->dim = dim;
+  t->id = gv_calloc((size_t)n, sizeof(int));
+  t->coord = gv_calloc((size_t)n * (size_t)dim, sizeof(double));
+  t->node_weight = gv_calloc((size_t)n, sizeof(double));
+
+  flat_builder_t b = {.t = t, .max_level = max_level, .coord = coord};
+  b.seq = gv_calloc((size_t)n, sizeof(int));
+  b.quad = gv_calloc((size_t)n, sizeof(int));
+  b.tmp = gv_calloc((size_t)n, sizeof(int));
+  b.counts = gv_calloc((size_t)(MAX(max_level, 0) + 1) << dim, sizeof(int));
+  for (int i = 0; i < n; i++) b.seq[i] = i;
+
+  const int root = flat_new_cells(&b, 1);
+  assert(width > 0);
+  t->width[root] = width;
+  for (int i = 0; i < dim; i++) t->center[root * dim + i] = center[i];
+  flat_build(&b, root, 0, n, 0);
+
+  free(b.seq);
+  free(b.quad);
+  free(b.tmp);
+  free(b.counts);
+
+  flat_link(t, max_level);
+  return &t->cells[root];
+}
+
+static void flat_delete(struct QuadTree_flat *t) {
+  free(t->center);
+  free(t->average);
+  free(t->width);
+  free(t->weight);
+  free(t->n);
+  free(t->quadrant);
+  free(t->first_child);
+  free(t->n_children);
+  free(t->first_point);
+  free(t->id);
+  free(t->coord);
+  free(t->node_weight);
+  free(t->cells);
+  free(t->qts);
+  free(t->nodes);
+  free(t);
+}
+
+/// `QuadTree_get_supernodes_internal` for a flat tree
+static void flat_get_supernodes(const struct QuadTree_flat *t, int c, double bh,
+                                double *pt, int nodeid, int *nsuper,
+                                int *nsupermax, double **center,
+                                double **supernode_wgts, double **distances,
+                                double *counts) {
+  const int dim = t->dim;
+  int i;
+
+  (*counts)++;
+
+  if (t->n_children[c] == 0) {
+    const int end = t->first_point[c] + t->n[c];
+    for (int p = t->first_point[c]; p < end; p++) {
+      check_or_realloc_arrays(dim, nsuper, nsupermax, center, supernode_wgts, distances);
+      if (t->id[p] != nodeid) {
+        double *coord = &t->coord[p * dim];
+        for (i = 0; i < dim; i++) (*center)[dim * (*nsuper) + i] = coord[i];
+        (*supernode_wgts)[*nsuper] = t->node_weight[p];
+        (*distances)[*nsuper] = point_distance(pt, coord, dim);
+        (*nsuper)++;
+      }
+    }
+    return;
+  }
+
+  const double dist = point_distance(&t->center[c * dim], pt, dim);
+  if (t->width[c] < bh * dist) {
+    check_or_realloc_arrays(dim, nsuper, nsupermax, center, supernode_wgts, distances);
+    for (i = 0; i < dim; i++) (*center)[dim * (*nsuper) + i] = t->average[c * dim + i];
+    (*supernode_wgts)[*nsuper] = t->weight[c];
+    (*distances)[*nsuper] = point_distance(&t->average[c * dim], pt, dim);
+    (*nsuper)++;
+  } else {
+    // the pointer tree counts a visit to each empty quadrant too
+    *counts += (1 << dim) - t->n_children[c];
+    for (int cc = t->first_child[c]; cc < t->first_child[c] + t->n_children[c];
+         cc++) {
+      flat_get_supernodes(t, cc, bh, pt, nodeid, nsuper, nsupermax, center,
+                          supernode_wgts, distances, counts);
+    }
+  }
+}
+
+/// a pair of cells whose interaction is yet to be computed
+typedef struct {
+  int c1;
+  int c2;
+} cell_pair_t;
+
+DEFINE_LIST(cell_pairs, cell_pair_t)
+
+/// parameters and accumulators of a repulsive force traversal of a flat tree
+typedef struct {
+  const struct QuadTree_flat *t;
+  double *x;          ///< node coordinates
+  double *force;      ///< force accumulated on each node
+  double *cell_force; ///< force accumulated on each cell
+  double bh;          ///< Barnes-Hut coefficient
+  double p;           ///< repulsive force power
+  double KP;          ///< pow(K, 1 - p)
+  double *counts;     ///< interaction counts, see QuadTree_get_repulsive_force
+  /// If non-null, do not compute any interactions. Instead, record here each
+  /// pair of cells reached at depth `split_depth` or that would interact
+  /// directly, in the order they would otherwise be processed.
+  cell_pairs_t *pending;
+  int split_depth;
+} interact_t;
+
+/// `QuadTree_repulsive_force_interact` for a flat tree
+static void flat_interact(int c1, int c2, interact_t *ctx, int depth) {
+  const struct QuadTree_flat *t = ctx->t;
+  const int dim = t->dim;
+  double *x = ctx->x, *force = ctx->force, *counts = ctx->counts;
+  const double bh = ctx->bh, p = ctx->p, KP = ctx->KP;
+  double *x1, *x2, dist, wgt1, wgt2, f, *f1, *f2;
+  int i, j, k;
+
+  if (ctx->pending && depth >= ctx->split_depth) {
+    cell_pairs_append(ctx->pending, (cell_pair_t){c1, c2});
+    return;
+  }
+
+  const bool leaf1 = t->n_children[c1] == 0;
+  const bool leaf2 = t->n_children[c2] == 0;
+
+  /* far enough, calculate repulsive force */
+  x1 = &t->average[c1 * dim];
+  x2 = &t->average[c2 * dim];
+  dist = point_distance(x1, x2, dim);
+  if (t->width[c1] + t->width[c2] < bh * dist) {
+    if (ctx->pending) {
+      cell_pairs_append(ctx->pending, (cell_pair_t){c1, c2});
+      return;
+    }
+    counts[0]++;
+    wgt1 = t->weight[c1];
+    wgt2 = t->weight[c2];
+    f1 = &ctx->cell_force[c1 * dim];
+    f2 = &ctx->cell_force[c2 * dim];
+    assert(dist > 0);
+    for (k = 0; k < dim; k++) {
+      if (p == -1) {
+        f = wgt1 * wgt2 * KP * (x1[k] - x2[k]) / (dist * dist);
+      } else {
+        f = wgt1 * wgt2 * KP * (x1[k] - x2[k]) / pow(dist, 1. - p);
+      }
+      f1[k] += f;
+      f2[k] -= f;
+    }
+    return;
+  }
+
+  /* both at leaves, calculate repulsive force */
+  if (leaf1 && leaf2) {
+    if (ctx->pending) {
+      cell_pairs_append(ctx->pending, (cell_pair_t){c1, c2});
+      return;
+    }
+    const int end1 = t->first_point[c1] + t->n[c1];
+    const int end2 = t->first_point[c2] + t->n[c2];
+    for (int p1 = t->first_point[c1]; p1 < end1; p1++) {
+      x1 = &t->coord[p1 * dim];
+      wgt1 = t->node_weight[p1];
+      const int i1 = t->id[p1];
+      f1 = &force[i1 * dim];
+      for (int p2 = t->first_point[c2]; p2 < end2; p2++) {
+        const int i2 = t->id[p2];
+        if ((c1 == c2 && i2 < i1) || i1 == i2) continue;
+        x2 = &t->coord[p2 * dim];
+        wgt2 = t->node_weight[p2];
+        f2 = &force[i2 * dim];
+        counts[1]++;
+        dist = distance_cropped(x, dim, i1, i2);
+        for (k = 0; k < dim; k++) {
+          if (p == -1) {
+            f = wgt1 * wgt2 * KP * (x1[k] - x2[k]) / (dist * dist);
+          } else {
+            f = wgt1 * wgt2 * KP * (x1[k] - x2[k]) / pow(dist, 1. - p);
+          }
+          f1[k] += f;
+          f2[k] -= f;
+        }
+      }
+    }
+    return;
+  }
+
+  const int first1 = t->first_child[c1], end1 = first1 + t->n_children[c1];
+  const int first2 = t->first_child[c2], end2 = first2 + t->n_children[c2];
+
+  /* identical, split one */
+  if (c1 == c2) {
+    for (i = first1; i < end1; i++) {
+      for (j = i; j < end1; j++) {
+        flat_interact(i, j, ctx, depth + 1);
+      }
+    }
+    return;
+  }
+
+  /* split the one with bigger box, or one not at the last level */
+  if (t->width[c1] > t->width[c2] && !leaf1) {
+    for (i = first1; i < end1; i++) flat_interact(i, c2, ctx, depth + 1);
+  } else if (t->width[c2] > t->width[c1] && !leaf2) {
+    for (i = first2; i < end2; i++) flat_interact(i, c1, ctx, depth + 1);
+  } else if (!leaf1) {
+    for (i = first1; i < end1; i++) flat_interact(i, c2, ctx, depth + 1);
+  } else {
+    assert(!leaf2);
+    for (i = first2; i < end2; i++) flat_interact(i, c1, ctx, depth + 1);
+  }
+}
+
+/// `QuadTree_repulsive_force_accumulate` for a flat tree
+static void flat_accumulate(const struct QuadTree_flat *t, int c,
+                            double *cell_force, double *force, double *counts) {
+  const int dim = t->dim;
+  const double *f = &cell_force[c * dim];
+  const double wgt = t->weight[c];
+  double wgt2;
+  int k;
+
+  assert(wgt > 0);
+  counts[2]++;
+
+  if (t->n_children[c] == 0) {
+    const int end = t->first_point[c] + t->n[c];
+    for (int p = t->first_point[c]; p < end; p++) {
+      double *f2 = &force[t->id[p] * dim];
+      wgt2 = t->node_weight[p];
+      wgt2 = wgt2 / wgt;
+      for (k = 0; k < dim; k++) f2[k] += wgt2 * f[k];
+    }
+    return;
+  }
+
+  for (int cc = t->first_child[c]; cc < t->first_child[c] + t->n_children[c];
+       cc++) {
+    double *f2 = &cell_force[cc * dim];
+    wgt2 = t->weight[cc];
+    wgt2 = wgt2 / wgt;
+    for (k = 0; k < dim; k++) f2[k] += wgt2 * f[k];
+    flat_accumulate(t, cc, cell_force, force, counts);
+  }
+}
+
+/// a repulsive force traversal split across threads
+typedef struct {
+  const cell_pairs_t *pairs; ///< independent parts of the traversal
+  interact_t *slots;         ///< traversal state for each slot
+  size_t n_slots;
+} interact_job_t;
+
+static void interact_slot(void *arg, size_t index, size_t worker) {
+  (void)worker;
+  interact_job_t *job = arg;
+  // pairs are dealt to slots round robin, so the order in which forces are
+  // summed depends only on the number of slots and not on thread scheduling
+  for (size_t i = index; i < cell_pairs_size(job->pairs); i += job->n_slots) {
+    const cell_pair_t pair = cell_pairs_get(job->pairs, i);
+    flat_interact(pair.c1, pair.c2, &job->slots[index], 0);
+  }
+}
+
+/// how many cell pairs to aim for per thread, to balance load between threads
+enum { PAIRS_PER_THREAD = 16 };
+
+/// compute cell and node forces of a flat tree using up to `threads` threads
+static void flat_interact_concurrent(const interact_t *ctx, int n, int max_level,
+                                     size_t threads) {
+  const struct QuadTree_flat *t = ctx->t;
+  const size_t cell_len = (size_t)t->n_cells * (size_t)t->dim;
+  const size_t node_len = (size_t)n * (size_t)t->dim;
+
+  // descend the first few levels of the traversal until it falls apart into
+  // enough independent cell pairs
+  cell_pairs_t pairs = {0};
+  interact_t split = *ctx;
+  split.pending = &pairs;
+  for (split.split_depth = 1; split.split_depth <= max_level;
+       split.split_depth++) {
+    cell_pairs_clear(&pairs);
+    flat_interact(0, 0, &split, 0);
+    if (cell_pairs_size(&pairs) >= PAIRS_PER_THREAD * threads) break;
+  }
+
+  // each slot gets its own node and cell force accumulators, and counts, so
+  // slots can be processed concurrently without synchronization
+  const size_t n_slots = threads;
+  interact_t *slots = gv_calloc(n_slots, sizeof(slots[0]));
+  double *cell_force = gv_calloc((n_slots - 1) * cell_len, sizeof(double));
+  double *node_force = gv_calloc((n_slots - 1) * node_len, sizeof(double));
+  double *counts = gv_calloc((n_slots - 1) * 4, sizeof(double));
+  slots[0] = *ctx;
+  for (size_t s = 1; s < n_slots; s++) {
+    slots[s] = *ctx;
+    slots[s].cell_force = &cell_force[(s - 1) * cell_len];
+    slots[s].force = &node_force[(s - 1) * node_len];
+    slots[s].counts = &counts[(s - 1) * 4];
+  }
+
+  interact_job_t job = {.pairs = &pairs, .slots = slots, .n_slots = n_slots};
+  gv_parallel_for(n_slots, threads, interact_slot, &job);
+
+  for (size_t s = 1; s < n_slots; s++) {
+    for (size_t i = 0; i < cell_len; i++) ctx->cell_force[i] += slots[s].cell_force[i];
+    for (size_t i = 0; i < node_len; i++) ctx->force[i] += slots[s].force[i];
+    for (int i = 0; i < 4; i++) ctx->counts[i] += slots[s].counts[i];
+  }
+
+  free(counts);
+  free(node_force);
+  free(cell_force);
+  free(slots);
+  cell_pairs_free(&pairs);
+}
+
 static void QuadTree_get_supernodes_internal(QuadTree qt, double bh, double *pt, int nodeid, int *nsuper, int *nsupermax, double **center, double **supernode_wgts, double **distances, double *counts) {
   double *coord, dist;
   int dim, i;
@@ -102,7 +645,12 @@ void QuadTree_get_supernodes(QuadTree qt, double bh, double *pt, int nodeid, int
   if (!*center) *center = gv_calloc(*nsupermax * dim, sizeof(double));
   if (!*supernode_wgts) *supernode_wgts = gv_calloc(*nsupermax, sizeof(double));
   if (!*distances) *distances = gv_calloc(*nsupermax, sizeof(double));
-  QuadTree_get_supernodes_internal(qt, bh, pt, nodeid, nsuper, nsupermax, center, supernode_wgts, distances, counts);
+  if (qt->flat) {
+    flat_get_supernodes(qt->flat, 0, bh, pt, nodeid, nsuper, nsupermax, center,
+                        supernode_wgts, distances, counts);
+  } else {
+    QuadTree_get_supernodes_internal(qt, bh, pt, nodeid, nsuper, nsupermax, center, supernode_wgts, distances, counts);
+  }
 
 }
 
@@ -278,7 +826,9 @@ static void QuadTree_repulsive_force_accumulate(QuadTree qt, double *force, doub
 
 }
 
-void QuadTree_get_repulsive_force(QuadTree qt, double *force, double *x, double bh, double p, double KP, double *counts){
+void QuadTree_get_repulsive_force(QuadTree qt, double *force, double *x,
+                                  double bh, double p, double KP,
+                                  double *counts, size_t threads) {
   // get repulsive force by a more efficient algorithm: we consider two cells,
   // if they are well separated, we calculate the overall repulsive force on the
   // cell level, if not well separated, we divide one of the cell. If both cells
@@ -295,14 +845,32 @@ void QuadTree_get_repulsive_force(QuadTree qt, double *force, double *x, double
   //   .  counts[1]: number of cell-node interaction
   //   .  counts[2]: number of total cells in the quadtree
   //   . Al normalized by dividing by number of nodes
+  //   threads: maximum number of threads to use. This is only used for trees
+  //     from QuadTree_new_from_point_list. With ≤ 1 thread, forces are summed
+  //     in the same order as a serial computation. Otherwise, the result
+  //     depends on the number of threads but is reproducible.
   int n = qt->n, dim = qt->dim, i;
 
   for (i = 0; i < 4; i++) counts[i] = 0;
 
   for (i = 0; i < dim*n; i++) force[i] = 0;
 
-  QuadTree_repulsive_force_interact(qt, qt, x, force, bh, p, KP, counts);
-  QuadTree_repulsive_force_accumulate(qt, force, counts);
+  if (qt->flat) {
+    const struct QuadTree_flat *t = qt->flat;
+    double *cell_force = gv_calloc((size_t)t->n_cells * (size_t)dim, sizeof(double));
+    interact_t ctx = {.t = t, .x = x, .force = force, .cell_force = cell_force,
+                      .bh = bh, .p = p, .KP = KP, .counts = counts};
+    if (threads > 1) {
+      flat_interact_concurrent(&ctx, n, qt->max_level, threads);
+    } else {
+      flat_interact(0, 0, &ctx, 0);
+    }
+    flat_accumulate(t, 0, cell_force, force, counts);
+    free(cell_force);
+  } else {
+    QuadTree_repulsive_force_interact(qt, qt, x, force, bh, p, KP, counts);
+    QuadTree_repulsive_force_accumulate(qt, force, counts);
+  }
   for (i = 0; i < 4; i++) counts[i] /= n;
 
 }
@@ -341,10 +909,10 @@ QuadTree QuadTree_new_from_point_list(int dim, int n, int max_level, double *coo
   }
   width = fmax(width, 0.00001);/* if we only have one point, width = 0! */
   width *= 0.52;
-  qt = QuadTree_new(dim, center, width, max_level);
-
-  for (i = 0; i < n; i++){
-    qt = QuadTree_add(qt, &(coord[i*dim]), 1, i);
+  if (n > 0) {
+    qt = flat_new(dim, n, max_level, coord, center, width);
+  } else {
+    qt = QuadTree_new(dim, center, width, max_level);
   }
 
 
@@ -369,12 +937,17 @@ QuadTree QuadTree_new(int dim, double *center, double width, int max_level){
   q->l = NULL;
   q->max_level = max_level;
   q->data = NULL;
+  q->flat = NULL;
   return q;
 }
 
 void QuadTree_delete(QuadTree q){
   int i, dim;
   if (!q) return;
+  if (q->flat) {
+    flat_delete(q->flat);
+    return;
+  }
   dim = q->dim;
   free(q->center);
   free(q->average);
@@ -514,6 +1087,7 @@ static QuadTree QuadTree_add_internal(QuadTree q, double *coord, double weight,
 
 QuadTree QuadTree_add(QuadTree q, double *coord, double weight, int id){
   if (!q) return q;
+  assert(!q->flat && "cannot add to a tree from QuadTree_new_from_point_list");
   return QuadTree_add_internal(q, coord, weight, id, 0);
   
 }
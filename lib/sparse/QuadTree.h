@@ -10,6 +10,7 @@
 
 #pragma once
 
+#include <stddef.h>
 #include <stdio.h>
 
 #ifdef __cplusplus
@@ -44,6 +45,8 @@ struct QuadTree_struct {
   node_data l;
   int max_level;
   void *data;
+  struct QuadTree_flat *flat;/* if non-NULL, this is the root of a tree from QuadTree_new_from_point_list,
+				whose cells and points live in contiguous arrays owned by flat */
 };
 
 
@@ -55,6 +58,8 @@ QuadTree QuadTree_add(QuadTree q, double *coord, double weight, int id);/* coord
 
 void QuadTree_print(FILE *fp, QuadTree q);
 
+/* build a tree of n points in one go. Cells and points are stored contiguously, in Morton order. The
+   result can be walked like any other tree but not added to. */
 QuadTree QuadTree_new_from_point_list(int dim, int n, int max_level, double *coord);
 
 double point_distance(double *p1, double *p2, int dim);
@@ -62,7 +67,8 @@ double point_distance(double *p1, double *p2, int dim);
 void QuadTree_get_supernodes(QuadTree qt, double bh, double *pt, int nodeid, int *nsuper, 
 			     int *nsupermax, double **center, double **supernode_wgts, double **distances, double *counts);
 
-void QuadTree_get_repulsive_force(QuadTree qt, double *force, double *x, double bh, double p, double KP, double *counts);
+void QuadTree_get_repulsive_force(QuadTree qt, double *force, double *x, double bh, double p, double KP, double *counts,
+                                  size_t threads);
 
 /* find the nearest point and put in ymin, index in imin and distance in min */
 void QuadTree_get_nearest(QuadTree qt, double *x, double *ymin, int *imin, double *min);
@@ -14,20 +14,21 @@
 #include <sparse/general.h>
 #include <errno.h>
 #include <util/alloc.h>
+#include <util/random.h>
 
 #ifdef DEBUG
 double _statistics[10];
 #endif
 
 double drand(void){
-  return rand()/(double) RAND_MAX;
+  return gv_rand()/(double) RAND_MAX;
 }
 
 int irand(int n){
   /* 0, 1, ..., n-1 */
   assert(n > 1);
   /*return (int) MIN(floor(drand()*n),n-1);*/
-  return rand()%n;
+  return gv_rand()%n;
 }
 
 int *random_permutation(int n){
@@ -0,0 +1,140 @@
+/// @file
+/// @brief formatting of numbers as `printf("%.5g")` does, without `printf`
+///
+/// Layout results are attached to a graph as `%.5g` text, several numbers for
+/// every node and edge, and for large graphs going through `snprintf` for each
+/// of them is a noticeable part of producing annotated output. `gv_numfmt`
+/// formats the common magnitudes directly and hands everything else (exact
+/// ties, very small or large magnitudes, NaN, infinities) to `snprintf`, so
+/// its result is always byte-identical to `%.5g` in the C locale.
+
+#pragma once
+
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+/// buffer size sufficient for any `gv_numfmt` result, including the NUL
+enum { GV_NUMFMT_SIZE = 32 };
+
+/// write `v` formatted as `%.5g` in the C locale
+///
+/// @param buf Destination of at least `GV_NUMFMT_SIZE` bytes
+/// @param v Number to format
+/// @return Length of the written string, excluding the NUL terminator
+static inline size_t gv_numfmt(char *buf, double v) {
+  // powers of ten, all exactly representable
+  static const double POW10[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,
+                                 1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                 1e12, 1e13, 1e14, 1e15, 1e16, 1e17,
+                                 1e18, 1e19, 1e20};
+  enum { E_MIN = -4, E_MAX = 19 };
+
+  if (v == 0) {
+    size_t len = 0;
+    if (signbit(v)) {
+      buf[len++] = '-';
+    }
+    buf[len++] = '0';
+    buf[len] = '\0';
+    return len;
+  }
+
+  const double a = v < 0 ? -v : v;
+  if (!isfinite(v) || a < 1e-4 || a >= POW10[E_MAX + 1]) {
+    return (size_t)snprintf(buf, GV_NUMFMT_SIZE, "%.5g", v);
+  }
+
+  // find the decimal exponent e, so that a / 10^(e - 4) is in [10000, 100000)
+  int e = 0;
+  if (a >= 1) {
+    while (e < E_MAX && a >= POW10[e + 1]) {
+      ++e;
+    }
+  } else {
+    e = -1;
+    while (e > E_MIN && a * POW10[-e] < 1) {
+      --e;
+    }
+  }
+  double scaled = 0;
+  bool ok = false;
+  for (int tries = 0; tries < 2; ++tries) {
+    scaled = e >= 4 ? a / POW10[e - 4] : a * POW10[4 - e];
+    if (scaled < 1e4 && e > E_MIN) {
+      --e; // estimate was off for a value just below a power of ten
+    } else if (scaled >= 1e5 && e < E_MAX) {
+      ++e;
+    } else {
+      ok = scaled >= 1e4 && scaled < 1e5;
+      break;
+    }
+  }
+
+  // `scaled` is within a few ulps of the exact quotient, so rounding it agrees
+  // with `printf` everywhere except close to a tie, which `printf` resolves
+  // from the exact binary value
+  unsigned long m = (unsigned long)scaled;
+  const double frac = scaled - (double)m;
+  if (!ok || (frac > 0.5 - 1e-6 && frac < 0.5 + 1e-6)) {
+    return (size_t)snprintf(buf, GV_NUMFMT_SIZE, "%.5g", v);
+  }
+  if (frac > 0.5) {
+    ++m;
+  }
+  if (m == 100000) { // rounding carried into a new digit
+    m = 10000;
+    ++e;
+  }
+
+  // the five significant digits, without trailing zeros
+  char digits[5];
+  for (int i = 4; i >= 0; --i) {
+    digits[i] = (char)('0' + m % 10);
+    m /= 10;
+  }
+  int ndigits = 5;
+  while (ndigits > 1 && digits[ndigits - 1] == '0') {
+    --ndigits;
+  }
+
+  char *p = buf;
+  if (v < 0) {
+    *p++ = '-';
+  }
+  if (e > 4) { // exponential notation
+    *p++ = digits[0];
+    if (ndigits > 1) {
+      *p++ = '.';
+      for (int i = 1; i < ndigits; ++i) {
+        *p++ = digits[i];
+      }
+    }
+    *p++ = 'e';
+    *p++ = '+';
+    *p++ = (char)('0' + e / 10);
+    *p++ = (char)('0' + e % 10);
+  } else if (e >= 0) {
+    for (int i = 0; i <= e; ++i) {
+      *p++ = digits[i];
+    }
+    if (ndigits > e + 1) {
+      *p++ = '.';
+      for (int i = e + 1; i < ndigits; ++i) {
+        *p++ = digits[i];
+      }
+    }
+  } else {
+    *p++ = '0';
+    *p++ = '.';
+    for (int i = -1; i > e; --i) {
+      *p++ = '0';
+    }
+    for (int i = 0; i < ndigits; ++i) {
+      *p++ = digits[i];
+    }
+  }
+  *p = '\0';
+  return (size_t)(p - buf);
+}
@@ -0,0 +1,72 @@
+/// @file
+/// @brief implementation of the generators in random.h
+
+#include "config.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <util/random.h>
+#include <util/tls.h>
+
+/// state of the calling thread’s private generator
+static TLS struct {
+  bool enabled;
+  uint64_t state;
+} prng;
+
+/// SplitMix64 step
+///
+/// This is small, fast, passes the usual statistical test suites, and every
+/// seed (including 0) yields a full-period sequence.
+static uint64_t next(void) {
+  uint64_t z = (prng.state += UINT64_C(0x9e3779b97f4a7c15));
+  z = (z ^ (z >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
+  z = (z ^ (z >> 27)) * UINT64_C(0x94d049bb133111eb);
+  return z ^ (z >> 31);
+}
+
+void gv_rand_private(bool enable) {
+  prng.enabled = enable;
+  prng.state = 1;
+}
+
+void gv_srand(unsigned seed) {
+  if (prng.enabled) {
+    prng.state = seed;
+    return;
+  }
+  srand(seed);
+}
+
+int gv_rand(void) {
+  if (prng.enabled) {
+    return (int)(next() % ((uint64_t)RAND_MAX + 1));
+  }
+  return rand();
+}
+
+void gv_srand48(long seed) {
+  if (prng.enabled) {
+    prng.state = (uint64_t)seed;
+    return;
+  }
+#ifdef HAVE_SRAND48
+  srand48(seed);
+#else
+  srand((unsigned)seed);
+#endif
+}
+
+double gv_drand48(void) {
+  if (prng.enabled) {
+    // use the upper 53 bits to fill a double’s mantissa
+    return (double)(next() >> 11) * 0x1.0p-53;
+  }
+#if defined(HAVE_DRAND48) || !defined(_WIN32)
+  return drand48();
+#else
+  // match the fallback `drand48` in lib/common/utils.c
+  return (double)rand() / RAND_MAX;
+#endif
+}
@@ -0,0 +1,49 @@
+/// @file
+/// @brief pseudo-random number generation that can be made thread-private
+///
+/// By default, these functions forward to the C library generators (`rand`,
+/// `drand48`, etc) so existing layouts are reproduced exactly. A thread that
+/// needs a random sequence that is both unaffected by and does not affect other
+/// threads can switch to a private generator with `gv_rand_private`. The
+/// private generator is the same on every platform, so a sequence produced from
+/// it depends only on the seeds it is given.
+
+#pragma once
+
+#include <stdbool.h>
+
+#ifndef UTIL_API
+#if !defined(__CYGWIN__) && defined(__GNUC__) && !defined(__MINGW32__)
+#define UTIL_API __attribute__((visibility("hidden")))
+#else
+#define UTIL_API /* nothing */
+#endif
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// switch the calling thread to or from its private generator
+///
+/// Enabling the private generator also resets it to a fixed initial state, as
+/// if it had just been seeded with 1.
+///
+/// @param enable True to use a private generator, false to use the C library
+UTIL_API void gv_rand_private(bool enable);
+
+/// `srand` equivalent
+UTIL_API void gv_srand(unsigned seed);
+
+/// `rand` equivalent, returning a value in `[0, RAND_MAX]`
+UTIL_API int gv_rand(void);
+
+/// `srand48` equivalent
+UTIL_API void gv_srand48(long seed);
+
+/// `drand48` equivalent, returning a value in `[0, 1)`
+UTIL_API double gv_drand48(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,123 @@
+/// @file
+/// @brief unit test for numfmt.h
+
+#include <assert.h>
+#include <float.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <util/numfmt.h>
+
+/// count of failed comparisons
+static int failures;
+
+/// compare the result of `gv_numfmt` against `snprintf`
+static void check(double v) {
+  char expected[GV_NUMFMT_SIZE];
+  snprintf(expected, sizeof(expected), "%.5g", v);
+  char actual[GV_NUMFMT_SIZE];
+  const size_t len = gv_numfmt(actual, v);
+  if (strcmp(expected, actual) != 0 || len != strlen(expected)) {
+    fprintf(stderr, "%.17g: expected \"%s\", got \"%s\" (length %zu)\n", v,
+            expected, actual, len);
+    ++failures;
+  }
+}
+
+/// the adjacent representable number, away from zero for `step` 1 and towards
+/// zero for `step` -1
+static double adjacent(double v, int step) {
+  uint64_t bits;
+  memcpy(&bits, &v, sizeof(bits));
+  bits += (uint64_t)(int64_t)step;
+  memcpy(&v, &bits, sizeof(v));
+  return v;
+}
+
+/// `10^e`, close enough to make test values from
+static double power(int e) {
+  double p = 1;
+  for (; e > 0; --e) {
+    p *= 10;
+  }
+  for (; e < 0; ++e) {
+    p /= 10;
+  }
+  return p;
+}
+
+/// check a value, its negation and its neighbours
+static void check_around(double v) {
+  const double vs[] = {v, adjacent(v, -1), adjacent(v, 1)};
+  for (size_t i = 0; i < sizeof(vs) / sizeof(vs[0]); ++i) {
+    check(vs[i]);
+    check(-vs[i]);
+  }
+}
+
+/// a deterministic generator, so failures are reproducible
+static uint64_t next(uint64_t *state) {
+  *state = *state * UINT64_C(6364136223846793005) + UINT64_C(1442695040888963407);
+  return *state >> 11;
+}
+
+int main(void) {
+  // special values
+  check(0.0);
+  check(-0.0);
+  check(INFINITY);
+  check(-INFINITY);
+  check(NAN);
+  check(DBL_MIN);
+  check(DBL_MAX);
+  check(adjacent(0.0, 1));
+
+  // powers of ten and values just rounding up to them
+  for (int e = -8; e <= 25; ++e) {
+    const double p = power(e);
+    check_around(p);
+    check_around(p * 0.99999);
+    check_around(p * 0.999995);
+    check_around(p * 0.9999951);
+    check_around(p * 0.9999949);
+  }
+
+  // ties at the fifth significant digit, which printf settles on the exact
+  // binary value
+  for (int e = -6; e <= 8; ++e) {
+    for (int d = 10000; d < 100000; d += 7) {
+      check_around((d + 0.5) * power(e - 4));
+    }
+  }
+
+  // numbers with few decimals, as layout coordinates usually are
+  for (int i = -200000; i <= 200000; ++i) {
+    check(i / 100.0);
+    check(i / 8.0);
+  }
+
+  // values of every magnitude
+  uint64_t state = 42;
+  for (int i = 0; i < 1000000; ++i) {
+    const double mantissa = (double)next(&state) / (double)(UINT64_C(1) << 53);
+    const int e = (int)(next(&state) % 40) - 12;
+    check(mantissa * power(e));
+    check(-mantissa * power(e));
+  }
+
+  // arbitrary bit patterns
+  for (int i = 0; i < 1000000; ++i) {
+    uint64_t bits = next(&state) << 11 | next(&state);
+    double v;
+    memcpy(&v, &bits, sizeof(v));
+    check(v);
+  }
+
+  if (failures > 0) {
+    fprintf(stderr, "%d mismatches\n", failures);
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
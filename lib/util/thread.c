@@ -0,0 +1,299 @@
+/// @file
+/// @brief implementation of the threading aids in thread.h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <util/alloc.h>
+#include <util/thread.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+void gv_mutex_lock(gv_mutex_t *m) {
+  AcquireSRWLockExclusive((PSRWLOCK)m);
+}
+void gv_mutex_unlock(gv_mutex_t *m) {
+  ReleaseSRWLockExclusive((PSRWLOCK)m);
+}
+#else
+void gv_mutex_lock(gv_mutex_t *m) { (void)pthread_mutex_lock(m); }
+void gv_mutex_unlock(gv_mutex_t *m) { (void)pthread_mutex_unlock(m); }
+#endif
+
+size_t gv_hardware_threads(void) {
+#ifdef _WIN32
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  if (info.dwNumberOfProcessors > 0) {
+    return (size_t)info.dwNumberOfProcessors;
+  }
+#elif defined(_SC_NPROCESSORS_ONLN)
+  const long n = sysconf(_SC_NPROCESSORS_ONLN);
+  if (n > 0) {
+    return (size_t)n;
+  }
+#endif
+  return 1;
+}
+
+/// a loop being run by `gv_parallel_for`
+typedef struct {
+  size_t n;    ///< number of iterations
+  size_t next; ///< next iteration to hand out
+  gv_mutex_t lock; ///< protects `next`
+  void (*fn)(void *arg, size_t index, size_t worker);
+  void *arg;
+} job_t;
+
+/// something for a new thread to do
+typedef struct {
+  void (*run)(void *task); ///< called with a pointer to this task
+} task_t;
+
+/// a worker taking part in a job
+typedef struct {
+  task_t task; ///< must be first
+  job_t *job;
+  size_t id;
+} worker_t;
+
+/// claim and run iterations until there are none left
+static void drain(job_t *job, size_t worker) {
+  for (;;) {
+    gv_mutex_lock(&job->lock);
+    const size_t index = job->next;
+    if (index < job->n) {
+      ++job->next;
+    }
+    gv_mutex_unlock(&job->lock);
+
+    if (index >= job->n) {
+      return;
+    }
+    job->fn(job->arg, index, worker);
+  }
+}
+
+static void work(void *task) {
+  worker_t *w = task;
+  drain(w->job, w->id);
+}
+
+#ifdef _WIN32
+typedef HANDLE thread_t;
+
+static DWORD WINAPI entry(LPVOID arg) {
+  task_t *task = arg;
+  task->run(task);
+  return 0;
+}
+
+static bool thread_start(thread_t *t, task_t *task) {
+  *t = CreateThread(NULL, 0, entry, task, 0, NULL);
+  return *t != NULL;
+}
+
+static void thread_join(thread_t t) {
+  (void)WaitForSingleObject(t, INFINITE);
+  (void)CloseHandle(t);
+}
+#else
+typedef pthread_t thread_t;
+
+static void *entry(void *arg) {
+  task_t *task = arg;
+  task->run(task);
+  return NULL;
+}
+
+static bool thread_start(thread_t *t, task_t *task) {
+  return pthread_create(t, NULL, entry, task) == 0;
+}
+
+static void thread_join(thread_t t) { (void)pthread_join(t, NULL); }
+#endif
+
+void gv_parallel_for(size_t n, size_t threads,
+                     void (*fn)(void *arg, size_t index, size_t worker),
+                     void *arg) {
+  if (threads > n) {
+    threads = n;
+  }
+
+  if (threads <= 1) {
+    for (size_t i = 0; i < n; ++i) {
+      fn(arg, i, 0);
+    }
+    return;
+  }
+
+  job_t job = {.n = n, .lock = GV_MUTEX_INIT, .fn = fn, .arg = arg};
+
+  // the calling thread is worker 0, so we need one fewer extra thread
+  thread_t *pool = gv_calloc(threads - 1, sizeof(pool[0]));
+  worker_t *workers = gv_calloc(threads - 1, sizeof(workers[0]));
+  size_t started = 0;
+  for (size_t i = 0; i < threads - 1; ++i) {
+    workers[i] = (worker_t){.task = {work}, .job = &job, .id = i + 1};
+    if (!thread_start(&pool[i], &workers[i].task)) {
+      // run with however many workers we managed to start
+      break;
+    }
+    ++started;
+  }
+
+  drain(&job, 0);
+
+  for (size_t i = 0; i < started; ++i) {
+    thread_join(pool[i]);
+  }
+  free(workers);
+  free(pool);
+
+#ifndef _WIN32
+  (void)pthread_mutex_destroy(&job.lock);
+#endif
+}
+
+static gv_mutex_t global_lock = GV_MUTEX_INIT;
+
+void gv_global_lock(void) { gv_mutex_lock(&global_lock); }
+
+void gv_global_unlock(void) { gv_mutex_unlock(&global_lock); }
+
+#ifdef _WIN32
+typedef CONDITION_VARIABLE cond_t;
+#define COND_INIT CONDITION_VARIABLE_INIT
+static void cond_wait(cond_t *c, gv_mutex_t *m) {
+  (void)SleepConditionVariableSRW(c, (PSRWLOCK)m, INFINITE, 0);
+}
+static void cond_signal(cond_t *c) { WakeConditionVariable(c); }
+static void cond_destroy(cond_t *c) { (void)c; }
+#else
+typedef pthread_cond_t cond_t;
+#define COND_INIT PTHREAD_COND_INITIALIZER
+static void cond_wait(cond_t *c, gv_mutex_t *m) {
+  (void)pthread_cond_wait(c, m);
+}
+static void cond_signal(cond_t *c) { (void)pthread_cond_signal(c); }
+static void cond_destroy(cond_t *c) { (void)pthread_cond_destroy(c); }
+#endif
+
+struct gv_prefetch_s {
+  task_t task; ///< must be first
+  void *(*produce)(void *arg);
+  void *arg;
+  bool threaded; ///< is there a producer thread?
+  thread_t thread;
+
+  gv_mutex_t lock;   ///< protects the fields below
+  cond_t not_empty;  ///< signalled when an item is queued or `done` is set
+  cond_t not_full;   ///< signalled when an item is taken or `stop` is set
+  void **items;      ///< ring buffer of queued items
+  size_t depth;      ///< capacity of `items`
+  size_t head;       ///< index of the oldest queued item
+  size_t size;       ///< number of queued items
+  bool done;         ///< has `produce` returned NULL?
+  bool stop;         ///< has the consumer asked the producer to stop?
+};
+
+static void prefetch(void *task) {
+  gv_prefetch_t *p = task;
+  for (;;) {
+    gv_mutex_lock(&p->lock);
+    while (p->size == p->depth && !p->stop) {
+      cond_wait(&p->not_full, &p->lock);
+    }
+    const bool stop = p->stop;
+    gv_mutex_unlock(&p->lock);
+    if (stop) {
+      return;
+    }
+
+    // produce outside the lock, so the consumer can take earlier items
+    void *item = p->produce(p->arg);
+
+    gv_mutex_lock(&p->lock);
+    if (item == NULL) {
+      p->done = true;
+    } else {
+      p->items[(p->head + p->size) % p->depth] = item;
+      ++p->size;
+    }
+    cond_signal(&p->not_empty);
+    gv_mutex_unlock(&p->lock);
+    if (item == NULL) {
+      return;
+    }
+  }
+}
+
+gv_prefetch_t *gv_prefetch_start(size_t depth, void *(*produce)(void *arg),
+                                 void *arg) {
+  gv_prefetch_t *p = gv_alloc(sizeof(*p));
+  *p = (gv_prefetch_t){.task = {prefetch},
+                       .produce = produce,
+                       .arg = arg,
+                       .lock = GV_MUTEX_INIT,
+                       .not_empty = COND_INIT,
+                       .not_full = COND_INIT,
+                       .depth = depth > 0 ? depth : 1};
+  p->items = gv_calloc(p->depth, sizeof(p->items[0]));
+  p->threaded = thread_start(&p->thread, &p->task);
+  return p;
+}
+
+void *gv_prefetch_next(gv_prefetch_t *p) {
+  if (!p->threaded) {
+    if (p->done) {
+      return NULL;
+    }
+    void *item = p->produce(p->arg);
+    p->done = item == NULL;
+    return item;
+  }
+
+  gv_mutex_lock(&p->lock);
+  while (p->size == 0 && !p->done) {
+    cond_wait(&p->not_empty, &p->lock);
+  }
+  void *item = NULL;
+  if (p->size > 0) {
+    item = p->items[p->head];
+    p->head = (p->head + 1) % p->depth;
+    --p->size;
+    cond_signal(&p->not_full);
+  }
+  gv_mutex_unlock(&p->lock);
+  return item;
+}
+
+void gv_prefetch_stop(gv_prefetch_t *p, void (*discard)(void *item)) {
+  if (p->threaded) {
+    gv_mutex_lock(&p->lock);
+    p->stop = true;
+    cond_signal(&p->not_full);
+    gv_mutex_unlock(&p->lock);
+    thread_join(p->thread);
+  }
+
+  for (; p->size > 0; --p->size) {
+    if (discard != NULL) {
+      discard(p->items[p->head]);
+    }
+    p->head = (p->head + 1) % p->depth;
+  }
+
+  cond_destroy(&p->not_full);
+  cond_destroy(&p->not_empty);
+#ifndef _WIN32
+  (void)pthread_mutex_destroy(&p->lock);
+#endif
+  free(p->items);
+  free(p);
+}
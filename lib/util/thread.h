@@ -0,0 +1,132 @@
+/// @file
+/// @brief minimal worker pool for data-parallel loops, and other threading aids
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+#ifndef UTIL_API
+#if !defined(__CYGWIN__) && defined(__GNUC__) && !defined(__MINGW32__)
+#define UTIL_API __attribute__((visibility("hidden")))
+#else
+#define UTIL_API /* nothing */
+#endif
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// how many threads the current machine can usefully run at once
+///
+/// @return Number of online processors, or 1 if this cannot be determined
+UTIL_API size_t gv_hardware_threads(void);
+
+/// run `fn(arg, index, worker)` for every `index` in `[0, n)`
+///
+/// Iterations are handed out to up to `threads` workers on demand, so `fn` must
+/// not depend on the order in which iterations are run or which worker runs
+/// them. `worker` is in `[0, threads)` and is unique among the workers running
+/// concurrently, making it suitable for indexing per-worker scratch space. The
+/// calling thread acts as worker 0. If `threads` is ≤ 1, `n` is ≤ 1, or threads
+/// cannot be created, all iterations are run by the caller in increasing order.
+///
+/// @param n Number of iterations
+/// @param threads Maximum number of workers to use
+/// @param fn Function to run for each iteration
+/// @param arg Opaque value to pass to `fn`
+UTIL_API void gv_parallel_for(size_t n, size_t threads,
+                              void (*fn)(void *arg, size_t index,
+                                         size_t worker),
+                              void *arg);
+
+/// acquire the process-wide lock
+///
+/// This is intended for serializing calls into third-party code that is not
+/// safe to call concurrently. It is not recursive.
+UTIL_API void gv_global_lock(void);
+
+/// release the process-wide lock
+UTIL_API void gv_global_unlock(void);
+
+/// a lock, for protecting state that more than one thread may touch
+///
+/// e.g.
+///
+///   static gv_mutex_t my_lock = GV_MUTEX_INIT;
+#ifdef _WIN32
+typedef struct {
+  void *ptr; ///< same layout as an `SRWLOCK`
+} gv_mutex_t;
+#define GV_MUTEX_INIT {0}
+#else
+typedef pthread_mutex_t gv_mutex_t;
+#define GV_MUTEX_INIT PTHREAD_MUTEX_INITIALIZER
+#endif
+
+/// acquire a lock, which must not already be held by the calling thread
+UTIL_API void gv_mutex_lock(gv_mutex_t *m);
+
+/// release a lock held by the calling thread
+UTIL_API void gv_mutex_unlock(gv_mutex_t *m);
+
+/// add to a counter that other threads may change at the same time
+///
+/// @param counter Counter to change, which other threads must also change
+///   only through this function
+/// @param delta Amount to add, or to subtract if negative
+/// @return The new value of the counter
+static inline uint64_t gv_atomic_add(uint64_t *counter, int64_t delta) {
+#ifdef _MSC_VER
+  return (uint64_t)_InterlockedExchangeAdd64((volatile int64_t *)counter,
+                                             delta) +
+         (uint64_t)delta;
+#else
+  return __atomic_add_fetch(counter, (uint64_t)delta, __ATOMIC_ACQ_REL);
+#endif
+}
+
+/// a thread producing items ahead of the thread consuming them
+typedef struct gv_prefetch_s gv_prefetch_t;
+
+/// start producing items on a new thread
+///
+/// `produce(arg)` is called repeatedly on the new thread, and each non-NULL
+/// item it returns is queued for `gv_prefetch_next`, until it returns NULL.
+/// The new thread waits while `depth` items are queued. If a thread cannot be
+/// created, items are instead produced by `gv_prefetch_next` as they are
+/// asked for.
+///
+/// @param depth Maximum number of items to queue, at least 1
+/// @param produce Function to make the next item, or return NULL when done
+/// @param arg Opaque value to pass to `produce`
+/// @return A handle to pass to `gv_prefetch_next` and `gv_prefetch_stop`
+UTIL_API gv_prefetch_t *gv_prefetch_start(size_t depth,
+                                          void *(*produce)(void *arg),
+                                          void *arg);
+
+/// take the next item, waiting for it if necessary
+///
+/// Items are returned in the order they were produced.
+///
+/// @return The next item, or NULL if `produce` has returned NULL
+UTIL_API void *gv_prefetch_next(gv_prefetch_t *p);
+
+/// stop producing items and release the handle
+///
+/// If `produce` is running, this waits for it to return. Items produced but
+/// not taken by `gv_prefetch_next` are passed to `discard`, if it is non-NULL.
+UTIL_API void gv_prefetch_stop(gv_prefetch_t *p, void (*discard)(void *item));
+
+#ifdef __cplusplus
+}
+#endif
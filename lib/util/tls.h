@@ -0,0 +1,20 @@
+/// \file
+/// \brief abstraction for thread-local storage
+/// \ingroup cgraph_utils
+
+#pragma once
+
+/// thread-local storage specifier
+///
+/// e.g.
+///
+///   static TLS int my_per_thread_counter;
+#ifdef _MSC_VER
+#define TLS __declspec(thread)
+#elif defined(__GNUC__)
+#define TLS __thread
+#else
+// assume this environment does not support threads and fall back to (thread
+// unsafe) globals
+#define TLS /* nothing */
+#endif
@@ -41,6 +41,7 @@ typedef enum {
 	FORMAT_XDOT,
 	FORMAT_XDOT12,
 	FORMAT_XDOT14,
+	FORMAT_GVB,
 } format_type;
 
 #define XDOTVERSION "1.7"
@@ -401,6 +402,7 @@ static void dot_begin_graph(GVJ_t *job)
 
     switch (job->render.id) {
 	case FORMAT_DOT:
+	case FORMAT_GVB:
 	    attach_attrs(g);
 	    break;
 	case FORMAT_CANON:
@@ -446,6 +448,11 @@ static void xdot_end_graph(graph_t* g)
     textflags[EMIT_GLABEL] = 0;
 }
 
+static size_t gvb_write(void *chan, const void *data, size_t size)
+{
+    return gvwrite(chan, data, size);
+}
+
 typedef int (*putstrfn) (void *chan, const char *str);
 typedef int (*flushfn) (void *chan);
 static void dot_end_graph(GVJ_t *job)
@@ -481,6 +488,10 @@ static void dot_end_graph(GVJ_t *job)
 	    if (!(job->flags & OUTPUT_NOT_REQUIRED))
 		agwrite(g, job);
 	    break;
+	case FORMAT_GVB:
+	    if (!(job->flags & OUTPUT_NOT_REQUIRED))
+		agwritegvb(g, job, gvb_write);
+	    break;
 	default:
 	    UNREACHABLE();
     }
@@ -768,6 +779,13 @@ gvdevice_features_t device_features_dot = {
     {72.,72.},			/* default dpi */
 };
 
+gvdevice_features_t device_features_gvb = {
+    GVDEVICE_BINARY_FORMAT,	/* flags */
+    {0.,0.},			/* default margin - points */
+    {0.,0.},			/* default page width, height - points */
+    {72.,72.},			/* default dpi */
+};
+
 gvplugin_installed_t gvrender_dot_types[] = {
     {FORMAT_DOT, "dot", 1, &dot_engine, &render_features_dot},
     {FORMAT_XDOT, "xdot", 1, &xdot_engine, &render_features_xdot},
@@ -783,5 +801,6 @@ gvplugin_installed_t gvdevice_dot_types[] = {
     {FORMAT_XDOT, "xdot:xdot", 1, NULL, &device_features_dot},
     {FORMAT_XDOT12, "xdot1.2:xdot", 1, NULL, &device_features_dot},
     {FORMAT_XDOT14, "xdot1.4:xdot", 1, NULL, &device_features_dot},
+    {FORMAT_GVB, "gvb:dot", 1, NULL, &device_features_gvb},
     {0, NULL, 0, NULL, NULL}
 };
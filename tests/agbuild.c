@@ -0,0 +1,212 @@
+/// \file
+/// \brief test of adding nodes and edges in bulk
+///
+/// Builds the same graphs with `agbuild` and with `agnode`, `agedge` and
+/// `agxset` one call at a time, for each kind of graph, and checks they are
+/// written out identically, before and after some of their nodes and edges are
+/// deleted.
+///
+/// See test_regression.py:test_agbuild
+
+#ifdef NDEBUG
+#error "this program is not intended to be compiled with assertions disabled"
+#endif
+
+#include <assert.h>
+#include <graphviz/cgraph.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum { NODES = 300, EDGES = 1500 };
+
+static char *names[NODES];
+static size_t ends[2 * EDGES];
+static char *colors[EDGES];
+static char *labels[NODES];
+
+/// a graph with some nodes, edges and attributes already in it
+static Agraph_t *start(Agdesc_t desc) {
+  Agraph_t *g = agopen("G", desc, NULL);
+  agattr(g, AGEDGE, "color", "black");
+  Agraph_t *sub = agsubg(g, "sub", 1);
+  agattr(sub, AGEDGE, "color", "red"); // a local default
+  Agnode_t *a = agnode(g, "n1", 1);
+  Agnode_t *b = agnode(g, "n2", 1);
+  agedge(g, a, b, NULL, 1);
+  agedge(g, b, b, NULL, 1);
+  agedge(sub, agnode(sub, "n3", 1), a, NULL, 1);
+  return g;
+}
+
+/// add the nodes and edges one at a time, as `agbuild` should
+static void build_slowly(Agraph_t *g, size_t nnodes, size_t nedges) {
+  Agnode_t *n[NODES];
+  for (size_t i = 0; i < nnodes; ++i) {
+    n[i] = agnode(g, names[i], 1);
+  }
+  Agedge_t *e[EDGES];
+  for (size_t i = 0; i < nedges; ++i) {
+    e[i] = agedge(g, n[ends[2 * i]], n[ends[2 * i + 1]], NULL, 1);
+  }
+  Agsym_t *label = agattr(agroot(g), AGNODE, "label", NULL);
+  if (label == NULL) {
+    label = agattr(agroot(g), AGNODE, "label", "");
+  }
+  for (size_t i = 0; i < nnodes; ++i) {
+    if (labels[i] != NULL) {
+      agxset(n[i], label, labels[i]);
+    }
+  }
+  Agsym_t *color = agattr(agroot(g), AGEDGE, "color", NULL);
+  for (size_t i = 0; i < nedges; ++i) {
+    if (e[i] != NULL && colors[i] != NULL) {
+      agxset(e[i], color, colors[i]);
+    }
+  }
+}
+
+/// add the nodes and edges with `agbuild`
+static void build_quickly(Agraph_t *g, size_t nnodes, size_t nedges) {
+  const Agcolumn_t columns[] = {
+      {.kind = AGNODE, .name = "label", .values = (const char **)labels},
+      {.kind = AGEDGE, .name = "color", .values = (const char **)colors},
+  };
+  Agnode_t *n[NODES];
+  Agedge_t *e[EDGES];
+  const int rc = agbuild(g, nnodes, (const char **)names, nedges, ends,
+                         sizeof(columns) / sizeof(columns[0]), columns, n, e);
+  assert(rc == 0);
+  for (size_t i = 0; i < nnodes; ++i) {
+    assert(n[i] == agnode(g, names[i], 0));
+  }
+  for (size_t i = 0; i < nedges; ++i) {
+    assert(e[i] == NULL || agtail(e[i]) == n[ends[2 * i]] ||
+           agtail(e[i]) == n[ends[2 * i + 1]]);
+  }
+}
+
+/// delete some of the nodes and edges
+static void trim(Agraph_t *g) {
+  int i = 0;
+  for (Agnode_t *n = agfstnode(g), *next; n != NULL; n = next, ++i) {
+    next = agnxtnode(g, n);
+    if (i % 11 == 0) {
+      agdelnode(g, n);
+    } else if (i % 3 == 0) {
+      for (Agedge_t *e = agfstout(g, n), *f; e != NULL; e = f) {
+        f = agnxtout(g, e);
+        agdeledge(g, e);
+        break;
+      }
+      Agedge_t *e = agfstin(g, n);
+      if (e != NULL) {
+        agdeledge(g, e);
+      }
+    }
+  }
+}
+
+static char *serialize(Agraph_t *g) {
+  char *buf = NULL;
+  size_t size = 0;
+  FILE *out = open_memstream(&buf, &size);
+  assert(out != NULL);
+  agwrite(g, out);
+  fclose(out);
+  return buf;
+}
+
+/// build both ways and compare
+static void check(Agdesc_t desc, bool into_subgraph) {
+  Agraph_t *g[2];
+  for (int i = 0; i < 2; ++i) {
+    g[i] = start(desc);
+    Agraph_t *target = into_subgraph ? agsubg(g[i], "sub", 0) : g[i];
+    // build in two batches, so the second adds to nodes that have edges
+    if (i == 0) {
+      build_slowly(target, NODES / 2, EDGES / 2);
+      build_slowly(target, NODES, EDGES);
+    } else {
+      build_quickly(target, NODES / 2, EDGES / 2);
+      build_quickly(target, NODES, EDGES);
+    }
+  }
+
+  char *slow = serialize(g[0]);
+  char *quick = serialize(g[1]);
+  assert(strcmp(slow, quick) == 0 && "agbuild made a different graph");
+  free(quick);
+  free(slow);
+
+  for (int i = 0; i < 2; ++i) {
+    trim(g[i]);
+  }
+  slow = serialize(g[0]);
+  quick = serialize(g[1]);
+  assert(strcmp(slow, quick) == 0 && "agbuild made a different graph");
+  free(quick);
+  free(slow);
+
+  agclose(g[1]);
+  agclose(g[0]);
+}
+
+int main(void) {
+  srand(42);
+  for (size_t i = 0; i < NODES; ++i) {
+    char name[16];
+    // some repeated names, and some names of nodes already in the graph
+    snprintf(name, sizeof(name), "n%d", i % 50 == 7 ? 3 : (int)i);
+    names[i] = strdup(name);
+    if (i % 4 != 0) {
+      snprintf(name, sizeof(name), "L%zu", i);
+      labels[i] = strdup(name);
+    }
+  }
+  for (size_t i = 0; i < EDGES; ++i) {
+    ends[2 * i] = (size_t)rand() % NODES;
+    // some loops and some repeated pairs
+    ends[2 * i + 1] = i % 37 == 0 ? ends[2 * i] : (size_t)rand() % NODES;
+    if (i % 29 == 0 && i > 0) {
+      ends[2 * i] = ends[2 * i - 1];
+      ends[2 * i + 1] = ends[2 * i - 2];
+    }
+    if (i % 5 != 0) {
+      char color[16];
+      snprintf(color, sizeof(color), "#%06x", rand() & 0xffffff);
+      colors[i] = strdup(color);
+    }
+  }
+  // ends of the first batch should be in its nodes
+  for (size_t i = 0; i < EDGES / 2; ++i) {
+    ends[2 * i] %= NODES / 2;
+    ends[2 * i + 1] %= NODES / 2;
+  }
+
+  const Agdesc_t descs[] = {Agdirected, Agstrictdirected, Agundirected,
+                            Agstrictundirected};
+  for (size_t i = 0; i < sizeof(descs) / sizeof(descs[0]); ++i) {
+    check(descs[i], false);
+    check(descs[i], true);
+  }
+
+  // an edge between nodes that do not exist should change nothing
+  Agraph_t *g = agopen("G", Agdirected, NULL);
+  const char *const two[] = {"a", "b"};
+  const size_t bad[] = {0, 2};
+  assert(agbuild(g, 2, two, 1, bad, 0, NULL, NULL, NULL) == -1);
+  assert(agnnodes(g) == 0);
+  agclose(g);
+
+  for (size_t i = 0; i < NODES; ++i) {
+    free(labels[i]);
+    free(names[i]);
+  }
+  for (size_t i = 0; i < EDGES; ++i) {
+    free(colors[i]);
+  }
+  printf("ok\n");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,95 @@
+/// \file
+/// \brief test of building and editing a graph with the arena discipline
+///
+/// Reads a graph from stdin twice, once with the default memory discipline and
+/// once with `AgArenaMemDisc`, makes the same edits to both, and checks they
+/// are written out identically.
+///
+/// See test_regression.py:test_arena_disc
+
+#ifdef NDEBUG
+#error "this program is not intended to be compiled with assertions disabled"
+#endif
+
+#include <assert.h>
+#include <graphviz/cgraph.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/// delete some nodes and edges, and add subgraphs and attributes
+static void edit(Agraph_t *g) {
+  Agraph_t *sub = agsubg(g, "sub", 1);
+  int i = 0;
+  for (Agnode_t *n = agfstnode(g), *next; n != NULL; n = next, ++i) {
+    next = agnxtnode(g, n);
+    if (i % 7 == 0) {
+      agdelnode(g, n);
+    } else if (i % 5 == 0) {
+      agsubnode(sub, n, 1);
+    } else if (i % 3 == 0 && agfstout(g, n) != NULL) {
+      agdeledge(g, agfstout(g, n));
+    }
+  }
+
+  // attributes declared after objects exist grow every object's table
+  agattr(g, AGNODE, "added", "x");
+  agattr(g, AGEDGE, "added", "y");
+  for (Agnode_t *n = agfstnode(g); n != NULL; n = agnxtnode(g, n)) {
+    agsafeset(n, "another", agnameof(n), "");
+    for (Agedge_t *e = agfstout(g, n); e != NULL; e = agnxtout(g, e)) {
+      agsafeset(e, "label", agnameof(n), "");
+    }
+  }
+
+  // a subgraph that is closed again before the graph is
+  Agraph_t *tmp = agsubg(g, "tmp", 1);
+  agsubnode(tmp, agfstnode(g), 1);
+  agclose(tmp);
+}
+
+/// read, edit and write out a graph with the given memory discipline
+static char *process(const char *input, Agmemdisc_t *mem) {
+  Agdisc_t disc = AgDefaultDisc;
+  disc.mem = mem;
+
+  FILE *in = fmemopen((void *)input, strlen(input), "r");
+  assert(in != NULL);
+  Agraph_t *g = agread(in, &disc);
+  assert(g != NULL);
+  fclose(in);
+
+  edit(g);
+
+  char *buf = NULL;
+  size_t size = 0;
+  FILE *out = open_memstream(&buf, &size);
+  assert(out != NULL);
+  agwrite(g, out);
+  fclose(out);
+
+  agclose(g);
+  return buf;
+}
+
+int main(void) {
+  // read all of stdin
+  char *input = NULL;
+  size_t size = 0;
+  FILE *all = open_memstream(&input, &size);
+  assert(all != NULL);
+  for (int c; (c = getchar()) != EOF;) {
+    fputc(c, all);
+  }
+  fclose(all);
+
+  char *heap = process(input, &AgMemDisc);
+  char *arena = process(input, &AgArenaMemDisc);
+  assert(strcmp(heap, arena) == 0 && "arena discipline changed the graph");
+  printf("%s", arena);
+
+  free(arena);
+  free(heap);
+  free(input);
+  return EXIT_SUCCESS;
+}
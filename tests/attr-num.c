@@ -0,0 +1,77 @@
+/// \file
+/// \brief test of reading attribute values as numbers
+///
+/// Checks that `agxget_double` and `agxget_int` parse what they should, and
+/// that the numbers they remember follow changes made with `agxset` and
+/// attributes declared after the numbers were first read.
+///
+/// See test_regression.py:test_attr_num
+
+#ifdef NDEBUG
+#error "this program is not intended to be compiled with assertions disabled"
+#endif
+
+#include <assert.h>
+#include <graphviz/cgraph.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+int main(void) {
+  Agraph_t *g = agopen("G", Agdirected, NULL);
+  Agsym_t *w = agattr(g, AGNODE, "w", "1.5");
+  Agsym_t *k = agattr(g, AGNODE, "k", "");
+  Agnode_t *n = agnode(g, "n", 1);
+
+  double d = -1;
+  int i = -1;
+
+  // defaults
+  assert(agxget_double(n, w, &d) && d == 1.5);
+  assert(agxget_int(n, w, &i) && i == 1);
+  assert(!agxget_double(n, k, &d) && d == 1.5 && "empty value parsed");
+  assert(!agxget_int(n, k, &i) && i == 1 && "empty value parsed");
+
+  // values changed after they have been read
+  agxset(n, w, "3.25");
+  assert(agxget_double(n, w, &d) && d == 3.25);
+  assert(agxget_int(n, w, &i) && i == 3);
+  agxset(n, w, "abc");
+  assert(!agxget_double(n, w, &d) && d == 3.25 && "garbage parsed");
+  assert(!agxget_int(n, w, &i) && i == 3 && "garbage parsed");
+  agxset(n, w, "3.25");
+  assert(agxget_double(n, w, &d) && d == 3.25);
+  agxset(n, k, "99999999999");
+  assert(agxget_double(n, k, &d) && d == 99999999999.0);
+  assert(!agxget_int(n, k, &i) && "out of range int parsed");
+  agxset(n, k, "-7");
+  assert(agxget_int(n, k, &i) && i == -7);
+
+  // attributes declared after numbers were first read
+  Agsym_t *late[10];
+  for (int j = 0; j < 10; j++) {
+    char name[16], value[16];
+    snprintf(name, sizeof(name), "late%d", j);
+    snprintf(value, sizeof(value), "%d", j * 10);
+    late[j] = agattr(g, AGNODE, name, value);
+  }
+  for (int j = 0; j < 10; j++) {
+    assert(agxget_int(n, late[j], &i) && i == j * 10);
+  }
+  agxset(n, late[9], "12.5");
+  assert(agxget_double(n, late[9], &d) && d == 12.5);
+
+  // a node made after the numbers of another were read
+  Agnode_t *m = agnode(g, "m", 1);
+  assert(agxget_double(m, w, &d) && d == 1.5);
+  assert(agxget_int(m, late[5], &i) && i == 50);
+
+  // graph attributes, whose values are also the defaults of subgraphs
+  Agsym_t *s = agattr(g, AGRAPH, "s", "2");
+  assert(agxget_int(g, s, &i) && i == 2);
+  agxset(g, s, "4");
+  assert(agxget_int(g, s, &i) && i == 4);
+
+  agclose(g);
+  printf("ok\n");
+  return EXIT_SUCCESS;
+}
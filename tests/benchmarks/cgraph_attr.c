@@ -0,0 +1,101 @@
+/// @file
+/// @brief micro-benchmark of reading numeric attributes from cgraph
+///
+/// A graph is built whose nodes each carry a number of numeric attributes, as
+/// the layout engines read `width`, `height`, `pos` and so on. Every
+/// attribute of every node is then read repeatedly, once by parsing the
+/// string `agxget` returns and once with `agxget_double`, which parses each
+/// value only the first time it is read. The time for the first pass and the
+/// average of the later ones are reported for each, and the sums of the
+/// values read are checked to agree.
+///
+/// Usage: bench_attr [nodes [attributes [passes]]]
+
+#include <cgraph/cgraph.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/// sum every attribute of every node
+static double pass(Agraph_t *g, Agsym_t **syms, int nsyms, bool cached) {
+  double sum = 0;
+  for (Agnode_t *n = agfstnode(g); n != NULL; n = agnxtnode(g, n)) {
+    for (int i = 0; i < nsyms; i++) {
+      double d = 0;
+      if (cached) {
+        (void)agxget_double(n, syms[i], &d);
+      } else {
+        d = strtod(agxget(n, syms[i]), NULL);
+      }
+      sum += d;
+    }
+  }
+  return sum;
+}
+
+/// time the first and later passes of one way of reading
+static void measure(const char *name, Agraph_t *g, Agsym_t **syms, int nsyms,
+                    int passes, bool cached, double *sum) {
+  double start = now();
+  *sum = pass(g, syms, nsyms, cached);
+  const double first = now() - start;
+
+  start = now();
+  for (int i = 1; i < passes; i++) {
+    (void)pass(g, syms, nsyms, cached);
+  }
+  const double later = passes > 1 ? (now() - start) / (passes - 1) : 0;
+
+  printf("%-16s %12.4f %12.4f\n", name, first, later);
+}
+
+int main(int argc, char **argv) {
+  const long nodes = argc > 1 ? atol(argv[1]) : 100000;
+  const int nsyms = argc > 2 ? atoi(argv[2]) : 8;
+  const int passes = argc > 3 ? atoi(argv[3]) : 10;
+
+  Agraph_t *g = agopen("G", Agdirected, NULL);
+  Agsym_t **syms = calloc((size_t)nsyms, sizeof(syms[0]));
+  if (syms == NULL) {
+    perror("calloc");
+    return EXIT_FAILURE;
+  }
+  for (int i = 0; i < nsyms; i++) {
+    char name[32];
+    snprintf(name, sizeof(name), "num%d", i);
+    syms[i] = agattr(g, AGNODE, name, "0");
+  }
+  srand(42);
+  for (long i = 0; i < nodes; i++) {
+    char name[32];
+    snprintf(name, sizeof(name), "n%ld", i);
+    Agnode_t *n = agnode(g, name, 1);
+    for (int j = 0; j < nsyms; j++) {
+      char value[32];
+      snprintf(value, sizeof(value), "%.4f", (double)rand() / RAND_MAX * 100);
+      agxset(n, syms[j], value);
+    }
+  }
+
+  printf("%ld nodes, %d attributes, %d passes\n", nodes, nsyms, passes);
+  printf("%-16s %12s %12s\n", "reader", "first s", "later s");
+  double parsed, cached;
+  measure("agxget+strtod", g, syms, nsyms, passes, false, &parsed);
+  measure("agxget_double", g, syms, nsyms, passes, true, &cached);
+
+  free(syms);
+  agclose(g);
+
+  if (parsed != cached) {
+    fprintf(stderr, "readers disagree: %f vs %f\n", parsed, cached);
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
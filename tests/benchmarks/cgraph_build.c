@@ -0,0 +1,118 @@
+/// @file
+/// @brief micro-benchmark of constructing graphs in bulk
+///
+/// A random graph with a label on each node and a weight on each edge is made
+/// twice, once with a call to `agnode`, `agedge` or `agxset` for each node,
+/// edge and value, and once with a single call to `agbuild`. The time each
+/// takes is reported, and the two graphs are expected to have the same numbers
+/// of nodes and edges, which is checked.
+///
+/// Usage: bench_build [nodes [edges [strict]]]
+
+#include <cgraph/cgraph.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char **argv) {
+  const size_t nnodes = argc > 1 ? (size_t)atol(argv[1]) : 250000;
+  const size_t nedges = argc > 2 ? (size_t)atol(argv[2]) : 1000000;
+  const bool strict = argc > 3 && atoi(argv[3]) != 0;
+  const Agdesc_t desc = strict ? Agstrictdirected : Agdirected;
+  if (nnodes == 0) {
+    fprintf(stderr, "usage: %s [nodes [edges [strict]]]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  char **names = calloc(nnodes, sizeof(names[0]));
+  char **labels = calloc(nnodes, sizeof(labels[0]));
+  size_t *ends = calloc(2 * nedges, sizeof(ends[0]));
+  char **weights = calloc(nedges, sizeof(weights[0]));
+  Agnode_t **nodes = calloc(nnodes, sizeof(nodes[0]));
+  if (names == NULL || labels == NULL || ends == NULL || weights == NULL ||
+      nodes == NULL) {
+    perror("calloc");
+    return EXIT_FAILURE;
+  }
+  static char *const digits[] = {"1", "2", "3", "4", "5"};
+  srand(42);
+  for (size_t i = 0; i < nnodes; i++) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "n%zu", i);
+    names[i] = strdup(buf);
+    snprintf(buf, sizeof(buf), "node %zu", i);
+    labels[i] = strdup(buf);
+  }
+  for (size_t i = 0; i < nedges; i++) {
+    ends[2 * i] = (size_t)rand() % nnodes;
+    ends[2 * i + 1] = (size_t)rand() % nnodes;
+    weights[i] = digits[rand() % 5];
+  }
+  printf("%zu nodes, %zu edges%s\n", nnodes, nedges, strict ? ", strict" : "");
+
+  // one call at a time
+  double start = now();
+  Agraph_t *g = agopen("G", desc, NULL);
+  Agsym_t *label = agattr(g, AGNODE, "label", "");
+  Agsym_t *weight = agattr(g, AGEDGE, "weight", "");
+  for (size_t i = 0; i < nnodes; i++) {
+    nodes[i] = agnode(g, names[i], 1);
+    agxset(nodes[i], label, labels[i]);
+  }
+  for (size_t i = 0; i < nedges; i++) {
+    Agedge_t *e = agedge(g, nodes[ends[2 * i]], nodes[ends[2 * i + 1]], NULL, 1);
+    agxset(e, weight, weights[i]);
+  }
+  const double calls = now() - start;
+  const int calls_nodes = agnnodes(g);
+  const int calls_edges = agnedges(g);
+  agclose(g);
+
+  // in bulk
+  start = now();
+  g = agopen("G", desc, NULL);
+  const Agcolumn_t columns[] = {
+      {.kind = AGNODE, .name = "label", .values = (const char **)labels},
+      {.kind = AGEDGE, .name = "weight", .values = (const char **)weights},
+  };
+  if (agbuild(g, nnodes, (const char **)names, nedges, ends,
+              sizeof(columns) / sizeof(columns[0]), columns, NULL,
+              NULL) != 0) {
+    fprintf(stderr, "agbuild failed\n");
+    return EXIT_FAILURE;
+  }
+  const double bulk = now() - start;
+  const int bulk_nodes = agnnodes(g);
+  const int bulk_edges = agnedges(g);
+  agclose(g);
+
+  printf("%-10s %9s\n", "api", "seconds");
+  printf("%-10s %9.3f\n", "per-call", calls);
+  printf("%-10s %9.3f\n", "agbuild", bulk);
+
+  for (size_t i = 0; i < nnodes; i++) {
+    free(labels[i]);
+    free(names[i]);
+  }
+  free(nodes);
+  free(weights);
+  free(ends);
+  free(labels);
+  free(names);
+
+  if (calls_nodes != bulk_nodes || calls_edges != bulk_edges) {
+    fprintf(stderr,
+            "graphs differ: %d nodes, %d edges vs %d nodes, %d edges\n",
+            calls_nodes, calls_edges, bulk_nodes, bulk_edges);
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
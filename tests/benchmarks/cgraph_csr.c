@@ -0,0 +1,145 @@
+/// @file
+/// @brief micro-benchmark of traversing a graph through an adjacency snapshot
+///
+/// A random graph is built, and a breadth first search following edges in
+/// both directions is run from its first node repeatedly, once stepping
+/// through cgraph's edge sets with `agfstedge` and `agnxtedge`, and once
+/// through a snapshot taken with `agcsr`. The time to take the snapshot is
+/// reported separately. Both searches are expected to reach the same number
+/// of nodes, which is checked.
+///
+/// Usage: bench_csr [nodes [edges [passes]]]
+
+#include <cgraph/cgraph.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/// what the cgraph search keeps with each node
+typedef struct {
+  Agrec_t h;
+  unsigned pass; ///< last search to reach this node
+} mark_t;
+
+#define MARK(n) (((mark_t *)AGDATA(n))->pass)
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/// search through cgraph, returning the number of nodes reached
+static size_t bfs_cgraph(Agraph_t *g, Agnode_t **queue, unsigned pass) {
+  size_t head = 0, tail = 0;
+  Agnode_t *start = agfstnode(g);
+  MARK(start) = pass;
+  queue[tail++] = start;
+  while (head < tail) {
+    Agnode_t *n = queue[head++];
+    for (Agedge_t *e = agfstedge(g, n); e != NULL; e = agnxtedge(g, e, n)) {
+      Agnode_t *m = aghead(e) == n ? agtail(e) : aghead(e);
+      if (MARK(m) != pass) {
+        MARK(m) = pass;
+        queue[tail++] = m;
+      }
+    }
+  }
+  return tail;
+}
+
+/// search through a snapshot, returning the number of nodes reached
+static size_t bfs_csr(const Agcsr_t *csr, size_t *queue, unsigned *mark,
+                      unsigned pass) {
+  size_t head = 0, tail = 0;
+  mark[0] = pass;
+  queue[tail++] = 0;
+  while (head < tail) {
+    const size_t n = queue[head++];
+    for (size_t k = csr->out[n]; k < csr->out[n + 1]; k++) {
+      const size_t m = csr->head[k];
+      if (mark[m] != pass) {
+        mark[m] = pass;
+        queue[tail++] = m;
+      }
+    }
+    for (size_t k = csr->in[n]; k < csr->in[n + 1]; k++) {
+      const size_t m = csr->tail[k];
+      if (mark[m] != pass) {
+        mark[m] = pass;
+        queue[tail++] = m;
+      }
+    }
+  }
+  return tail;
+}
+
+int main(int argc, char **argv) {
+  const long nodes = argc > 1 ? atol(argv[1]) : 200000;
+  const long edges = argc > 2 ? atol(argv[2]) : 800000;
+  const unsigned passes = argc > 3 ? (unsigned)atoi(argv[3]) : 10;
+  if (nodes < 1 || passes < 1) {
+    fprintf(stderr, "usage: %s [nodes [edges [passes]]]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  Agraph_t *g = agopen("G", Agdirected, NULL);
+  Agnode_t **node = calloc((size_t)nodes, sizeof(node[0]));
+  if (node == NULL) {
+    perror("calloc");
+    return EXIT_FAILURE;
+  }
+  for (long i = 0; i < nodes; i++) {
+    char name[32];
+    snprintf(name, sizeof(name), "n%ld", i);
+    node[i] = agnode(g, name, 1);
+    agbindrec(node[i], "bfs", sizeof(mark_t), true);
+  }
+  srand(42);
+  for (long i = 0; i < edges; i++) {
+    agedge(g, node[rand() % nodes], node[rand() % nodes], NULL, 1);
+  }
+  printf("%ld nodes, %ld edges, %u passes\n", nodes, edges, passes);
+
+  double start = now();
+  size_t reached_cgraph = 0;
+  for (unsigned pass = 1; pass <= passes; pass++) {
+    reached_cgraph = bfs_cgraph(g, node, pass);
+  }
+  const double cgraph = (now() - start) / passes;
+
+  start = now();
+  Agcsr_t *csr = agcsr(g, NULL, 0);
+  const double snapshot = now() - start;
+
+  size_t *queue = calloc(csr->nnodes, sizeof(queue[0]));
+  unsigned *mark = calloc(csr->nnodes, sizeof(mark[0]));
+  if (queue == NULL || mark == NULL) {
+    perror("calloc");
+    return EXIT_FAILURE;
+  }
+  start = now();
+  size_t reached_csr = 0;
+  for (unsigned pass = 1; pass <= passes; pass++) {
+    reached_csr = bfs_csr(csr, queue, mark, pass);
+  }
+  const double traversal = (now() - start) / passes;
+
+  printf("%-10s %12s %12s\n", "traversal", "snapshot s", "search s");
+  printf("%-10s %12s %12.4f\n", "cgraph", "", cgraph);
+  printf("%-10s %12.4f %12.4f\n", "agcsr", snapshot, traversal);
+
+  free(mark);
+  free(queue);
+  agcsrfree(csr);
+  free(node);
+  agclose(g);
+
+  if (reached_cgraph != reached_csr) {
+    fprintf(stderr, "searches disagree: %zu vs %zu nodes reached\n",
+            reached_cgraph, reached_csr);
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,146 @@
+/// @file
+/// @brief micro-benchmark of looking up and iterating over nodes and edges
+///
+/// A random graph is made, with a subgraph holding half of its nodes and the
+/// edges between them. Then nodes are looked up by ID with `agidnode`, edges
+/// by their ends and ID with `agidedge`, and every edge is visited with
+/// `agfstout` and `agnxtout`, in both the root graph and the subgraph. The
+/// time per lookup or per edge visited is reported.
+///
+/// Usage: bench_dict [nodes [edges]]
+
+#include <cgraph/cgraph.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/// look up nodes in random order
+static double find_nodes(Agraph_t *g, Agnode_t **nodes, size_t n,
+                         size_t lookups) {
+  size_t found = 0;
+  const double start = now();
+  for (size_t i = 0; i < lookups; i++) {
+    Agnode_t *v = nodes[(size_t)rand() % n];
+    found += agidnode(g, AGID(v), 0) != NULL;
+  }
+  const double t = now() - start;
+  if (found == 0) {
+    fprintf(stderr, "no nodes found\n");
+    exit(EXIT_FAILURE);
+  }
+  return t / (double)lookups;
+}
+
+/// look up edges in random order
+static double find_edges(Agraph_t *g, Agedge_t **edges, size_t n,
+                         size_t lookups) {
+  size_t found = 0;
+  const double start = now();
+  for (size_t i = 0; i < lookups; i++) {
+    Agedge_t *e = edges[(size_t)rand() % n];
+    found += agidedge(g, agtail(e), aghead(e), AGID(e), 0) != NULL;
+  }
+  const double t = now() - start;
+  if (found == 0) {
+    fprintf(stderr, "no edges found\n");
+    exit(EXIT_FAILURE);
+  }
+  return t / (double)lookups;
+}
+
+/// visit every edge, a number of times
+static double visit_edges(Agraph_t *g, int rounds) {
+  size_t visited = 0;
+  const double start = now();
+  for (int r = 0; r < rounds; r++) {
+    for (Agnode_t *n = agfstnode(g); n != NULL; n = agnxtnode(g, n)) {
+      for (Agedge_t *e = agfstout(g, n); e != NULL; e = agnxtout(g, e)) {
+        visited++;
+      }
+    }
+  }
+  const double t = now() - start;
+  if (visited != (size_t)rounds * (size_t)agnedges(g)) {
+    fprintf(stderr, "visited %zu edges, expected %zu\n", visited,
+            (size_t)rounds * (size_t)agnedges(g));
+    exit(EXIT_FAILURE);
+  }
+  return visited == 0 ? 0 : t / (double)visited;
+}
+
+int main(int argc, char **argv) {
+  const size_t nnodes = argc > 1 ? (size_t)atol(argv[1]) : 200000;
+  const size_t nedges = argc > 2 ? (size_t)atol(argv[2]) : 1000000;
+  if (nnodes == 0) {
+    fprintf(stderr, "usage: %s [nodes [edges]]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  char **names = calloc(nnodes, sizeof(names[0]));
+  size_t *ends = calloc(2 * nedges, sizeof(ends[0]));
+  Agnode_t **nodes = calloc(nnodes, sizeof(nodes[0]));
+  Agedge_t **edges = calloc(nedges, sizeof(edges[0]));
+  if (names == NULL || ends == NULL || nodes == NULL || edges == NULL) {
+    perror("calloc");
+    return EXIT_FAILURE;
+  }
+  srand(42);
+  for (size_t i = 0; i < nnodes; i++) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "n%zu", i);
+    names[i] = strdup(buf);
+  }
+  for (size_t i = 0; i < nedges; i++) {
+    ends[2 * i] = (size_t)rand() % nnodes;
+    ends[2 * i + 1] = (size_t)rand() % nnodes;
+  }
+
+  Agraph_t *g = agopen("G", Agdirected, NULL);
+  if (agbuild(g, nnodes, (const char **)names, nedges, ends, 0, NULL, nodes,
+              edges) != 0) {
+    fprintf(stderr, "agbuild failed\n");
+    return EXIT_FAILURE;
+  }
+  Agraph_t *sub = agsubg(g, "sub", 1);
+  for (size_t i = 0; i < nnodes; i += 2) {
+    agsubnode(sub, nodes[i], 1);
+  }
+  size_t nsubedges = 0;
+  for (size_t i = 0; i < nedges; i++) {
+    if (ends[2 * i] % 2 == 0 && ends[2 * i + 1] % 2 == 0) {
+      edges[nsubedges++] = agsubedge(sub, edges[i], 1);
+    }
+  }
+  printf("%zu nodes, %zu edges, subgraph of %d nodes, %d edges\n", nnodes,
+         nedges, agnnodes(sub), agnedges(sub));
+
+  const size_t lookups = 2000000;
+  // visit enough edges to time, however few the graph has
+  const int rounds = nedges >= lookups ? 5 : (int)(5 * lookups / (nedges + 1));
+  printf("%-22s %10s %10s\n", "operation", "root (ns)", "sub (ns)");
+  printf("%-22s %10.1f %10.1f\n", "agidnode",
+         1e9 * find_nodes(g, nodes, nnodes, lookups),
+         1e9 * find_nodes(sub, nodes, nnodes, lookups));
+  printf("%-22s %10.1f %10.1f\n", "agidedge",
+         1e9 * find_edges(g, edges, nsubedges, lookups),
+         1e9 * find_edges(sub, edges, nsubedges, lookups));
+  printf("%-22s %10.1f %10.1f\n", "agfstout/agnxtout",
+         1e9 * visit_edges(g, rounds), 1e9 * visit_edges(sub, rounds));
+
+  agclose(g);
+  for (size_t i = 0; i < nnodes; i++) {
+    free(names[i]);
+  }
+  free(edges);
+  free(nodes);
+  free(ends);
+  free(names);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,182 @@
+/// @file
+/// @brief micro-benchmark of reading graphs in the gvb format against DOT
+///
+/// A graph like one dot has laid out, with positions, sizes and labels on its
+/// nodes and splines on its edges, is made at random, or read from a file
+/// named on the command line. It is written to temporary files as DOT, with
+/// `agwrite`, and as gvb, with `agwritegvb`. Each file is then read back
+/// repeatedly, DOT with `agread` and `agmmapread` and gvb with `agreadgvb` and
+/// `agmmapread`, and the fastest time of each reader is reported along with
+/// the size of each file. The graphs read are expected to be the same size as
+/// the one written, which is checked.
+///
+/// Usage: bench_gvb [nodes [edges [repeats]]]
+///        bench_gvb file.gv [repeats]
+
+#include <cgraph/cgraph.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/// make a random graph with the attributes of a laid out one
+static Agraph_t *generate(size_t nnodes, size_t nedges) {
+  Agraph_t *g = agopen("G", Agdirected, NULL);
+  agattr(g, AGRAPH, "bb", "0,0,1000,1000");
+  Agsym_t *pos = agattr(g, AGNODE, "pos", "");
+  Agsym_t *width = agattr(g, AGNODE, "width", "0.75");
+  Agsym_t *height = agattr(g, AGNODE, "height", "0.5");
+  Agsym_t *label = agattr(g, AGNODE, "label", "\\N");
+  Agsym_t *epos = agattr(g, AGEDGE, "pos", "");
+  Agsym_t *elabel = agattr(g, AGEDGE, "label", "");
+  Agnode_t **nodes = calloc(nnodes, sizeof(nodes[0]));
+  if (nodes == NULL) {
+    return NULL;
+  }
+  srand(42);
+  char buf[256];
+  for (size_t i = 0; i < nnodes; i++) {
+    snprintf(buf, sizeof(buf), "n%zu", i);
+    nodes[i] = agnode(g, buf, 1);
+    snprintf(buf, sizeof(buf), "%d,%d", rand() % 10000, rand() % 10000);
+    agxset(nodes[i], pos, buf);
+    snprintf(buf, sizeof(buf), "%.2f", 0.75 + (double)(rand() % 100) / 100);
+    agxset(nodes[i], width, buf);
+    agxset(nodes[i], height, "0.5");
+    snprintf(buf, sizeof(buf), "node %zu\\n%d", i, rand());
+    agxset(nodes[i], label, buf);
+  }
+  for (size_t i = 0; i < nedges; i++) {
+    Agedge_t *e =
+        agedge(g, nodes[(size_t)rand() % nnodes], nodes[(size_t)rand() % nnodes],
+               NULL, 1);
+    int x = rand() % 10000;
+    int y = rand() % 10000;
+    snprintf(buf, sizeof(buf), "e,%d,%d %d,%d %d.5,%d.5 %d,%d %d,%d", x, y, x,
+             y + 10, x + 5, y + 20, x + 10, y + 30, x + 10, y + 40);
+    agxset(e, epos, buf);
+    if (i % 4 == 0) {
+      snprintf(buf, sizeof(buf), "%d", rand() % 100);
+      agxset(e, elabel, buf);
+    }
+  }
+  free(nodes);
+  return g;
+}
+
+/// read a graph from a file in one of the ways under test
+static Agraph_t *load(FILE *f, bool gvb, bool mapped) {
+  rewind(f);
+  if (mapped) {
+    Agmmap_t *m = agmmapopen(f);
+    if (m == NULL) {
+      return NULL;
+    }
+    Agraph_t *g = agmmapread(m, NULL);
+    agmmapclose(m);
+    return g;
+  }
+  return gvb ? agreadgvb(f, NULL) : agread(f, NULL);
+}
+
+static long file_size(FILE *f) {
+  fseek(f, 0, SEEK_END);
+  return ftell(f);
+}
+
+int main(int argc, char **argv) {
+  Agraph_t *g;
+  int repeats = 5;
+  if (argc > 1 && strchr(argv[1], '.') != NULL) {
+    FILE *in = fopen(argv[1], "r");
+    if (in == NULL) {
+      perror(argv[1]);
+      return EXIT_FAILURE;
+    }
+    g = agread(in, NULL);
+    fclose(in);
+    if (argc > 2) {
+      repeats = atoi(argv[2]);
+    }
+  } else {
+    const size_t nnodes = argc > 1 ? (size_t)atol(argv[1]) : 100000;
+    const size_t nedges = argc > 2 ? (size_t)atol(argv[2]) : 150000;
+    if (argc > 3) {
+      repeats = atoi(argv[3]);
+    }
+    g = nnodes == 0 ? NULL : generate(nnodes, nedges);
+  }
+  if (g == NULL || repeats < 1) {
+    fprintf(stderr, "usage: %s [nodes [edges [repeats]]]\n"
+                    "       %s file.gv [repeats]\n",
+            argv[0], argv[0]);
+    return EXIT_FAILURE;
+  }
+  const int nnodes = agnnodes(g);
+  const int nedges = agnedges(g);
+  printf("%d nodes, %d edges\n", nnodes, nedges);
+
+  FILE *dot = tmpfile();
+  FILE *gvb = tmpfile();
+  if (dot == NULL || gvb == NULL) {
+    perror("tmpfile");
+    return EXIT_FAILURE;
+  }
+  double start = now();
+  agwrite(g, dot);
+  fflush(dot);
+  const double dot_write = now() - start;
+  start = now();
+  agwritegvb(g, gvb, NULL);
+  fflush(gvb);
+  const double gvb_write = now() - start;
+  agclose(g);
+
+  const struct {
+    const char *name;
+    FILE *f;
+    bool gvb;
+    bool mapped;
+  } readers[] = {
+      {"agread", dot, false, false},
+      {"agmmapread", dot, false, true},
+      {"agreadgvb", gvb, true, false},
+      {"agmmapread", gvb, true, true},
+  };
+
+  printf("%-6s %9s %9s\n", "format", "bytes", "write s");
+  printf("%-6s %9ld %9.3f\n", "dot", file_size(dot), dot_write);
+  printf("%-6s %9ld %9.3f\n", "gvb", file_size(gvb), gvb_write);
+  printf("%-6s %-12s %9s\n", "format", "reader", "read s");
+  int rc = EXIT_SUCCESS;
+  for (size_t i = 0; i < sizeof(readers) / sizeof(readers[0]); i++) {
+    double best = -1;
+    for (int r = 0; r < repeats; r++) {
+      start = now();
+      Agraph_t *h = load(readers[i].f, readers[i].gvb, readers[i].mapped);
+      const double t = now() - start;
+      if (h == NULL || agnnodes(h) != nnodes || agnedges(h) != nedges) {
+        fprintf(stderr, "%s read a different graph\n", readers[i].name);
+        rc = EXIT_FAILURE;
+      }
+      if (h != NULL) {
+        agclose(h);
+      }
+      if (best < 0 || t < best) {
+        best = t;
+      }
+    }
+    printf("%-6s %-12s %9.3f\n", readers[i].gvb ? "gvb" : "dot",
+           readers[i].name, best);
+  }
+  fclose(gvb);
+  fclose(dot);
+  return rc;
+}
@@ -0,0 +1,140 @@
+/// @file
+/// @brief micro-benchmark of cgraph's memory disciplines
+///
+/// A random graph with node and edge attributes is written to a temporary
+/// file, which is then read and closed with the default memory discipline,
+/// `AgMemDisc`, and with `AgArenaMemDisc`. Each runs in its own child process,
+/// so that the peak resident memory reported for it is its own. The time to
+/// read the graph and the time to close it are reported for each.
+///
+/// Usage: bench_mem [nodes [edges]]
+
+#include <cgraph/cgraph.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+/// what a child reports back to its parent
+typedef struct {
+  double load;   ///< seconds to read the graph
+  double close;  ///< seconds to close it
+  long maxrss;   ///< peak resident memory, in kilobytes
+} result_t;
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/// write a random graph of the given size
+static void generate(FILE *f, long nodes, long edges) {
+  srand(42);
+  fprintf(f, "digraph G {\n"
+             "  node [shape=box];\n");
+  for (long i = 0; i < nodes; i++) {
+    fprintf(f, "  n%ld [label=\"node %ld\", width=%.2f];\n", i, i,
+            0.5 + (double)(i % 7) / 10);
+  }
+  for (long i = 0; i < edges; i++) {
+    const long t = rand() % nodes;
+    const long h = rand() % nodes;
+    fprintf(f, "  n%ld -> n%ld [weight=%d, color=\"#%06x\"];\n", t, h,
+            1 + rand() % 5, rand() & 0xffffff);
+  }
+  fprintf(f, "}\n");
+}
+
+/// read and close `path` with the given memory discipline, in this process
+static result_t measure(const char *path, Agmemdisc_t *mem) {
+  Agdisc_t disc = AgDefaultDisc;
+  disc.mem = mem;
+
+  FILE *f = fopen(path, "r");
+  if (f == NULL) {
+    perror(path);
+    exit(EXIT_FAILURE);
+  }
+  result_t r = {0};
+  double start = now();
+  Agraph_t *g = agread(f, &disc);
+  r.load = now() - start;
+  fclose(f);
+  if (g == NULL) {
+    fprintf(stderr, "failed to read %s\n", path);
+    exit(EXIT_FAILURE);
+  }
+
+  start = now();
+  agclose(g);
+  r.close = now() - start;
+
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  r.maxrss = usage.ru_maxrss;
+  return r;
+}
+
+/// run `measure` in a child process
+static result_t run(const char *path, Agmemdisc_t *mem) {
+  int fds[2];
+  if (pipe(fds) != 0) {
+    perror("pipe");
+    exit(EXIT_FAILURE);
+  }
+  const pid_t pid = fork();
+  if (pid < 0) {
+    perror("fork");
+    exit(EXIT_FAILURE);
+  }
+  if (pid == 0) {
+    close(fds[0]);
+    const result_t r = measure(path, mem);
+    if (write(fds[1], &r, sizeof(r)) != (ssize_t)sizeof(r)) {
+      _exit(EXIT_FAILURE);
+    }
+    _exit(EXIT_SUCCESS);
+  }
+  close(fds[1]);
+  result_t r;
+  const int ok = read(fds[0], &r, sizeof(r)) == (ssize_t)sizeof(r);
+  close(fds[0]);
+  int status;
+  waitpid(pid, &status, 0);
+  if (!ok || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    fprintf(stderr, "child process failed\n");
+    exit(EXIT_FAILURE);
+  }
+  return r;
+}
+
+int main(int argc, char **argv) {
+  const long nodes = argc > 1 ? atol(argv[1]) : 100000;
+  const long edges = argc > 2 ? atol(argv[2]) : 400000;
+
+  char path[] = "/tmp/bench_mem_XXXXXX";
+  const int fd = mkstemp(path);
+  if (fd < 0) {
+    perror("mkstemp");
+    return EXIT_FAILURE;
+  }
+  FILE *f = fdopen(fd, "w");
+  generate(f, nodes, edges);
+  fclose(f);
+
+  printf("%ld nodes, %ld edges\n", nodes, edges);
+  const result_t heap = run(path, &AgMemDisc);
+  const result_t arena = run(path, &AgArenaMemDisc);
+  unlink(path);
+
+  printf("%-16s %9s %9s %9s\n", "discipline", "load s", "close s", "peak MB");
+  printf("%-16s %9.3f %9.3f %9.1f\n", "AgMemDisc", heap.load, heap.close,
+         (double)heap.maxrss / 1024);
+  printf("%-16s %9.3f %9.3f %9.1f\n", "AgArenaMemDisc", arena.load,
+         arena.close, (double)arena.maxrss / 1024);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,128 @@
+/// @file
+/// @brief micro-benchmark of cgraph's reference counted strings
+///
+/// A graph whose nodes and edges carry many attributes, drawn from small sets
+/// of colors, shapes, fonts and styles as in typical generated graphs, is
+/// written as DOT in memory and read with `agmemread`. The fastest time to read
+/// it and the growth in peak resident memory from reading it are reported.
+/// Then every node's `color` is set in turn from a palette, once with `agxset`
+/// and once with `agxset_interned` using strings interned beforehand.
+///
+/// Usage: bench_refstr [nodes [repeats]]
+
+#include <cgraph/agxbuf.h>
+#include <cgraph/cgraph.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <time.h>
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static long maxrss(void) {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+
+static const char *COLORS[] = {"red",    "green", "blue",      "black",
+                               "gray50", "navy",  "firebrick", "#ff8000"};
+static const char *SHAPES[] = {"box", "ellipse", "circle", "diamond"};
+static const char *FONTS[] = {"Helvetica", "Times-Roman", "Courier"};
+static const char *STYLES[] = {"filled", "dashed", "bold", "filled,rounded"};
+
+#define PICK(a) (a)[(size_t)rand() % (sizeof(a) / sizeof((a)[0]))]
+
+/// write an attribute heavy graph of the given size
+static void generate(agxbuf *dot, size_t nodes) {
+  srand(42);
+  agxbprint(dot, "digraph G {\n");
+  for (size_t i = 0; i < nodes; i++) {
+    agxbprint(dot,
+              "  n%zu [color=\"%s\", fillcolor=\"%s\", fontcolor=\"%s\", "
+              "shape=%s, fontname=\"%s\", style=\"%s\", fontsize=%d, "
+              "penwidth=%d, group=g%d];\n",
+              i, PICK(COLORS), PICK(COLORS), PICK(COLORS), PICK(SHAPES),
+              PICK(FONTS), PICK(STYLES), 10 + rand() % 4, 1 + rand() % 3,
+              rand() % 16);
+  }
+  for (size_t i = 0; i < 2 * nodes; i++) {
+    agxbprint(dot,
+              "  n%zu -> n%zu [color=\"%s\", style=\"%s\", fontname=\"%s\", "
+              "arrowhead=normal, penwidth=%d];\n",
+              (size_t)rand() % nodes, (size_t)rand() % nodes, PICK(COLORS),
+              PICK(STYLES), PICK(FONTS), 1 + rand() % 3);
+  }
+  agxbprint(dot, "}\n");
+}
+
+int main(int argc, char **argv) {
+  const size_t nodes = argc > 1 ? (size_t)atol(argv[1]) : 100000;
+  const int repeats = argc > 2 ? atoi(argv[2]) : 5;
+  if (nodes == 0 || repeats < 1) {
+    fprintf(stderr, "usage: %s [nodes [repeats]]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  agxbuf dot = {0};
+  generate(&dot, nodes);
+  char *text = agxbdisown(&dot);
+  printf("%zu nodes, %zu edges, %zu attributes each\n", nodes, 2 * nodes,
+         (size_t)9);
+
+  const long before = maxrss();
+  double best = -1;
+  Agraph_t *g = NULL;
+  for (int r = 0; r < repeats; r++) {
+    if (g != NULL) {
+      agclose(g);
+    }
+    const double start = now();
+    g = agmemread(text);
+    const double t = now() - start;
+    if (g == NULL) {
+      fprintf(stderr, "failed to read the graph\n");
+      return EXIT_FAILURE;
+    }
+    if (best < 0 || t < best) {
+      best = t;
+    }
+  }
+  printf("%-22s %9.3f s\n", "agmemread", best);
+  printf("%-22s %9ld KB\n", "peak memory growth", maxrss() - before);
+
+  Agsym_t *color = agattr(g, AGNODE, "color", NULL);
+  const size_t ncolors = sizeof(COLORS) / sizeof(COLORS[0]);
+  double start = now();
+  for (int r = 0; r < repeats; r++) {
+    size_t i = (size_t)r;
+    for (Agnode_t *n = agfstnode(g); n != NULL; n = agnxtnode(g, n)) {
+      agxset(n, color, COLORS[i++ % ncolors]);
+    }
+  }
+  printf("%-22s %9.3f s\n", "agxset", (now() - start) / repeats);
+
+  char *interned[sizeof(COLORS) / sizeof(COLORS[0])];
+  for (size_t i = 0; i < ncolors; i++) {
+    interned[i] = agstrdup(g, COLORS[i]);
+  }
+  start = now();
+  for (int r = 0; r < repeats; r++) {
+    size_t i = (size_t)r;
+    for (Agnode_t *n = agfstnode(g); n != NULL; n = agnxtnode(g, n)) {
+      agxset_interned(n, color, interned[i++ % ncolors]);
+    }
+  }
+  printf("%-22s %9.3f s\n", "agxset_interned", (now() - start) / repeats);
+  for (size_t i = 0; i < ncolors; i++) {
+    agstrfree(g, interned[i]);
+  }
+
+  agclose(g);
+  free(text);
+  return EXIT_SUCCESS;
+}
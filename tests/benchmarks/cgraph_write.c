@@ -0,0 +1,160 @@
+/// @file
+/// @brief micro-benchmark of writing DOT with `agwrite`
+///
+/// A graph annotated as layout leaves it, with positions, sizes and edge
+/// splines on every object, is read with `agmemread` and written with
+/// `agwrite`, once to a temporary file and once through a discipline that
+/// only counts what it is given. The fastest time of each, the output
+/// throughput and the number of `putstr` calls are reported. Then the
+/// coordinates of the graph are formatted as `%.5g` with `snprintf` and with
+/// `gv_numfmt`, as `attach_attrs` does when annotating a layout.
+///
+/// Usage: bench_write [nodes [repeats]]
+
+#include <cgraph/agxbuf.h>
+#include <cgraph/cgraph.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <util/numfmt.h>
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/// a coordinate with the precision layouts typically have
+static double coord(void) { return rand() % 2000000 / 100.0; }
+
+/// write an annotated graph of the given size
+static void generate(agxbuf *dot, size_t nodes) {
+  srand(42);
+  agxbprint(dot, "digraph G {\n"
+                 "  graph [bb=\"0,0,20000,20000\"];\n"
+                 "  node [label=\"\\N\", shape=box];\n");
+  for (size_t i = 0; i < nodes; i++) {
+    agxbprint(dot,
+              "  n%zu [height=0.5, pos=\"%.5g,%.5g\", width=%.5g, "
+              "xlabel=\"node %zu\"];\n",
+              i, coord(), coord(), 0.75 + rand() % 100 / 100.0, i);
+  }
+  for (size_t i = 0; i < 2 * nodes; i++) {
+    agxbprint(dot, "  n%zu -> n%zu [pos=\"e", (size_t)rand() % nodes,
+              (size_t)rand() % nodes);
+    for (int j = 0; j < 5; j++) {
+      agxbprint(dot, ",%.5g,%.5g ", coord(), coord());
+    }
+    agxbprint(dot, "%.5g,%.5g\", weight=%d];\n", coord(), coord(),
+              1 + rand() % 3);
+  }
+  agxbprint(dot, "}\n");
+}
+
+/// totals of what a counting discipline was given
+static size_t calls, bytes;
+
+static int count_putstr(void *chan, const char *str) {
+  (void)chan;
+  ++calls;
+  bytes += strlen(str);
+  return 0;
+}
+
+static int count_flush(void *chan) {
+  (void)chan;
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  const size_t nodes = argc > 1 ? (size_t)atol(argv[1]) : 100000;
+  const int repeats = argc > 2 ? atoi(argv[2]) : 5;
+  if (nodes == 0 || repeats < 1) {
+    fprintf(stderr, "usage: %s [nodes [repeats]]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  agxbuf dot = {0};
+  generate(&dot, nodes);
+  char *text = agxbdisown(&dot);
+  Agraph_t *g = agmemread(text);
+  if (g == NULL) {
+    fprintf(stderr, "failed to read the graph\n");
+    return EXIT_FAILURE;
+  }
+  printf("%zu nodes, %zu edges\n", nodes, 2 * nodes);
+
+  double best = -1;
+  long size = 0;
+  for (int r = 0; r < repeats; r++) {
+    FILE *f = tmpfile();
+    if (f == NULL) {
+      fprintf(stderr, "failed to create a temporary file\n");
+      return EXIT_FAILURE;
+    }
+    const double start = now();
+    if (agwrite(g, f) != 0) {
+      fprintf(stderr, "failed to write the graph\n");
+      return EXIT_FAILURE;
+    }
+    const double t = now() - start;
+    size = ftell(f);
+    fclose(f);
+    if (best < 0 || t < best) {
+      best = t;
+    }
+  }
+  printf("%-22s %9.3f s %9.1f MB/s\n", "agwrite to file", best,
+         (double)size / best / 1e6);
+
+  // substitute the discipline, as `-Tdot` output does
+  Agiodisc_t io = {.putstr = count_putstr, .flush = count_flush};
+  Agiodisc_t *saved = g->clos->disc.io;
+  g->clos->disc.io = &io;
+  best = -1;
+  for (int r = 0; r < repeats; r++) {
+    calls = bytes = 0;
+    const double start = now();
+    agwrite(g, NULL);
+    const double t = now() - start;
+    if (best < 0 || t < best) {
+      best = t;
+    }
+  }
+  g->clos->disc.io = saved;
+  printf("%-22s %9.3f s %9.1f MB/s %zu calls\n", "agwrite to discipline",
+         best, (double)bytes / best / 1e6, calls);
+
+  // the coordinates of a layout of this size
+  const size_t count = 14 * nodes;
+  double *values = malloc(count * sizeof(values[0]));
+  if (values == NULL) {
+    fprintf(stderr, "out of memory\n");
+    return EXIT_FAILURE;
+  }
+  for (size_t i = 0; i < count; i++) {
+    values[i] = coord() + rand() % 1000 / 1e6;
+  }
+  char buf[GV_NUMFMT_SIZE];
+  size_t total = 0;
+  double start = now();
+  for (size_t i = 0; i < count; i++) {
+    total += (size_t)snprintf(buf, sizeof(buf), "%.5g", values[i]);
+  }
+  printf("%-22s %9.3f s\n", "snprintf %.5g", now() - start);
+  start = now();
+  for (size_t i = 0; i < count; i++) {
+    total -= gv_numfmt(buf, values[i]);
+  }
+  printf("%-22s %9.3f s\n", "gv_numfmt", now() - start);
+  free(values);
+  if (total != 0) {
+    fprintf(stderr, "formatted lengths differ\n");
+    return EXIT_FAILURE;
+  }
+
+  agclose(g);
+  free(text);
+  return EXIT_SUCCESS;
+}
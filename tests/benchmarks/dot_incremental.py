@@ -0,0 +1,134 @@
+#!/usr/bin/env python3
+
+"""
+Benchmark of dot’s incremental re-layout
+
+Random DAGs are laid out by dot with `incremental=true`, then edited by adding
+a node and a few edges, and the edited graph is laid out again both from scratch
+(`incremental=false`) and incrementally. The median wall clock time of each is
+reported, along with how many pairs of nodes sharing a rank before and after the
+edit changed their relative order, as a measure of layout stability.
+"""
+
+import argparse
+import itertools
+import random
+import shutil
+import statistics
+import subprocess
+import sys
+import time
+from typing import Dict, List, Tuple
+
+
+def dag(nodes: int, edges: int, seed: int) -> str:
+    """generate a random connected DAG in DOT syntax"""
+    rng = random.Random(seed)
+    lines = ["digraph {"]
+    for i in range(1, nodes):
+        lines += [f"  n{rng.randrange(max(0, i - 50), i)} -> n{i};"]
+    for _ in range(edges - (nodes - 1)):
+        a = rng.randrange(nodes - 1)
+        b = rng.randrange(a + 1, min(nodes, a + 50))
+        lines += [f"  n{a} -> n{b};"]
+    return "\n".join(lines) + "\n}\n"
+
+
+def edit(previous: str, nodes: int, seed: int) -> str:
+    """add a node, hanging between two existing ones, and a cross edge"""
+    rng = random.Random(seed)
+    a = rng.randrange(nodes // 2)
+    b = rng.randrange(nodes // 2, nodes)
+    c = rng.randrange(nodes // 2)
+    d = rng.randrange(nodes // 2, nodes)
+    body = previous.rstrip().rstrip("}")
+    return body + f"  n{a} -> added; added -> n{b}; n{c} -> n{d};\n}}\n"
+
+
+def layout(dot: str, source: str, *args: str) -> Tuple[float, str]:
+    """time one layout, returning elapsed seconds and -Tplain output"""
+    start = time.perf_counter()
+    plain = subprocess.run(
+        [dot, "-Tplain", *args],
+        input=source,
+        stdout=subprocess.PIPE,
+        check=True,
+        universal_newlines=True,
+    ).stdout
+    return time.perf_counter() - start, plain
+
+
+def positions(plain: str) -> Dict[str, Tuple[float, float]]:
+    """(rank coordinate, coordinate within the rank) of each node"""
+    pos = {}
+    for line in plain.splitlines():
+        fields = line.split()
+        if fields[0] == "node":
+            pos[fields[1]] = (float(fields[3]), float(fields[2]))
+    return pos
+
+
+def swaps(
+    before: Dict[str, Tuple[float, float]], after: Dict[str, Tuple[float, float]]
+) -> Tuple[int, int]:
+    """count node pairs on a common rank in both layouts that changed order"""
+    pairs = changed = 0
+    for u, v in itertools.combinations(before, 2):
+        if before[u][0] != before[v][0] or after[u][0] != after[v][0]:
+            continue
+        pairs += 1
+        if (before[u][1] < before[v][1]) != (after[u][1] < after[v][1]):
+            changed += 1
+    return changed, pairs
+
+
+def main(args: List[str]) -> int:  # pylint: disable=C0116
+    parser = argparse.ArgumentParser(description=__doc__.strip().split("\n")[0])
+    parser.add_argument(
+        "--graphs",
+        nargs="*",
+        default=["500,700", "1000,1400", "2000,2800"],
+        help="random DAGs to lay out, as NODES,EDGES",
+    )
+    parser.add_argument(
+        "--repeat", type=int, default=3, help="runs per configuration"
+    )
+    parser.add_argument("--seed", type=int, default=42)
+    parser.add_argument("--dot", default=shutil.which("dot") or "dot")
+    options = parser.parse_args(args[1:])
+
+    print(
+        f"{'graph':<16} {'mode':>11} {'seconds':>9} {'speedup':>8} "
+        f"{'reordered pairs':>18}"
+    )
+    for spec in options.graphs:
+        nodes, edges = (int(x) for x in spec.split(","))
+        source = dag(nodes, edges, options.seed)
+        _, plain = layout(options.dot, source)
+        before = positions(plain)
+        previous = subprocess.run(
+            [options.dot, "-Tdot", "-Gincremental=true"],
+            input=source,
+            stdout=subprocess.PIPE,
+            check=True,
+            universal_newlines=True,
+        ).stdout
+        edited = edit(previous, nodes, options.seed)
+
+        results = {}
+        for mode in ("full", "incremental"):
+            flag = f"-Gincremental={'true' if mode == 'incremental' else 'false'}"
+            runs = [layout(options.dot, edited, flag) for _ in range(options.repeat)]
+            seconds = statistics.median(t for t, _ in runs)
+            changed, pairs = swaps(before, positions(runs[0][1]))
+            results[mode] = seconds
+            print(
+                f"{spec:<16} {mode:>11} {seconds:>9.3f} "
+                f"{results['full'] / seconds:>8.2f} {f'{changed}/{pairs}':>18}"
+            )
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
@@ -0,0 +1,99 @@
+#!/usr/bin/env python3
+
+"""
+Benchmark of dot’s crossing minimization on dense bipartite graphs
+
+Each graph has two ranks of the same width, with every node on the first
+joined to a random subset of nodes on the second. dot is stopped after
+crossing minimization (`phase=2`), and the time it reports for that phase is
+taken from its verbose output. The median over repeated runs is reported
+alongside the number of crossings found.
+
+Several dot executables can be given, for example builds before and after a
+change. Each graph is then laid out by each of them, and any whose node order
+differs from that of the first is flagged.
+"""
+
+import argparse
+import random
+import re
+import shutil
+import statistics
+import subprocess
+import sys
+from typing import List, Tuple
+
+
+def bipartite(width: int, degree: int, seed: int) -> str:
+    """generate a two rank graph with `degree` edges per node on the first"""
+    rng = random.Random(seed)
+    lines = ["digraph {"]
+    for i in range(width):
+        for j in sorted(rng.sample(range(width), degree)):
+            lines += [f"  t{i} -> b{j};"]
+    return "\n".join(lines) + "\n}\n"
+
+
+def mincross(dot: str, source: str) -> Tuple[float, int, str]:
+    """
+    run crossing minimization, returning seconds taken, crossings and node
+    order
+    """
+    proc = subprocess.run(
+        [dot, "-v", "-Gphase=2", "-Tdot"],
+        input=source,
+        stdout=subprocess.PIPE,
+        stderr=subprocess.PIPE,
+        check=True,
+        universal_newlines=True,
+    )
+    m = re.search(r"^mincross .*: (\d+) crossings, ([\d.]+) secs", proc.stderr, re.M)
+    if m is None:
+        sys.stderr.write(proc.stderr)
+        raise RuntimeError(f"no mincross timing in output of {dot}")
+    order = "\n".join(re.findall(r"\border=\d+", proc.stdout))
+    return float(m.group(2)), int(m.group(1)), order
+
+
+def main(args: List[str]) -> int:  # pylint: disable=C0116
+    parser = argparse.ArgumentParser(description=__doc__.strip().split("\n")[0])
+    parser.add_argument(
+        "--graphs",
+        nargs="*",
+        default=["100,10", "200,20", "400,20"],
+        help="graphs to lay out, as WIDTH,DEGREE",
+    )
+    parser.add_argument(
+        "--repeat", type=int, default=3, help="runs per configuration"
+    )
+    parser.add_argument("--seed", type=int, default=42)
+    parser.add_argument(
+        "--dot",
+        nargs="+",
+        default=[shutil.which("dot") or "dot"],
+        help="dot executables to compare",
+    )
+    options = parser.parse_args(args[1:])
+
+    print(f"{'graph':<12} {'edges':>7} {'seconds':>9} {'crossings':>10}  dot")
+    for spec in options.graphs:
+        width, degree = (int(x) for x in spec.split(","))
+        source = bipartite(width, degree, options.seed)
+        reference = None
+        for dot in options.dot:
+            runs = [mincross(dot, source) for _ in range(options.repeat)]
+            seconds = statistics.median(t for t, _, _ in runs)
+            _, crossings, order = runs[0]
+            if reference is None:
+                reference = order
+            note = "" if order == reference else "  (different order)"
+            print(
+                f"{spec:<12} {width * degree:>7} {seconds:>9.3f} {crossings:>10}"
+                f"  {dot}{note}"
+            )
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
@@ -0,0 +1,169 @@
+#!/usr/bin/env python3
+
+"""
+Benchmark of dot’s orthogonal edge routing
+
+Each graph has random edges between nodes of a few ranks apart, laid out with
+`splines=ortho`. Crossing minimization and positioning are limited (`mclimit`,
+`nslimit`) to keep them from dominating the run. The times dot reports for
+building the maze of cells around the nodes and for finding the shortest path
+of every edge through it are taken from its verbose output, along with the
+total time of the run.
+The median over repeated runs is reported, with the number of crossings between
+horizontal and vertical pieces of different edges as a measure of quality.
+
+Each graph is laid out serially and then routed in rounds with each of the
+given numbers of threads, along with how many edges each time had to be routed
+again because an earlier edge in their round made their path heavier. Layouts
+with threads are compared with the one using a single thread and any that
+differs is flagged.
+
+Given more than one dot, the layouts each produces are compared with those of
+the first and any that differs is flagged. Orthogonal routes of equal weight
+may be chosen differently by different searches, so a differing layout is not
+by itself an error.
+"""
+
+import argparse
+import bisect
+import random
+import re
+import shutil
+import statistics
+import subprocess
+import sys
+import time
+from typing import List, Optional, Tuple
+
+
+def ranked_edges(nodes: int, edges: int, span: int, seed: int) -> str:
+    """generate `edges` edges between nodes up to `span` apart"""
+    rng = random.Random(seed)
+    lines = ["digraph {", "  mclimit=0.05; nslimit=0.2; splines=ortho;"]
+    for _ in range(edges):
+        tail = rng.randrange(nodes - span)
+        lines += [f"  n{tail} -> n{tail + rng.randrange(1, span + 1)};"]
+    return "\n".join(lines) + "\n}\n"
+
+
+def crossings(layout: str) -> int:
+    """count crossings between pieces of different edges in a -Tplain layout"""
+    horizontal = []  # (y, x1, x2, edge)
+    vertical = []  # (x, y1, y2, edge)
+    for index, line in enumerate(layout.splitlines()):
+        fields = line.split()
+        if not fields or fields[0] != "edge":
+            continue
+        n = int(fields[3])
+        coords = [float(f) for f in fields[4 : 4 + 2 * n]]
+        # the pieces of an orthogonal edge are the straight Béziers joining
+        # every third control point
+        corners = list(zip(coords[0::2], coords[1::2]))[::3]
+        for (x1, y1), (x2, y2) in zip(corners, corners[1:]):
+            if y1 == y2 and x1 != x2:
+                horizontal += [(y1, min(x1, x2), max(x1, x2), index)]
+            elif x1 == x2 and y1 != y2:
+                vertical += [(x1, min(y1, y2), max(y1, y2), index)]
+
+    vertical.sort()
+    xs = [v[0] for v in vertical]
+    count = 0
+    for y, x1, x2, edge in horizontal:
+        lo = bisect.bisect_right(xs, x1)
+        hi = bisect.bisect_left(xs, x2)
+        for _, y1, y2, other in vertical[lo:hi]:
+            if other != edge and y1 < y < y2:
+                count += 1
+    return count
+
+
+def route(
+    dot: str, source: str, threads: Optional[int]
+) -> Tuple[float, float, float, int, str]:
+    """
+    lay out a graph, returning seconds spent building the maze, seconds spent
+    finding paths, seconds spent in total, number of routes redone and the
+    layout
+    """
+    args = [dot, "-v", "-Tplain"]
+    if threads is not None:
+        args += [f"-Gthreads={threads}"]
+    start = time.monotonic()
+    proc = subprocess.run(
+        args,
+        input=source,
+        stdout=subprocess.PIPE,
+        stderr=subprocess.PIPE,
+        check=True,
+        universal_newlines=True,
+    )
+    total = time.monotonic() - start
+    maze = re.search(r"^orthoEdges: maze .* ([\d.]+) sec", proc.stderr, re.M)
+    m = re.search(r"^orthoEdges: .* shortest paths in ([\d.]+) sec", proc.stderr, re.M)
+    again = re.search(r"^orthoEdges: .*, (\d+) routed again", proc.stderr, re.M)
+    return (
+        float(maze.group(1)) if maze else float("nan"),
+        float(m.group(1)) if m else float("nan"),
+        total,
+        int(again.group(1)) if again else 0,
+        proc.stdout,
+    )
+
+
+def main(args: List[str]) -> int:  # pylint: disable=C0116
+    parser = argparse.ArgumentParser(description=__doc__.strip().split("\n")[0])
+    parser.add_argument(
+        "--graphs",
+        nargs="*",
+        default=["300,1000,8", "1000,3000,8", "2000,6000,8", "10000,10000,8"],
+        help="graphs to lay out, as NODES,EDGES,SPAN",
+    )
+    parser.add_argument(
+        "--threads",
+        type=int,
+        nargs="*",
+        default=[1, 2, 4],
+        help="numbers of threads to route with, besides serially",
+    )
+    parser.add_argument(
+        "--repeat", type=int, default=3, help="runs per configuration"
+    )
+    parser.add_argument("--seed", type=int, default=42)
+    parser.add_argument(
+        "--dot",
+        nargs="+",
+        default=[shutil.which("dot") or "dot"],
+        help="dot executables to compare",
+    )
+    options = parser.parse_args(args[1:])
+
+    print(
+        f"{'graph':<14} {'dot':<30} {'threads':>7} {'maze':>9} {'paths':>9}"
+        f" {'total':>9} {'crossings':>9} {'redone':>7}"
+    )
+    for spec in options.graphs:
+        nodes, edges, span = (int(x) for x in spec.split(","))
+        source = ranked_edges(nodes, edges, span, options.seed)
+        references = {}
+        for dot in options.dot:
+            for threads in [None] + options.threads:
+                runs = [route(dot, source, threads) for _ in range(options.repeat)]
+                maze = statistics.median(m for m, _, _, _, _ in runs)
+                paths = statistics.median(p for _, p, _, _, _ in runs)
+                total = statistics.median(t for _, _, t, _, _ in runs)
+                _, _, _, again, layout = runs[0]
+                # compare with the first dot, and threaded layouts with each other
+                key = "-" if threads is None else "threads"
+                reference = references.setdefault(key, layout)
+                note = "" if layout == reference else "  (different layout)"
+                print(
+                    f"{spec:<14} {dot[-30:]:<30} {threads or '-':>7} {maze:>9.3f}"
+                    f" {paths:>9.3f} {total:>9.3f} {crossings(layout):>9}"
+                    f" {again:>7}{note}"
+                )
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
@@ -0,0 +1,174 @@
+/// @file
+/// @brief micro-benchmark of reading DOT files into cgraph
+///
+/// A random graph with node and edge attributes, quoted strings and comments
+/// is written to a temporary file, which is then read with `agread`, through
+/// the flex scanner and stdio, and with `agmmapread`, from the file mapped
+/// into memory. Each reader runs in its own child process, so that the peak
+/// resident memory reported for it is its own. The throughput of each is
+/// reported, and the two readers are expected to see the same numbers of
+/// nodes and edges, which is checked.
+///
+/// Usage: bench_parse [nodes [edges [repeats]]]
+
+#include <cgraph/cgraph.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+/// what a child reports back to its parent
+typedef struct {
+  double seconds;    ///< fastest of the repeated reads
+  long nodes, edges; ///< size of the graph read
+  long maxrss;       ///< peak resident memory, in kilobytes
+} result_t;
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/// write a random graph of the given size
+static void generate(FILE *f, long nodes, long edges) {
+  srand(42);
+  fprintf(f, "/* generated by bench_parse */\n"
+             "digraph G {\n"
+             "  graph [rankdir=LR, label=\"benchmark\"];\n"
+             "  node [shape=box, fontname=\"Helvetica\"];\n");
+  for (long i = 0; i < nodes; i++) {
+    fprintf(f, "  n%ld [label=\"node %ld\\n(\\\"quoted\\\")\", width=%.2f];\n", i,
+            i, 0.5 + (double)(i % 7) / 10);
+  }
+  for (long i = 0; i < edges; i++) {
+    const long t = rand() % nodes;
+    const long h = rand() % nodes;
+    if (i % 10 == 0) {
+      fprintf(f, "  // edge %ld\n", i);
+    }
+    fprintf(f, "  n%ld -> n%ld [weight=%d, color=\"#%06x\"];\n", t, h,
+            1 + rand() % 5, rand() & 0xffffff);
+  }
+  fprintf(f, "}\n");
+}
+
+/// read `path` `repeats` times with the given reader, in this process
+static result_t measure(const char *path, bool mapped, int repeats) {
+  result_t r = {.seconds = -1};
+  for (int i = 0; i < repeats; i++) {
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+      perror(path);
+      exit(EXIT_FAILURE);
+    }
+    const double start = now();
+    Agraph_t *g;
+    if (mapped) {
+      Agmmap_t *m = agmmapopen(f);
+      if (m == NULL) {
+        perror("agmmapopen");
+        exit(EXIT_FAILURE);
+      }
+      g = agmmapread(m, NULL);
+      agmmapclose(m);
+    } else {
+      g = agread(f, NULL);
+    }
+    const double elapsed = now() - start;
+    fclose(f);
+    if (g == NULL) {
+      fprintf(stderr, "failed to read %s\n", path);
+      exit(EXIT_FAILURE);
+    }
+    r.nodes = agnnodes(g);
+    r.edges = agnedges(g);
+    agclose(g);
+    if (r.seconds < 0 || elapsed < r.seconds) {
+      r.seconds = elapsed;
+    }
+  }
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  r.maxrss = usage.ru_maxrss;
+  return r;
+}
+
+/// run `measure` in a child process
+static result_t run(const char *path, bool mapped, int repeats) {
+  int fds[2];
+  if (pipe(fds) != 0) {
+    perror("pipe");
+    exit(EXIT_FAILURE);
+  }
+  const pid_t pid = fork();
+  if (pid < 0) {
+    perror("fork");
+    exit(EXIT_FAILURE);
+  }
+  if (pid == 0) {
+    close(fds[0]);
+    const result_t r = measure(path, mapped, repeats);
+    if (write(fds[1], &r, sizeof(r)) != (ssize_t)sizeof(r)) {
+      _exit(EXIT_FAILURE);
+    }
+    _exit(EXIT_SUCCESS);
+  }
+  close(fds[1]);
+  result_t r;
+  const bool ok = read(fds[0], &r, sizeof(r)) == (ssize_t)sizeof(r);
+  close(fds[0]);
+  int status;
+  waitpid(pid, &status, 0);
+  if (!ok || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    fprintf(stderr, "%s reader failed\n", mapped ? "agmmapread" : "agread");
+    exit(EXIT_FAILURE);
+  }
+  return r;
+}
+
+int main(int argc, char **argv) {
+  const long nodes = argc > 1 ? atol(argv[1]) : 100000;
+  const long edges = argc > 2 ? atol(argv[2]) : 400000;
+  const int repeats = argc > 3 ? atoi(argv[3]) : 3;
+
+  char path[] = "/tmp/bench_parse_XXXXXX";
+  const int fd = mkstemp(path);
+  if (fd < 0) {
+    perror("mkstemp");
+    return EXIT_FAILURE;
+  }
+  FILE *f = fdopen(fd, "w");
+  generate(f, nodes, edges);
+  fclose(f);
+
+  struct stat st;
+  stat(path, &st);
+  const double mb = (double)st.st_size / (1024 * 1024);
+  printf("%ld nodes, %ld edges, %.1f MB, best of %d\n", nodes, edges, mb,
+         repeats);
+
+  const result_t flex = run(path, false, repeats);
+  const result_t mapped = run(path, true, repeats);
+  unlink(path);
+
+  printf("%-12s %9s %9s %9s\n", "reader", "seconds", "MB/s", "peak MB");
+  printf("%-12s %9.3f %9.1f %9.1f\n", "agread", flex.seconds,
+         mb / flex.seconds, (double)flex.maxrss / 1024);
+  printf("%-12s %9.3f %9.1f %9.1f\n", "agmmapread", mapped.seconds,
+         mb / mapped.seconds, (double)mapped.maxrss / 1024);
+
+  if (flex.nodes != mapped.nodes || flex.edges != mapped.edges) {
+    fprintf(stderr,
+            "readers disagree: %ld nodes, %ld edges vs %ld nodes, %ld edges\n",
+            flex.nodes, flex.edges, mapped.nodes, mapped.edges);
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,116 @@
+#!/usr/bin/env python3
+
+"""
+Benchmark of parsing graphs ahead of processing them
+
+A directory of small random graphs is generated with gvgen, and then run through
+dot and some of the graph filters, once reading one graph at a time and once
+with graphs parsed ahead on another thread (dot’s `--pipeline` and the filters’
+`-P`). The median wall clock time of each configuration is reported, along with
+its speedup over reading one graph at a time. The output of each pair of runs
+is checked to be the same.
+"""
+
+import argparse
+import shutil
+import statistics
+import subprocess
+import sys
+import tempfile
+import time
+from pathlib import Path
+from typing import List, Tuple
+
+
+def run(args: List[str]) -> Tuple[float, bytes]:
+    """time one run, returning elapsed seconds and output"""
+    start = time.perf_counter()
+    proc = subprocess.run(
+        args, stdout=subprocess.PIPE, stderr=subprocess.DEVNULL, check=False
+    )
+    elapsed = time.perf_counter() - start
+    # filters may exit non-zero for inputs they reject, so only treat crashes as
+    # failure
+    if proc.returncode < 0:
+        raise RuntimeError(f"{' '.join(args)} failed")
+    return elapsed, proc.stdout
+
+
+def main(args: List[str]) -> int:  # pylint: disable=C0116
+    parser = argparse.ArgumentParser(description=__doc__.strip().split("\n")[0])
+    parser.add_argument(
+        "--graphs", type=int, default=2000, help="number of graphs to generate"
+    )
+    parser.add_argument(
+        "--nodes", type=int, default=30, help="nodes in each generated graph"
+    )
+    parser.add_argument(
+        "--edges", type=int, default=45, help="edges in each generated graph"
+    )
+    parser.add_argument(
+        "--format", default="svg", help="output format for dot to render"
+    )
+    parser.add_argument(
+        "--repeat", type=int, default=3, help="runs per configuration"
+    )
+    parser.add_argument("--gvgen", default=shutil.which("gvgen") or "gvgen")
+    parser.add_argument("--dot", default=shutil.which("dot") or "dot")
+    parser.add_argument("--nop", default=shutil.which("nop") or "nop")
+    parser.add_argument("--gc", default=shutil.which("gc") or "gc")
+    parser.add_argument("--tred", default=shutil.which("tred") or "tred")
+    options = parser.parse_args(args[1:])
+
+    with tempfile.TemporaryDirectory() as tmp:
+        graphs = []
+        for i in range(options.graphs):
+            graph = Path(tmp) / f"{i:06}.gv"
+            with open(graph, "wt", encoding="utf-8") as f:
+                subprocess.run(
+                    [
+                        options.gvgen,
+                        f"-r{options.nodes},{options.edges}",
+                        f"-ng{i}_",
+                        f"-Ng{i}",
+                    ],
+                    stdout=f,
+                    check=True,
+                )
+            graphs += [str(graph)]
+
+        commands = [
+            (
+                f"dot -T{options.format}",
+                [options.dot, f"-T{options.format}"],
+                "--pipeline",
+            ),
+            ("nop", [options.nop], "-P"),
+            ("gc -a", [options.gc, "-a"], "-P"),
+            ("tred", [options.tred], "-P"),
+        ]
+
+        print(
+            f"{options.graphs} graphs of {options.nodes} nodes, "
+            f"{options.edges} edges"
+        )
+        print(f"{'command':<16} {'mode':>10} {'seconds':>9} {'speedup':>8}")
+        for name, command, flag in commands:
+            serial = []
+            pipelined = []
+            for _ in range(options.repeat):
+                t, out = run(command + graphs)
+                serial += [t]
+                t, piped = run(command[:1] + [flag] + command[1:] + graphs)
+                pipelined += [t]
+                if out != piped:
+                    sys.stderr.write(f"{name}: output differs with {flag}\n")
+                    return 1
+            s = statistics.median(serial)
+            p = statistics.median(pipelined)
+            print(f"{name:<16} {'serial':>10} {s:>9.3f} {1:>8.2f}")
+            print(f"{name:<16} {flag:>10} {p:>9.3f} {s / p:>8.2f}")
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
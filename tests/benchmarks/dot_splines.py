@@ -0,0 +1,106 @@
+#!/usr/bin/env python3
+
+"""
+Benchmark of dot’s edge routing with different numbers of threads
+
+Each graph is a chain of nodes with many more edges spanning a few ranks each,
+so most edges are routed through several virtual nodes. Crossing minimization
+and positioning are limited (`mclimit`, `nslimit`) to keep them from dominating
+the run. The time dot reports for routing splines is taken from its verbose
+output, along with how many edge groups were routed concurrently and how many
+of those had to be routed again because an earlier route in their batch
+resized a virtual node they used. The median over repeated runs is reported.
+
+Every layout is compared with the one using a single thread, which routes edges
+one after the other, and any that differs is flagged.
+"""
+
+import argparse
+import random
+import re
+import shutil
+import statistics
+import subprocess
+import sys
+from typing import List, Tuple
+
+
+def long_edges(nodes: int, edges: int, span: int, seed: int) -> str:
+    """generate a chain with `edges` more edges of up to `span` ranks"""
+    rng = random.Random(seed)
+    lines = ["digraph {", "  mclimit=0.05; nslimit=0.2;"]
+    for i in range(nodes - 1):
+        lines += [f"  n{i} -> n{i + 1};"]
+    for _ in range(edges):
+        tail = rng.randrange(nodes - span)
+        lines += [f"  n{tail} -> n{tail + rng.randrange(2, span + 1)};"]
+    return "\n".join(lines) + "\n}\n"
+
+
+def route(dot: str, source: str, threads: int) -> Tuple[float, int, str]:
+    """
+    lay out a graph, returning seconds spent routing splines, number of routes
+    redone and the layout
+    """
+    proc = subprocess.run(
+        [dot, "-v", f"-Gthreads={threads}", "-Tdot"],
+        input=source,
+        stdout=subprocess.PIPE,
+        stderr=subprocess.PIPE,
+        check=True,
+        universal_newlines=True,
+    )
+    m = re.search(r"^routesplines: .* ([\d.]+) sec", proc.stderr, re.M)
+    if m is None:
+        sys.stderr.write(proc.stderr)
+        raise RuntimeError(f"no routesplines timing in output of {dot}")
+    again = re.search(r"^dot_splines: .*, (\d+) routed again", proc.stderr, re.M)
+    layout = re.sub(r"\s*threads=\d+,?", "", proc.stdout)
+    return float(m.group(1)), int(again.group(1)) if again else 0, layout
+
+
+def main(args: List[str]) -> int:  # pylint: disable=C0116
+    parser = argparse.ArgumentParser(description=__doc__.strip().split("\n")[0])
+    parser.add_argument(
+        "--graphs",
+        nargs="*",
+        default=["400,1500,10", "1000,4000,10", "1000,4000,20"],
+        help="graphs to lay out, as NODES,EDGES,SPAN",
+    )
+    parser.add_argument(
+        "--threads",
+        type=int,
+        nargs="+",
+        default=[1, 2, 4, 8],
+        help="numbers of threads to route with",
+    )
+    parser.add_argument(
+        "--repeat", type=int, default=3, help="runs per configuration"
+    )
+    parser.add_argument("--seed", type=int, default=42)
+    parser.add_argument("--dot", default=shutil.which("dot") or "dot")
+    options = parser.parse_args(args[1:])
+
+    print(f"{'graph':<14} {'threads':>7} {'seconds':>9} {'speedup':>8} {'redone':>7}")
+    for spec in options.graphs:
+        nodes, edges, span = (int(x) for x in spec.split(","))
+        source = long_edges(nodes, edges, span, options.seed)
+        reference = None
+        base = None
+        for threads in [1] + [t for t in options.threads if t != 1]:
+            runs = [route(options.dot, source, threads) for _ in range(options.repeat)]
+            seconds = statistics.median(t for t, _, _ in runs)
+            _, again, layout = runs[0]
+            if reference is None:
+                reference, base = layout, seconds
+            note = "" if layout == reference else "  (different layout)"
+            print(
+                f"{spec:<14} {threads:>7} {seconds:>9.3f} {base / seconds:>7.2f}x"
+                f" {again:>7}{note}"
+            )
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
@@ -0,0 +1,155 @@
+#!/usr/bin/env python3
+
+"""
+Benchmark of neato’s Hogwild SGD against its serial SGD
+
+Grids and random graphs are generated with gvgen and each is laid out by neato
+with `mode=sgd`, and with `mode=hogwild` for each requested thread count, with
+several iteration limits. The wall clock time of each layout is reported with
+its stress. The stress is normalized, as by Gansner, Koren and North, after
+scaling the layout to fit the graph distances best, so layouts from different
+runs can be compared. A mode that reaches lower stress sooner is doing better.
+"""
+
+import argparse
+import collections
+import math
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+from pathlib import Path
+from typing import Dict, List, Optional, Tuple
+
+Position = Tuple[float, float]
+
+
+def layout(
+    neato: str, graph: Path, mode: str, threads: Optional[int], maxiter: int
+) -> Tuple[float, Dict[str, Position], List[Tuple[str, str]]]:
+    """
+    lay out `graph`, returning elapsed seconds, node positions and edges
+    """
+    args = [neato, f"-Gmode={mode}", f"-Gmaxiter={maxiter}", "-Tplain"]
+    if threads is not None:
+        args += [f"-Gthreads={threads}"]
+    args += [graph]
+
+    start = time.perf_counter()
+    out = subprocess.check_output(args, universal_newlines=True)
+    elapsed = time.perf_counter() - start
+
+    pos = {}
+    edges = []
+    for line in out.splitlines():
+        fields = line.split()
+        if fields[0] == "node":
+            pos[fields[1]] = (float(fields[2]), float(fields[3]))
+        elif fields[0] == "edge":
+            edges += [(fields[1], fields[2])]
+    return elapsed, pos, edges
+
+
+def distances(edges: List[Tuple[str, str]]) -> Dict[Tuple[str, str], int]:
+    """hop counts between every pair of connected nodes, by BFS"""
+    adj = collections.defaultdict(set)
+    for a, b in edges:
+        if a != b:
+            adj[a].add(b)
+            adj[b].add(a)
+    dist = {}
+    for s in adj:
+        seen = {s: 0}
+        queue = collections.deque([s])
+        while queue:
+            u = queue.popleft()
+            for v in adj[u]:
+                if v not in seen:
+                    seen[v] = seen[u] + 1
+                    queue.append(v)
+        for t, d in seen.items():
+            if s < t:
+                dist[(s, t)] = d
+    return dist
+
+
+def stress(pos: Dict[str, Position], dist: Dict[Tuple[str, str], int]) -> float:
+    """normalized stress of a layout, at its best scale"""
+    terms = [(math.dist(pos[s], pos[t]), d) for (s, t), d in dist.items()]
+    num = sum(x / d for x, d in terms)
+    den = sum(x * x / (d * d) for x, d in terms)
+    scale = num / den
+    return sum((scale * x - d) ** 2 / (d * d) for x, d in terms) / len(terms)
+
+
+def main(args: List[str]) -> int:  # pylint: disable=C0116
+    parser = argparse.ArgumentParser(description=__doc__.strip().split("\n")[0])
+    parser.add_argument(
+        "--grid",
+        type=int,
+        nargs="*",
+        default=[40, 60],
+        help="side lengths of square grids to lay out",
+    )
+    parser.add_argument(
+        "--random",
+        nargs="*",
+        default=["2000,4000"],
+        help="random graphs to lay out, as NODES,EDGES",
+    )
+    parser.add_argument(
+        "--threads",
+        type=int,
+        nargs="+",
+        default=[1, 2, 4, 8],
+        help="thread counts to run Hogwild SGD with",
+    )
+    parser.add_argument(
+        "--maxiter",
+        type=int,
+        nargs="+",
+        default=[10, 30],
+        help="iteration limits to run each mode with",
+    )
+    parser.add_argument("--gvgen", default=shutil.which("gvgen") or "gvgen")
+    parser.add_argument("--neato", default=shutil.which("neato") or "neato")
+    options = parser.parse_args(args[1:])
+
+    with tempfile.TemporaryDirectory() as tmp:
+        graphs = []
+        for side in options.grid:
+            graphs += [(f"grid {side}x{side}", f"-g{side},{side}")]
+        for spec in options.random:
+            graphs += [(f"random {spec}", f"-r{spec}")]
+
+        configs = [("sgd", None)]
+        configs += [("hogwild", threads) for threads in options.threads]
+
+        print(
+            f"{'graph':<20} {'mode':>8} {'threads':>7} {'maxiter':>7} "
+            f"{'seconds':>9} {'stress':>9}"
+        )
+        for i, (name, gen) in enumerate(graphs):
+            graph = Path(tmp) / f"{i}.gv"
+            with open(graph, "wt", encoding="utf-8") as f:
+                subprocess.run([options.gvgen, gen], stdout=f, check=True)
+
+            dist = None
+            for mode, threads in configs:
+                for maxiter in options.maxiter:
+                    seconds, pos, edges = layout(
+                        options.neato, graph, mode, threads, maxiter
+                    )
+                    if dist is None:
+                        dist = distances(edges)
+                    print(
+                        f"{name:<20} {mode:>8} {threads or '-':>7} {maxiter:>7} "
+                        f"{seconds:>9.2f} {stress(pos, dist):>9.5f}"
+                    )
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
@@ -0,0 +1,111 @@
+#!/usr/bin/env python3
+
+"""
+Benchmark of neato’s sparse stress model
+
+Grids are generated with gvgen, and connected random graphs (a random tree with
+further random edges) by this script. Each is laid out by neato with
+`mode=sparse`. Graphs up to a given size are also laid out with
+`mode=major`, whose memory grows with the square of the number of nodes. The
+wall clock time and peak resident memory of each layout are reported.
+"""
+
+import argparse
+import os
+import random
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+from pathlib import Path
+from typing import List, Tuple
+
+
+def random_graph(nodes: int, edges: int, seed: int) -> str:
+    """generate a connected graph with `nodes` nodes and `edges` edges"""
+    rng = random.Random(seed)
+    lines = ["graph {"]
+    for i in range(1, nodes):
+        lines += [f"  {rng.randrange(i)} -- {i};"]
+    for _ in range(edges - (nodes - 1)):
+        lines += [f"  {rng.randrange(nodes)} -- {rng.randrange(nodes)};"]
+    return "\n".join(lines) + "\n}\n"
+
+
+def layout(neato: str, graph: Path, mode: str) -> Tuple[float, int]:
+    """
+    lay out `graph`, returning elapsed seconds and peak resident memory in
+    kilobytes
+    """
+    args = [neato, f"-Gmode={mode}", "-Goverlap=true", "-Tplain", "-o", "/dev/null"]
+    args += [graph]
+
+    with tempfile.TemporaryFile() as stderr:
+        start = time.perf_counter()
+        proc = subprocess.Popen(args, stderr=stderr)
+        _, status, usage = os.wait4(proc.pid, 0)
+        elapsed = time.perf_counter() - start
+        if not os.WIFEXITED(status) or os.WEXITSTATUS(status) != 0:
+            stderr.seek(0)
+            sys.stderr.write(stderr.read().decode("utf-8", "replace"))
+            raise RuntimeError(f"{' '.join(str(a) for a in args)} failed")
+    return elapsed, usage.ru_maxrss
+
+
+def main(args: List[str]) -> int:  # pylint: disable=C0116
+    parser = argparse.ArgumentParser(description=__doc__.strip().split("\n")[0])
+    parser.add_argument(
+        "--grid",
+        type=int,
+        nargs="*",
+        default=[100, 224, 316, 448],
+        help="side lengths of square grids to lay out",
+    )
+    parser.add_argument(
+        "--random",
+        nargs="*",
+        default=["10000,20000", "50000,100000", "200000,400000"],
+        help="random graphs to lay out, as NODES,EDGES",
+    )
+    parser.add_argument(
+        "--major",
+        type=int,
+        default=10000,
+        help="largest number of nodes to also lay out with mode=major",
+    )
+    parser.add_argument("--seed", type=int, default=42)
+    parser.add_argument("--gvgen", default=shutil.which("gvgen") or "gvgen")
+    parser.add_argument("--neato", default=shutil.which("neato") or "neato")
+    options = parser.parse_args(args[1:])
+
+    with tempfile.TemporaryDirectory() as tmp:
+        graphs = []
+        for side in options.grid:
+            graphs += [(f"grid {side}x{side}", side * side, f"-g{side},{side}")]
+        for spec in options.random:
+            nodes = int(spec.split(",")[0])
+            graphs += [(f"random {spec}", nodes, spec)]
+
+        print(f"{'graph':<24} {'mode':>6} {'seconds':>9} {'peak MB':>9}")
+        for i, (name, nodes, gen) in enumerate(graphs):
+            graph = Path(tmp) / f"{i}.gv"
+            with open(graph, "wt", encoding="utf-8") as f:
+                if gen.startswith("-"):
+                    subprocess.run([options.gvgen, gen], stdout=f, check=True)
+                else:
+                    nodes, edges = (int(x) for x in gen.split(","))
+                    f.write(random_graph(nodes, edges, options.seed))
+
+            modes = ["sparse"]
+            if nodes <= options.major:
+                modes += ["major"]
+            for mode in modes:
+                seconds, rss = layout(options.neato, graph, mode)
+                print(f"{name:<24} {mode:>6} {seconds:>9.2f} {rss / 1024:>9.1f}")
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
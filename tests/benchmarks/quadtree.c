@@ -0,0 +1,119 @@
+/// @file
+/// @brief micro-benchmark of the quadtree used by sfdp
+///
+/// This compares a tree built one point at a time by `QuadTree_add`, which
+/// is how `QuadTree_new_from_point_list` used to work, against the contiguous
+/// tree `QuadTree_new_from_point_list` now builds. For each, the time to build
+/// the tree and to compute repulsive forces with it is reported. The two trees
+/// are expected to give bitwise identical forces, and this is checked.
+///
+/// Usage: bench_quadtree [points [repeats]]
+
+#include <math.h>
+#include <sparse/QuadTree.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <util/alloc.h>
+
+enum { DIM = 2, MAX_LEVEL = 10 };
+
+/// Barnes-Hut coefficient sfdp uses
+static const double BH = 0.6;
+
+/// build a tree the way QuadTree_new_from_point_list once did
+static QuadTree build_incremental(int n, double *coord) {
+  double xmin[DIM], xmax[DIM], center[DIM];
+
+  for (int k = 0; k < DIM; k++) {
+    xmin[k] = xmax[k] = coord[k];
+  }
+  for (int i = 1; i < n; i++) {
+    for (int k = 0; k < DIM; k++) {
+      xmin[k] = fmin(xmin[k], coord[i * DIM + k]);
+      xmax[k] = fmax(xmax[k], coord[i * DIM + k]);
+    }
+  }
+  double width = xmax[0] - xmin[0];
+  for (int k = 0; k < DIM; k++) {
+    center[k] = (xmin[k] + xmax[k]) * 0.5;
+    width = fmax(width, xmax[k] - xmin[k]);
+  }
+  width = fmax(width, 0.00001) * 0.52;
+
+  QuadTree qt = QuadTree_new(DIM, center, width, MAX_LEVEL);
+  for (int i = 0; i < n; i++) {
+    qt = QuadTree_add(qt, &coord[i * DIM], 1, i);
+  }
+  return qt;
+}
+
+static double seconds_since(clock_t start) {
+  return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+/// time building and computing forces with one kind of tree, in processor
+/// seconds
+static void run(const char *name, bool flat, int n, double *coord,
+                int repeats, double *force) {
+  double build = 0, forces = 0;
+  double counts[4];
+
+  for (int r = 0; r < repeats; r++) {
+    clock_t start = clock();
+    QuadTree qt = flat ? QuadTree_new_from_point_list(DIM, n, MAX_LEVEL, coord)
+                       : build_incremental(n, coord);
+    build += seconds_since(start);
+
+    start = clock();
+    QuadTree_get_repulsive_force(qt, force, coord, BH, -1, 1, counts, 1);
+    forces += seconds_since(start);
+
+    QuadTree_delete(qt);
+  }
+
+  printf("%-12s %10d %12.6f %12.6f\n", name, n, build / repeats,
+         forces / repeats);
+}
+
+int main(int argc, char **argv) {
+  const int n = argc > 1 ? atoi(argv[1]) : 100000;
+  const int repeats = argc > 2 ? atoi(argv[2]) : 5;
+  if (n <= 0 || repeats <= 0) {
+    fprintf(stderr, "usage: %s [points [repeats]]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  // points in a handful of Gaussian clusters, roughly what sfdp sees
+  double *coord = gv_calloc((size_t)n * DIM, sizeof(double));
+  srand(42);
+  for (int i = 0; i < n; i++) {
+    const int cluster = rand() % 8;
+    for (int k = 0; k < DIM; k++) {
+      const double u1 = (rand() + 1.0) / ((double)RAND_MAX + 2.0);
+      const double u2 = (rand() + 1.0) / ((double)RAND_MAX + 2.0);
+      const double g = sqrt(-2 * log(u1)) * cos(2 * M_PI * u2);
+      coord[i * DIM + k] = 100 * (cluster >> k & 1) + 15 * g;
+    }
+  }
+
+  double *incremental = gv_calloc((size_t)n * DIM, sizeof(double));
+  double *flat = gv_calloc((size_t)n * DIM, sizeof(double));
+
+  printf("%-12s %10s %12s %12s\n", "tree", "points", "build (s)", "force (s)");
+  run("incremental", false, n, coord, repeats, incremental);
+  run("flat", true, n, coord, repeats, flat);
+
+  int rc = EXIT_SUCCESS;
+  if (memcmp(incremental, flat, (size_t)n * DIM * sizeof(double)) != 0) {
+    fprintf(stderr, "forces computed with the two trees differ\n");
+    rc = EXIT_FAILURE;
+  }
+
+  free(flat);
+  free(incremental);
+  free(coord);
+  return rc;
+}
@@ -0,0 +1,101 @@
+#!/usr/bin/env python3
+
+"""
+Benchmark of sfdp’s concurrent force computation
+
+Grids and random graphs are generated with gvgen and each is laid out by sfdp
+with the `threads` attribute unset (the serial path) and then with each
+requested thread count. The Barnes-Hut quadtree is forced on with
+`quadtree=fast`, as sfdp would otherwise only use it for graphs with more than
+10000 nodes. The median wall clock time of each configuration is reported, along
+with its speedup over the serial path.
+"""
+
+import argparse
+import shutil
+import statistics
+import subprocess
+import sys
+import tempfile
+import time
+from pathlib import Path
+from typing import List, Optional
+
+
+def layout(sfdp: str, graph: Path, threads: Optional[int]) -> float:
+    """time one layout of `graph`, returning elapsed seconds"""
+    args = [sfdp, "-Gquadtree=fast", "-Tplain", "-o", "/dev/null"]
+    if threads is not None:
+        args += [f"-Gthreads={threads}"]
+    args += [graph]
+
+    start = time.perf_counter()
+    proc = subprocess.run(args, stderr=subprocess.PIPE, universal_newlines=True)
+    elapsed = time.perf_counter() - start
+
+    # builds without a triangulation library fail overlap removal, but still
+    # complete the part of the layout we are interested in
+    if proc.returncode != 0 and "triangulation library" not in proc.stderr:
+        sys.stderr.write(proc.stderr)
+        raise RuntimeError(f"{' '.join(str(a) for a in args)} failed")
+    return elapsed
+
+
+def main(args: List[str]) -> int:  # pylint: disable=C0116
+    parser = argparse.ArgumentParser(description=__doc__.strip().split("\n")[0])
+    parser.add_argument(
+        "--grid",
+        type=int,
+        nargs="*",
+        default=[100, 200],
+        help="side lengths of square grids to lay out",
+    )
+    parser.add_argument(
+        "--random",
+        nargs="*",
+        default=["10000,30000", "40000,120000"],
+        help="random graphs to lay out, as NODES,EDGES",
+    )
+    parser.add_argument(
+        "--threads",
+        type=int,
+        nargs="+",
+        default=[1, 2, 4, 8],
+        help="thread counts to compare against the serial path",
+    )
+    parser.add_argument(
+        "--repeat", type=int, default=3, help="runs per configuration"
+    )
+    parser.add_argument("--gvgen", default=shutil.which("gvgen") or "gvgen")
+    parser.add_argument("--sfdp", default=shutil.which("sfdp") or "sfdp")
+    options = parser.parse_args(args[1:])
+
+    with tempfile.TemporaryDirectory() as tmp:
+        graphs = []
+        for side in options.grid:
+            graphs += [(f"grid {side}x{side}", f"-g{side},{side}")]
+        for spec in options.random:
+            graphs += [(f"random {spec}", f"-r{spec}")]
+
+        print(f"{'graph':<24} {'threads':>7} {'seconds':>9} {'speedup':>8}")
+        for i, (name, gen) in enumerate(graphs):
+            graph = Path(tmp) / f"{i}.gv"
+            with open(graph, "wt", encoding="utf-8") as f:
+                subprocess.run([options.gvgen, gen], stdout=f, check=True)
+
+            serial = statistics.median(
+                layout(options.sfdp, graph, None) for _ in range(options.repeat)
+            )
+            print(f"{name:<24} {'serial':>7} {serial:>9.3f} {1:>8.2f}")
+            for threads in options.threads:
+                t = statistics.median(
+                    layout(options.sfdp, graph, threads)
+                    for _ in range(options.repeat)
+                )
+                print(f"{name:<24} {threads:>7} {t:>9.3f} {serial / t:>8.2f}")
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
@@ -0,0 +1,102 @@
+/// \file
+/// \brief test of adjacency snapshots
+///
+/// Reads a graph from stdin and checks that the snapshots `agcsr` takes of it,
+/// and of each of its subgraphs, have the nodes, edges and weights that
+/// iterating over the graph finds.
+///
+/// See test_regression.py:test_csr
+
+#ifdef NDEBUG
+#error "this program is not intended to be compiled with assertions disabled"
+#endif
+
+#include <assert.h>
+#include <graphviz/cgraph.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/// check the snapshot of `g` against `g`
+static void check(Agraph_t *g, Agsym_t *weight) {
+  Agcsr_t *csr = agcsr(g, weight, -1);
+  assert(csr->nnodes == (size_t)agnnodes(g));
+  assert(csr->nedges == (size_t)agnedges(g));
+  assert((weight == NULL) == (csr->weight == NULL));
+
+  size_t i = 0;
+  for (Agnode_t *n = agfstnode(g); n != NULL; n = agnxtnode(g, n), ++i) {
+    assert(csr->node[i] == n);
+    size_t index = SIZE_MAX;
+    assert(agcsrindex(csr, n, &index) && index == i);
+
+    // out-edges, in the order of agfstout
+    size_t k = csr->out[i];
+    for (Agedge_t *e = agfstout(g, n); e != NULL; e = agnxtout(g, e), ++k) {
+      assert(k < csr->out[i + 1]);
+      assert(csr->edge[k] == e);
+      assert(csr->node[csr->head[k]] == aghead(e));
+      if (weight != NULL) {
+        double w = -1;
+        (void)agxget_double(e, weight, &w);
+        assert(csr->weight[k] == w);
+      }
+    }
+    assert(k == csr->out[i + 1]);
+
+    // in-edges, as a set
+    assert(csr->in[i + 1] - csr->in[i] == (size_t)agdegree(g, n, 1, 0));
+    for (k = csr->in[i]; k < csr->in[i + 1]; ++k) {
+      const Agedge_t *e = csr->edge[csr->in_edge[k]];
+      assert(aghead(e) == n);
+      assert(agtail(e) == csr->node[csr->tail[k]]);
+    }
+  }
+
+  agcsrfree(csr);
+}
+
+int main(void) {
+  Agraph_t *g = agread(stdin, NULL);
+  assert(g != NULL);
+  Agsym_t *weight = agattr(g, AGEDGE, "weight", NULL);
+
+  check(g, NULL);
+  check(g, weight);
+  for (Agraph_t *sg = agfstsubg(g); sg != NULL; sg = agnxtsubg(sg)) {
+    check(sg, weight);
+  }
+
+  // nodes not in a snapshot, including one from another graph
+  Agraph_t *sg = agfstsubg(g);
+  assert(sg != NULL);
+  Agcsr_t *csr = agcsr(sg, NULL, 0);
+  Agraph_t *other = agopen("other", Agdirected, NULL);
+  size_t index = SIZE_MAX;
+  for (int i = 0; i < agnnodes(g); ++i) {
+    char name[16];
+    snprintf(name, sizeof(name), "%d", i);
+    Agnode_t *n = agnode(other, name, 1);
+    assert(!agcsrindex(csr, n, &index) && "node of another graph found");
+  }
+  for (Agnode_t *n = agfstnode(g); n != NULL; n = agnxtnode(g, n)) {
+    assert(agcsrindex(csr, n, &index) == (agsubnode(sg, n, 0) != NULL));
+  }
+  assert(index != SIZE_MAX);
+  agclose(other);
+  agcsrfree(csr);
+
+  // a graph with holes in its node numbering
+  int i = 0;
+  for (Agnode_t *n = agfstnode(g), *next; n != NULL; n = next, ++i) {
+    next = agnxtnode(g, n);
+    if (i % 3 != 0) {
+      agdelnode(g, n);
+    }
+  }
+  check(g, weight);
+
+  agclose(g);
+  printf("ok\n");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,199 @@
+/// \file
+/// \brief test of writing graphs in the gvb format and reading them back
+///
+/// Each graph named on the command line, or a built in one if there are none,
+/// is written with `agwritegvb` and read back with `agreadgvb`,
+/// `agmemreadgvb` and `agmmapread`. The graphs read must write the same DOT
+/// as the original. The built in graph also checks the numbers kept for
+/// `pos` and `bb`, and that damaged images are refused.
+///
+/// See test_regression.py:test_gvb
+
+#ifdef NDEBUG
+#error "this program is not intended to be compiled with assertions disabled"
+#endif
+
+#include <assert.h>
+#include <graphviz/cgraph.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char GRAPH[] =
+    "digraph G {\n"
+    "  graph [bb=\"0,0,100,200\", label=<<b>G</b>>];\n"
+    "  node [shape=box];\n"
+    "  a [pos=\"10,20\", label=\"a \\\"quoted\\\" label\"];\n"
+    "  b [pos=\"30.5,-40!\"];\n"
+    "  c [pos=\"1,2,3\"];\n"
+    "  subgraph cluster_x {\n"
+    "    graph [bb=\"1,2,3,4\", color=red];\n"
+    "    node [color=blue];\n"
+    "    d; e [label=<<i>e</i>>];\n"
+    "    d -> e [weight=3];\n"
+    "    { rank=same; f; }\n"
+    "  }\n"
+    "  a -> b -> c;\n"
+    "  a -> b [key=k1, color=green];\n"
+    "  a -> b [key=k2];\n"
+    "  c -> a;\n"
+    "  c -> c;\n"
+    "  lonely;\n"
+    "}\n";
+
+/// the contents of a file
+static char *slurp(FILE *f, size_t *size) {
+  rewind(f);
+  size_t capacity = 4096;
+  char *data = malloc(capacity);
+  assert(data != NULL);
+  size_t n = 0;
+  size_t got;
+  while ((got = fread(data + n, 1, capacity - n, f)) > 0) {
+    n += got;
+    if (n == capacity) {
+      capacity *= 2;
+      data = realloc(data, capacity);
+      assert(data != NULL);
+    }
+  }
+  *size = n;
+  return data;
+}
+
+/// the DOT a graph writes
+static char *dot(Agraph_t *g) {
+  FILE *f = tmpfile();
+  assert(f != NULL);
+  assert(agwrite(g, f) == 0);
+  size_t size;
+  char *text = slurp(f, &size);
+  fclose(f);
+  text[size] = '\0';
+  return text;
+}
+
+static void check_coords(Agraph_t *g) {
+  const double *c;
+  Agsym_t *pos = agattr(g, AGNODE, "pos", NULL);
+  Agsym_t *bb = agattr(g, AGRAPH, "bb", NULL);
+  assert(pos != NULL && bb != NULL);
+
+  assert(agxget_coords(agnode(g, "a", 0), pos, &c) == 2);
+  assert(c[0] == 10 && c[1] == 20);
+  assert(agxget_coords(agnode(g, "b", 0), pos, &c) == 2);
+  assert(c[0] == 30.5 && c[1] == -40);
+  assert(agxget_coords(agnode(g, "c", 0), pos, &c) == 0 &&
+         "3D position kept");
+  assert(agxget_coords(g, bb, &c) == 4);
+  assert(c[0] == 0 && c[1] == 0 && c[2] == 100 && c[3] == 200);
+  Agraph_t *x = agsubg(g, "cluster_x", 0);
+  assert(x != NULL);
+  assert(agxget_coords(x, bb, &c) == 4);
+  assert(c[0] == 1 && c[1] == 2 && c[2] == 3 && c[3] == 4);
+
+  // numbers are forgotten once the value changes
+  Agnode_t *a = agnode(g, "a", 0);
+  agxset(a, pos, "7,8");
+  assert(agxget_coords(a, pos, &c) == 0);
+}
+
+/// write a graph and check what each reader makes of it
+static void round_trip(Agraph_t *g, bool builtin) {
+  char *expected = dot(g);
+
+  FILE *f = tmpfile();
+  assert(f != NULL);
+  assert(agwritegvb(g, f, NULL) == 0);
+  // a second copy, to check graphs are read one after another
+  assert(agwritegvb(g, f, NULL) == 0);
+  fflush(f);
+  size_t size;
+  char *data = slurp(f, &size);
+  assert(agisgvb(data, size));
+  assert(size % 8 == 0);
+
+  // from a stream
+  rewind(f);
+  for (int i = 0; i < 2; ++i) {
+    Agraph_t *h = agreadgvb(f, NULL);
+    assert(h != NULL);
+    char *got = dot(h);
+    if (strcmp(got, expected) != 0) {
+      fprintf(stderr, "expected:\n%s\ngot:\n%s\n", expected, got);
+      abort();
+    }
+    if (builtin) {
+      check_coords(h);
+    }
+    free(got);
+    agclose(h);
+  }
+  assert(agreadgvb(f, NULL) == NULL && "graph after the end of the file");
+
+  // from memory
+  size_t used = 0;
+  Agraph_t *h = agmemreadgvb(data, size, &used, NULL);
+  assert(h != NULL);
+  assert(used == size / 2);
+  char *got = dot(h);
+  assert(strcmp(got, expected) == 0);
+  free(got);
+  agclose(h);
+
+  // from a mapped file, where supported
+  Agmmap_t *m = agmmapopen(f);
+  if (m != NULL) {
+    for (int i = 0; i < 2; ++i) {
+      h = agmmapread(m, NULL);
+      assert(h != NULL);
+      got = dot(h);
+      assert(strcmp(got, expected) == 0);
+      free(got);
+      agclose(h);
+    }
+    assert(agmmapread(m, NULL) == NULL);
+    agmmapclose(m);
+  }
+
+  if (builtin) {
+    // a truncated image
+    assert(agmemreadgvb(data, used - 8, NULL, NULL) == NULL);
+    // an image of another version, and of another byte order
+    char *bad = malloc(used);
+    assert(bad != NULL);
+    memcpy(bad, data, used);
+    bad[8] ^= 0x40;
+    assert(agmemreadgvb(bad, used, NULL, NULL) == NULL);
+    memcpy(bad, data, used);
+    bad[12] ^= 0x40;
+    assert(agmemreadgvb(bad, used, NULL, NULL) == NULL);
+    free(bad);
+  }
+
+  free(data);
+  fclose(f);
+  free(expected);
+}
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    Agraph_t *g = agmemread(GRAPH);
+    assert(g != NULL);
+    round_trip(g, true);
+    agclose(g);
+  }
+  for (int i = 1; i < argc; ++i) {
+    FILE *f = fopen(argv[i], "r");
+    assert(f != NULL);
+    Agraph_t *g;
+    while ((g = agread(f, NULL)) != NULL) {
+      round_trip(g, false);
+      agclose(g);
+    }
+    fclose(f);
+  }
+  printf("ok\n");
+  return EXIT_SUCCESS;
+}
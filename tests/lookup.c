@@ -0,0 +1,141 @@
+/// \file
+/// \brief test of finding and visiting the nodes and edges of a graph
+///
+/// Adds and deletes many nodes and edges in a graph and a subgraph, checking
+/// nodes can be found by name and edges visited the same way with
+/// `agfstout`/`agnxtout` and `agfstin`/`agnxtin` throughout, including while
+/// the edges are being changed or visited twice at once.
+///
+/// See test_regression.py:test_lookup
+
+#ifdef NDEBUG
+#error "this program is not intended to be compiled with assertions disabled"
+#endif
+
+#include <assert.h>
+#include <graphviz/cgraph.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+enum { NODES = 3000, EDGES = 12000, STEPS = 20000 };
+
+static char names[NODES][16];
+
+/// is each node in the graph, as far as we know?
+static bool present[NODES];
+
+/// count a node's out-edges, also visiting them again from each one
+static size_t outs(Agraph_t *g, Agnode_t *n) {
+  size_t count = 0;
+  for (Agedge_t *e = agfstout(g, n); e != NULL; e = agnxtout(g, e)) {
+    assert(agtail(e) == n);
+    // an inner visit of the same edges must agree with the outer one
+    size_t inner = 0;
+    Agedge_t *f;
+    for (f = agfstout(g, n); f != NULL && f != e; f = agnxtout(g, f)) {
+      ++inner;
+    }
+    assert(f == e && inner == count);
+    ++count;
+  }
+  return count;
+}
+
+/// count a node's in-edges
+static size_t ins(Agraph_t *g, Agnode_t *n) {
+  size_t count = 0;
+  for (Agedge_t *e = agfstin(g, n); e != NULL; e = agnxtin(g, e)) {
+    assert(aghead(e) == n);
+    ++count;
+  }
+  return count;
+}
+
+/// check every node can be found, and every edge visited, from both ends
+static void check(Agraph_t *g) {
+  size_t count = 0;
+  for (size_t i = 0; i < NODES; ++i) {
+    Agnode_t *n = agnode(g, names[i], 0);
+    if (g == agroot(g)) {
+      assert((n != NULL) == present[i]);
+    }
+    count += n != NULL;
+  }
+  assert(count == (size_t)agnnodes(g));
+
+  size_t out = 0, in = 0;
+  for (Agnode_t *n = agfstnode(g); n != NULL; n = agnxtnode(g, n)) {
+    out += outs(g, n);
+    in += ins(g, n);
+    assert(agidnode(g, AGID(n), 0) == n);
+  }
+  assert(out == (size_t)agnedges(g));
+  assert(in == (size_t)agnedges(g));
+}
+
+int main(void) {
+  srand(42);
+  for (size_t i = 0; i < NODES; ++i) {
+    snprintf(names[i], sizeof(names[i]), "n%zu", i);
+  }
+
+  Agraph_t *g = agopen("G", Agdirected, NULL);
+  Agraph_t *sub = agsubg(g, "sub", 1);
+  for (size_t i = 0; i < NODES; ++i) {
+    agnode(i % 3 == 0 ? sub : g, names[i], 1);
+    present[i] = true;
+  }
+  for (size_t i = 0; i < EDGES; ++i) {
+    Agnode_t *t = agnode(g, names[(size_t)rand() % NODES], 0);
+    Agnode_t *h = agnode(g, names[(size_t)rand() % NODES], 0);
+    agedge(i % 4 == 0 ? sub : g, t, h, NULL, 1);
+  }
+  check(g);
+  check(sub);
+
+  // delete and recreate nodes, so their slots are emptied and refilled
+  for (size_t step = 0; step < STEPS; ++step) {
+    const size_t i = (size_t)rand() % NODES;
+    if (present[i]) {
+      agdelnode(g, agnode(g, names[i], 0));
+      present[i] = false;
+    } else {
+      Agnode_t *n = agnode(step % 2 == 0 ? sub : g, names[i], 1);
+      present[i] = true;
+      // with a few edges, some added while visiting the node's edges
+      Agnode_t *other = agfstnode(g);
+      agedge(g, n, other, NULL, 1);
+      for (Agedge_t *e = agfstout(g, other); e != NULL; e = agnxtout(g, e)) {
+        if (aghead(e) == other) {
+          agedge(g, other, n, NULL, 1);
+          break;
+        }
+      }
+      agedge(g, other, n, NULL, 1);
+    }
+    if (step % 2000 == 0) {
+      check(g);
+      check(sub);
+    }
+  }
+  check(g);
+  check(sub);
+
+  // delete edges while visiting them
+  for (Agnode_t *n = agfstnode(g); n != NULL; n = agnxtnode(g, n)) {
+    bool odd = false;
+    for (Agedge_t *e = agfstout(g, n), *f; e != NULL; e = f) {
+      f = agnxtout(g, e);
+      if ((odd = !odd)) {
+        agdeledge(g, e);
+      }
+    }
+  }
+  check(g);
+  check(sub);
+
+  agclose(g);
+  printf("ok\n");
+  return EXIT_SUCCESS;
+}
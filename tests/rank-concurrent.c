@@ -0,0 +1,165 @@
+/// \file
+/// \brief stress test for ranking several graphs concurrently
+///
+/// Builds a set of random DAGs, ranks each of them with network simplex once
+/// serially and once from a pool of threads, and checks the resulting ranks
+/// are identical.
+///
+/// See test_regression.py:test_rank_concurrent
+
+#ifdef NDEBUG
+#error "this program is not intended to be compiled with assertions disabled"
+#endif
+
+#include <assert.h>
+#include <graphviz/cgraph.h>
+#include <graphviz/types.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// exported by libgvc, but not part of its public headers
+extern int rank2(graph_t *g, int balance, int maxiter, int search_size);
+
+enum { GRAPHS = 24, THREADS = 6 };
+
+/// a simple deterministic PRNG so the serial and concurrent graphs match
+static unsigned next(unsigned *seed) {
+  *seed = *seed * 1103515245u + 12345u;
+  return (*seed >> 16) & 0x7fff;
+}
+
+static void append(elist *l, edge_t *e) {
+  l->list = realloc(l->list, (l->size + 2) * sizeof(edge_t *));
+  assert(l->list != NULL);
+  l->list[l->size++] = e;
+  l->list[l->size] = NULL;
+}
+
+/// construct a random connected DAG with the fast graph structure `rank2`
+/// expects
+static graph_t *make_graph(unsigned seed) {
+  graph_t *g = agopen("g", Agdirected, NULL);
+  assert(g != NULL);
+  agbindrec(g, "Agraphinfo_t", sizeof(Agraphinfo_t), true);
+
+  const int n_nodes = 200 + (int)(next(&seed) % 800);
+  node_t **nodes = calloc((size_t)n_nodes, sizeof(nodes[0]));
+  assert(nodes != NULL);
+
+  node_t *last = NULL;
+  for (int i = 0; i < n_nodes; ++i) {
+    char name[32];
+    snprintf(name, sizeof(name), "n%d", i);
+    node_t *n = nodes[i] = agnode(g, name, 1);
+    agbindrec(n, "Agnodeinfo_t", sizeof(Agnodeinfo_t), true);
+    ND_in(n).list = calloc(1, sizeof(edge_t *));
+    ND_out(n).list = calloc(1, sizeof(edge_t *));
+    assert(ND_in(n).list != NULL && ND_out(n).list != NULL);
+    if (last == NULL) {
+      GD_nlist(g) = n;
+    } else {
+      ND_next(last) = n;
+      ND_prev(n) = last;
+    }
+    last = n;
+  }
+
+  for (int i = 1; i < n_nodes; ++i) {
+    // one edge from an earlier node keeps the graph connected, a few more make
+    // the ranking non-trivial
+    const int extra = (int)(next(&seed) % 4);
+    for (int j = 0; j <= extra; ++j) {
+      node_t *t = nodes[next(&seed) % (unsigned)i];
+      node_t *h = nodes[i];
+      edge_t *e = agedge(g, t, h, NULL, 1);
+      assert(e != NULL);
+      agbindrec(e, "Agedgeinfo_t", sizeof(Agedgeinfo_t), true);
+      ED_minlen(e) = (int)(next(&seed) % 3);
+      ED_weight(e) = 1 + (int)(next(&seed) % 4);
+      append(&ND_out(t), e);
+      append(&ND_in(h), e);
+    }
+  }
+
+  free(nodes);
+  return g;
+}
+
+static void free_graph(graph_t *g) {
+  for (node_t *n = agfstnode(g); n != NULL; n = agnxtnode(g, n)) {
+    free(ND_in(n).list);
+    free(ND_out(n).list);
+  }
+  agclose(g);
+}
+
+/// serialize the ranks of a graph
+static char *dump(graph_t *g) {
+  char *buffer = NULL;
+  size_t size = 0;
+  FILE *f = open_memstream(&buffer, &size);
+  assert(f != NULL);
+  for (node_t *n = GD_nlist(g); n != NULL; n = ND_next(n)) {
+    fprintf(f, "%s %d\n", agnameof(n), ND_rank(n));
+  }
+  fclose(f);
+  return buffer;
+}
+
+static graph_t *concurrent[GRAPHS];
+static int results[GRAPHS];
+
+static void *worker(void *arg) {
+  const size_t id = (size_t)arg;
+  for (size_t i = id; i < GRAPHS; i += THREADS) {
+    // alternate between balancing modes to cover more of the solver
+    results[i] = rank2(concurrent[i], (int)(i % 3), INT_MAX, -1);
+  }
+  return NULL;
+}
+
+int main(void) {
+
+  // rank each graph serially to obtain reference output
+  char *expected[GRAPHS];
+  for (size_t i = 0; i < GRAPHS; ++i) {
+    graph_t *g = make_graph((unsigned)i + 1);
+    const int r = rank2(g, (int)(i % 3), INT_MAX, -1);
+    assert(r == 0 && "serial ranking failed");
+    expected[i] = dump(g);
+    free_graph(g);
+  }
+
+  // construct identical graphs, then rank them all at once
+  for (size_t i = 0; i < GRAPHS; ++i) {
+    concurrent[i] = make_graph((unsigned)i + 1);
+  }
+  pthread_t threads[THREADS];
+  for (size_t i = 0; i < THREADS; ++i) {
+    const int r = pthread_create(&threads[i], NULL, worker, (void *)i);
+    assert(r == 0 && "failed to create thread");
+  }
+  for (size_t i = 0; i < THREADS; ++i) {
+    const int r = pthread_join(threads[i], NULL);
+    assert(r == 0 && "failed to join thread");
+  }
+
+  int rc = EXIT_SUCCESS;
+  for (size_t i = 0; i < GRAPHS; ++i) {
+    assert(results[i] == 0 && "concurrent ranking failed");
+    char *got = dump(concurrent[i]);
+    if (strcmp(expected[i], got) != 0) {
+      fprintf(stderr, "graph %zu was ranked differently when concurrent\n", i);
+      rc = EXIT_FAILURE;
+    }
+    free(got);
+    free(expected[i]);
+    free_graph(concurrent[i]);
+  }
+
+  return rc;
+}
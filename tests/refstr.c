@@ -0,0 +1,159 @@
+/// \file
+/// \brief test of cgraph's reference counted strings
+///
+/// Interns many strings in a graph, releases them in a scrambled order and
+/// checks that the rest can still be found, to exercise the string table
+/// growing and closing gaps. Checks that `agstrref` takes references to the
+/// same string, copies strings of another graph, and can be used by several
+/// threads at once on strings of no graph.
+///
+/// See test_regression.py:test_refstr
+
+#ifdef NDEBUG
+#error "this program is not intended to be compiled with assertions disabled"
+#endif
+
+#include <assert.h>
+#include <graphviz/cgraph.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum { STRINGS = 100000, THREADS = 4, REFS = 100000 };
+
+static void name(char *buf, size_t size, int i) {
+  snprintf(buf, size, "string %d", i);
+}
+
+/// intern strings, release them in a scrambled order and look for the rest
+static void churn(void) {
+  Agraph_t *g = agopen("g", Agdirected, NULL);
+  assert(g != NULL);
+  char **s = calloc(STRINGS, sizeof(s[0]));
+  assert(s != NULL);
+  char buf[64];
+  for (int i = 0; i < STRINGS; ++i) {
+    name(buf, sizeof(buf), i);
+    s[i] = agstrdup(g, buf);
+    assert(s[i] != NULL && strcmp(s[i], buf) == 0);
+  }
+  for (int i = 0; i < STRINGS; ++i) {
+    name(buf, sizeof(buf), i);
+    assert(agstrbind(g, buf) == s[i]);
+    assert(agstrdup(g, buf) == s[i] && "second reference is the same string");
+  }
+
+  // release every string once, and every third one twice
+  for (int i = 0; i < STRINGS; ++i) {
+    const int j = (int)((unsigned)i * 7919u % STRINGS);
+    assert(agstrfree(g, s[j]) == 0);
+    if (j % 3 == 0) {
+      assert(agstrfree(g, s[j]) == 0);
+    }
+  }
+  for (int i = 0; i < STRINGS; ++i) {
+    name(buf, sizeof(buf), i);
+    if (i % 3 == 0) {
+      assert(agstrbind(g, buf) == NULL && "released string still found");
+    } else {
+      assert(agstrbind(g, buf) == s[i] && "held string lost");
+    }
+  }
+  for (int i = 0; i < STRINGS; ++i) {
+    if (i % 3 != 0) {
+      assert(agstrfree(g, s[i]) == 0);
+    }
+  }
+  assert(agstrbind(g, "string 1") == NULL);
+  free(s);
+  agclose(g);
+}
+
+static void refs(void) {
+  Agraph_t *g = agopen("g", Agdirected, NULL);
+  Agraph_t *h = agopen("h", Agdirected, NULL);
+  assert(g != NULL && h != NULL);
+
+  char *s = agstrdup(g, "shared");
+  assert(agstrref(g, s) == s);
+  assert(agstrfree(g, s) == 0);
+  assert(agstrbind(g, "shared") == s && "one reference remains");
+  assert(agstrfree(g, s) == 0);
+  assert(agstrbind(g, "shared") == NULL);
+
+  // HTML-ness goes with the string
+  char *html = agstrdup_html(g, "<b>x</b>");
+  char *ref = agstrref(g, html);
+  assert(ref == html && aghtmlstr(ref));
+  agstrfree(g, ref);
+
+  // a string of another graph is copied into this one
+  char *copy = agstrref(h, html);
+  assert(copy != html && strcmp(copy, html) == 0);
+  assert(agstrbind(h, "<b>x</b>") == copy);
+  assert(agstrfree(g, copy) != 0 && "released from the wrong graph");
+  agstrfree(h, copy);
+  agstrfree(g, html);
+
+  // values set from interned strings
+  Agsym_t *color = agattr(g, AGNODE, "color", "black");
+  char *red = agstrdup(g, "red");
+  Agnode_t *n = agnode(g, "n", 1);
+  Agnode_t *m = agnode(g, "m", 1);
+  assert(agxget(n, color) == agxget(m, color) && "defaults are shared");
+  assert(agxset_interned(n, color, red) == 0);
+  assert(agxset_interned(m, color, red) == 0);
+  assert(agxget(n, color) == red && agxget(m, color) == red);
+  agstrfree(g, red);
+  assert(strcmp(agxget(n, color), "red") == 0);
+  agxset(n, color, "blue");
+  assert(agstrbind(g, "red") == red && "m still holds it");
+  agxset(m, color, "blue");
+  assert(agstrbind(g, "red") == NULL);
+
+  agclose(h);
+  agclose(g);
+}
+
+static void *take_refs(void *arg) {
+  char *s = arg;
+  for (int i = 0; i < REFS; ++i) {
+    char *r = agstrref(NULL, s);
+    assert(r == s);
+    if (i % 2 == 0) {
+      agstrfree(NULL, r);
+    }
+  }
+  for (int i = 0; i < REFS; ++i) {
+    if (i % 2 != 0) {
+      agstrfree(NULL, s);
+    }
+  }
+  return NULL;
+}
+
+/// references to strings of no graph from several threads at once
+static void concurrent(void) {
+  char *s = agstrdup(NULL, "no graph");
+  assert(s != NULL);
+  pthread_t t[THREADS];
+  for (int i = 0; i < THREADS; ++i) {
+    assert(pthread_create(&t[i], NULL, take_refs, s) == 0);
+  }
+  for (int i = 0; i < THREADS; ++i) {
+    assert(pthread_join(t[i], NULL) == 0);
+  }
+  assert(agstrbind(NULL, "no graph") == s && "one reference remains");
+  agstrfree(NULL, s);
+  assert(agstrbind(NULL, "no graph") == NULL);
+}
+
+int main(void) {
+  churn();
+  refs();
+  concurrent();
+  printf("ok\n");
+  return EXIT_SUCCESS;
+}
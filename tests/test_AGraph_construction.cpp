@@ -1,4 +1,5 @@
 #include <stdexcept>
+#include <string>
 
 #include <catch2/catch_all.hpp>
 
@@ -38,3 +39,26 @@ TEST_CASE("AGraph can be move assigned") {
   other = std::move(g);
   REQUIRE(other.c_struct() == c_ptr);
 }
+
+TEST_CASE("AGraph can be constructed empty and built in bulk") {
+  CGraph::AGraph g{"G", Agdirected};
+  REQUIRE(g.c_struct() != nullptr);
+  g.build({"a", "b", "c"}, {{0, 1}, {1, 2}, {2, 0}},
+          {{AGNODE, "label", {"A", "B", "C"}},
+           {AGEDGE, "weight", {"1", "2", "3"}}});
+  REQUIRE(agnnodes(g.c_struct()) == 3);
+  REQUIRE(agnedges(g.c_struct()) == 3);
+  Agnode_t *b = agnode(g.c_struct(), const_cast<char *>("b"), 0);
+  REQUIRE(b != nullptr);
+  REQUIRE(std::string(agget(b, const_cast<char *>("label"))) == "B");
+  Agedge_t *e = agfstout(g.c_struct(), b);
+  REQUIRE(e != nullptr);
+  REQUIRE(std::string(agnameof(aghead(e))) == "c");
+  REQUIRE(std::string(agget(e, const_cast<char *>("weight"))) == "2");
+}
+
+TEST_CASE("AGraph built with an edge to a missing node throws an exception") {
+  CGraph::AGraph g{"G", Agundirected};
+  REQUIRE_THROWS_AS(g.build({"a"}, {{0, 1}}), std::invalid_argument);
+  REQUIRE(agnnodes(g.c_struct()) == 0);
+}
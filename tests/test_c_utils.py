@@ -48,6 +48,24 @@ def test_bitarray():
     _, _ = run_c(src, cflags=cflags)
 
 
+def test_numfmt():
+    """run numfmt.h’s unit tests"""
+
+    # locate the unit tests
+    src = Path(__file__).parent.resolve() / "../lib/util/test_numfmt.c"
+    assert src.exists()
+
+    # locate lib directory that needs to be in the include path
+    lib = Path(__file__).parent.resolve() / "../lib"
+
+    # extra C flags this compilation needs
+    cflags = ["-I", lib]
+    if platform.system() != "Windows":
+        cflags += ["-std=gnu99", "-Wall", "-Wextra", "-Werror"]
+
+    _, _ = run_c(src, cflags=cflags)
+
+
 @pytest.mark.parametrize("builtins", (False, True))
 def test_overflow_h(builtins: bool):
     """test ../lib/util/overflow.h"""
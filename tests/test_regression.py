@@ -7,10 +7,12 @@ of these indicates that a past bug has been reintroduced.
 
 import dataclasses
 import io
+import itertools
 import json
 import math
 import os
 import platform
+import random
 import re
 import shlex
 import shutil
@@ -5122,6 +5124,673 @@ def test_agxbuf_use_implicit_nul():
     run_c(c_src, cflags=cflags)
 
 
+@pytest.mark.skipif(
+    is_static_build(),
+    reason="dynamic libraries are unavailable to link against in static builds",
+)
+@pytest.mark.skipif(
+    platform.system() == "Windows", reason="test case uses POSIX threads"
+)
+def test_rank_concurrent():
+    """
+    ranking separate graphs from separate threads should give the same results
+    as ranking them one after another
+    """
+
+    # find co-located test source
+    c_src = (Path(__file__).parent / "rank-concurrent.c").resolve()
+    assert c_src.exists(), "missing test case"
+
+    # GNU99 needed for `open_memstream`
+    run_c(c_src, cflags=["-std=gnu99", "-pthread"], link=["cgraph", "gvc"])
+
+
+@pytest.mark.parametrize("engine", ("neato", "sfdp"))
+def test_threads_deterministic(engine: str):
+    """
+    laying out components concurrently should give the same result, regardless
+    of how many threads are used
+    """
+
+    if which(engine) is None:
+        pytest.skip(f"{engine} not available")
+
+    # construct a graph with many components of varying size and shape
+    graph = io.StringIO()
+    graph.write("graph {\n")
+    for c in range(60):
+        size = 3 + c % 11
+        for i in range(1, size):
+            graph.write(f"  c{c}_{(i - 1) // 2} -- c{c}_{i};\n")
+            if i % 4 == 0:
+                graph.write(f"  c{c}_0 -- c{c}_{i};\n")
+    graph.write("}\n")
+    source = graph.getvalue()
+
+    def layout(threads: int) -> str:
+        p = subprocess.run(
+            [which(engine), f"-Gthreads={threads}", "-Tplain"],
+            input=source,
+            stdout=subprocess.PIPE,
+            stderr=subprocess.PIPE,
+            universal_newlines=True,
+        )
+        # if sfdp was built without libgts, it will not handle anything
+        # non-trivial
+        no_gts_error = "remove_overlap: Graphviz not built with triangulation library"
+        if no_gts_error in p.stderr:
+            pytest.skip(f"{engine} built without triangulation library")
+        assert p.returncode == 0, f"{engine} failed: {p.stderr}"
+        return p.stdout
+
+    ref = layout(1)
+    for threads in (2, 4, 7):
+        assert layout(threads) == ref, f"layout with {threads} threads differed"
+
+
+@pytest.mark.skipif(which("dot") is None, reason="dot not available")
+def test_dot_mincross_threads():
+    """
+    dot’s crossing minimization should give the same result regardless of how
+    many threads are used
+    """
+
+    # a connected graph with ranks wide enough to be worth spreading across
+    # threads
+    rng = random.Random(42)
+    graph = io.StringIO()
+    graph.write("digraph {\n")
+    for r in range(2):
+        for i in range(1100):
+            graph.write(f"  n{r}_{i} -> n{r + 1}_{min(1099, i + 1)};\n")
+            j = min(1099, max(0, i + rng.randrange(-4, 5)))
+            graph.write(f"  n{r}_{i} -> n{r + 1}_{j};\n")
+    graph.write("}\n")
+    source = graph.getvalue()
+
+    def layout(threads: int) -> str:
+        # limit mincross iterations to keep the test quick
+        return subprocess.check_output(
+            [which("dot"), "-Gmclimit=0.1", f"-Gthreads={threads}", "-Tplain"],
+            input=source,
+            universal_newlines=True,
+        )
+
+    ref = layout(1)
+    for threads in (2, 4):
+        assert layout(threads) == ref, f"layout with {threads} threads differed"
+
+
+@pytest.mark.skipif(which("dot") is None, reason="dot not available")
+def test_dot_splines_threads():
+    """
+    dot should route edges the same regardless of how many threads are used
+    """
+
+    # a chain with many edges spanning several ranks, so routes run through
+    # virtual nodes next to those of other routes
+    rng = random.Random(42)
+    graph = io.StringIO()
+    graph.write("digraph {\n  nslimit=1;\n")
+    for i in range(99):
+        graph.write(f"  n{i} -> n{i + 1};\n")
+    for _ in range(400):
+        i = rng.randrange(90)
+        graph.write(f"  n{i} -> n{i + rng.randrange(2, 10)};\n")
+    graph.write("  n3 -> n20 -> n3 [label=back];\n  n5 -> n5;\n}\n")
+    source = graph.getvalue()
+
+    def layout(threads: int) -> str:
+        output = subprocess.check_output(
+            [which("dot"), f"-Gthreads={threads}", "-Tdot"],
+            input=source,
+            universal_newlines=True,
+        )
+        return re.sub(r"\s*threads=\d+,?", "", output)
+
+    ref = layout(1)
+    for threads in (2, 4, 7):
+        assert layout(threads) == ref, f"routing with {threads} threads differed"
+
+
+def test_ortho_many_edges():
+    """
+    every edge of a graph with many orthogonal routes should be made of
+    horizontal and vertical pieces
+    """
+
+    rng = random.Random(42)
+    graph = io.StringIO()
+    graph.write("digraph {\n  splines=ortho;\n")
+    for _ in range(600):
+        i = rng.randrange(190)
+        graph.write(f"  n{i} -> n{i + rng.randrange(1, 10)};\n")
+    graph.write("}\n")
+
+    output = dot("json", source=graph.getvalue())
+    data = json.loads(output)
+
+    assert len(data["edges"]) == 600, "edges missing from output"
+    for edge in data["edges"]:
+        points = [op for op in edge["_draw_"] if op["op"] == "b"][0]["points"]
+        for (x0, y0), (x1, y1) in zip(points, points[1:]):
+            assert (
+                abs(x0 - x1) < 0.01 or abs(y0 - y1) < 0.01
+            ), f"edge {edge['_gvid']} has a diagonal piece"
+
+
+def test_ortho_threads():
+    """
+    routing orthogonal edges in rounds should give the same result regardless
+    of how many threads are used
+    """
+
+    # enough edges for several rounds, some of them through the same cells
+    rng = random.Random(42)
+    graph = io.StringIO()
+    graph.write("digraph {\n  splines=ortho;\n")
+    for _ in range(300):
+        i = rng.randrange(90)
+        graph.write(f"  n{i} -> n{i + rng.randrange(1, 10)};\n")
+    graph.write("  n5 -> n5;\n}\n")
+    source = graph.getvalue()
+
+    def layout(threads: int) -> str:
+        return subprocess.check_output(
+            [which("dot"), f"-Gthreads={threads}", "-Tplain"],
+            input=source,
+            universal_newlines=True,
+        )
+
+    ref = layout(1)
+    assert ref.count("\nedge ") == 301, "edges missing from output"
+    for threads in (2, 4, 7):
+        assert layout(threads) == ref, f"routing with {threads} threads differed"
+
+
+@pytest.mark.skipif(which("sfdp") is None, reason="sfdp not available")
+def test_sfdp_threads_reproducible():
+    """
+    computing the forces on a single component concurrently should give the same
+    result every time for a given number of threads
+    """
+
+    # a grid large enough for its quadtree to be split across threads
+    graph = io.StringIO()
+    graph.write("graph {\n")
+    for i in range(30):
+        for j in range(30):
+            if i > 0:
+                graph.write(f"  n{i - 1}_{j} -- n{i}_{j};\n")
+            if j > 0:
+                graph.write(f"  n{i}_{j - 1} -- n{i}_{j};\n")
+    graph.write("}\n")
+    source = graph.getvalue()
+
+    def layout() -> str:
+        p = subprocess.run(
+            [which("sfdp"), "-Gquadtree=fast", "-Gthreads=3", "-Tplain"],
+            input=source,
+            stdout=subprocess.PIPE,
+            stderr=subprocess.PIPE,
+            universal_newlines=True,
+        )
+        # if sfdp was built without libgts, it will not handle anything
+        # non-trivial
+        no_gts_error = "remove_overlap: Graphviz not built with triangulation library"
+        if no_gts_error in p.stderr:
+            pytest.skip("sfdp built without triangulation library")
+        assert p.returncode == 0, f"sfdp failed: {p.stderr}"
+        return p.stdout
+
+    ref = layout()
+    for _ in range(3):
+        assert layout() == ref, "concurrent layout was not reproducible"
+
+
+@pytest.mark.skipif(which("dot") is None, reason="dot not available")
+def test_dot_incremental():
+    """
+    feeding dot’s own output back to it with `incremental=true` should keep the
+    previous ranks and order, and an edited graph should keep most of them
+    """
+
+    # a random DAG with some crossings to minimize
+    rng = random.Random(42)
+    graph = io.StringIO()
+    graph.write("digraph {\n")
+    for i in range(1, 60):
+        graph.write(f"  n{rng.randrange(i)} -> n{i};\n")
+    for _ in range(25):
+        a, b = sorted(rng.sample(range(60), 2))
+        graph.write(f"  n{a} -> n{b};\n")
+    graph.write("}\n")
+    source = graph.getvalue()
+
+    def layout(fmt: str, source: str, *args: str) -> str:
+        return subprocess.check_output(
+            [which("dot"), f"-T{fmt}", *args], input=source, universal_newlines=True
+        )
+
+    def positions(source: str) -> dict:
+        """(rank coordinate, coordinate within the rank) of each node"""
+        plain = layout("plain", source)
+        pos = {}
+        for line in plain.splitlines():
+            fields = line.split()
+            if fields[0] == "node":
+                pos[fields[1]] = (float(fields[3]), float(fields[2]))
+        return pos
+
+    def swaps(a: dict, b: dict) -> int:
+        """number of node pairs on the same rank in both, whose order differs"""
+        count = 0
+        for u, v in itertools.combinations(a, 2):
+            if a[u][0] == a[v][0] and b[u][0] == b[v][0]:
+                if (a[u][1] < a[v][1]) != (b[u][1] < b[v][1]):
+                    count += 1
+        return count
+
+    previous = layout("dot", source, "-Gincremental=true")
+    before = positions(source)
+
+    # an unchanged graph should keep its ranks and order
+    again = positions(previous)
+    assert all(
+        again[n][0] == before[n][0] for n in before
+    ), "incremental layout of an unchanged graph changed ranks"
+    assert (
+        swaps(before, again) == 0
+    ), "incremental layout of an unchanged graph reordered nodes"
+
+    # after an edit, nodes should stay in the same order on their ranks
+    edited = previous.rstrip().rstrip("}") + "  n3 -> new; new -> n40;\n}\n"
+    after = positions(edited)
+    pairs = sum(
+        1
+        for u, v in itertools.combinations(before, 2)
+        if before[u][0] == before[v][0] and after[u][0] == after[v][0]
+    )
+    assert (
+        swaps(before, after) <= pairs // 20
+    ), "incremental layout of an edited graph reordered many nodes"
+
+
+@pytest.mark.skipif(which("neato") is None, reason="neato not available")
+@pytest.mark.parametrize("mode", ("major", "sgd"))
+def test_neato_apsp_threads(mode: str):
+    """
+    computing the shortest paths of a single component concurrently should not
+    change its layout
+    """
+
+    # a connected graph with a pinned node, edges of different lengths and
+    # paths of different lengths between the same nodes
+    graph = io.StringIO()
+    graph.write('graph {\n  n0 [pos="0,0!"];\n')
+    for i in range(1, 120):
+        graph.write(f"  n{(i - 1) // 3} -- n{i} [len={1 + i % 3}];\n")
+        if i % 7 == 0:
+            graph.write(f"  n{i // 2} -- n{i};\n")
+    graph.write("}\n")
+    source = graph.getvalue()
+
+    def layout(threads: int) -> str:
+        return subprocess.check_output(
+            [which("neato"), f"-Gmode={mode}", f"-Gthreads={threads}", "-Tplain"],
+            input=source,
+            universal_newlines=True,
+        )
+
+    ref = layout(1)
+    for threads in (2, 4, 7):
+        assert layout(threads) == ref, f"layout with {threads} threads differed"
+
+
+@pytest.mark.skipif(which("neato") is None, reason="neato not available")
+def test_neato_hogwild():
+    """
+    Hogwild SGD should lay out every node and leave pinned nodes in place, and
+    with a single thread it should be reproducible
+    """
+
+    # a grid with a pinned corner
+    graph = io.StringIO()
+    graph.write('graph {\n  n0_0 [pos="1,2!"];\n')
+    for i in range(15):
+        for j in range(15):
+            if i > 0:
+                graph.write(f"  n{i - 1}_{j} -- n{i}_{j};\n")
+            if j > 0:
+                graph.write(f"  n{i}_{j - 1} -- n{i}_{j};\n")
+    graph.write("}\n")
+    source = graph.getvalue()
+
+    def layout(threads: int) -> str:
+        return subprocess.check_output(
+            [
+                which("neato"),
+                "-Gmode=hogwild",
+                f"-Gthreads={threads}",
+                "-Gnotranslate=true",
+                "-Tplain",
+            ],
+            input=source,
+            universal_newlines=True,
+        )
+
+    ref = layout(1)
+    assert layout(1) == ref, "single threaded layout was not reproducible"
+
+    for output in (ref, layout(3)):
+        pos = {}
+        for line in output.splitlines():
+            fields = line.split()
+            if fields[0] == "node":
+                pos[fields[1]] = (float(fields[2]), float(fields[3]))
+        assert len(pos) == 15 * 15, "not every node was laid out"
+        assert all(math.isfinite(x) and math.isfinite(y) for x, y in pos.values())
+        x, y = pos["n0_0"]
+        assert abs(x - 1) < 0.01 and abs(y - 2) < 0.01, "pinned node moved"
+
+
+@pytest.mark.skipif(which("neato") is None, reason="neato not available")
+def test_neato_sparse():
+    """
+    neato’s sparse stress model should lay out a graph and honor pinned nodes
+    """
+
+    # a ring, long enough for its far side to only be reached through pivots
+    ring = "graph { " + " ".join(f"n{i} -- n{(i + 1) % 60};" for i in range(60))
+    ring += ' n0 [pos="0,0!"]; n30 [pos="10,0!"]; }'
+
+    p = subprocess.run(
+        [which("neato"), "-Gmode=sparse", "-Gstart=random", "-Tplain"],
+        input=ring,
+        stdout=subprocess.PIPE,
+        stderr=subprocess.PIPE,
+        universal_newlines=True,
+    )
+    if "Illegal value sparse" in p.stderr:
+        pytest.skip("neato built without sfdp")
+    assert p.returncode == 0, f"neato failed: {p.stderr}"
+
+    pos = {}
+    for line in p.stdout.splitlines():
+        fields = line.split()
+        if fields[0] == "node":
+            pos[fields[1]] = (float(fields[2]), float(fields[3]))
+    assert len(pos) == 60, "not every node was laid out"
+
+    # the plain output is translated, but pinned nodes keep their offset
+    (x0, y0), (x30, y30) = pos["n0"], pos["n30"]
+    assert abs(x30 - x0 - 10) < 0.01, "pinned node moved"
+    assert abs(y30 - y0) < 0.01, "pinned node moved"
+
+    # the rest of the ring passes around both sides of the line between them
+    above = sum(1 for x, y in pos.values() if y > y0 + 0.5)
+    below = sum(1 for x, y in pos.values() if y < y0 - 0.5)
+    assert above > 10 and below > 10, "ring was not opened out"
+
+
+def test_mmap_read(tmp_path: Path):
+    """
+    reading a named file, which is mapped into memory, should give the same
+    graphs as reading the same text from stdin
+    """
+
+    text = textwrap.dedent(
+        """\
+        /* a comment */
+        digraph "first graph" {
+          // another comment
+          node [shape=box, label="multi\\nline"];
+          a [label="say \\"hi\\""];
+          b [label=<<b>bold</b> &amp; <i>italic</i>>];
+          c [label="continued \\
+        line" + " and joined"];
+        # 12 "elsewhere.gv"
+          a:p1:n -> b:s -> c [weight=2.5, minlen=1];
+          subgraph cluster_x { d; e -> d }
+          -.5 -> 1.5;
+        }
+        graph second {
+          EDGE [color=red]
+          x -- y -- z; { rank=same x z }
+        }
+        """
+    )
+    source = tmp_path / "input.gv"
+    source.write_text(text, encoding="utf-8")
+
+    mapped = dot("canon", source)
+    streamed = dot("canon", source=text)
+    assert mapped == streamed, "reading a file and stdin gave different graphs"
+    assert "second" in mapped, "second graph in the file was not read"
+
+
+@pytest.mark.skipif(
+    platform.system() == "Windows",
+    reason="test case uses open_memstream, unavailable on Windows",
+)
+def test_arena_disc():
+    """
+    a graph using the arena memory discipline should be built, edited and
+    closed the same as one using the default discipline
+    """
+
+    # find co-located test source
+    c_src = (Path(__file__).parent / "arena-disc.c").resolve()
+    assert c_src.exists(), "missing test case"
+
+    # a graph with subgraphs and attributes, including HTML-like labels
+    graph = ["digraph G {", "  node [shape=box];"]
+    for i in range(200):
+        graph += [f'  n{i} [label="node {i}", width={i % 7}];']
+        graph += [f"  n{i} -> n{(i * 7 + 3) % 200} [weight={i % 5}];"]
+        graph += [f"  n{i} -> n{(i * 13 + 1) % 200};"]
+    for i in range(10):
+        graph += [f"  subgraph cluster_{i} {{ label=<<b>{i}</b>>; n{i * 20} }}"]
+    graph += ["}"]
+
+    # GNU99 needed for `fmemopen` and `open_memstream`
+    stdout, _ = run_c(
+        c_src, input="\n".join(graph), cflags=["-std=gnu99"], link=["cgraph"]
+    )
+    assert "added" in stdout, "attribute declared after nodes were lost"
+
+
+def test_attr_num():
+    """
+    numbers read from attribute values should follow changes to those values
+    """
+
+    # find co-located test source
+    c_src = (Path(__file__).parent / "attr-num.c").resolve()
+    assert c_src.exists(), "missing test case"
+
+    stdout, _ = run_c(c_src, link=["cgraph"])
+    assert stdout.strip() == "ok", "unexpected output"
+
+
+@pytest.mark.parametrize("directed", (False, True))
+def test_csr(directed: bool):
+    """
+    a snapshot of a graph’s adjacency should match the graph
+    """
+
+    # find co-located test source
+    c_src = (Path(__file__).parent / "csr.c").resolve()
+    assert c_src.exists(), "missing test case"
+
+    # a graph with loops, multi-edges, weights and subgraphs
+    op = "->" if directed else "--"
+    graph = ["digraph G {" if directed else "graph G {"]
+    for i in range(100):
+        graph += [f"  n{i} {op} n{(i * 7 + 3) % 100} [weight={i % 5}];"]
+        graph += [f"  n{i} {op} n{(i * 13 + 1) % 100} [weight=x];"]
+    graph += [f"  n5 {op} n5; n6 {op} n7; n6 {op} n7;"]
+    for i in range(5):
+        nodes = " ".join(f"n{j}" for j in range(i * 20, i * 20 + 10))
+        graph += [f"  subgraph s{i} {{ {nodes} n{i} {op} n{i + 50} }}"]
+    graph += ["}"]
+
+    stdout, _ = run_c(c_src, input="\n".join(graph), link=["cgraph"])
+    assert stdout.strip() == "ok", "unexpected output"
+
+
+@pytest.mark.skipif(
+    platform.system() == "Windows",
+    reason="test case uses open_memstream, unavailable on Windows",
+)
+def test_agbuild():
+    """
+    a graph built in bulk should be the same as one built a node and edge at a
+    time
+    """
+
+    # find co-located test source
+    c_src = (Path(__file__).parent / "agbuild.c").resolve()
+    assert c_src.exists(), "missing test case"
+
+    stdout, _ = run_c(c_src, cflags=["-std=gnu99"], link=["cgraph"])
+    assert stdout.strip() == "ok", "unexpected output"
+
+
+def test_lookup():
+    """
+    nodes should be found, and edges visited, correctly as a graph changes
+    """
+
+    # find co-located test source
+    c_src = (Path(__file__).parent / "lookup.c").resolve()
+    assert c_src.exists(), "missing test case"
+
+    stdout, _ = run_c(c_src, link=["cgraph"])
+    assert stdout.strip() == "ok", "unexpected output"
+
+
+@pytest.mark.parametrize(
+    "tool,flag",
+    (("dot", "--pipeline"), ("dot", "--pipeline=1"), ("nop", "-P"), ("gc", "-P")),
+)
+def test_pipeline(tmp_path: Path, tool: str, flag: str):
+    """
+    parsing graphs ahead of processing them should not change the output or its
+    order, nor the exit status
+    """
+
+    if which(tool) is None:
+        pytest.skip(f"{tool} not available")
+
+    # many files, one with several graphs, one that is not valid DOT and one
+    # that does not exist
+    inputs = []
+    for i in range(40):
+        source = tmp_path / f"{i}.gv"
+        edges = " ".join(f"n{j} -> n{(j * 7 + i) % 15};" for j in range(15))
+        source.write_text(f"digraph g{i} {{ {edges} }}", encoding="utf-8")
+        inputs += [source]
+    several = tmp_path / "several.gv"
+    several.write_text("digraph a { x -> y } graph b { z } digraph c { }")
+    inputs[20:20] = [several]
+    invalid = tmp_path / "invalid.gv"
+    invalid.write_text("digraph { a -> }")
+    inputs += [invalid, tmp_path / "missing.gv", inputs[0]]
+
+    args = [which(tool)] + (["-Tsvg"] if tool == "dot" else [])
+    serial = subprocess.run(
+        args + inputs, stdout=subprocess.PIPE, stderr=subprocess.PIPE, check=False
+    )
+    piped = subprocess.run(
+        args + [flag] + inputs,
+        stdout=subprocess.PIPE,
+        stderr=subprocess.PIPE,
+        check=False,
+    )
+
+    assert serial.stderr != b"", "invalid and missing inputs were not reported"
+    assert piped.returncode == serial.returncode, f"{flag} changed exit status"
+    assert piped.stdout == serial.stdout, f"{flag} changed output"
+    assert sorted(piped.stderr.splitlines()) == sorted(
+        serial.stderr.splitlines()
+    ), f"{flag} changed diagnostics"
+
+
+def test_gvb():
+    """
+    graphs written in the gvb format should read back as the same graphs
+    """
+
+    # find co-located test source
+    c_src = (Path(__file__).parent / "gvb.c").resolve()
+    assert c_src.exists(), "missing test case"
+
+    stdout, _ = run_c(c_src, link=["cgraph"])
+    assert stdout.strip() == "ok", "unexpected output"
+
+    graphs = [
+        Path(__file__).parent / "graphs" / f
+        for f in ("clust4.gv", "html.gv", "multi.gv", "b7.gv", "url.gv")
+    ]
+    stdout, _ = run_c(c_src, args=[str(g) for g in graphs], link=["cgraph"])
+    assert stdout.strip() == "ok", "unexpected output"
+
+
+@pytest.mark.skipif(which("dot") is None, reason="dot not available")
+def test_gvb_output(tmp_path: Path):
+    """
+    a graph dot writes with `-Tgvb` should render as the same graph written
+    with `-Tdot` does
+    """
+
+    source = Path(__file__).parent / "graphs" / "clust4.gv"
+    dot = which("dot")
+    layout = subprocess.check_output([dot, "-Tdot", source])
+    binary = tmp_path / "clust4.gvb"
+    subprocess.check_call([dot, "-Tgvb", "-o", binary, source])
+
+    expected = subprocess.check_output([dot, "-Tcanon"], input=layout)
+    from_file = subprocess.check_output([dot, "-Tcanon", binary])
+    assert from_file == expected, "gvb file read differently"
+    from_stdin = subprocess.check_output([dot, "-Tcanon"], input=binary.read_bytes())
+    assert from_stdin == expected, "gvb read from stdin differently"
+
+
+@pytest.mark.skipif(
+    platform.system() == "Windows", reason="test case uses POSIX threads"
+)
+def test_refstr():
+    """
+    interned strings should be found, shared and released correctly
+    """
+
+    # find co-located test source
+    c_src = (Path(__file__).parent / "refstr.c").resolve()
+    assert c_src.exists(), "missing test case"
+
+    stdout, _ = run_c(c_src, cflags=["-pthread"], link=["cgraph"])
+    assert stdout.strip() == "ok", "unexpected output"
+
+
+@pytest.mark.skipif(which("dot") is None, reason="dot not available")
+def test_agwrite_canon():
+    """
+    `agwrite` should quote, escape and break lines of IDs exactly as it always
+    has, with buffered output and the fast path for IDs needing no quotes
+    """
+
+    # find co-located test source and the output of the unbuffered writer
+    source = Path(__file__).parent / "agwrite.gv"
+    assert source.exists(), "missing test case"
+    expected = (Path(__file__).parent / "agwrite.canon").read_text(encoding="utf-8")
+
+    canonical = subprocess.check_output(
+        [which("dot"), "-Tcanon", source], encoding="utf-8"
+    )
+    assert canonical == expected, "agwrite output changed"
+
+
 @pytest.mark.skipif(which("edgepaint") is None, reason="edgepaint not available")
 def test_edgepaint_error_message():
     """